@@ -0,0 +1,36 @@
+#include <string.h>
+#include "dht11_decode.h"
+
+#define DHT11_BITS  40
+
+dht11_decode_result_t dht11_decode(const dht11_pulse_t *pulses, size_t n, uint8_t out[5]) {
+    uint16_t low_us[DHT11_MAX_PULSES / 2];
+    uint16_t high_us[DHT11_MAX_PULSES / 2];
+    size_t   pairs = 0;
+
+    if (n > DHT11_MAX_PULSES) n = DHT11_MAX_PULSES;
+
+    // Gom các cặp LOW -> HIGH hoàn chỉnh; HIGH dài bất thường là line idle
+    for (size_t i = 0; i + 1 < n; i++) {
+        if (pulses[i].level != 0 || pulses[i + 1].level != 1) continue;
+        if (pulses[i + 1].us > DHT11_BIT_HIGH_MAX_US) continue;
+        low_us[pairs]  = pulses[i].us;
+        high_us[pairs] = pulses[i + 1].us;
+        pairs++;
+        i++;
+    }
+    if (pairs < DHT11_BITS) return DHT11_DECODE_FRAME_ERROR;
+
+    memset(out, 0, 5);
+    size_t first = pairs - DHT11_BITS;
+    for (size_t b = 0; b < DHT11_BITS; b++) {
+        uint16_t lo = low_us[first + b], hi = high_us[first + b];
+        if (lo < DHT11_BIT_LOW_MIN_US || lo > DHT11_BIT_LOW_MAX_US || hi < DHT11_BIT_HIGH_MIN_US) {
+            return DHT11_DECODE_FRAME_ERROR;
+        }
+        if (hi > DHT11_BIT_ONE_US) out[b / 8] |= (uint8_t)(1 << (7 - (b % 8)));
+    }
+
+    if (out[4] != ((out[0] + out[1] + out[2] + out[3]) & 0xFF)) return DHT11_DECODE_CRC_ERROR;
+    return DHT11_DECODE_OK;
+}
@@ -0,0 +1,33 @@
+#ifndef DHT11_DECODE_H_
+#define DHT11_DECODE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ==== Giải mã chuỗi xung DHT11 (không phụ thuộc ESP-IDF) ====
+// Sau tín hiệu start, DHT11 kéo LOW ~80us, HIGH ~80us, rồi 40 bit:
+//   mỗi bit = LOW ~50us + HIGH ~26-28us (bit 0) hoặc ~70us (bit 1).
+// Đầu chuỗi có thể bị cắt (bắt đầu capture trễ) nên lấy 40 cặp LOW/HIGH
+// cuối cùng làm dữ liệu.
+#define DHT11_BIT_LOW_MIN_US    30
+#define DHT11_BIT_LOW_MAX_US    90
+#define DHT11_BIT_HIGH_MIN_US   10
+#define DHT11_BIT_HIGH_MAX_US   100
+#define DHT11_BIT_ONE_US        48      // HIGH dài hơn ngưỡng này là bit 1
+#define DHT11_MAX_PULSES        128
+
+typedef struct {
+    uint8_t  level;     // 0 = LOW, 1 = HIGH
+    uint16_t us;
+} dht11_pulse_t;
+
+typedef enum {
+    DHT11_DECODE_OK = 0,
+    DHT11_DECODE_FRAME_ERROR,   // thiếu bit / độ rộng xung sai
+    DHT11_DECODE_CRC_ERROR,
+} dht11_decode_result_t;
+
+// out[0] = humi, out[1] = humi thập phân, out[2] = temp, out[3] = temp thập phân, out[4] = checksum
+dht11_decode_result_t dht11_decode(const dht11_pulse_t *pulses, size_t n, uint8_t out[5]);
+
+#endif /* DHT11_DECODE_H_ */
@@ -22,105 +22,151 @@
  * SOFTWARE.
 */
 
+#include <string.h>
 #include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_log.h"
 #include "driver/gpio.h"
-#include "esp32/rom/ets_sys.h"
+#include "driver/rmt_rx.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 
 #include "esp32-dht11.h"
+#include "dht11_decode.h"
+
+#define DHT11_RMT_RESOLUTION_HZ  1000000    /* 1 tick = 1us */
+#define DHT11_START_LOW_MS       20         /* host kéo LOW >= 18ms */
+#define DHT11_RX_SYMBOLS         64         /* khung DHT11 ~42 symbol */
+
+static const char *TAG = "DHT11";
 
 static gpio_num_t dht_gpio;
 static int64_t last_read_time = -2000000;
-static struct dht11_reading last_read;
-
-static int _waitOrTimeout(uint16_t microSeconds, int level) {
-    int micros_ticks = 0;
-    while(gpio_get_level(dht_gpio) == level) { 
-        if(micros_ticks++ > microSeconds) 
-            return DHT11_TIMEOUT_ERROR;
-        ets_delay_us(1);
-    }
-    return micros_ticks;
-}
+static struct dht11_reading last_read = {DHT11_TIMEOUT_ERROR, -1, -1};
 
-static int _checkCRC(uint8_t data[]) {
-    if(data[4] == ((data[0] + data[1] + data[2] + data[3])&0xFF))
-        return DHT11_OK;
-    else
-        return DHT11_CRC_ERROR;
+static rmt_channel_handle_t rx_chan;
+static rmt_symbol_word_t rx_symbols[DHT11_RX_SYMBOLS];
+static QueueHandle_t rx_done_queue;     /* ISR RMT -> task driver */
+static QueueHandle_t request_queue;     /* 1 yêu cầu đọc tại 1 thời điểm */
+
+static bool IRAM_ATTR _rxDoneCallback(rmt_channel_handle_t chan, const rmt_rx_done_event_data_t *edata, void *ctx) {
+    BaseType_t woken = pdFALSE;
+    xQueueSendFromISR((QueueHandle_t)ctx, &edata->num_symbols, &woken);
+    return woken == pdTRUE;
 }
 
-static void _sendStartSignal() {
-    gpio_set_direction(dht_gpio, GPIO_MODE_OUTPUT);
-    gpio_set_level(dht_gpio, 0);
-    ets_delay_us(20 * 1000);
-    gpio_set_level(dht_gpio, 1);
-    ets_delay_us(40);
-    gpio_set_direction(dht_gpio, GPIO_MODE_INPUT);
+/* Trải symbol RMT (2 mức / symbol) thành danh sách xung, bỏ mức 0us */
+static size_t _symbolsToPulses(size_t num_symbols, dht11_pulse_t *pulses) {
+    size_t n = 0;
+    for (size_t i = 0; i < num_symbols && n + 2 <= DHT11_MAX_PULSES; i++) {
+        if (rx_symbols[i].duration0) pulses[n++] = (dht11_pulse_t){ rx_symbols[i].level0, rx_symbols[i].duration0 };
+        if (rx_symbols[i].duration1) pulses[n++] = (dht11_pulse_t){ rx_symbols[i].level1, rx_symbols[i].duration1 };
+    }
+    return n;
 }
 
-static int _checkResponse() {
-    /* Wait for next step ~80us*/
-    if(_waitOrTimeout(80, 0) == DHT11_TIMEOUT_ERROR)
-        return DHT11_TIMEOUT_ERROR;
+static struct dht11_reading _captureOnce() {
+    static dht11_pulse_t pulses[DHT11_MAX_PULSES];
+    struct dht11_reading r = {DHT11_TIMEOUT_ERROR, -1, -1};
+    size_t num_symbols = 0;
 
-    /* Wait for next step ~80us*/
-    if(_waitOrTimeout(80, 1) == DHT11_TIMEOUT_ERROR) 
-        return DHT11_TIMEOUT_ERROR;
+    rmt_receive_config_t rcv = {
+        .signal_range_min_ns = 1000,            /* lọc gai < 1us */
+        .signal_range_max_ns = 200 * 1000,      /* HIGH > 200us = hết khung */
+    };
 
-    return DHT11_OK;
-}
+    xQueueReset(rx_done_queue);
+
+    /* Start signal: task ngủ trong lúc giữ LOW thay vì ets_delay_us */
+    gpio_set_level(dht_gpio, 0);
+    vTaskDelay(pdMS_TO_TICKS(DHT11_START_LOW_MS) + 1);
+    gpio_set_level(dht_gpio, 1);
+    if (rmt_receive(rx_chan, rx_symbols, sizeof(rx_symbols), &rcv) != ESP_OK) return r;
 
-static struct dht11_reading _timeoutError() {
-    struct dht11_reading timeoutError = {DHT11_TIMEOUT_ERROR, -1, -1};
-    return timeoutError;
+    if (xQueueReceive(rx_done_queue, &num_symbols, pdMS_TO_TICKS(DHT11_READ_TIMEOUT_MS)) != pdTRUE) {
+        /* không có phản hồi: hủy lần nhận đang chờ */
+        rmt_disable(rx_chan);
+        rmt_enable(rx_chan);
+        return r;
+    }
+
+    uint8_t data[5];
+    size_t n = _symbolsToPulses(num_symbols, pulses);
+    switch (dht11_decode(pulses, n, data)) {
+        case DHT11_DECODE_OK:
+            r.status = DHT11_OK;
+            r.temperature = data[2];
+            r.humidity = data[0];
+            break;
+        case DHT11_DECODE_CRC_ERROR:
+            r.status = DHT11_CRC_ERROR;
+            break;
+        default:
+            break;
+    }
+    return r;
 }
 
-static struct dht11_reading _crcError() {
-    struct dht11_reading crcError = {DHT11_CRC_ERROR, -1, -1};
-    return crcError;
+static void _driverTask(void *arg) {
+    TaskHandle_t requester;
+    for (;;) {
+        xQueueReceive(request_queue, &requester, portMAX_DELAY);
+        /* yêu cầu xếp hàng trong lúc đang đọc: trả luôn kết quả vừa có */
+        if (esp_timer_get_time() - 2000000 >= last_read_time) {
+            last_read_time = esp_timer_get_time();
+            last_read = _captureOnce();
+            if (last_read.status != DHT11_OK) {
+                ESP_LOGD(TAG, "read error %d", last_read.status);
+            }
+        }
+        if (requester) xTaskNotifyGive(requester);
+    }
 }
 
 void DHT11_init(gpio_num_t gpio_num) {
-    /* Wait 1 seconds to make the device pass its initial unstable status */
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
     dht_gpio = gpio_num;
+    /* Cảm biến cần ~1s để ổn định sau khi cấp nguồn: chặn lần đọc đầu thay vì delay */
+    last_read_time = esp_timer_get_time() - 1000000;
+
+    rmt_rx_channel_config_t rx_cfg = {
+        .gpio_num = gpio_num,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = DHT11_RMT_RESOLUTION_HZ,
+        .mem_block_symbols = DHT11_RX_SYMBOLS,
+    };
+    ESP_ERROR_CHECK(rmt_new_rx_channel(&rx_cfg, &rx_chan));
+
+    /* Open-drain: mức 1 = nhả line cho pull-up, RMT vẫn đọc được input */
+    gpio_set_direction(dht_gpio, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_level(dht_gpio, 1);
+
+    rx_done_queue = xQueueCreate(1, sizeof(size_t));
+    request_queue = xQueueCreate(1, sizeof(TaskHandle_t));
+    rmt_rx_event_callbacks_t cbs = { .on_recv_done = _rxDoneCallback };
+    ESP_ERROR_CHECK(rmt_rx_register_event_callbacks(rx_chan, &cbs, rx_done_queue));
+    ESP_ERROR_CHECK(rmt_enable(rx_chan));
+
+    xTaskCreate(_driverTask, "dht11", 3072, NULL, 6, NULL);
 }
 
-struct dht11_reading DHT11_read() {
+esp_err_t DHT11_start_read(TaskHandle_t notify_task) {
     /* Tried to sense too son since last read (dht11 needs ~2 seconds to make a new read) */
     if(esp_timer_get_time() - 2000000 < last_read_time) {
-        return last_read;
+        if (notify_task) xTaskNotifyGive(notify_task);
+        return ESP_OK;
     }
+    if (xQueueSend(request_queue, &notify_task, 0) != pdTRUE) return ESP_ERR_INVALID_STATE;
+    return ESP_OK;
+}
 
-    last_read_time = esp_timer_get_time();
-
-    uint8_t data[5] = {0,0,0,0,0};
-
-    _sendStartSignal();
-
-    if(_checkResponse() == DHT11_TIMEOUT_ERROR)
-        return last_read = _timeoutError();
-    
-    /* Read response */
-    for(int i = 0; i < 40; i++) {
-        /* Initial data */
-        if(_waitOrTimeout(50, 0) == DHT11_TIMEOUT_ERROR)
-            return last_read = _timeoutError();
-                
-        if(_waitOrTimeout(70, 1) > 28) {
-            /* Bit received was a 1 */
-            data[i/8] |= (1 << (7-(i%8)));
-        }
-    }
+struct dht11_reading DHT11_last_reading(void) {
+    return last_read;
+}
 
-    if(_checkCRC(data) != DHT11_CRC_ERROR) {
-        last_read.status = DHT11_OK;
-        last_read.temperature = data[2];
-        last_read.humidity = data[0];
-        return last_read;
-    } else {
-        return last_read = _crcError();
+struct dht11_reading DHT11_read() {
+    if (DHT11_start_read(xTaskGetCurrentTaskHandle()) == ESP_OK) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DHT11_START_LOW_MS + DHT11_READ_TIMEOUT_MS) + 2);
     }
-}
\ No newline at end of file
+    return last_read;
+}
@@ -26,6 +26,9 @@
 #define DHT11_H_
 
 #include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
 
 enum dht11_status {
     DHT11_CRC_ERROR = -2,
@@ -39,8 +42,19 @@ struct dht11_reading {
     int humidity;
 };
 
+/* Thời gian chờ tối đa cho 1 lần đọc (start 20ms + khung dữ liệu ~5ms) */
+#define DHT11_READ_TIMEOUT_MS 60
+
 void DHT11_init(gpio_num_t);
 
+/* Bắt đầu đọc không chặn: xung được capture bằng RMT và giải mã trong task
+ * driver. Xong thì xTaskNotifyGive(notify_task), lấy kết quả bằng
+ * DHT11_last_reading(). ESP_ERR_INVALID_STATE nếu đang có lần đọc khác. */
+esp_err_t DHT11_start_read(TaskHandle_t notify_task);
+
+struct dht11_reading DHT11_last_reading(void);
+
+/* API cũ: start + chờ kết quả (task gọi ngủ, không busy-wait) */
 struct dht11_reading DHT11_read();
 
 #endif
\ No newline at end of file
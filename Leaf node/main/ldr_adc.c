@@ -0,0 +1,166 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+
+#include "ldr_adc.h"
+#include "ldr_filter.h"
+
+#define LDR_FRAME_BYTES     256     // 128 mẫu / frame DMA
+#define LDR_POOL_MAX        16384   // giới hạn RAM cho pool DMA
+#define LDR_TASK_STACK      3072
+#define LDR_TASK_PRIO       3
+#define LDR_ATTEN           ADC_ATTEN_DB_12
+#define LDR_VREF_MV         3300
+#define LDR_RAW_MAX         4095
+
+static const char *TAG = "LDR_ADC";
+
+static adc_continuous_handle_t s_adc;
+static adc_cali_handle_t       s_cali;
+static bool                    s_cali_ok;
+static ldr_adc_config_t        s_cfg;
+static ldr_median_t            s_median;
+
+static portMUX_TYPE            s_lock = portMUX_INITIALIZER_UNLOCKED;
+static ldr_reading_t           s_last;
+static bool                    s_has_last;
+static volatile uint32_t       s_overflows;
+
+static bool IRAM_ATTR _poolOvf(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *ctx) {
+    s_overflows++;
+    return false;
+}
+
+static void _caliInit(void) {
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cfg = {
+        .unit_id  = ADC_UNIT_1,
+        .atten    = LDR_ATTEN,
+        .bitwidth = ADC_BITWIDTH_12,
+    };
+    s_cali_ok = adc_cali_create_scheme_line_fitting(&cfg, &s_cali) == ESP_OK;
+#elif ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t cfg = {
+        .unit_id  = ADC_UNIT_1,
+        .chan     = s_cfg.channel,
+        .atten    = LDR_ATTEN,
+        .bitwidth = ADC_BITWIDTH_12,
+    };
+    s_cali_ok = adc_cali_create_scheme_curve_fitting(&cfg, &s_cali) == ESP_OK;
+#endif
+    if (!s_cali_ok) ESP_LOGW(TAG, "Không có eFuse calibration, dùng Vref %dmV", LDR_VREF_MV);
+}
+
+/* Cộng các mẫu của kênh LDR trong 1 frame DMA (format TYPE1 2 byte/mẫu) */
+static uint32_t _sumFrame(const uint8_t *buf, uint32_t len, uint32_t *count) {
+    uint16_t vals[LDR_FRAME_BYTES / SOC_ADC_DIGI_RESULT_BYTES];
+    size_t n = 0;
+
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&buf[i];
+        if (p->type1.channel == s_cfg.channel) vals[n++] = p->type1.data;
+    }
+    *count += n;
+    return ldr_sum_u16(vals, n);
+}
+
+static void ldr_task(void *arg) {
+    uint8_t frame[LDR_FRAME_BYTES];
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(s_cfg.window_ms));
+
+        // gom toàn bộ frame DMA đã tích lũy trong cửa sổ, không chờ thêm
+        uint64_t sum = 0;
+        uint32_t n = 0, got = 0;
+        while (adc_continuous_read(s_adc, frame, sizeof(frame), &got, 0) == ESP_OK) {
+            sum += _sumFrame(frame, got, &n);
+        }
+        if (n == 0) continue;
+
+        uint16_t mean = (uint16_t)((sum + n / 2) / n);
+        uint16_t raw  = ldr_median_push(&s_median, mean);
+        int mv = 0;
+        if (!s_cali_ok || adc_cali_raw_to_voltage(s_cali, raw, &mv) != ESP_OK) {
+            mv = (raw * LDR_VREF_MV + LDR_RAW_MAX / 2) / LDR_RAW_MAX;
+        }
+
+        portENTER_CRITICAL(&s_lock);
+        s_last.raw        = raw;
+        s_last.mv         = (uint16_t)mv;
+        s_last.calibrated = s_cali_ok;
+        s_last.windows++;
+        s_last.samples    = n;
+        s_last.overflows  = s_overflows;
+        s_has_last        = true;
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+esp_err_t ldr_adc_init(const ldr_adc_config_t *cfg) {
+    s_cfg = *cfg;
+    if (s_cfg.sample_hz < SOC_ADC_SAMPLE_FREQ_THRES_LOW)  s_cfg.sample_hz = SOC_ADC_SAMPLE_FREQ_THRES_LOW;
+    if (s_cfg.sample_hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) s_cfg.sample_hz = SOC_ADC_SAMPLE_FREQ_THRES_HIGH;
+    if (s_cfg.window_ms < 10) s_cfg.window_ms = 10;
+    ldr_median_init(&s_median, s_cfg.median_len);
+
+    // pool DMA phải chứa đủ 1 cửa sổ (+ dự phòng 1 cửa sổ nếu task bị trễ)
+    uint32_t win_bytes = s_cfg.sample_hz / 1000 * s_cfg.window_ms * SOC_ADC_DIGI_RESULT_BYTES;
+    uint32_t pool = ((2 * win_bytes + LDR_FRAME_BYTES - 1) / LDR_FRAME_BYTES) * LDR_FRAME_BYTES;
+    if (pool > LDR_POOL_MAX) {
+        ESP_LOGW(TAG, "Pool %uB > %uB, sẽ mất mẫu mỗi cửa sổ - giảm sample_hz/window_ms",
+                 (unsigned)pool, (unsigned)LDR_POOL_MAX);
+        pool = LDR_POOL_MAX;
+    }
+
+    adc_continuous_handle_cfg_t hcfg = {
+        .max_store_buf_size = pool,
+        .conv_frame_size    = LDR_FRAME_BYTES,
+    };
+    esp_err_t err = adc_continuous_new_handle(&hcfg, &s_adc);
+    if (err != ESP_OK) return err;
+
+    adc_digi_pattern_config_t pattern = {
+        .atten     = LDR_ATTEN,
+        .channel   = s_cfg.channel & 0x7,
+        .unit      = ADC_UNIT_1,
+        .bit_width = ADC_BITWIDTH_12,
+    };
+    adc_continuous_config_t dcfg = {
+        .pattern_num    = 1,
+        .adc_pattern    = &pattern,
+        .sample_freq_hz = s_cfg.sample_hz,
+        .conv_mode      = ADC_CONV_SINGLE_UNIT_1,
+        .format         = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    err = adc_continuous_config(s_adc, &dcfg);
+    if (err != ESP_OK) return err;
+
+    adc_continuous_evt_cbs_t cbs = { .on_pool_ovf = _poolOvf };
+    err = adc_continuous_register_event_callbacks(s_adc, &cbs, NULL);
+    if (err != ESP_OK) return err;
+
+    _caliInit();
+
+    err = adc_continuous_start(s_adc);
+    if (err != ESP_OK) return err;
+
+    ESP_LOGI(TAG, "ch=%d, %uHz, window=%ums, median=%u, pool=%uB",
+             (int)s_cfg.channel, (unsigned)s_cfg.sample_hz, (unsigned)s_cfg.window_ms,
+             (unsigned)s_median.size, (unsigned)pool);
+    xTaskCreate(ldr_task, "ldr_adc", LDR_TASK_STACK, NULL, LDR_TASK_PRIO, NULL);
+    return ESP_OK;
+}
+
+bool ldr_adc_get(ldr_reading_t *out) {
+    portENTER_CRITICAL(&s_lock);
+    bool ok = s_has_last;
+    *out = s_last;
+    portEXIT_CRITICAL(&s_lock);
+    return ok;
+}
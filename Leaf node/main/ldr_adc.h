@@ -0,0 +1,33 @@
+#ifndef LDR_ADC_H_
+#define LDR_ADC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_adc/adc_continuous.h"
+
+// ==== LDR qua ADC continuous (DMA) ====
+// DMA lấy mẫu liên tục, task nền gom mỗi window_ms thành 1 giá trị trung bình
+// rồi lấy trung vị median_len cửa sổ gần nhất, đổi sang mV bằng hiệu chuẩn eFuse.
+typedef struct {
+    adc_channel_t channel;
+    uint32_t      sample_hz;    // kẹp về [SOC_ADC_SAMPLE_FREQ_THRES_LOW, HIGH]
+    uint32_t      window_ms;    // 100ms = 5 chu kỳ điện 50Hz, triệt nhấp nháy đèn
+    uint8_t       median_len;   // lẻ, <= LDR_MEDIAN_MAX
+} ldr_adc_config_t;
+
+typedef struct {
+    uint16_t raw;           // đã lọc, 12-bit
+    uint16_t mv;
+    bool     calibrated;    // false: mv ước lượng từ Vref 3.3V (chip không có eFuse)
+    uint32_t windows;       // số cửa sổ đã xử lý
+    uint32_t samples;       // số mẫu trong cửa sổ gần nhất
+    uint32_t overflows;     // pool DMA đầy (task gom không kịp)
+} ldr_reading_t;
+
+esp_err_t ldr_adc_init(const ldr_adc_config_t *cfg);
+
+// false nếu chưa có cửa sổ nào
+bool ldr_adc_get(ldr_reading_t *out);
+
+#endif /* LDR_ADC_H_ */
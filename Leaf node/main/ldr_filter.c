@@ -0,0 +1,55 @@
+#include <string.h>
+#include "ldr_filter.h"
+
+uint32_t ldr_sum_u16(const uint16_t *x, size_t n) {
+    uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        s0 += x[i];
+        s1 += x[i + 1];
+        s2 += x[i + 2];
+        s3 += x[i + 3];
+    }
+    for (; i < n; i++) s0 += x[i];
+    return s0 + s1 + s2 + s3;
+}
+
+uint16_t ldr_mean_u16(const uint16_t *x, size_t n) {
+    if (n == 0) return 0;
+    return (uint16_t)((ldr_sum_u16(x, n) + n / 2) / n);
+}
+
+uint16_t ldr_median_u16(uint16_t *x, size_t n) {
+    if (n == 0) return 0;
+
+    for (size_t i = 1; i < n; i++) {
+        uint16_t v = x[i];
+        size_t j = i;
+        while (j > 0 && x[j - 1] > v) {
+            x[j] = x[j - 1];
+            j--;
+        }
+        x[j] = v;
+    }
+    // n chẵn: trung bình 2 phần tử giữa
+    if (n & 1) return x[n / 2];
+    return (uint16_t)(((uint32_t)x[n / 2 - 1] + x[n / 2] + 1) / 2);
+}
+
+void ldr_median_init(ldr_median_t *m, uint8_t size) {
+    memset(m, 0, sizeof(*m));
+    if (size > LDR_MEDIAN_MAX) size = LDR_MEDIAN_MAX;
+    if (size == 0) size = 1;
+    m->size = size | 1;     // LDR_MEDIAN_MAX lẻ nên không vượt quá
+}
+
+uint16_t ldr_median_push(ldr_median_t *m, uint16_t v) {
+    m->v[m->pos] = v;
+    m->pos = (uint8_t)((m->pos + 1) % m->size);
+    if (m->count < m->size) m->count++;
+
+    uint16_t tmp[LDR_MEDIAN_MAX];
+    memcpy(tmp, m->v, m->count * sizeof(tmp[0]));
+    return ldr_median_u16(tmp, m->count);
+}
@@ -0,0 +1,32 @@
+#ifndef LDR_FILTER_H_
+#define LDR_FILTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ==== Bộ lọc cho mẫu ADC của LDR (không phụ thuộc ESP-IDF) ====
+// Mỗi cửa sổ DMA được gộp bằng trung bình (boxcar), sau đó lấy trung vị
+// của LDR_MEDIAN_MAX cửa sổ gần nhất để loại gai.
+#define LDR_MEDIAN_MAX  9
+
+// Tổng n mẫu, cộng 4 mẫu mỗi vòng để compiler giữ được trong thanh ghi
+uint32_t ldr_sum_u16(const uint16_t *x, size_t n);
+
+// Trung bình làm tròn, 0 nếu n = 0
+uint16_t ldr_mean_u16(const uint16_t *x, size_t n);
+
+// Trung vị, sắp xếp tại chỗ x (insertion sort - chỉ dùng cho n nhỏ)
+uint16_t ldr_median_u16(uint16_t *x, size_t n);
+
+typedef struct {
+    uint16_t v[LDR_MEDIAN_MAX];
+    uint8_t  size;      // độ dài cửa sổ (lẻ, <= LDR_MEDIAN_MAX)
+    uint8_t  count;     // số phần tử đã có
+    uint8_t  pos;
+} ldr_median_t;
+
+void     ldr_median_init(ldr_median_t *m, uint8_t size);
+// Đưa 1 giá trị vào, trả về trung vị của cửa sổ hiện tại
+uint16_t ldr_median_push(ldr_median_t *m, uint16_t v);
+
+#endif /* LDR_FILTER_H_ */
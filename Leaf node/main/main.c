@@ -4,6 +4,9 @@
 #include <stdlib.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
 #include "esp_log.h"
 #include "esp_event.h"
 #include "esp_netif.h"
@@ -11,13 +14,26 @@
 #include "esp_mesh.h"
 #include "esp_mesh_internal.h"
 #include "driver/gpio.h"
-#include "driver/adc.h"        
 #include "nvs_flash.h"
+#include "nvs.h"
 #include "esp_mac.h"
 #include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
 
-#include "cJSON.h"
+#include "telemetry.h"
+#include "motion.h"
+#include "report_policy.h"
 #include "esp32-dht11.h"
+#include "ldr_adc.h"
+#include "parent_scan.h"
+#include "parent_select.h"
+#include "link.h"
+#include "cmd.h"
+#include "tsync.h"
+#include "congest.h"
+#include "series.h"
+#include "time_sync.h"
 #include "ssd1306.h"
 
 
@@ -27,12 +43,27 @@
 #pragma GCC diagnostic pop
 
 #define TAG "LEAF_NODE"
-#define Vref 3.3f
+#define NODE_ID             1                 // "Leaf_01"
 
 
 #define DHT_PIN             GPIO_NUM_4
 #define PIR_PIN             GPIO_NUM_27
-#define LDR_ADC_CHANNEL     ADC1_CHANNEL_6   // GPIO34 
+#define LDR_ADC_CHANNEL     ADC_CHANNEL_6    // ADC1, GPIO34
+#define LDR_SAMPLE_HZ       20000             // mức thấp nhất của DMA trên ESP32
+#define LDR_WINDOW_MS       100
+#define LDR_MEDIAN_LEN      5
+
+#define PIR_DEBOUNCE_US     50000             // cạnh cách cạnh trước < 50ms: đọc lại chân khi hết cửa sổ
+#define MOTION_QUEUE_LEN    8
+#define MOTION_PENDING      8                 // số sự kiện chờ ACK để đo RTT
+
+#define POLICY_NVS_NS       "leaf"
+#define POLICY_NVS_KEY      "report_pol"
+#define POLICY_STATS_EVERY  60                // log tỉ lệ gửi sau mỗi N mẫu
+
+#define REJOIN_NVS_KEY      "rejoin"
+#define REJOIN_VERSION      1
+#define FAST_REJOIN_MS      3000              // nối parent cũ không được -> scan
 
 
 static const uint8_t MESH_ID[6] = { 0x7A, 0x10, 0x20, 0x30, 0x40, 0x50 };
@@ -40,14 +71,27 @@ static const uint8_t MESH_ID[6] = { 0x7A, 0x10, 0x20, 0x30, 0x40, 0x50 };
 #define ROUTER_PASS         "TinhHoa978"
 #define ROUTER_CHANNEL      0                 // auto
 
-//SoftAP MAC (BSSID) của Relay A/B 
-static const uint8_t RELAY_A_BSSID[6] = { 0x88,0x57,0x21,0xB3,0x56,0xF5 };
-static const uint8_t RELAY_B_BSSID[6] = { 0x00,0x70,0x07,0x7E,0x6F,0xBD }; 
+// Parent = relay cùng mesh ID, học từ vendor IE khi scan (không cố định BSSID)
+#define ENABLE_AUTO_FALLBACK  0   // 1 = nếu không thấy relay sau N lần -> bật self-organized
+#define FALLBACK_WAIT_SCANS  20   // số vòng quét trước khi fallback
+#define PARENT_RETRY_MS    1000   // nghỉ giữa 2 vòng quét toàn băng
+#define PARENT_EVAL_MS    60000   // đang có parent: quét kênh hiện tại để cân bằng tải
+#define PARENT_SWITCH_MS   8000   // chủ động đổi parent mà chưa nối được -> tìm lại
+#define PARENT_MGR_QUEUE_LEN  8
 
+// 1 = telemetry/link gửi cho parent để relay gộp batch (Parent node RELAY_AGGREGATE),
+// 0 = gửi thẳng root. Motion + ACK lệnh luôn đi thẳng root vì cần trễ thấp.
+#define LEAF_UPLINK_VIA_PARENT  1
 
-#define ONLY_USE_RELAY_A      0   // 1 = CHỈ dùng Relay A (không xét B)
-#define ENABLE_AUTO_FALLBACK  0   // 1 = nếu không thấy A/B sau N lần -> bật self-organized
-#define FALLBACK_WAIT_SCANS  20   // số vòng quét trước khi fallback
+// 1 = lấy mẫu/gửi tại slot root cấp (kèm beacon thời gian) thay vì cứ sample_ms tính từ boot,
+// tránh các leaf boot cùng lúc gửi cùng pha vào 1 relay / root. Chưa có slot -> như cũ.
+#define LEAF_SLOTTED_TX         1
+
+// > 1: gom N mẫu telemetry vào 1 frame SERIES (series.h) cho triển khai chịu được trễ vài
+// chục giây, bớt N-1 header mesh + airtime. Mẫu cũ nhất chờ quá LEAF_SERIES_MAX_AGE_MS
+// hoặc lệnh read_now thì gửi luôn. 0/1 = mỗi mẫu 1 frame telemetry như cũ.
+#define LEAF_SERIES_SAMPLES     0
+#define LEAF_SERIES_MAX_AGE_MS  60000
 
 
 static uint8_t           tx_buf[256];
@@ -60,20 +104,126 @@ static volatile bool     g_root_addr_ok = false;
 
 static mesh_addr_t       g_parent_bssid = {0};
 static mesh_addr_t       g_mesh_id_addr = { .addr = {0} };
-static bool              g_mesh_started  = false;
 
-static volatile bool     g_reselect_task_running = false;
+// Quản lý parent: event mesh / SCAN_DONE -> queue -> parent_mgr_task
+typedef enum {
+    PM_EV_LOST = 0,         // boot, mất parent hoặc NO_PARENT_FOUND
+    PM_EV_CONNECTED,
+    PM_EV_ROOT,             // có địa chỉ root từ MESH_EVENT_ROOT_ADDRESS
+    PM_EV_SCAN_DONE,
+} pm_event_t;
+
+typedef enum {
+    PM_T_NONE = 0,
+    PM_T_RETRY,             // quét lại toàn băng
+    PM_T_EVAL,              // đánh giá lại parent hiện tại
+    PM_T_SWITCH,            // hết hạn chờ parent mới
+} pm_timer_t;
+
+static QueueHandle_t     g_pm_q;
+static volatile bool     g_pm_searching = false;
+static uint8_t           g_parent_channel = 0;     // kênh parent gần nhất, 0 = chưa biết
+static parent_select_t   g_ps;                     // chỉ parent_mgr_task truy cập
+
+// Parent/kênh/root lần nối tốt gần nhất, lưu NVS để boot nối thẳng không cần scan
+typedef struct {
+    uint16_t version;
+    bool     has_parent;
+    bool     has_root;
+    ps_obs_t parent;
+    uint8_t  root[6];
+} rejoin_cache_t;
 
+static rejoin_cache_t    g_rejoin;
 
+// Mốc thời gian boot (us từ lúc chip chạy), đo power-on -> mẫu đầu tiên
 typedef struct {
-    uint8_t bssid[6];
-    char    ssid[33];
-    uint8_t channel;
-    int8_t  rssi;
-} mesh_parent_t;
+    int64_t app_main;
+    int64_t mesh_started;
+    int64_t parent;
+    int64_t root;
+    int64_t first_tx;
+    bool    fast_rejoin;
+    bool    root_cached;    // mẫu đầu gửi bằng địa chỉ root trong cache
+} boot_times_t;
+
+static boot_times_t      g_boot;
+
+// PARENT_CONNECTED / ROOT_ADDRESS -> send_sensor_task lúc boot. Không dùng task notify:
+// notify của task đó dành cho DHT11 báo đọc xong, event mesh đến giữa lúc capture sẽ
+// cắt ngang lần chờ và lấy nhầm mẫu của chu kỳ trước.
+#define TX_READY_BIT            (1u << 0)
+static EventGroupHandle_t g_tx_ready;
+
+// Thời gian nối lại parent, gửi cho root qua frame MESH_MSG_LINK
+static int64_t           g_lost_us = 0;            // 0 = không trong vòng tìm parent
+static link_stats_t      g_link = { .node_id = NODE_ID };
+static volatile bool     g_link_dirty = false;
+static uint32_t          g_round_scans_base = 0;
+
+// PIR: ISR -> queue -> motion_send_task
+typedef struct {
+    int64_t t_edge_us;
+    uint8_t level;
+} motion_evt_t;
+
+typedef struct {
+    uint16_t seq;
+    int64_t  t_edge_us;
+    int64_t  t_send_us;
+} motion_pending_t;
+
+static QueueHandle_t     g_motion_q;
+static volatile int      s_pir_level = 0;
+static volatile bool     s_pir_latched = false;  // có chuyển động kể từ lần lấy mẫu trước
+static int64_t           s_pir_last_edge_us = 0;
+static int64_t           s_pir_deferred_us = 0;  // cạnh đầu tiên bị hoãn trong cửa sổ, 0 = không có
+static esp_timer_handle_t s_pir_timer;           // đọc lại chân khi hết cửa sổ chống dội
+static portMUX_TYPE      s_pir_mux = portMUX_INITIALIZER_UNLOCKED;
+static motion_pending_t  s_motion_pending[MOTION_PENDING];
+static volatile uint32_t g_motion_latency_us = 0;  // cạnh -> root của sự kiện gần nhất
+
+// Chính sách báo cáo: send_sensor_task sở hữu g_policy. g_policy_pending = bản cấu hình mới nhất,
+// ghi/đọc cả struct + cờ trong g_policy_mux (cfg ~56 byte, không copy nguyên tử được)
+static report_policy_t     g_policy;
+static report_policy_cfg_t g_policy_pending;
+static bool                g_policy_changed = false;
+static portMUX_TYPE        g_policy_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Lệnh từ root: mesh_rx_task chỉ đặt cờ + đánh thức, không chờ chu kỳ lấy mẫu
+static SemaphoreHandle_t   g_sensor_wake;              // ngủ giữa 2 mẫu, give = lấy mẫu ngay
+static volatile bool       g_force_report = false;
+
+// Mesh time từ beacon root: mesh_rx_task cập nhật, send_sensor_task đọc (64 bit -> spinlock)
+static time_sync_t         g_tsync;
+static portMUX_TYPE        g_tsync_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint16_t   g_tx_slot;                  // (slot << 8) | slots, 0 = chưa được cấp
+
+// Root báo nghẽn: giãn chu kỳ lấy mẫu CONG_STRETCH(level) lần tới khi level về 0 / hết hạn
+static volatile uint8_t    g_cong_level = 0;
+static volatile uint32_t   g_cong_until_ms = 0;
+
+// Gom mẫu (LEAF_SERIES_SAMPLES), chỉ send_sensor_task truy cập
+static series_builder_t    s_series;
+static uint8_t             s_series_buf[SERIES_FRAME_MAX];
+static uint16_t            s_series_seq;               // seq mẫu đầu
+static uint8_t             s_series_flags;
+static uint32_t            s_series_since_ms;          // đồng hồ local lúc thêm mẫu đầu
+
+
+// false nếu chưa nhận beacon nào
+static bool leaf_mesh_time(int64_t local_us, int64_t *mesh_us)
+{
+    portENTER_CRITICAL(&g_tsync_mux);
+    bool ok = g_tsync.synced;
+    if (ok) *mesh_us = time_sync_now(&g_tsync, local_us);
+    portEXIT_CRITICAL(&g_tsync_mux);
+    return ok;
+}
 
-static inline bool bssid_is_nonzero(const uint8_t b[6]) {
-    return b[0]|b[1]|b[2]|b[3]|b[4]|b[5];
+static inline uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
 }
 
 // mở kênh 1-13 và băng thông 20MHz
@@ -92,16 +242,80 @@ static void try_set_bandwidth(void)
     if (mode & WIFI_MODE_AP)  esp_wifi_set_bandwidth(WIFI_IF_AP,  WIFI_BW_HT20);
 }
 
+// Nhận mức mới (gọi trong critical section). Trả về false nếu mức không đổi.
+static bool IRAM_ATTR pir_accept(int level, int64_t t_edge_us, int64_t now, motion_evt_t *ev)
+{
+    s_pir_deferred_us = 0;
+    if (level == s_pir_level) return false;
+    s_pir_level = level;
+    s_pir_last_edge_us = now;
+    if (level) s_pir_latched = true;
+    *ev = (motion_evt_t){ .t_edge_us = t_edge_us, .level = (uint8_t)level };
+    return true;
+}
+
+// Bắt cạnh PIR, đóng dấu thời gian và chống dội; xử lý ở motion_send_task.
+// Cạnh trong cửa sổ chống dội không bị bỏ hẳn: hẹn timer đọc lại chân khi hết cửa sổ,
+// nếu không glitch ngắn (lên rồi xuống trong 50ms) sẽ để s_pir_level kẹt ở 1.
+static void IRAM_ATTR pir_isr(void *arg)
+{
+    int64_t now = esp_timer_get_time();
+    int level = gpio_get_level(PIR_PIN);
+    motion_evt_t ev;
+    bool send = false;
+    int64_t wait_us = 0;
+
+    portENTER_CRITICAL_ISR(&s_pir_mux);
+    if (now - s_pir_last_edge_us < PIR_DEBOUNCE_US) {
+        if (!s_pir_deferred_us) {
+            s_pir_deferred_us = now;
+            wait_us = s_pir_last_edge_us + PIR_DEBOUNCE_US - now;
+        }
+    } else {
+        send = pir_accept(level, now, now, &ev);
+    }
+    portEXIT_CRITICAL_ISR(&s_pir_mux);
+
+    if (wait_us > 0) esp_timer_start_once(s_pir_timer, (uint64_t)wait_us);
+    if (!send) return;
+    BaseType_t woken = pdFALSE;
+    xQueueSendFromISR(g_motion_q, &ev, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+// Hết cửa sổ chống dội: mức chân khác mức đã nhận -> coi như cạnh, tính từ cạnh bị hoãn
+static void pir_resample_cb(void *arg)
+{
+    int64_t now = esp_timer_get_time();
+    int level = gpio_get_level(PIR_PIN);
+    motion_evt_t ev;
+
+    portENTER_CRITICAL(&s_pir_mux);
+    int64_t t_edge = s_pir_deferred_us ? s_pir_deferred_us : now;
+    bool send = pir_accept(level, t_edge, now, &ev);
+    portEXIT_CRITICAL(&s_pir_mux);
+
+    if (send) xQueueSend(g_motion_q, &ev, 0);
+}
+
 static void pir_init(void)
 {
+    g_motion_q = xQueueCreate(MOTION_QUEUE_LEN, sizeof(motion_evt_t));
+
     gpio_config_t io_conf = {
         .pin_bit_mask = (1ULL << PIR_PIN),
         .mode = GPIO_MODE_INPUT,
         .pull_up_en = GPIO_PULLUP_DISABLE,
         .pull_down_en = GPIO_PULLDOWN_ENABLE,
-        .intr_type = GPIO_INTR_DISABLE
+        .intr_type = GPIO_INTR_ANYEDGE
     };
     gpio_config(&io_conf);
+    s_pir_level = gpio_get_level(PIR_PIN);
+
+    const esp_timer_create_args_t targs = { .callback = pir_resample_cb, .name = "pir_debounce" };
+    ESP_ERROR_CHECK(esp_timer_create(&targs, &s_pir_timer));
+    ESP_ERROR_CHECK(gpio_install_isr_service(0));
+    ESP_ERROR_CHECK(gpio_isr_handler_add(PIR_PIN, pir_isr, NULL));
 }
 
 static void log_path(void)
@@ -112,70 +326,32 @@ static void log_path(void)
 }
 
 
-static bool find_best_parent(mesh_parent_t *out)
+// Đưa kết quả scan vào bảng ứng viên: chỉ AP có IE đúng mesh ID và nhận được child
+static void learn_candidates(uint32_t now_ms)
 {
-    //Scan blocking. task đang gọi sẽ bị “chặn” (block) đến khi firmware quét xong tất cả kênh.
-    wifi_scan_config_t sc = { .ssid=0, .bssid=0, .channel=0, .show_hidden=true };
-    ESP_ERROR_CHECK(esp_wifi_scan_start(&sc, true));
-
-    //Lấy số lượng AP rồi cấp phát đúng size
-    uint16_t ap_num = 0;
-    ESP_ERROR_CHECK(esp_wifi_scan_get_ap_num(&ap_num));
-    if (ap_num == 0) {
-        ESP_LOGI(TAG, "Scan xong: KHÔNG thấy AP nào");
-        return false;
-    }
-
-    wifi_ap_record_t *recs = (wifi_ap_record_t*)calloc(ap_num, sizeof(wifi_ap_record_t));
-    if (!recs) {
-        ESP_LOGE(TAG, "calloc ap records fail");
-        return false;
-    }
-
-    uint16_t n = ap_num;
-    esp_err_t e = esp_wifi_scan_get_ap_records(&n, recs);
-    if (e != ESP_OK) {
-        ESP_LOGE(TAG, "esp_wifi_scan_get_ap_records err: %s", esp_err_to_name(e));
-        free(recs);
-        return false;
-    }
-
-    bool needA = bssid_is_nonzero(RELAY_A_BSSID);
-    bool needB = (!ONLY_USE_RELAY_A) && bssid_is_nonzero(RELAY_B_BSSID);
-
-    bool seenA = false, seenB = false;
-    wifi_ap_record_t recA = {0}, recB = {0};
-
-    for (int i = 0; i < n; ++i) {
-        if (needA && !memcmp(recs[i].bssid, RELAY_A_BSSID, 6)) { recA = recs[i]; seenA = true; }
-        if (needB && !memcmp(recs[i].bssid, RELAY_B_BSSID, 6)) { recB = recs[i]; seenB = true; }
-    }
-
-    if (!seenA && !seenB) {
-        ESP_LOGI(TAG, "Scan xong: KHÔNG thấy Relay A/B");
-        free(recs);
-        return false;
+    const parent_scan_ap_t *aps;
+    uint16_t n = parent_scan_results(&aps);
+
+    for (int i = 0; i < n; i++) {
+        const parent_scan_ap_t *ap = &aps[i];
+        if (!ap->has_ie || memcmp(ap->assoc.mesh_id, MESH_ID, 6)) continue;
+        // root chỉ 2 slot dành cho relay, leaf không nhận child
+        if (ap->assoc.mesh_type != MESH_NODE) continue;
+
+        ps_obs_t o = {
+            .channel   = ap->rec.primary,
+            .rssi      = ap->rec.rssi,
+            .layer     = ap->assoc.layer,
+            .assoc     = ap->assoc.assoc,
+            .assoc_cap = ap->assoc.assoc_cap,
+        };
+        memcpy(o.bssid, ap->rec.bssid, 6);
+        strlcpy(o.ssid, (const char*)ap->rec.ssid, sizeof(o.ssid));
+        ps_observe(&g_ps, &o, now_ms);
     }
-
-    const wifi_ap_record_t *best = NULL;
-    if (seenA && seenB) best = (recA.rssi >= recB.rssi) ? &recA : &recB;
-    else if (seenA)     best = &recA;
-    else                best = &recB;
-
-    memset(out, 0, sizeof(*out));
-    memcpy(out->bssid, best->bssid, 6);
-    strlcpy(out->ssid, (const char*)best->ssid, sizeof(out->ssid));
-    out->channel = best->primary;
-    out->rssi    = best->rssi;
-
-    ESP_LOGI(TAG, "Chọn parent: SSID=\"%s\", BSSID=" MACSTR ", ch=%u, RSSI=%d",
-             out->ssid, MAC2STR(out->bssid), out->channel, out->rssi);
-
-    free(recs);
-    return true;
 }
 
-static void set_parent_to_candidate(const mesh_parent_t *cand)
+static void set_parent_to_candidate(const ps_obs_t *cand)
 {
     wifi_config_t p = {0};
     strlcpy((char*)p.sta.ssid,     cand->ssid,          sizeof(p.sta.ssid));
@@ -187,58 +363,28 @@ static void set_parent_to_candidate(const mesh_parent_t *cand)
     p.sta.threshold.authmode = WIFI_AUTH_OPEN;           // cho phép kết nối AP OPEN
     memset(p.sta.password, 0, sizeof(p.sta.password));   // OPEN => không mật khẩu
 
-    esp_err_t err = esp_mesh_set_parent(&p, &g_mesh_id_addr, MESH_LEAF, 3);
+    esp_err_t err = esp_mesh_set_parent(&p, &g_mesh_id_addr, MESH_LEAF, cand->layer + 1);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "esp_mesh_set_parent fail: %s", esp_err_to_name(err));
         return;
     }
-    ESP_LOGI(TAG, "set_parent OK -> " MACSTR " (SSID=%s, ch=%u)",
-             MAC2STR(cand->bssid), cand->ssid, cand->channel);
+    ESP_LOGI(TAG, "set_parent OK -> " MACSTR " (SSID=%s, ch=%u, RSSI=%d, layer=%u, assoc=%u/%u)",
+             MAC2STR(cand->bssid), cand->ssid, cand->channel, cand->rssi,
+             cand->layer, cand->assoc, cand->assoc_cap);
 }
 
 
-static void reselect_parent_task(void *arg) {
-    g_reselect_task_running = true;
-
-    mesh_parent_t cand;
-    int tries = 0;
-
-    while (!find_best_parent(&cand)) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        if (++tries >= FALLBACK_WAIT_SCANS) break;
-    }
-
-    if (tries < FALLBACK_WAIT_SCANS) {
-        set_parent_to_candidate(&cand);
-        if (g_mesh_started && !g_mesh_connected) {
-            ESP_LOGW(TAG, "Restart mesh để áp dụng parent mới");
-            esp_mesh_stop();
-            vTaskDelay(pdMS_TO_TICKS(150));
-            esp_mesh_start();
-        }
-    }
-#if ENABLE_AUTO_FALLBACK
-    else {
-        ESP_LOGW(TAG, "Không thấy Relay A/B sau %d lần -> bật self-organized (fallback) & start mesh", tries);
-        esp_mesh_set_self_organized(true, true);
-        if (!g_mesh_started) {
-            esp_mesh_start();
-            g_mesh_started = true;
-        }
-    }
-#endif
-
-    g_reselect_task_running = false;
-    vTaskDelete(NULL);
+// event loop -> parent_mgr_task, không làm việc nặng trong handler
+static void pm_post(pm_event_t ev)
+{
+    if (g_pm_q) xQueueSend(g_pm_q, &ev, 0);
 }
 
-static void schedule_reselect_parent(void) {
-    if (!g_reselect_task_running) {
-        xTaskCreate(reselect_parent_task, "reselect_parent", 4096, NULL, 5, NULL);
-    }
+static void on_scan_done(uint16_t num, uint8_t channel, void *ctx)
+{
+    pm_post(PM_EV_SCAN_DONE);
 }
 
-
 static void mesh_event_handler(void *arg, esp_event_base_t base, int32_t id, void *event_data)
 {
     switch (id) {
@@ -250,24 +396,45 @@ static void mesh_event_handler(void *arg, esp_event_base_t base, int32_t id, voi
         ESP_LOGI(TAG, "PARENT_CONNECTED: " MACSTR ", layer:%d",
                  MAC2STR(g_parent_bssid.addr), connected->self_layer);
 
-        wifi_ap_record_t ap_info;
+        wifi_ap_record_t ap_info = {0};
         if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
             ESP_LOGI(TAG, "Parent RSSI: %d dBm", ap_info.rssi);
+            g_parent_channel = ap_info.primary;
         }
+
+        if (g_lost_us) {
+            parent_scan_stats_t ss;
+            parent_scan_get_stats(&ss);
+            g_link.reconnect_ms = (uint32_t)((esp_timer_get_time() - g_lost_us) / 1000);
+            g_link.scans        = (uint16_t)(ss.scans - g_round_scans_base);
+            g_link.rssi         = ap_info.rssi;
+            g_link.layer        = (uint8_t)connected->self_layer;
+            g_lost_us = 0;
+            g_link_dirty = true;
+            ESP_LOGI(TAG, "Time-to-reconnect: %ums, %u scan (last scan %ums)",
+                     (unsigned)g_link.reconnect_ms, g_link.scans, (unsigned)ss.last_scan_ms);
+        }
+        if (!g_boot.parent) g_boot.parent = esp_timer_get_time();
+        pm_post(PM_EV_CONNECTED);
+        if (g_root_addr_ok) xEventGroupSetBits(g_tx_ready, TX_READY_BIT);
         try_set_bandwidth();
         log_path(); // dùng để tránh -Wunused-function
         break;
     }
     case MESH_EVENT_PARENT_DISCONNECTED:
+        if (g_mesh_connected) {
+            g_lost_us = esp_timer_get_time();
+            g_link.reconnects++;
+        }
         g_mesh_connected = false;
         ESP_LOGW(TAG, "PARENT_DISCONNECTED -> reselect");
-        schedule_reselect_parent();
+        pm_post(PM_EV_LOST);
         break;
 
     case MESH_EVENT_NO_PARENT_FOUND: {
         mesh_event_no_parent_found_t *e = (mesh_event_no_parent_found_t*)event_data;
         ESP_LOGW(TAG, "NO_PARENT_FOUND scan=%d -> reselect", e->scan_times);
-        schedule_reselect_parent();
+        pm_post(PM_EV_LOST);
         break;
     }
     case MESH_EVENT_LAYER_CHANGE: {
@@ -279,7 +446,10 @@ static void mesh_event_handler(void *arg, esp_event_base_t base, int32_t id, voi
         const mesh_event_root_address_t *e = (const mesh_event_root_address_t *)event_data;
         memcpy(g_root_addr.addr, e->addr, 6);
         g_root_addr_ok = true;
+        if (!g_boot.root) g_boot.root = esp_timer_get_time();
         ESP_LOGI(TAG, "Root MAC: " MACSTR, MAC2STR(g_root_addr.addr));
+        pm_post(PM_EV_ROOT);
+        if (g_mesh_connected) xEventGroupSetBits(g_tx_ready, TX_READY_BIT);
         break;
     }
     default:
@@ -288,26 +458,228 @@ static void mesh_event_handler(void *arg, esp_event_base_t base, int32_t id, voi
 }
 
 
+static void rejoin_load(void)
+{
+    size_t len = sizeof(g_rejoin);
+    nvs_handle_t h;
+    bool ok = false;
+
+    if (nvs_open(POLICY_NVS_NS, NVS_READONLY, &h) == ESP_OK) {
+        ok = nvs_get_blob(h, REJOIN_NVS_KEY, &g_rejoin, &len) == ESP_OK && len == sizeof(g_rejoin)
+             && g_rejoin.version == REJOIN_VERSION;
+        nvs_close(h);
+    }
+    if (!ok) {
+        memset(&g_rejoin, 0, sizeof(g_rejoin));
+        g_rejoin.version = REJOIN_VERSION;
+        return;
+    }
+    if (g_rejoin.has_parent) g_parent_channel = g_rejoin.parent.channel;
+    ESP_LOGI(TAG, "Rejoin cache: parent=" MACSTR " ch=%u, root=" MACSTR "%s",
+             MAC2STR(g_rejoin.parent.bssid), g_rejoin.parent.channel,
+             MAC2STR(g_rejoin.root), g_rejoin.has_root ? "" : " (none)");
+}
+
+// Chỉ ghi khi đổi để tránh mòn flash (parent_mgr_task gọi)
+static void rejoin_save(const rejoin_cache_t *next)
+{
+    if (!memcmp(next, &g_rejoin, sizeof(g_rejoin))) return;
+    g_rejoin = *next;
+
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(POLICY_NVS_NS, NVS_READWRITE, &h);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(h, REJOIN_NVS_KEY, &g_rejoin, sizeof(g_rejoin));
+        if (err == ESP_OK) err = nvs_commit(h);
+        nvs_close(h);
+    }
+    if (err != ESP_OK) ESP_LOGW(TAG, "Lưu rejoin NVS fail: %s", esp_err_to_name(err));
+}
+
+static void log_boot_times(void)
+{
+#define BOOT_MS(t) ((t) ? (long)((t) / 1000) : -1L)
+    ESP_LOGI(TAG, "BOOT ms: app_main=%ld mesh=%ld parent=%ld root=%ld first_tx=%ld (fast_rejoin=%d, root_cached=%d)",
+             BOOT_MS(g_boot.app_main), BOOT_MS(g_boot.mesh_started), BOOT_MS(g_boot.parent),
+             BOOT_MS(g_boot.root), BOOT_MS(g_boot.first_tx), g_boot.fast_rejoin, g_boot.root_cached);
+#undef BOOT_MS
+}
+
+static void policy_load(void)
+{
+    report_policy_cfg_t cfg;
+    size_t len = sizeof(cfg);
+    nvs_handle_t h;
+    bool ok = false;
+
+    if (nvs_open(POLICY_NVS_NS, NVS_READONLY, &h) == ESP_OK) {
+        ok = nvs_get_blob(h, POLICY_NVS_KEY, &cfg, &len) == ESP_OK && len == sizeof(cfg)
+             && report_policy_validate(&cfg);
+        nvs_close(h);
+    }
+    if (!ok) report_policy_default(&cfg);
+    report_policy_init(&g_policy, &cfg);
+    g_policy_pending = cfg;
+    ESP_LOGI(TAG, "Report policy (%s): sample=%ums, heartbeat=%ums",
+             ok ? "NVS" : "default", (unsigned)cfg.sample_ms, (unsigned)cfg.sensor[RP_TEMP].max_interval_ms);
+}
+
+// Đổi chính sách lúc chạy: lưu NVS, send_sensor_task áp dụng ở chu kỳ kế tiếp
+esp_err_t leaf_set_report_policy(const report_policy_cfg_t *in)
+{
+    report_policy_cfg_t cfg = *in;
+    if (!report_policy_validate(&cfg)) return ESP_ERR_INVALID_ARG;
+
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(POLICY_NVS_NS, NVS_READWRITE, &h);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(h, POLICY_NVS_KEY, &cfg, sizeof(cfg));
+        if (err == ESP_OK) err = nvs_commit(h);
+        nvs_close(h);
+    }
+    if (err != ESP_OK) ESP_LOGW(TAG, "Lưu policy NVS fail: %s", esp_err_to_name(err));
+
+    portENTER_CRITICAL(&g_policy_mux);
+    g_policy_pending = cfg;
+    g_policy_changed = true;
+    portEXIT_CRITICAL(&g_policy_mux);
+    return ESP_OK;
+}
+
+// Đích của frame định kỳ: relay cha (gộp batch) hoặc root.
+// Địa chỉ mesh là MAC STA, BSSID parent là MAC softAP = MAC STA + 1.
+static void uplink_addr(mesh_addr_t *dest)
+{
+    if (!LEAF_UPLINK_VIA_PARENT || esp_mesh_get_layer() <= 2) {
+        memcpy(dest->addr, g_root_addr.addr, 6);
+        return;
+    }
+    memcpy(dest->addr, g_parent_bssid.addr, 6);
+    for (int i = 5; i >= 0; i--) {
+        if (dest->addr[i]-- != 0) break;
+    }
+}
+
+// Báo thời gian nối lại parent cho root (1 frame sau mỗi lần nối)
+static void send_link_stats(void)
+{
+    uint8_t buf[LINK_FRAME_LEN];
+    size_t len = link_encode(&g_link, buf, sizeof(buf));
+
+    mesh_data_t d = { .data = buf, .size = len, .proto = MESH_PROTO_BIN, .tos = MESH_TOS_P2P };
+    mesh_addr_t dest = {0};
+    uplink_addr(&dest);
+    if (esp_mesh_send(&dest, &d, MESH_DATA_P2P | MESH_DATA_NONBLOCK, NULL, 0) == ESP_OK) g_link_dirty = false;
+}
+
+// Ngủ tới mốc slot kế tiếp (hoặc sample_ms nếu chưa có slot/chưa đồng bộ),
+// lệnh read_now / đổi chu kỳ cắt ngang được
+static void sensor_sleep(void)
+{
+    uint32_t period_ms = g_policy.cfg.sample_ms;
+    uint8_t  level = g_cong_level;
+    if (level && (int32_t)(g_cong_until_ms - now_ms()) > 0) period_ms *= CONG_STRETCH(level);
+
+    int64_t wait_us = (int64_t)period_ms * 1000;
+#if LEAF_SLOTTED_TX
+    uint16_t slot = g_tx_slot;
+    int64_t mesh_us;
+    if ((slot & 0xff) && leaf_mesh_time(esp_timer_get_time(), &mesh_us)) {
+        wait_us = time_sync_slot_wait(mesh_us, period_ms, slot >> 8, slot & 0xff);
+    }
+#endif
+    // làm tròn lên tick để không thức trước mốc
+    xSemaphoreTake(g_sensor_wake, (TickType_t)((wait_us / 1000 + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS));
+}
+
+// Gửi các mẫu đang gom (nếu có) rồi mở frame mới
+static void series_flush(void)
+{
+    if (series_empty(&s_series)) return;
+
+    uint8_t count = s_series.count;
+    size_t  len   = series_finish(&s_series, NODE_ID, s_series_seq, s_series_flags);
+    mesh_data_t d = { .data = s_series_buf, .size = len, .proto = MESH_PROTO_BIN, .tos = MESH_TOS_P2P };
+    mesh_addr_t dest = {0};
+    uplink_addr(&dest);
+    esp_err_t err = esp_mesh_send(&dest, &d, MESH_DATA_P2P, NULL, 0);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Sent series " MACSTR ": seq=%u..%u, %uB (%u B/mẫu)", MAC2STR(dest.addr),
+                 s_series_seq, (uint16_t)(s_series_seq + count - 1), (unsigned)len, (unsigned)(len / count));
+    } else {
+        ESP_LOGE(TAG, "Mesh send series failed: %s (0x%x), bỏ %u mẫu", esp_err_to_name(err), err, count);
+    }
+    series_begin(&s_series, s_series_buf, sizeof(s_series_buf));
+}
+
+#if LEAF_SERIES_SAMPLES > 1
+// Thêm 1 mẫu vào frame SERIES, thời điểm theo mesh time nếu đã đồng bộ
+static void series_push(const telemetry_t *tlm, uint32_t local_ms)
+{
+    int64_t t_now = esp_timer_get_time(), mesh_now;
+    bool    synced = leaf_mesh_time(t_now, &mesh_now);
+    uint8_t flags  = synced ? SERIES_FLAG_SYNC : 0;
+    uint32_t t_ms  = (uint32_t)((synced ? mesh_now : t_now) / 1000);
+
+    // không trộn 2 gốc thời gian trong 1 frame
+    if (!series_empty(&s_series) && flags != s_series_flags) series_flush();
+    if (!series_add(&s_series, tlm, t_ms)) {
+        series_flush();
+        series_add(&s_series, tlm, t_ms);
+    }
+    if (s_series.count == 1) {
+        s_series_seq      = tlm->seq;
+        s_series_flags    = flags;
+        s_series_since_ms = local_ms;
+    }
+}
+#endif
+
 static void send_sensor_task(void *arg)
 {
-    while (!g_mesh_connected || !g_root_addr_ok) vTaskDelay(pdMS_TO_TICKS(300));
+    // event PARENT_CONNECTED / ROOT_ADDRESS đánh thức, không poll
+    while (!g_mesh_connected || !g_root_addr_ok) {
+        xEventGroupWaitBits(g_tx_ready, TX_READY_BIT, pdTRUE, pdFALSE, portMAX_DELAY);
+    }
     ESP_LOGI(TAG, "TX ready: layer=%u, root=" MACSTR, esp_mesh_get_layer(), MAC2STR(g_root_addr.addr));
 
+    uint16_t seq = 0;
+    series_begin(&s_series, s_series_buf, sizeof(s_series_buf));
+
     for (;;) {
-        // DHT11
-        struct dht11_reading dht = DHT11_read();
+        report_policy_cfg_t cfg;
+        portENTER_CRITICAL(&g_policy_mux);
+        bool changed = g_policy_changed;
+        if (changed) cfg = g_policy_pending;
+        g_policy_changed = false;
+        portEXIT_CRITICAL(&g_policy_mux);
+        if (changed) {
+            report_policy_apply(&g_policy, &cfg);
+            ESP_LOGI(TAG, "Report policy updated: sample=%ums", (unsigned)g_policy.cfg.sample_ms);
+        }
+        if (g_link_dirty && g_mesh_connected && g_root_addr_ok) send_link_stats();
+
+        // DHT11: RMT capture chạy nền trong lúc đọc PIR/LDR
+        ulTaskNotifyTake(pdTRUE, 0);
+        bool dht_pending = DHT11_start_read(xTaskGetCurrentTaskHandle()) == ESP_OK;
+
+        // PIR: mức hiện tại hoặc có cạnh lên trong chu kỳ vừa qua
+        int motion = gpio_get_level(PIR_PIN) || s_pir_latched;
+        s_pir_latched = false;
+
+        // LDR: giá trị đã lọc sẵn từ task ADC continuous, không đọc ADC ở đây
+        ldr_reading_t ldr;
+        bool  ldr_ok = ldr_adc_get(&ldr);
+        int   raw    = ldr.raw;
+        float vout   = ldr.mv / 1000.0f;
+        if (ldr_ok) ESP_LOGI(TAG, "Light raw=%d, Vout=%.3f V%s", raw, vout, ldr.calibrated ? "" : " (uncal)");
+
+        if (dht_pending) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DHT11_READ_TIMEOUT_MS + 30));
+        struct dht11_reading dht = DHT11_last_reading();
         int temp = 0, hum = 0;
         if (dht.status == DHT11_OK) { temp = dht.temperature; hum = dht.humidity; }
         else                        { ESP_LOGW(TAG, "DHT11 read error"); }
 
-        // PIR
-        int motion = gpio_get_level(PIR_PIN);
-
-        // LDR 
-        int   raw  = adc1_get_raw(LDR_ADC_CHANNEL);         
-        float vout = ((float)raw / 4095.0f) * Vref;        
-        ESP_LOGI(TAG, "Light raw=%d, Vout=%.2f V", raw, vout);
-
         // OLED 
         char line[24];
         ssd1306_clear(&oled);
@@ -317,27 +689,65 @@ static void send_sensor_task(void *arg)
         snprintf(line, sizeof(line), "Light:%.2fV", vout);ssd1306_display_text(&oled, 4, line, false);
         snprintf(line, sizeof(line), "Motion:%s", motion ? "YES" : "NO");
         ssd1306_display_text(&oled, 5, line, false);
+        size_t oled_bytes = ssd1306_flush(&oled);
+        ESP_LOGD(TAG, "OLED flush %uB", (unsigned)oled_bytes);
+
+        // Chỉ gửi khi có thay đổi đáng kể hoặc tới hạn heartbeat
+        uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+        int32_t  vals[RP_SENSOR_COUNT] = { temp, hum, raw, motion };
+        uint32_t valid = (1u << RP_MOTION);
+        if (ldr_ok)                 valid |= (1u << RP_LIGHT);
+        if (dht.status == DHT11_OK) valid |= (1u << RP_TEMP) | (1u << RP_HUMI);
+
+        uint32_t reason = report_policy_evaluate(&g_policy, now_ms, vals, valid);
+        if (g_force_report) {
+            g_force_report = false;
+            reason |= RP_REASON_FORCED;
+        }
+        if (g_policy.samples % POLICY_STATS_EVERY == 0) {
+            ESP_LOGI(TAG, "Report policy: sent %u/%u samples",
+                     (unsigned)g_policy.sent, (unsigned)g_policy.samples);
+        }
+        if (LEAF_SERIES_SAMPLES > 1 && !series_empty(&s_series) &&
+            now_ms - s_series_since_ms >= LEAF_SERIES_MAX_AGE_MS) {
+            series_flush();
+        }
+        if (reason == RP_REASON_NONE) {
+            sensor_sleep();
+            continue;
+        }
 
-        // JSON
-        cJSON *root = cJSON_CreateObject();
-        cJSON_AddStringToObject(root, "node_id", "Leaf_01");
-        cJSON_AddStringToObject(root, "role", "leaf");
-        cJSON_AddNumberToObject(root, "temp", temp);
-        cJSON_AddNumberToObject(root, "humi", hum);
-        cJSON_AddNumberToObject(root, "light_v", vout);
-        cJSON_AddNumberToObject(root, "light_raw", raw);
-        cJSON_AddNumberToObject(root, "motion", motion);
-
-        char *json_str = cJSON_PrintUnformatted(root);
-        size_t len = json_str ? strnlen(json_str, sizeof(tx_buf) - 1) : 0;
-        if (json_str && len > 0) {
-            memcpy(tx_buf, json_str, len);
-            tx_buf[len] = '\0';
-        } else {
-            const char *fallback = "{\"err\":\"json\"}";
-            len = strlen(fallback);
-            memcpy(tx_buf, fallback, len + 1);
+        // Frame nhị phân cố định 13 byte thay cho JSON
+        telemetry_t tlm = {
+            .node_id   = NODE_ID,
+            .seq       = seq,
+            .temp      = (int8_t)temp,
+            .humi      = (uint8_t)hum,
+            .light_raw = (uint16_t)raw,
+            .light_mv  = ldr.mv,
+            .motion    = (uint8_t)motion,
+            .flags     = (dht.status == DHT11_OK) ? TLM_FLAG_DHT_OK : 0,
+        };
+        if (ldr_ok && ldr.calibrated) tlm.flags |= TLM_FLAG_LIGHT_MV;
+#if LEAF_SERIES_SAMPLES > 1
+        // mẫu đã vào buffer coi như đã báo, read_now thì gửi ngay cả frame
+        series_push(&tlm, now_ms);
+        report_policy_commit(&g_policy, now_ms, vals, valid);
+        seq++;
+        if (s_series.count >= LEAF_SERIES_SAMPLES || (reason & RP_REASON_FORCED)) series_flush();
+        sensor_sleep();
+        continue;
+#endif
+        // timestamp + layer để root đo trễ theo số hop; đã đồng bộ thì gửi mesh time
+        int64_t t_tx = esp_timer_get_time(), mesh_tx;
+        tlm.flags |= TLM_FLAG_TX_TS;
+        tlm.layer  = (uint8_t)esp_mesh_get_layer();
+        tlm.tx_us  = (uint32_t)t_tx;
+        if (leaf_mesh_time(t_tx, &mesh_tx)) {
+            tlm.flags |= TLM_FLAG_TX_SYNC;
+            tlm.tx_us  = (uint32_t)mesh_tx;
         }
+        size_t len = telemetry_encode(&tlm, tx_buf, sizeof(tx_buf));
 
         data.data  = tx_buf;
         data.size  = len;
@@ -346,51 +756,366 @@ static void send_sensor_task(void *arg)
 
       
         mesh_addr_t dest = {0};
-        memcpy(dest.addr, g_root_addr.addr, 6);
+        uplink_addr(&dest);
         esp_err_t err = esp_mesh_send(&dest, &data, MESH_DATA_P2P, NULL, 0);
-        if (err == ESP_OK) ESP_LOGI(TAG, "Sent to ROOT " MACSTR ": %s", MAC2STR(dest.addr), (char*)data.data);
-        else               ESP_LOGE(TAG, "Mesh send failed: %s (0x%x)", esp_err_to_name(err), err);
+        if (err == ESP_OK) {
+            ESP_LOGI(TAG, "Sent to %s " MACSTR ": seq=%u, %uB, reason=0x%x",
+                     memcmp(dest.addr, g_root_addr.addr, 6) ? "RELAY" : "ROOT",
+                     MAC2STR(dest.addr), tlm.seq, (unsigned)len, (unsigned)reason);
+            report_policy_commit(&g_policy, now_ms, vals, valid);
+            seq++;
+            if (!g_boot.first_tx) {
+                g_boot.first_tx    = esp_timer_get_time();
+                g_boot.root_cached = !g_boot.root;
+                log_boot_times();
+            }
+        } else {
+            ESP_LOGE(TAG, "Mesh send failed: %s (0x%x)", esp_err_to_name(err), err);
+        }
 
-        if (json_str) free(json_str);
-        cJSON_Delete(root);
-        vTaskDelay(pdMS_TO_TICKS(5000));
+        sensor_sleep();
     }
 }
 
 
-static void parent_select_and_start_mesh_task(void *arg)
+// Gửi sự kiện PIR ngay, tách khỏi chu kỳ telemetry 5s
+static void motion_send_task(void *arg)
 {
-    mesh_parent_t cand;
-    int tries = 0;
+    static uint8_t buf[MOTION_FRAME_LEN];
+    uint16_t seq = 0;
+    motion_evt_t ev;
 
-    while (!find_best_parent(&cand)) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        if (++tries >= FALLBACK_WAIT_SCANS) break;
+    for (;;) {
+        xQueueReceive(g_motion_q, &ev, portMAX_DELAY);
+        if (!g_mesh_connected || !g_root_addr_ok) {
+            ESP_LOGW(TAG, "Motion %u: mesh chưa sẵn sàng — bỏ", ev.level);
+            continue;
+        }
+
+        int64_t t_send = esp_timer_get_time();
+        motion_event_t m = {
+            .node_id         = NODE_ID,
+            .seq             = seq,
+            .level           = ev.level,
+            .edge_to_send_us = (uint32_t)(t_send - ev.t_edge_us),
+            .last_latency_us = g_motion_latency_us,
+        };
+        mesh_data_t md = {
+            .data  = buf,
+            .size  = (uint16_t)motion_encode(&m, buf, sizeof(buf)),
+            .proto = MESH_PROTO_BIN,
+            .tos   = MESH_TOS_P2P,
+        };
+        s_motion_pending[seq % MOTION_PENDING] = (motion_pending_t){ seq, ev.t_edge_us, t_send };
+
+        mesh_addr_t dest = {0};
+        memcpy(dest.addr, g_root_addr.addr, 6);
+        esp_err_t err = esp_mesh_send(&dest, &md, MESH_DATA_P2P, NULL, 0);
+        if (err == ESP_OK) ESP_LOGI(TAG, "Motion %u sent: seq=%u, edge->send=%uus", ev.level, seq, (unsigned)m.edge_to_send_us);
+        else               ESP_LOGE(TAG, "Motion send failed: %s", esp_err_to_name(err));
+        seq++;
     }
+}
 
-    if (tries < FALLBACK_WAIT_SCANS) {
-        set_parent_to_candidate(&cand);
-        if (!g_mesh_started) {
-            ESP_ERROR_CHECK(esp_mesh_start());
-            g_mesh_started = true;
-        }
+// Beacon: chỉnh offset/drift rồi trả echo để root đo RTT (owd cho beacon sau) và sai số
+static void tsync_handle(const mesh_addr_t *from, const tsync_beacon_t *b, int64_t t_rx)
+{
+    portENTER_CRITICAL(&g_tsync_mux);
+    int32_t err = time_sync_on_beacon(&g_tsync, (int64_t)b->root_us, b->owd_us,
+                                      (b->flags & TSYNC_FLAG_UTC) != 0, t_rx);
+    time_sync_t ts = g_tsync;
+    portEXIT_CRITICAL(&g_tsync_mux);
+    uint16_t slot = b->slots ? (uint16_t)((b->slot << 8) | b->slots) : 0;
+    if (slot != g_tx_slot) {
+        g_tx_slot = slot;
+        ESP_LOGI(TAG, "TX slot %u/%u", b->slot, b->slots);
     }
-#if ENABLE_AUTO_FALLBACK
-    else {
-        ESP_LOGW(TAG, "Không thấy Relay A/B sau %d lần -> bật self-organized (fallback) & start mesh", tries);
-        ESP_ERROR_CHECK(esp_mesh_set_self_organized(true, true));
-        if (!g_mesh_started) {
-            ESP_ERROR_CHECK(esp_mesh_start());
-            g_mesh_started = true;
+
+    int64_t t_tx = esp_timer_get_time();
+    tsync_echo_t e = {
+        .node_id = NODE_ID,
+        .seq     = b->seq,
+        .flags   = TSYNC_FLAG_SYNCED,
+        .root_us = (uint32_t)b->root_us,
+        .hold_us = (uint32_t)(t_tx - t_rx),
+        .leaf_us = (uint32_t)time_sync_now(&ts, t_tx),
+        .err_us  = err,
+    };
+    uint8_t buf[TSYNC_ECHO_LEN];
+    mesh_data_t d = {
+        .data  = buf,
+        .size  = (uint16_t)tsync_echo_encode(&e, buf, sizeof(buf)),
+        .proto = MESH_PROTO_BIN,
+        .tos   = MESH_TOS_P2P,
+    };
+    esp_err_t ret = esp_mesh_send(from, &d, MESH_DATA_P2P | MESH_DATA_NONBLOCK, NULL, 0);
+    ESP_LOGD(TAG, "Beacon %u: err=%dus, owd=%uus, drift=%.2fppm, steps=%u%s", b->seq, (int)err,
+             (unsigned)b->owd_us, ts.drift * 1e6f, (unsigned)ts.steps, ret == ESP_OK ? "" : ", echo fail");
+}
+
+// Thực thi lệnh root gửi xuống. Chỉ đổi cấu hình / đặt cờ, không đọc cảm biến ở đây.
+static uint8_t cmd_execute(const cmd_t *c)
+{
+    // lấy bản mới nhất, kể cả bản chưa được send_sensor_task áp dụng; không đọc g_policy.cfg
+    // vì send_sensor_task có thể đang ghi đè trong report_policy_apply
+    report_policy_cfg_t cfg;
+    portENTER_CRITICAL(&g_policy_mux);
+    cfg = g_policy_pending;
+    portEXIT_CRITICAL(&g_policy_mux);
+    uint32_t ms = (c->arg_len >= 4) ? mp_get_u32(c->arg) : 0;
+
+    switch (c->op) {
+    case CMD_OP_PING:
+        return CMD_OK;
+    case CMD_OP_SET_SAMPLE:
+        if (c->arg_len < 4 || ms < REPORT_MIN_SAMPLE_MS) return CMD_ERR_ARG;
+        cfg.sample_ms = ms;
+        break;
+    case CMD_OP_SET_HEARTBEAT:
+        if (c->arg_len < 4 || ms == 0) return CMD_ERR_ARG;
+        for (int i = 0; i < RP_SENSOR_COUNT; i++) cfg.sensor[i].max_interval_ms = ms;
+        break;
+    case CMD_OP_READ_NOW:
+        g_force_report = true;
+        xSemaphoreGive(g_sensor_wake);
+        return CMD_OK;
+    default:
+        return CMD_ERR_OP;
+    }
+
+    if (leaf_set_report_policy(&cfg) != ESP_OK) return CMD_ERR_FAIL;
+    xSemaphoreGive(g_sensor_wake);   // chu kỳ mới có hiệu lực ngay
+    return CMD_OK;
+}
+
+static void cmd_handle(const mesh_addr_t *from, const cmd_t *c)
+{
+    int64_t t_rx = esp_timer_get_time();
+    cmd_ack_t ack = {
+        .node_id = NODE_ID,
+        .cmd_id  = c->cmd_id,
+        .op      = c->op,
+        .status  = cmd_execute(c),
+    };
+    ack.leaf_us = (uint32_t)(esp_timer_get_time() - t_rx);
+
+    uint8_t buf[CMD_ACK_LEN];
+    mesh_data_t d = {
+        .data  = buf,
+        .size  = (uint16_t)cmd_ack_encode(&ack, buf, sizeof(buf)),
+        .proto = MESH_PROTO_BIN,
+        .tos   = MESH_TOS_P2P,
+    };
+    esp_err_t err = esp_mesh_send(from, &d, MESH_DATA_P2P | MESH_DATA_NONBLOCK, NULL, 0);
+    ESP_LOGI(TAG, "CMD id=%u op=%s -> %s (%uus)%s", c->cmd_id,
+             cmd_op_name(c->op) ? cmd_op_name(c->op) : "?", cmd_status_name(ack.status),
+             (unsigned)ack.leaf_us, err == ESP_OK ? "" : ", ACK send fail");
+}
+
+// Nhận downlink từ root: ACK sự kiện PIR, lệnh MQTT, beacon thời gian
+static void mesh_rx_task(void *arg)
+{
+    static uint8_t rx_buf[64];
+    mesh_addr_t from;
+    mesh_data_t rx = { .data = rx_buf, .proto = MESH_PROTO_BIN, .tos = MESH_TOS_P2P };
+    int flag = 0;
+
+    for (;;) {
+        rx.size = sizeof(rx_buf);
+        if (esp_mesh_recv(&from, &rx, portMAX_DELAY, &flag, NULL, 0) != ESP_OK) continue;
+        int64_t t_rx = esp_timer_get_time();
+
+        congest_t cong;
+        if (congest_decode(rx_buf, rx.size, &cong)) {
+            if (cong.level != g_cong_level) ESP_LOGW(TAG, "Root congestion %u -> %u", g_cong_level, cong.level);
+            g_cong_until_ms = now_ms() + cong.ttl_s * 1000u;
+            g_cong_level    = cong.level;
+            flag = 0;
+            continue;
+        }
+
+        tsync_beacon_t bcn;
+        if (tsync_beacon_decode(rx_buf, rx.size, &bcn)) {
+            tsync_handle(&from, &bcn, t_rx);
+            flag = 0;
+            continue;
+        }
+
+        cmd_t cmd;
+        if (cmd_decode(rx_buf, rx.size, &cmd)) {
+            cmd_handle(&from, &cmd);
+            flag = 0;
+            continue;
+        }
+
+        uint16_t node_id, seq;
+        if (motion_ack_decode(rx_buf, rx.size, &node_id, &seq) && node_id == NODE_ID) {
+            const motion_pending_t *p = &s_motion_pending[seq % MOTION_PENDING];
+            if (p->seq != seq) continue;
+            // cạnh -> root ≈ (cạnh -> gửi) + RTT/2
+            int64_t rtt = esp_timer_get_time() - p->t_send_us;
+            g_motion_latency_us = (uint32_t)((p->t_send_us - p->t_edge_us) + rtt / 2);
+            ESP_LOGI(TAG, "Motion ACK seq=%u: RTT=%lldus, edge->root≈%uus",
+                     seq, (long long)rtt, (unsigned)g_motion_latency_us);
         }
+        flag = 0;
     }
+}
+
+static void pm_fallback(int tries)
+{
+#if ENABLE_AUTO_FALLBACK
+    ESP_LOGW(TAG, "Không thấy relay sau %d lần -> bật self-organized (fallback)", tries);
+    esp_mesh_set_self_organized(true, true);
+#else
+    ESP_LOGW(TAG, "Không thấy relay sau %d lần", tries);
 #endif
+}
 
-    vTaskDelete(NULL);
+static bool pm_scan(uint8_t channel, uint8_t *scan_ch)
+{
+    *scan_ch = channel;
+    return parent_scan_start(channel) == ESP_OK;
+}
+
+static void pm_arm(pm_timer_t *timer, TickType_t *due, pm_timer_t what, uint32_t ms)
+{
+    *timer = what;
+    *due   = xTaskGetTickCount() + pdMS_TO_TICKS(ms);
+}
+
+// Vòng tìm parent: quét kênh đã biết trước, không thấy mới quét toàn băng,
+// toàn băng không thấy thì nghỉ PARENT_RETRY_MS rồi quét lại.
+// Đang có parent: mỗi PARENT_EVAL_MS quét kênh mesh, đổi parent nếu ps_select cho phép.
+static void parent_mgr_task(void *arg)
+{
+    int        tries = 0;
+    uint8_t    scan_ch = 0;
+    pm_timer_t timer = PM_T_NONE;
+    TickType_t due = 0;
+    bool       switching = false;
+    ps_obs_t   target = {0};            // parent vừa set, dùng để phạt khi nối lỗi / lưu cache
+
+    // boot: thử nối thẳng parent trong cache, hết FAST_REJOIN_MS mới scan
+    if (g_rejoin.has_parent) {
+        ESP_LOGI(TAG, "Fast rejoin -> " MACSTR, MAC2STR(g_rejoin.parent.bssid));
+        g_boot.fast_rejoin = true;
+        switching = true;
+        target = g_rejoin.parent;
+        set_parent_to_candidate(&target);
+        pm_arm(&timer, &due, PM_T_SWITCH, FAST_REJOIN_MS);
+    } else {
+        pm_post(PM_EV_LOST);
+    }
+
+    for (;;) {
+        pm_event_t ev;
+        TickType_t wait = portMAX_DELAY;
+        if (timer != PM_T_NONE) {
+            int32_t left = (int32_t)(due - xTaskGetTickCount());
+            wait = left > 0 ? (TickType_t)left : 0;
+        }
+
+        if (xQueueReceive(g_pm_q, &ev, wait) != pdTRUE) {
+            pm_timer_t t = timer;
+            timer = PM_T_NONE;
+            if (t == PM_T_RETRY && g_pm_searching) {
+                if (!pm_scan(0, &scan_ch)) pm_arm(&timer, &due, PM_T_RETRY, PARENT_RETRY_MS);
+            } else if (t == PM_T_EVAL && g_mesh_connected) {
+                if (!pm_scan(g_parent_channel, &scan_ch)) pm_arm(&timer, &due, PM_T_EVAL, PARENT_EVAL_MS);
+            } else if (t == PM_T_SWITCH && switching) {
+                ESP_LOGW(TAG, "Đổi parent quá %dms -> tìm lại", PARENT_SWITCH_MS);
+                switching = false;
+                pm_post(PM_EV_LOST);
+            }
+            continue;
+        }
+
+        switch (ev) {
+        case PM_EV_CONNECTED:
+            switching = false;
+            g_pm_searching = false;
+            ps_set_current(&g_ps, g_parent_bssid.addr, now_ms());
+            pm_arm(&timer, &due, PM_T_EVAL, PARENT_EVAL_MS);
+            if (!memcmp(target.bssid, g_parent_bssid.addr, 6)) {
+                rejoin_cache_t next = g_rejoin;
+                next.has_parent = true;
+                next.parent = target;
+                next.parent.channel = g_parent_channel ? g_parent_channel : target.channel;
+                rejoin_save(&next);
+            }
+            break;
+
+        case PM_EV_ROOT: {
+            rejoin_cache_t next = g_rejoin;
+            next.has_root = true;
+            memcpy(next.root, g_root_addr.addr, 6);
+            rejoin_save(&next);
+            break;
+        }
+
+        case PM_EV_LOST:
+            if (switching || g_pm_searching || g_mesh_connected) break;
+            ps_link_failed(&g_ps, target.bssid, now_ms());
+            ps_set_current(&g_ps, NULL, now_ms());
+            g_pm_searching = true;
+            tries = 0;
+            if (!g_lost_us) g_lost_us = esp_timer_get_time();
+            {
+                parent_scan_stats_t ss;
+                parent_scan_get_stats(&ss);
+                g_round_scans_base = ss.scans;
+            }
+            if (!pm_scan(g_parent_channel, &scan_ch)) pm_arm(&timer, &due, PM_T_RETRY, PARENT_RETRY_MS);
+            break;
+
+        case PM_EV_SCAN_DONE: {
+            learn_candidates(now_ms());
+            const ps_cand_t *best = ps_select(&g_ps, now_ms());
+
+            if (g_mesh_connected && !switching) {
+                if (best) {
+                    ESP_LOGI(TAG, "Cân bằng tải: đổi parent " MACSTR " -> " MACSTR,
+                             MAC2STR(g_parent_bssid.addr), MAC2STR(best->obs.bssid));
+                    switching = true;
+                    target = best->obs;
+                    set_parent_to_candidate(&target);
+                    pm_arm(&timer, &due, PM_T_SWITCH, PARENT_SWITCH_MS);
+                } else {
+                    pm_arm(&timer, &due, PM_T_EVAL, PARENT_EVAL_MS);
+                }
+                break;
+            }
+            if (!g_pm_searching) break;
+
+            if (best) {
+                g_pm_searching = false;
+                timer = PM_T_NONE;
+                target = best->obs;
+                set_parent_to_candidate(&target);
+                break;
+            }
+            if (scan_ch) {
+                ESP_LOGI(TAG, "Không thấy parent trên ch=%u -> quét toàn băng", scan_ch);
+                if (!pm_scan(0, &scan_ch)) pm_arm(&timer, &due, PM_T_RETRY, PARENT_RETRY_MS);
+                break;
+            }
+            ESP_LOGI(TAG, "Scan xong: KHÔNG có relay nào dùng được");
+            if (++tries >= FALLBACK_WAIT_SCANS) {
+                g_pm_searching = false;
+                pm_fallback(tries);
+                break;
+            }
+            pm_arm(&timer, &due, PM_T_RETRY, PARENT_RETRY_MS);
+            break;
+        }
+        }
+    }
 }
 
 void app_main(void)
 {
+    g_boot.app_main = esp_timer_get_time();
     ESP_LOGI(TAG, "Leaf node started");
     memcpy(g_mesh_id_addr.addr, MESH_ID, 6);
 
@@ -413,6 +1138,7 @@ void app_main(void)
     try_set_bandwidth();
 
   
+    g_tx_ready = xEventGroupCreate();   // trước khi event mesh đầu tiên tới
     ESP_ERROR_CHECK(esp_mesh_init());
     ESP_ERROR_CHECK(esp_event_handler_register(MESH_EVENT, ESP_EVENT_ANY_ID, &mesh_event_handler, NULL));
 
@@ -436,22 +1162,49 @@ void app_main(void)
     ESP_LOGW(TAG, "Mesh AP auth=OPEN (no password)");
 
 
-    xTaskCreate(parent_select_and_start_mesh_task, "parent_select", 6144, NULL, 6, NULL);
+    // start mesh trước (không tự tổ chức) để scan đọc được vendor IE của relay,
+    // parent_mgr_task chọn parent rồi esp_mesh_set_parent
+    ESP_ERROR_CHECK(esp_mesh_start());
+    g_boot.mesh_started = esp_timer_get_time();
+
+    // có root trong cache thì gửi được ngay khi nối parent, không chờ ROOT_ADDRESS
+    rejoin_load();
+    if (g_rejoin.has_root) {
+        memcpy(g_root_addr.addr, g_rejoin.root, 6);
+        g_root_addr_ok = true;
+    }
+
+    ps_init(&g_ps, NULL);
+    g_pm_q = xQueueCreate(PARENT_MGR_QUEUE_LEN, sizeof(pm_event_t));
+    ESP_ERROR_CHECK(parent_scan_init(on_scan_done, NULL));
+    xTaskCreate(parent_mgr_task, "parent_mgr", 4096, NULL, 6, NULL);
+    g_lost_us = esp_timer_get_time();   // boot -> parent đầu tiên
 
   
     DHT11_init(DHT_PIN);
     pir_init();
+    policy_load();
 
   
-    adc1_config_width(ADC_WIDTH_BIT_12);
-    adc1_config_channel_atten(LDR_ADC_CHANNEL, ADC_ATTEN_DB_12);
+    ldr_adc_config_t ldr_cfg = {
+        .channel    = LDR_ADC_CHANNEL,
+        .sample_hz  = LDR_SAMPLE_HZ,
+        .window_ms  = LDR_WINDOW_MS,
+        .median_len = LDR_MEDIAN_LEN,
+    };
+    ESP_ERROR_CHECK(ldr_adc_init(&ldr_cfg));
 
   
     ssd1306_init(&oled);
     ssd1306_clear(&oled);
     ssd1306_display_text(&oled, 0, "Leaf Node Init", false);
+    ssd1306_flush(&oled);
 
    
     data.data = tx_buf;
+    time_sync_init(&g_tsync);
+    g_sensor_wake = xSemaphoreCreateBinary();
     xTaskCreate(send_sensor_task, "send_sensor_data", 4096, NULL, 5, NULL);
+    xTaskCreate(motion_send_task, "motion_send", 3072, NULL, 7, NULL);
+    xTaskCreate(mesh_rx_task, "mesh_rx", 3072, NULL, 6, NULL);
 }
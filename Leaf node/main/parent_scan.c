@@ -0,0 +1,119 @@
+#include <string.h>
+#include "esp_log.h"
+#include "esp_event.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "esp_mesh.h"
+
+#include "parent_scan.h"
+
+// Kênh đã biết: quét active ngắn. Toàn băng: giữ mặc định của IDF.
+#define SCAN_TARGETED_MIN_MS    30
+#define SCAN_TARGETED_MAX_MS    80
+#define SCAN_TIMEOUT_US         (5 * 1000 * 1000)   // mất SCAN_DONE -> bỏ scan treo
+
+static const char *TAG = "PARENT_SCAN";
+
+static parent_scan_ap_t      s_aps[PARENT_SCAN_MAX_AP];
+static wifi_ap_record_t      s_recs[PARENT_SCAN_MAX_AP];   // chỉ dùng cho scan trước khi mesh start
+static uint16_t              s_num;
+static volatile bool         s_busy;
+static uint8_t               s_channel;
+static int64_t               s_start_us;
+static parent_scan_stats_t   s_stats;
+static parent_scan_done_cb_t s_cb;
+static void                 *s_cb_ctx;
+
+static void _finish(uint16_t num) {
+    s_num = num;
+    s_stats.last_scan_ms = (uint32_t)((esp_timer_get_time() - s_start_us) / 1000);
+    s_busy = false;
+    ESP_LOGD(TAG, "ch=%u: %u AP trong %ums", s_channel, num, (unsigned)s_stats.last_scan_ms);
+    if (s_cb) s_cb(num, s_channel, s_cb_ctx);
+}
+
+static void _wifiScanDone(void *arg, esp_event_base_t base, int32_t id, void *data) {
+    if (!s_busy) return;
+
+    uint16_t n = PARENT_SCAN_MAX_AP;
+    if (esp_wifi_scan_get_ap_records(&n, s_recs) != ESP_OK) {
+        s_stats.failed++;
+        n = 0;
+    }
+    for (int i = 0; i < n; i++) {
+        s_aps[i].rec = s_recs[i];
+        s_aps[i].has_ie = false;
+    }
+    _finish(n);
+}
+
+// Mesh đã start: lấy record + vendor IE qua API mesh (tự giải phóng danh sách của driver)
+static void _meshScanDone(void *arg, esp_event_base_t base, int32_t id, void *data) {
+    if (!s_busy) return;
+
+    const mesh_event_scan_done_t *e = (const mesh_event_scan_done_t *)data;
+    uint16_t n = 0;
+    for (int i = 0; i < e->number && n < PARENT_SCAN_MAX_AP; i++) {
+        int ie_len = 0;
+        parent_scan_ap_t *ap = &s_aps[n];
+        esp_mesh_scan_get_ap_ie_len(&ie_len);
+        if (esp_mesh_scan_get_ap_record(&ap->rec, &ap->assoc) != ESP_OK) break;
+        ap->has_ie = ie_len == sizeof(ap->assoc);
+        n++;
+    }
+    _finish(n);
+}
+
+esp_err_t parent_scan_init(parent_scan_done_cb_t cb, void *ctx) {
+    s_cb = cb;
+    s_cb_ctx = ctx;
+    esp_err_t err = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_SCAN_DONE, &_wifiScanDone, NULL);
+    if (err != ESP_OK) return err;
+    return esp_event_handler_register(MESH_EVENT, MESH_EVENT_SCAN_DONE, &_meshScanDone, NULL);
+}
+
+esp_err_t parent_scan_start(uint8_t channel) {
+    if (s_busy) {
+        if (esp_timer_get_time() - s_start_us < SCAN_TIMEOUT_US) return ESP_ERR_INVALID_STATE;
+        ESP_LOGW(TAG, "Scan ch=%u không có SCAN_DONE -> hủy", s_channel);
+        esp_wifi_scan_stop();
+        s_stats.failed++;
+        s_busy = false;
+    }
+
+    wifi_scan_config_t sc = { .ssid = 0, .bssid = 0, .channel = channel, .show_hidden = true };
+    if (channel) {
+        sc.scan_type = WIFI_SCAN_TYPE_ACTIVE;
+        sc.scan_time.active.min = SCAN_TARGETED_MIN_MS;
+        sc.scan_time.active.max = SCAN_TARGETED_MAX_MS;
+    }
+
+    s_busy = true;
+    s_channel = channel;
+    s_start_us = esp_timer_get_time();
+    esp_err_t err = esp_wifi_scan_start(&sc, false);
+    if (err != ESP_OK) {
+        s_busy = false;
+        s_stats.failed++;
+        ESP_LOGW(TAG, "scan_start ch=%u fail: %s", channel, esp_err_to_name(err));
+        return err;
+    }
+
+    s_stats.scans++;
+    if (channel) s_stats.targeted++;
+    else         s_stats.full++;
+    return ESP_OK;
+}
+
+bool parent_scan_busy(void) {
+    return s_busy;
+}
+
+uint16_t parent_scan_results(const parent_scan_ap_t **aps) {
+    *aps = s_aps;
+    return s_num;
+}
+
+void parent_scan_get_stats(parent_scan_stats_t *out) {
+    *out = s_stats;
+}
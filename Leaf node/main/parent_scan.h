@@ -0,0 +1,45 @@
+#ifndef PARENT_SCAN_H_
+#define PARENT_SCAN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi.h"
+#include "esp_mesh.h"
+
+// ==== Scan parent không chặn ====
+// esp_wifi_scan_start(block=false), kết quả về qua WIFI_EVENT_SCAN_DONE (mesh chưa
+// start) hoặc MESH_EVENT_SCAN_DONE (mesh đã start), chép vào buffer cấp sẵn.
+#define PARENT_SCAN_MAX_AP      24
+
+typedef struct {
+    wifi_ap_record_t rec;
+    mesh_assoc_t     assoc;     // vendor IE của mesh, chỉ hợp lệ khi has_ie
+    bool             has_ie;
+} parent_scan_ap_t;
+
+// Gọi trong task event loop: không block, chỉ chuyển tiếp cho task xử lý
+typedef void (*parent_scan_done_cb_t)(uint16_t num, uint8_t channel, void *ctx);
+
+typedef struct {
+    uint32_t scans;
+    uint32_t targeted;          // scan 1 kênh (kênh parent đã biết)
+    uint32_t full;              // scan toàn băng
+    uint32_t failed;
+    uint32_t last_scan_ms;      // thời gian scan gần nhất
+} parent_scan_stats_t;
+
+// Đăng ký handler SCAN_DONE, gọi sau esp_event_loop_create_default
+esp_err_t parent_scan_init(parent_scan_done_cb_t cb, void *ctx);
+
+// channel = 0: toàn băng. ESP_ERR_INVALID_STATE nếu đang có scan khác.
+esp_err_t parent_scan_start(uint8_t channel);
+
+bool parent_scan_busy(void);
+
+// Kết quả scan gần nhất, hợp lệ tới lần parent_scan_start kế tiếp
+uint16_t parent_scan_results(const parent_scan_ap_t **aps);
+
+void parent_scan_get_stats(parent_scan_stats_t *out);
+
+#endif /* PARENT_SCAN_H_ */
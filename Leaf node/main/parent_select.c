@@ -0,0 +1,123 @@
+#include <string.h>
+#include "parent_select.h"
+
+void ps_default_cfg(ps_cfg_t *cfg) {
+    cfg->w_rssi        = 2;
+    cfg->w_layer       = 15;
+    cfg->w_load        = 40;
+    cfg->w_fail        = 25;
+    cfg->rssi_floor    = -90;
+    cfg->rssi_ceil     = -45;
+    cfg->max_layer     = 5;
+    cfg->hysteresis    = 12;
+    cfg->min_dwell_ms  = 120000;
+    cfg->stale_ms      = 180000;
+    cfg->fail_decay_ms = 60000;
+}
+
+void ps_init(parent_select_t *ps, const ps_cfg_t *cfg) {
+    memset(ps, 0, sizeof(*ps));
+    if (cfg) ps->cfg = *cfg;
+    else     ps_default_cfg(&ps->cfg);
+}
+
+static ps_cand_t *_find(parent_select_t *ps, const uint8_t bssid[6]) {
+    for (int i = 0; i < PS_MAX_CAND; i++) {
+        if (ps->cand[i].used && !memcmp(ps->cand[i].obs.bssid, bssid, 6)) return &ps->cand[i];
+    }
+    return NULL;
+}
+
+void ps_observe(parent_select_t *ps, const ps_obs_t *obs, uint32_t now_ms) {
+    ps_cand_t *c = _find(ps, obs->bssid);
+    if (!c) {
+        ps_cand_t *oldest = &ps->cand[0];
+        for (int i = 0; i < PS_MAX_CAND; i++) {
+            if (!ps->cand[i].used) { oldest = &ps->cand[i]; break; }
+            if (now_ms - ps->cand[i].seen_ms > now_ms - oldest->seen_ms) oldest = &ps->cand[i];
+        }
+        c = oldest;
+        memset(c, 0, sizeof(*c));
+        c->used = true;
+        c->fail_ms = now_ms;
+    }
+    c->obs = *obs;
+    c->seen_ms = now_ms;
+}
+
+static void _decay(const ps_cfg_t *cfg, ps_cand_t *c, uint32_t now_ms) {
+    if (!cfg->fail_decay_ms) return;
+    while (c->fails && now_ms - c->fail_ms >= cfg->fail_decay_ms) {
+        c->fails--;
+        c->fail_ms += cfg->fail_decay_ms;
+    }
+    if (!c->fails) c->fail_ms = now_ms;
+}
+
+void ps_link_failed(parent_select_t *ps, const uint8_t bssid[6], uint32_t now_ms) {
+    ps_cand_t *c = _find(ps, bssid);
+    if (!c) return;
+    _decay(&ps->cfg, c, now_ms);
+    if (c->fails < UINT8_MAX) c->fails++;
+    c->fail_ms = now_ms;
+}
+
+void ps_set_current(parent_select_t *ps, const uint8_t bssid[6], uint32_t now_ms) {
+    ps->has_cur = bssid != NULL;
+    if (bssid) memcpy(ps->cur_bssid, bssid, 6);
+    ps->cur_since_ms = now_ms;
+}
+
+int32_t ps_score(parent_select_t *ps, ps_cand_t *c, uint32_t now_ms) {
+    const ps_cfg_t *cfg = &ps->cfg;
+    const ps_obs_t *o = &c->obs;
+    bool is_cur = ps->has_cur && !memcmp(o->bssid, ps->cur_bssid, 6);
+
+    if (now_ms - c->seen_ms > cfg->stale_ms) return PS_SCORE_INVALID;
+    if (o->layer == 0 || o->layer > cfg->max_layer) return PS_SCORE_INVALID;
+    if (o->rssi < cfg->rssi_floor) return PS_SCORE_INVALID;
+
+    // parent hiện tại đã tính mình trong assoc
+    uint32_t assoc = o->assoc;
+    if (is_cur && assoc) assoc--;
+    if (o->assoc_cap && assoc >= o->assoc_cap) return PS_SCORE_INVALID;
+
+    int32_t rssi = o->rssi > cfg->rssi_ceil ? cfg->rssi_ceil : o->rssi;
+    int32_t score = cfg->w_rssi * (rssi - cfg->rssi_floor);
+    score -= cfg->w_layer * (int32_t)(o->layer - 1);
+    // tải tính theo chỗ trống sau khi mình vào -> leaf dàn đều giữa các relay
+    if (o->assoc_cap) score -= cfg->w_load * (int32_t)(assoc + 1) / o->assoc_cap;
+
+    _decay(cfg, c, now_ms);
+    score -= cfg->w_fail * c->fails;
+    return score;
+}
+
+const ps_cand_t *ps_select(parent_select_t *ps, uint32_t now_ms) {
+    ps_cand_t *best = NULL, *cur = NULL;
+    int32_t best_score = PS_SCORE_INVALID, cur_score = PS_SCORE_INVALID;
+
+    for (int i = 0; i < PS_MAX_CAND; i++) {
+        ps_cand_t *c = &ps->cand[i];
+        if (!c->used) continue;
+
+        int32_t s = ps_score(ps, c, now_ms);
+        if (ps->has_cur && !memcmp(c->obs.bssid, ps->cur_bssid, 6)) {
+            cur = c;
+            cur_score = s;
+        }
+        if (s != PS_SCORE_INVALID && (!best || s > best_score)) {
+            best = c;
+            best_score = s;
+        }
+    }
+
+    if (!best) return NULL;
+    if (!ps->has_cur) return best;
+    if (best == cur) return NULL;
+
+    // đang có parent: chỉ đổi khi đã ở đủ lâu và ứng viên tốt hơn rõ rệt
+    if (now_ms - ps->cur_since_ms < ps->cfg.min_dwell_ms) return NULL;
+    if (cur && cur_score != PS_SCORE_INVALID && best_score < cur_score + ps->cfg.hysteresis) return NULL;
+    return best;
+}
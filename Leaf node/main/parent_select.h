@@ -0,0 +1,73 @@
+#ifndef PARENT_SELECT_H_
+#define PARENT_SELECT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==== Chọn parent theo điểm (không phụ thuộc ESP-IDF) ====
+// Bảng ứng viên học từ kết quả scan + vendor IE của mesh. Điểm gồm:
+//   RSSI  - layer sâu - tải (assoc/assoc_cap) - số lần link lỗi gần đây
+// Đang có parent thì chỉ đổi khi ứng viên hơn >= hysteresis và đã ở đủ min_dwell.
+#define PS_MAX_CAND     16
+
+typedef struct {
+    int32_t  w_rssi;            // điểm / dB trên mức rssi_floor
+    int32_t  w_layer;           // trừ mỗi layer sâu hơn layer 1
+    int32_t  w_load;            // trừ khi parent đầy (assoc == assoc_cap)
+    int32_t  w_fail;            // trừ mỗi lần link lỗi
+    int8_t   rssi_floor;        // dưới mức này coi như không dùng được
+    int8_t   rssi_ceil;         // trên mức này không cộng thêm
+    uint8_t  max_layer;         // layer tối đa của parent (leaf = layer + 1)
+    int32_t  hysteresis;
+    uint32_t min_dwell_ms;      // thời gian tối thiểu ở 1 parent trước khi tự đổi
+    uint32_t stale_ms;          // không thấy trong scan quá lâu -> bỏ qua
+    uint32_t fail_decay_ms;     // mỗi khoảng này quên 1 lần lỗi
+} ps_cfg_t;
+
+// 1 AP thấy trong scan, đã lọc đúng mesh ID
+typedef struct {
+    uint8_t  bssid[6];
+    char     ssid[33];
+    uint8_t  channel;
+    int8_t   rssi;
+    uint8_t  layer;
+    uint8_t  assoc;             // số child hiện có
+    uint8_t  assoc_cap;         // max_connection của parent, 0 = không rõ
+} ps_obs_t;
+
+typedef struct {
+    bool     used;
+    ps_obs_t obs;
+    uint32_t seen_ms;
+    uint8_t  fails;
+    uint32_t fail_ms;           // mốc giảm fails gần nhất
+} ps_cand_t;
+
+typedef struct {
+    ps_cfg_t  cfg;
+    ps_cand_t cand[PS_MAX_CAND];
+    uint8_t   cur_bssid[6];
+    bool      has_cur;
+    uint32_t  cur_since_ms;
+} parent_select_t;
+
+#define PS_SCORE_INVALID    INT32_MIN
+
+void ps_default_cfg(ps_cfg_t *cfg);
+void ps_init(parent_select_t *ps, const ps_cfg_t *cfg);
+
+// Thêm/cập nhật ứng viên; bảng đầy thì thay ứng viên thấy lâu nhất
+void ps_observe(parent_select_t *ps, const ps_obs_t *obs, uint32_t now_ms);
+
+void ps_link_failed(parent_select_t *ps, const uint8_t bssid[6], uint32_t now_ms);
+
+// Đã nối vào bssid (NULL = mất parent)
+void ps_set_current(parent_select_t *ps, const uint8_t bssid[6], uint32_t now_ms);
+
+// PS_SCORE_INVALID nếu không dùng được (đầy, quá sâu, RSSI yếu, lâu không thấy)
+int32_t ps_score(parent_select_t *ps, ps_cand_t *c, uint32_t now_ms);
+
+// Ứng viên nên nối tới, NULL = giữ nguyên (hoặc không có ứng viên nào)
+const ps_cand_t *ps_select(parent_select_t *ps, uint32_t now_ms);
+
+#endif /* PARENT_SELECT_H_ */
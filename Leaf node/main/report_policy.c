@@ -0,0 +1,65 @@
+#include <string.h>
+#include "report_policy.h"
+
+void report_policy_default(report_policy_cfg_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->version   = REPORT_POLICY_VERSION;
+    cfg->sample_ms = 5000;
+    cfg->sensor[RP_TEMP]   = (rp_sensor_cfg_t){ .deadband = 1,   .min_interval_ms = 5000, .max_interval_ms = 60000 };
+    cfg->sensor[RP_HUMI]   = (rp_sensor_cfg_t){ .deadband = 3,   .min_interval_ms = 5000, .max_interval_ms = 60000 };
+    cfg->sensor[RP_LIGHT]  = (rp_sensor_cfg_t){ .deadband = 100, .min_interval_ms = 5000, .max_interval_ms = 60000 };
+    cfg->sensor[RP_MOTION] = (rp_sensor_cfg_t){ .deadband = 1,   .min_interval_ms = 0,    .max_interval_ms = 60000 };
+}
+
+bool report_policy_validate(report_policy_cfg_t *cfg) {
+    if (cfg->version != REPORT_POLICY_VERSION) return false;
+    if (cfg->sample_ms < REPORT_MIN_SAMPLE_MS) cfg->sample_ms = REPORT_MIN_SAMPLE_MS;
+
+    for (int i = 0; i < RP_SENSOR_COUNT; i++) {
+        rp_sensor_cfg_t *s = &cfg->sensor[i];
+        if (s->deadband < 0) s->deadband = 0;
+        if (s->max_interval_ms < cfg->sample_ms) s->max_interval_ms = cfg->sample_ms;
+        if (s->min_interval_ms > s->max_interval_ms) s->min_interval_ms = s->max_interval_ms;
+    }
+    return true;
+}
+
+void report_policy_init(report_policy_t *rp, const report_policy_cfg_t *cfg) {
+    memset(rp, 0, sizeof(*rp));
+    rp->cfg = *cfg;
+}
+
+void report_policy_apply(report_policy_t *rp, const report_policy_cfg_t *cfg) {
+    rp->cfg = *cfg;
+}
+
+uint32_t report_policy_evaluate(report_policy_t *rp, uint32_t now_ms,
+                                const int32_t v[RP_SENSOR_COUNT], uint32_t valid_mask) {
+    rp->samples++;
+    if (!rp->has_last) return RP_REASON_FIRST;
+
+    uint32_t since = now_ms - rp->last_tx_ms + REPORT_SLACK_MS;
+    uint32_t reason = RP_REASON_NONE;
+
+    for (int i = 0; i < RP_SENSOR_COUNT; i++) {
+        const rp_sensor_cfg_t *s = &rp->cfg.sensor[i];
+        if (since >= s->max_interval_ms) reason |= RP_REASON_HEARTBEAT;
+        if (!(valid_mask & (1u << i)) || since < s->min_interval_ms) continue;
+
+        int32_t d = v[i] - rp->last[i];
+        if (d < 0) d = -d;
+        if (d >= s->deadband && d > 0) reason |= RP_REASON_CHANGE;
+    }
+    return reason;
+}
+
+void report_policy_commit(report_policy_t *rp, uint32_t now_ms,
+                          const int32_t v[RP_SENSOR_COUNT], uint32_t valid_mask) {
+    for (int i = 0; i < RP_SENSOR_COUNT; i++) {
+        // giá trị lỗi không ghi đè mốc so sánh cũ
+        if ((valid_mask & (1u << i)) || !rp->has_last) rp->last[i] = v[i];
+    }
+    rp->has_last   = true;
+    rp->last_tx_ms = now_ms;
+    rp->sent++;
+}
@@ -0,0 +1,72 @@
+#ifndef REPORT_POLICY_H_
+#define REPORT_POLICY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==== Chính sách báo cáo theo thay đổi (không phụ thuộc ESP-IDF) ====
+// Mỗi chu kỳ lấy mẫu, frame chỉ được gửi khi:
+//  - có cảm biến thay đổi >= deadband và đã qua min_interval của nó, hoặc
+//  - đã quá max_interval (heartbeat) của bất kỳ cảm biến nào.
+#define REPORT_POLICY_VERSION   1
+#define REPORT_MIN_SAMPLE_MS    2000    // DHT11 cần ~2s giữa 2 lần đọc
+#define REPORT_SLACK_MS         100     // gửi theo slot: khoảng cách 2 mẫu lệch vài tick quanh sample_ms
+
+typedef enum {
+    RP_TEMP = 0,
+    RP_HUMI,
+    RP_LIGHT,
+    RP_MOTION,
+    RP_SENSOR_COUNT
+} rp_sensor_t;
+
+typedef struct {
+    int32_t  deadband;          // |mới - đã báo| >= deadband mới tính là thay đổi
+    uint32_t min_interval_ms;   // không gửi vì thay đổi nhanh hơn mức này
+    uint32_t max_interval_ms;   // heartbeat
+} rp_sensor_cfg_t;
+
+// Lưu nguyên struct vào NVS, version đổi khi layout đổi
+typedef struct {
+    uint16_t        version;
+    uint32_t        sample_ms;
+    rp_sensor_cfg_t sensor[RP_SENSOR_COUNT];
+} report_policy_cfg_t;
+
+typedef enum {
+    RP_REASON_NONE      = 0,
+    RP_REASON_FIRST     = 1 << 0,
+    RP_REASON_CHANGE    = 1 << 1,
+    RP_REASON_HEARTBEAT = 1 << 2,
+    RP_REASON_FORCED    = 1 << 3,   // lệnh read_now từ root, không qua evaluate
+} rp_reason_t;
+
+typedef struct {
+    report_policy_cfg_t cfg;
+    bool     has_last;
+    int32_t  last[RP_SENSOR_COUNT];     // giá trị trong frame gần nhất
+    uint32_t last_tx_ms;
+    uint32_t samples;
+    uint32_t sent;
+} report_policy_t;
+
+void report_policy_default(report_policy_cfg_t *cfg);
+
+// Kẹp tham số về miền hợp lệ, false nếu sai version
+bool report_policy_validate(report_policy_cfg_t *cfg);
+
+void report_policy_init(report_policy_t *rp, const report_policy_cfg_t *cfg);
+
+// Đổi tham số lúc chạy, giữ nguyên trạng thái lần gửi trước
+void report_policy_apply(report_policy_t *rp, const report_policy_cfg_t *cfg);
+
+// valid_mask: bit (1 << rp_sensor_t) = giá trị hợp lệ (vd DHT11 lỗi thì bỏ temp/humi).
+// Trả về tổ hợp rp_reason_t, RP_REASON_NONE = không gửi.
+uint32_t report_policy_evaluate(report_policy_t *rp, uint32_t now_ms,
+                                const int32_t v[RP_SENSOR_COUNT], uint32_t valid_mask);
+
+// Gọi sau khi đã gửi frame
+void report_policy_commit(report_policy_t *rp, uint32_t now_ms,
+                          const int32_t v[RP_SENSOR_COUNT], uint32_t valid_mask);
+
+#endif /* REPORT_POLICY_H_ */
@@ -12,14 +12,6 @@ static void ssd1306_send_cmd(uint8_t cmd) {
                                buffer, 2, 1000 / portTICK_PERIOD_MS);
 }
 
-// ==== Hàm gửi data ====
-static void ssd1306_send_data(uint8_t *data, size_t len) {
-    uint8_t buffer[len + 1];
-    buffer[0] = 0x40;
-    memcpy(&buffer[1], data, len);
-    i2c_master_write_to_device(I2C_MASTER_NUM, SSD1306_I2C_ADDRESS,
-                               buffer, len+1, 1000 / portTICK_PERIOD_MS);
-}
 
 // ==== Khởi tạo OLED ====
 void ssd1306_init(SSD1306_t *dev) {
@@ -64,19 +56,14 @@ void ssd1306_init(SSD1306_t *dev) {
     ssd1306_send_cmd(0x14);
     ssd1306_send_cmd(0xAF); // Display ON
 
-    ESP_LOGI(TAG, "SSD1306 init OK");
+    ssd1306_fb_init(&dev->fb);
+    dev->bus_bytes = 0;
+    ESP_LOGI(TAG, "SSD1306 init OK (I2C %d kHz)", I2C_MASTER_FREQ_HZ / 1000);
 }
 
-// ==== Clear screen ====
+// ==== Clear screen (framebuffer) ====
 void ssd1306_clear(SSD1306_t *dev) {
-    uint8_t zero[SSD1306_WIDTH];
-    memset(zero, 0x00, sizeof(zero));
-    for (int page = 0; page < (SSD1306_HEIGHT / 8); page++) {
-        ssd1306_send_cmd(0xB0 + page);
-        ssd1306_send_cmd(0x00);
-        ssd1306_send_cmd(0x10);
-        ssd1306_send_data(zero, SSD1306_WIDTH);
-    }
+    ssd1306_fb_clear(&dev->fb);
 }
 
 // ==== Hiển thị text ====
@@ -85,16 +72,26 @@ void ssd1306_display_text(SSD1306_t *dev, int row, const char *text, bool invert
     int len = strlen(text);
     if (len > 16) len = 16;
 
-    ssd1306_send_cmd(0xB0 + row);
-    ssd1306_send_cmd(0x00);
-    ssd1306_send_cmd(0x10);
-
-    uint8_t buffer[len*8];
     for (int i = 0; i < len; i++) {
-        memcpy(&buffer[i*8], font8x8_basic_tr[(uint8_t)text[i]], 8);
-        if (invert) {
-            for (int j=0;j<8;j++) buffer[i*8+j] = ~buffer[i*8+j];
-        }
+        ssd1306_fb_write(&dev->fb, row, i*8, font8x8_basic_tr[(uint8_t)text[i]], 8, invert);
+    }
+}
+
+// ==== Flush: chỉ gửi hộp bao vùng thay đổi, 1 lần ghi I2C ====
+size_t ssd1306_flush(SSD1306_t *dev) {
+    static uint8_t tx[SSD1306_FB_FLUSH_MAX];
+    ssd1306_region_t r;
+
+    if (!ssd1306_fb_dirty_region(&dev->fb, &r)) return 0;
+
+    size_t n = ssd1306_fb_build_flush(&dev->fb, &r, tx, sizeof(tx));
+    esp_err_t err = i2c_master_write_to_device(I2C_MASTER_NUM, SSD1306_I2C_ADDRESS,
+                                               tx, n, 1000 / portTICK_PERIOD_MS);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "flush fail: %s", esp_err_to_name(err));
+        return 0;   // giữ shadow cũ để lần sau gửi lại
     }
-    ssd1306_send_data(buffer, len*8);
+    ssd1306_fb_commit(&dev->fb, &r);
+    dev->bus_bytes += n + 1;    // + byte địa chỉ
+    return n + 1;
 }
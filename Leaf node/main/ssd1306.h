@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "driver/i2c.h"
+#include "ssd1306_fb.h"
 
 // ==== OLED SSD1306 ====
 #define SSD1306_WIDTH   128
@@ -14,16 +15,26 @@
 #define I2C_MASTER_NUM I2C_NUM_0
 #define I2C_MASTER_SDA_IO 21
 #define I2C_MASTER_SCL_IO 22
+#define SSD1306_I2C_FAST_MODE 1   // 1 = 400 kHz, 0 = 100 kHz (dây dài / pull-up yếu)
+#if SSD1306_I2C_FAST_MODE
+#define I2C_MASTER_FREQ_HZ 400000
+#else
 #define I2C_MASTER_FREQ_HZ 100000
+#endif
 
 typedef struct {
     int width;
     int height;
+    ssd1306_fb_t fb;
+    uint32_t bus_bytes;     // tổng byte đã gửi qua I2C kể từ init
 } SSD1306_t;
 
 // ==== API ====
+// clear/display_text chỉ vẽ vào framebuffer; ssd1306_flush mới gửi lên panel
 void ssd1306_init(SSD1306_t *dev);
 void ssd1306_clear(SSD1306_t *dev);
 void ssd1306_display_text(SSD1306_t *dev, int row, const char *text, bool invert);
+// Gửi vùng thay đổi trong 1 transaction, trả về số byte trên bus (0 = không đổi)
+size_t ssd1306_flush(SSD1306_t *dev);
 
 #endif /* SSD1306_H_ */
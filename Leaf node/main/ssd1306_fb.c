@@ -0,0 +1,79 @@
+#include <string.h>
+#include "ssd1306_fb.h"
+
+#define CTRL_CMD_SINGLE     0x80    // Co=1, D/C=0: 1 byte lệnh, sau đó còn control byte
+#define CTRL_DATA_STREAM    0x40    // Co=0, D/C=1: phần còn lại là data
+
+void ssd1306_fb_init(ssd1306_fb_t *fb) {
+    memset(fb->buf, 0x00, sizeof(fb->buf));
+    // RAM panel sau reset không xác định: shadow khác buf để lần flush đầu gửi hết
+    memset(fb->shadow, 0xFF, sizeof(fb->shadow));
+    fb->dirty_pages = 0xFF;
+}
+
+void ssd1306_fb_clear(ssd1306_fb_t *fb) {
+    memset(fb->buf, 0x00, sizeof(fb->buf));
+    fb->dirty_pages = 0xFF;
+}
+
+void ssd1306_fb_write(ssd1306_fb_t *fb, int page, int col, const uint8_t *data, size_t len, bool invert) {
+    if (page < 0 || page >= SSD1306_FB_PAGES || col < 0 || col >= SSD1306_FB_COLS) return;
+    if (len > (size_t)(SSD1306_FB_COLS - col)) len = SSD1306_FB_COLS - col;
+
+    uint8_t *dst = &fb->buf[page][col];
+    for (size_t i = 0; i < len; i++) dst[i] = invert ? (uint8_t)~data[i] : data[i];
+    fb->dirty_pages |= (uint8_t)(1u << page);
+}
+
+bool ssd1306_fb_dirty_region(const ssd1306_fb_t *fb, ssd1306_region_t *r) {
+    int p0 = -1, p1 = -1, c0 = SSD1306_FB_COLS, c1 = -1;
+
+    for (int p = 0; p < SSD1306_FB_PAGES; p++) {
+        if (!(fb->dirty_pages & (1u << p))) continue;
+        const uint8_t *b = fb->buf[p], *s = fb->shadow[p];
+
+        int lo = 0, hi = SSD1306_FB_COLS - 1;
+        while (lo <= hi && b[lo] == s[lo]) lo++;
+        if (lo > hi) continue;                      // page ghi lại đúng nội dung cũ
+        while (b[hi] == s[hi]) hi--;
+
+        if (p0 < 0) p0 = p;
+        p1 = p;
+        if (lo < c0) c0 = lo;
+        if (hi > c1) c1 = hi;
+    }
+    if (p0 < 0) return false;
+
+    r->page0 = (uint8_t)p0; r->page1 = (uint8_t)p1;
+    r->col0  = (uint8_t)c0; r->col1  = (uint8_t)c1;
+    return true;
+}
+
+size_t ssd1306_fb_build_flush(const ssd1306_fb_t *fb, const ssd1306_region_t *r, uint8_t *out, size_t cap) {
+    size_t w = (size_t)(r->col1 - r->col0 + 1);
+    size_t h = (size_t)(r->page1 - r->page0 + 1);
+    if (cap < 12 + 1 + w * h) return 0;
+
+    const uint8_t cmds[6] = { 0x21, r->col0, r->col1,      // column address
+                              0x22, r->page0, r->page1 };  // page address
+    size_t n = 0;
+    for (int i = 0; i < 6; i++) {
+        out[n++] = CTRL_CMD_SINGLE;
+        out[n++] = cmds[i];
+    }
+    out[n++] = CTRL_DATA_STREAM;
+    for (int p = r->page0; p <= r->page1; p++) {
+        memcpy(&out[n], &fb->buf[p][r->col0], w);
+        n += w;
+    }
+    return n;
+}
+
+void ssd1306_fb_commit(ssd1306_fb_t *fb, const ssd1306_region_t *r) {
+    size_t w = (size_t)(r->col1 - r->col0 + 1);
+    for (int p = r->page0; p <= r->page1; p++) {
+        memcpy(&fb->shadow[p][r->col0], &fb->buf[p][r->col0], w);
+    }
+    // vùng ngoài hộp bao đã trùng shadow nên không còn page nào bẩn
+    fb->dirty_pages = 0;
+}
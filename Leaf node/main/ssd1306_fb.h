@@ -0,0 +1,40 @@
+#ifndef SSD1306_FB_H_
+#define SSD1306_FB_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ==== Framebuffer 128x64 (1 KB) + diff với nội dung đang có trên panel ====
+// Không phụ thuộc I2C: vẽ vào buf, flush chỉ gửi vùng khác với shadow.
+#define SSD1306_FB_PAGES    8
+#define SSD1306_FB_COLS     128
+
+// 6 lệnh (0x80 + cmd) + control byte data + toàn bộ 1 KB
+#define SSD1306_FB_FLUSH_MAX    (12 + 1 + SSD1306_FB_PAGES * SSD1306_FB_COLS)
+
+typedef struct {
+    uint8_t buf[SSD1306_FB_PAGES][SSD1306_FB_COLS];
+    uint8_t shadow[SSD1306_FB_PAGES][SSD1306_FB_COLS];  // những gì panel đang hiển thị
+    uint8_t dirty_pages;                                // bit p: page p có ghi từ lần flush trước
+} ssd1306_fb_t;
+
+typedef struct {
+    uint8_t page0, page1;   // bao gồm cả 2 đầu
+    uint8_t col0, col1;
+} ssd1306_region_t;
+
+void ssd1306_fb_init(ssd1306_fb_t *fb);
+void ssd1306_fb_clear(ssd1306_fb_t *fb);
+void ssd1306_fb_write(ssd1306_fb_t *fb, int page, int col, const uint8_t *data, size_t len, bool invert);
+
+// Hộp bao các byte khác shadow; false nếu panel đã đúng
+bool ssd1306_fb_dirty_region(const ssd1306_fb_t *fb, ssd1306_region_t *r);
+
+// Dựng 1 transaction I2C: đặt cửa sổ cột/page rồi stream data. Trả về số byte.
+size_t ssd1306_fb_build_flush(const ssd1306_fb_t *fb, const ssd1306_region_t *r, uint8_t *out, size_t cap);
+
+// Gọi sau khi gửi thành công: shadow = buf trong vùng r
+void ssd1306_fb_commit(ssd1306_fb_t *fb, const ssd1306_region_t *r);
+
+#endif /* SSD1306_FB_H_ */
@@ -0,0 +1,71 @@
+#include <string.h>
+#include "time_sync.h"
+
+void time_sync_init(time_sync_t *ts) {
+    memset(ts, 0, sizeof(*ts));
+}
+
+int64_t time_sync_now(const time_sync_t *ts, int64_t local_us) {
+    return local_us + ts->offset_us + (int64_t)(ts->drift * (float)(local_us - ts->ref_local_us));
+}
+
+static void time_sync_step(time_sync_t *ts, int64_t sample, int64_t local_rx_us) {
+    ts->offset_us    = sample;
+    ts->ref_local_us = local_rx_us;
+    ts->drift        = 0.0f;
+    ts->rejects      = 0;
+    ts->synced       = true;
+    ts->steps++;
+}
+
+int32_t time_sync_on_beacon(time_sync_t *ts, int64_t root_us, uint32_t owd_us, bool utc, int64_t local_rx_us) {
+    int64_t sample = root_us + owd_us - local_rx_us;
+    ts->samples++;
+
+    // lần đầu hoặc root đổi gốc thời gian (vừa có SNTP): nhảy thẳng
+    if (!ts->synced || utc != ts->utc) {
+        ts->utc = utc;
+        time_sync_step(ts, sample, local_rx_us);
+        ts->last_err_us = 0;
+        return 0;
+    }
+
+    int64_t err = sample - (time_sync_now(ts, local_rx_us) - local_rx_us);
+    ts->last_err_us = (err > INT32_MAX) ? INT32_MAX : (err < INT32_MIN) ? INT32_MIN : (int32_t)err;
+
+    if (err > TS_STEP_US || err < -TS_STEP_US) {
+        time_sync_step(ts, sample, local_rx_us);
+        return ts->last_err_us;
+    }
+    if (err < -TS_OUTLIER_US) {
+        ts->outliers++;
+        if (++ts->rejects >= TS_STEP_AFTER) time_sync_step(ts, sample, local_rx_us);
+        return ts->last_err_us;
+    }
+    ts->rejects = 0;
+
+    // drift = độ dốc offset giữa 2 lần sửa, offset mới = ước lượng + 1 phần sai số
+    int64_t dt = local_rx_us - ts->ref_local_us;
+    int64_t predicted = sample - err;
+    if (dt > 0) {
+        float d = (float)(sample - ts->offset_us) / (float)dt;
+        ts->drift += TS_DRIFT_GAIN * (d - ts->drift);
+        if (ts->drift > TS_DRIFT_MAX)  ts->drift = TS_DRIFT_MAX;
+        if (ts->drift < -TS_DRIFT_MAX) ts->drift = -TS_DRIFT_MAX;
+    }
+    ts->offset_us    = predicted + (int64_t)(TS_GAIN * (float)err);
+    ts->ref_local_us = local_rx_us;
+    return ts->last_err_us;
+}
+
+int64_t time_sync_slot_wait(int64_t mesh_us, uint32_t period_ms, uint8_t slot, uint8_t slots) {
+    int64_t period = (int64_t)period_ms * 1000;
+    if (period <= 0 || slots == 0) return period;
+
+    int64_t phase = period * slot / slots;
+    int64_t pos   = (mesh_us - phase) % period;
+    if (pos < 0) pos += period;
+    int64_t wait = period - pos;
+    if (wait < period / 4) wait += period;
+    return wait;
+}
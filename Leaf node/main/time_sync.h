@@ -0,0 +1,45 @@
+#ifndef TIME_SYNC_H_
+#define TIME_SYNC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==== Ước lượng mesh time từ beacon của root (không phụ thuộc ESP-IDF) ====
+// mesh = local + offset + drift * (local - ref_local).
+// Mẫu offset = (root_us + owd_us) - local lúc nhận beacon. Beacon bị kẹt hàng đợi
+// cho mẫu nhỏ hơn thật nên mẫu lệch âm quá TS_OUTLIER_US bị bỏ; bỏ liên tiếp
+// TS_STEP_AFTER lần (vd đường đi đổi hẳn) hoặc lệch quá TS_STEP_US thì nhảy thẳng.
+#define TS_OUTLIER_US       3000
+#define TS_STEP_US          50000
+#define TS_STEP_AFTER       3
+#define TS_GAIN             0.5f    // phần sai số được sửa vào offset mỗi mẫu
+#define TS_DRIFT_GAIN       0.3f    // EWMA cho drift
+#define TS_DRIFT_MAX        200e-6f // thạch anh ESP32 cỡ ±20 ppm, kẹp rộng gấp 10
+
+typedef struct {
+    bool     synced;
+    bool     utc;           // mesh time là UTC (root đã có SNTP)
+    int64_t  offset_us;     // mesh - local tại ref_local_us
+    int64_t  ref_local_us;
+    float    drift;         // s/s
+    int32_t  last_err_us;   // sai số mẫu gần nhất so với ước lượng
+    uint8_t  rejects;       // số mẫu bị bỏ liên tiếp
+    uint32_t samples;
+    uint32_t steps;
+    uint32_t outliers;
+} time_sync_t;
+
+void time_sync_init(time_sync_t *ts);
+
+// Cập nhật từ 1 beacon, trả về sai số mẫu (us) so với ước lượng trước đó
+int32_t time_sync_on_beacon(time_sync_t *ts, int64_t root_us, uint32_t owd_us, bool utc, int64_t local_rx_us);
+
+// Mesh time ứng với đồng hồ local, chỉ có nghĩa khi synced
+int64_t time_sync_now(const time_sync_t *ts, int64_t local_us);
+
+// Slot gửi: mốc = k * period + slot * period / slots theo mesh time (mọi leaf cùng lưới).
+// Trả về thời gian chờ (us) tới mốc kế tiếp; mốc gần hơn period/4 coi như vừa gửi (thức sớm
+// vài ms trước mốc) nên lùi sang chu kỳ sau để không gửi 2 lần liền nhau.
+int64_t time_sync_slot_wait(int64_t mesh_us, uint32_t period_ms, uint8_t slot, uint8_t slots);
+
+#endif /* TIME_SYNC_H_ */
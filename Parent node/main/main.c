@@ -11,6 +11,13 @@
 #include "esp_netif.h"
 #include "esp_wifi.h"
 #include "esp_mesh.h"
+#include "esp_timer.h"
+#include "batch.h"
+#include "frag.h"
+#include "cmd.h"
+#include "congest.h"
+#include "telemetry.h"
+#include "stat_reduce.h"
 
 //#define TAG "RELAY_NODE_A"
 #define TAG "RELAY_NODE_B"
@@ -20,6 +27,22 @@ static const uint8_t MESH_ID[6] = { 0x7A,0x10,0x20,0x30,0x40,0x50 };
 #define ROUTER_PASS     "TinhHoa978"
 #define ROUTER_CHANNEL  0          // 0 = auto
 
+// Gộp frame của leaf con thành 1 frame BATCH gửi root, đóng khi đủ 1 trong 3 ngưỡng.
+// RELAY_AGGREGATE 0: mỗi frame đi riêng (batch 1 phần tử) — dùng để so sánh tải link root.
+#define RELAY_AGGREGATE       1
+#define RELAY_BATCH_FRAMES    8
+#define RELAY_BATCH_BYTES     1024    // > FRAG_RX_MAX thì batch đi thành nhiều mảnh FRAG
+#define RELAY_BATCH_WINDOW_MS 500
+#define RELAY_STATS_PERIOD_MS 10000
+
+// Rút gọn telemetry: mỗi leaf gửi 1 SUMMARY (min/max/mean/count/last) mỗi cửa sổ thay cho
+// mẫu thô. 0 = tắt; đổi lúc chạy bằng lệnh "relay_window", từng leaf thô bằng "relay_raw".
+#define RELAY_REDUCE_WINDOW_MS 0
+#define RELAY_REDUCE_POLL_MS   100
+// Root báo nghẽn >= CONG_LEVEL_SUMMARY: rút gọn mọi leaf (trừ leaf đặt thô) với cửa sổ ít nhất
+// bằng mức này, hết nghẽn thì về cửa sổ cấu hình
+#define RELAY_CONG_WINDOW_MS   30000
+
 static esp_netif_t *g_mesh_netif_sta = NULL;
 static esp_netif_t *g_mesh_netif_ap  = NULL;
 static volatile bool g_mesh_connected = false;
@@ -27,6 +50,31 @@ static mesh_addr_t   g_parent_bssid = {0};
 static mesh_addr_t   g_root_addr    = {0};
 static volatile bool g_have_root    = false;
 
+typedef enum {
+    FLUSH_COUNT = 0,
+    FLUSH_BYTES,
+    FLUSH_TIME,
+    FLUSH_REASONS
+} flush_reason_t;
+
+typedef struct {
+    uint32_t rx_frames;         // frame từ leaf con
+    uint32_t tx_frames;         // frame gửi lên root (= tải link root)
+    uint32_t tx_bytes;
+    uint32_t tx_fail;
+    uint32_t dropped;           // chưa có root / frame quá dài
+    uint32_t reduced;           // mẫu telemetry gộp vào summary
+    uint32_t summaries;
+    uint32_t alarms;            // frame lớp ALARM chuyển ngay, không chờ batch
+    uint32_t flushes[FLUSH_REASONS];
+} relay_stats_t;
+
+static relay_stats_t g_relay;
+static stat_reduce_t g_reduce;      // chỉ relay_fwd_task truy cập
+static uint32_t      s_window_cfg = RELAY_REDUCE_WINDOW_MS;    // theo lệnh relay_window
+static uint8_t       s_cong_level = 0;
+static int64_t       s_cong_until_us = 0;
+
 
 static void wifi_country_1_13(void) {
     wifi_country_t c = { .cc = "CN", .schan = 1, .nchan = 13, .policy = WIFI_COUNTRY_POLICY_MANUAL };
@@ -91,9 +139,215 @@ static void mesh_event_handler(void *arg, esp_event_base_t base, int32_t id, voi
 
 
 
-static void mesh_sniff_task(void *arg) {
+static uint8_t          s_batch_buf[RELAY_BATCH_BYTES];
+static batch_builder_t  s_batch;
+static int64_t          s_batch_open_us;   // thời điểm frame đầu tiên vào batch
+
+// Gửi message lên root; dài hơn buffer nhận của root thì cắt mảnh
+static esp_err_t relay_send(const uint8_t *msg, size_t len) {
+    static uint8_t  frag_buf[FRAG_RX_MAX];
+    static uint16_t msg_id = 0;
+    mesh_addr_t dest = g_root_addr;
+    mesh_data_t tx = { .data = (uint8_t *)msg, .size = (uint16_t)len, .proto = MESH_PROTO_BIN, .tos = MESH_TOS_P2P };
+
+    if (len <= FRAG_RX_MAX) {
+        esp_err_t err = esp_mesh_send(&dest, &tx, MESH_DATA_P2P, NULL, 0);
+        if (err == ESP_OK) g_relay.tx_frames++;
+        return err;
+    }
+
+    uint8_t count = frag_count(len);
+    if (count == 0) return ESP_ERR_INVALID_SIZE;
+    msg_id++;
+    tx.data = frag_buf;
+    for (uint8_t i = 0; i < count; i++) {
+        tx.size = (uint16_t)frag_encode(msg, len, msg_id, i, frag_buf, sizeof(frag_buf));
+        // mất 1 mảnh là mất cả message, không gửi tiếp
+        esp_err_t err = esp_mesh_send(&dest, &tx, MESH_DATA_P2P, NULL, 0);
+        if (err != ESP_OK) return err;
+        g_relay.tx_frames++;
+    }
+    return ESP_OK;
+}
+
+static void relay_flush(flush_reason_t why) {
+    size_t len = batch_finish(&s_batch);
+    if (len == 0) return;
+
+    esp_err_t err = relay_send(s_batch_buf, len);
+    if (err == ESP_OK) {
+        g_relay.tx_bytes += len;
+        g_relay.flushes[why]++;
+    } else {
+        g_relay.tx_fail++;
+        ESP_LOGW(TAG, "Batch %u frames -> root fail: %s", s_batch.count, esp_err_to_name(err));
+    }
+    batch_begin(&s_batch, s_batch_buf, RELAY_BATCH_BYTES);
+}
+
+// ALARM: batch 1 phần tử (giữ MAC leaf) gửi ngay, đi trước batch TELEMETRY đang mở
+static void relay_send_alarm(const uint8_t mac[6], const uint8_t *data, size_t len) {
+    static uint8_t buf[BATCH_FRAME_MAX];
+    batch_builder_t b;
+
+    batch_begin(&b, buf, sizeof(buf));
+    if (!batch_add(&b, mac, data, len)) {
+        g_relay.dropped++;
+        return;
+    }
+    size_t n = batch_finish(&b);
+    mesh_proto_set_class(buf, MESH_CLASS_ALARM);
+
+    esp_err_t err = relay_send(buf, n);
+    if (err == ESP_OK) {
+        g_relay.tx_bytes += n;
+        g_relay.alarms++;
+    } else {
+        g_relay.tx_fail++;
+        ESP_LOGW(TAG, "Alarm " MACSTR " -> root fail: %s", MAC2STR(mac), esp_err_to_name(err));
+    }
+}
+
+static void relay_log_stats(uint32_t dt_ms) {
+    static relay_stats_t prev;
+    float dt = dt_ms / 1000.0f;
+    uint32_t rx = g_relay.rx_frames - prev.rx_frames;
+    uint32_t tx = g_relay.tx_frames - prev.tx_frames;
+
+    ESP_LOGI(TAG, "Relay: in %.1f frame/s, root link %.1f frame/s (%.1f B/s), %.2f frame/batch, "
+             "flush count/bytes/time=%u/%u/%u, fail=%u, drop=%u, reduced=%u -> %u summaries, alarms=%u",
+             rx / dt, tx / dt, (g_relay.tx_bytes - prev.tx_bytes) / dt, tx ? (float)rx / tx : 0.0f,
+             (unsigned)g_relay.flushes[FLUSH_COUNT], (unsigned)g_relay.flushes[FLUSH_BYTES],
+             (unsigned)g_relay.flushes[FLUSH_TIME], (unsigned)g_relay.tx_fail, (unsigned)g_relay.dropped,
+             (unsigned)g_relay.reduced, (unsigned)g_relay.summaries, (unsigned)g_relay.alarms);
+    prev = g_relay;
+}
+
+static void relay_enqueue(const uint8_t mac[6], const uint8_t *data, size_t len, int max_frames) {
+    if (batch_empty(&s_batch)) s_batch_open_us = esp_timer_get_time();
+    if (!batch_add(&s_batch, mac, data, len)) {
+        relay_flush(FLUSH_BYTES);
+        s_batch_open_us = esp_timer_get_time();
+        if (!batch_add(&s_batch, mac, data, len)) g_relay.dropped++;
+    }
+    if (s_batch.count >= max_frames) relay_flush(FLUSH_COUNT);
+}
+
+// true nếu frame telemetry đã được gộp vào cửa sổ, không cần chuyển thô
+static bool relay_reduce(const uint8_t mac[6], const uint8_t *data, size_t len, uint32_t now_ms) {
+    telemetry_t t;
+    if (g_reduce.window_ms == 0 || !telemetry_decode(data, len, &t)) return false;
+
+    sr_node_t *n = sr_node(&g_reduce, mac, now_ms);
+    if (!n || n->raw) return false;
+
+    int32_t  v[SUMMARY_FIELDS] = { t.temp, t.humi, t.light_raw, t.motion };
+    uint32_t valid = (1u << SUMMARY_LIGHT) | (1u << SUMMARY_MOTION);
+    if (t.flags & TLM_FLAG_DHT_OK) valid |= (1u << SUMMARY_TEMP) | (1u << SUMMARY_HUMI);
+    sr_add(n, t.node_id, t.seq, v, valid, now_ms);
+    g_relay.reduced++;
+    return true;
+}
+
+// Cửa sổ hết hạn -> SUMMARY vào batch, mang MAC leaf như frame thô
+static void relay_emit_summaries(uint32_t now_ms, int max_frames) {
+    uint8_t buf[SUMMARY_FRAME_LEN];
+    summary_t sum;
+
+    for (int i = 0; i < SR_MAX_NODES; i++) {
+        sr_node_t *n = &g_reduce.nodes[i];
+        if (!sr_due(&g_reduce, n, now_ms) || !sr_take(n, &sum)) continue;
+        relay_enqueue(n->mac, buf, summary_encode(&sum, buf, sizeof(buf)), max_frames);
+        g_relay.summaries++;
+    }
+}
+
+// Đổi cửa sổ rút gọn. Tắt thì xả các cửa sổ dở thành SUMMARY thay vì bỏ mẫu.
+static void relay_set_window(uint32_t window_ms) {
+    const int max_frames = RELAY_AGGREGATE ? RELAY_BATCH_FRAMES : 1;
+    if (window_ms == g_reduce.window_ms) return;
+
+    if (window_ms == 0) {
+        uint8_t buf[SUMMARY_FRAME_LEN];
+        summary_t sum;
+        for (int i = 0; i < SR_MAX_NODES; i++) {
+            sr_node_t *n = &g_reduce.nodes[i];
+            if (!sr_take(n, &sum)) continue;
+            if (!g_have_root || !g_mesh_connected) {
+                g_relay.dropped++;
+                continue;
+            }
+            relay_enqueue(n->mac, buf, summary_encode(&sum, buf, sizeof(buf)), max_frames);
+            g_relay.summaries++;
+        }
+    }
+    g_reduce.window_ms = window_ms;
+    ESP_LOGI(TAG, "Reduce window = %ums (cfg %ums, congestion %u)",
+             (unsigned)window_ms, (unsigned)s_window_cfg, s_cong_level);
+}
+
+static void relay_apply_window(void) {
+    uint32_t w = s_window_cfg;
+    if (s_cong_level >= CONG_LEVEL_SUMMARY && w < RELAY_CONG_WINDOW_MS) w = RELAY_CONG_WINDOW_MS;
+    relay_set_window(w);
+}
+
+static void relay_congest(const congest_t *c) {
+    s_cong_until_us = esp_timer_get_time() + c->ttl_s * 1000000LL;
+    if (c->level == s_cong_level) return;
+    ESP_LOGW(TAG, "Root congestion %u -> %u", s_cong_level, c->level);
+    s_cong_level = c->level;
+    relay_apply_window();
+}
+
+static bool parse_mac_arg(const cmd_t *c, uint8_t mac[6]) {
+    if (c->arg_len < 7) return false;
+    memcpy(mac, c->arg, 6);
+    return true;
+}
+
+// Lệnh root gửi riêng cho relay (topic MQTT của relay)
+static void relay_cmd(const mesh_addr_t *from, const cmd_t *c) {
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    cmd_ack_t ack = { .cmd_id = c->cmd_id, .op = c->op, .status = CMD_OK };
+    uint8_t mac[6];
+
+    switch (c->op) {
+    case CMD_OP_PING:
+        break;
+    case CMD_OP_RELAY_WINDOW:
+        if (c->arg_len < 4) { ack.status = CMD_ERR_ARG; break; }
+        // cửa sổ đang mở được đóng ở vòng kế tiếp theo ngưỡng mới
+        s_window_cfg = mp_get_u32(c->arg);
+        relay_apply_window();
+        break;
+    case CMD_OP_RELAY_RAW: {
+        if (!parse_mac_arg(c, mac)) { ack.status = CMD_ERR_ARG; break; }
+        sr_node_t *n = sr_node(&g_reduce, mac, now_ms);
+        if (!n) { ack.status = CMD_ERR_FAIL; break; }
+        n->raw = c->arg[6] != 0;
+        ESP_LOGI(TAG, "Leaf " MACSTR ": %s", MAC2STR(mac), n->raw ? "raw" : "reduced");
+        break;
+    }
+    default:
+        ack.status = CMD_ERR_OP;
+        break;
+    }
+
+    uint8_t buf[CMD_ACK_LEN];
+    mesh_data_t tx = {
+        .data  = buf,
+        .size  = (uint16_t)cmd_ack_encode(&ack, buf, sizeof(buf)),
+        .proto = MESH_PROTO_BIN,
+        .tos   = MESH_TOS_P2P,
+    };
+    esp_mesh_send(from, &tx, MESH_DATA_P2P | MESH_DATA_NONBLOCK, NULL, 0);
+}
+
+// Leaf con gửi frame cho relay (parent), relay gộp rồi chuyển lên root
+static void relay_fwd_task(void *arg) {
     mesh_addr_t from;
-    uint8_t rx_buf[256];
+    static uint8_t rx_buf[256];
     mesh_data_t rx = {
         .data  = rx_buf,
         .size  = sizeof(rx_buf),
@@ -101,15 +355,57 @@ static void mesh_sniff_task(void *arg) {
         .tos   = MESH_TOS_P2P
     };
     int flag = 0;
+    int64_t last_stats = esp_timer_get_time();
+    const int max_frames = RELAY_AGGREGATE ? RELAY_BATCH_FRAMES : 1;
+
+    batch_begin(&s_batch, s_batch_buf, RELAY_BATCH_BYTES);
+    sr_init(&g_reduce, RELAY_REDUCE_WINDOW_MS);
 
     for (;;) {
+        // batch đang mở: chỉ chờ tới hạn cửa sổ; đang rút gọn: dậy định kỳ để đóng cửa sổ
+        int timeout_ms = g_reduce.window_ms ? RELAY_REDUCE_POLL_MS : 1000;
+        if (!batch_empty(&s_batch)) {
+            int64_t left = s_batch_open_us + RELAY_BATCH_WINDOW_MS * 1000LL - esp_timer_get_time();
+            if (left < timeout_ms * 1000LL) timeout_ms = left > 0 ? (int)((left + 999) / 1000) : 0;
+        }
+
         rx.size = sizeof(rx_buf);
-        esp_err_t err = esp_mesh_recv(&from, &rx, 1000 / portTICK_PERIOD_MS, &flag, NULL, 0);
-        if (err == ESP_OK) {
-            size_t n = (rx.size < sizeof(rx_buf)) ? rx.size : sizeof(rx_buf)-1;
-            rx_buf[n] = '\0';
-            ESP_LOGI(TAG, "RX (child=" MACSTR "): %s", MAC2STR(from.addr), (char*)rx.data);
-            flag = 0;
+        esp_err_t err = esp_mesh_recv(&from, &rx, timeout_ms, &flag, NULL, 0);
+        uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+        cmd_t cmd;
+        congest_t cong;
+        if (err == ESP_OK && cmd_decode(rx.data, rx.size, &cmd)) {
+            relay_cmd(&from, &cmd);
+        } else if (err == ESP_OK && congest_decode(rx.data, rx.size, &cong)) {
+            relay_congest(&cong);
+        } else if (err == ESP_OK) {
+            g_relay.rx_frames++;
+            if (!g_have_root || !g_mesh_connected) {
+                g_relay.dropped++;
+            } else if (mesh_proto_class(rx.data, rx.size) == MESH_CLASS_ALARM) {
+                relay_send_alarm(from.addr, rx.data, rx.size);
+            } else if (!relay_reduce(from.addr, rx.data, rx.size, now_ms)) {
+                relay_enqueue(from.addr, rx.data, rx.size, max_frames);
+            }
+        }
+        flag = 0;
+        // mất các lần nhắc lại (vd root khởi động lại) -> tự hết nghẽn
+        if (s_cong_level && esp_timer_get_time() >= s_cong_until_us) {
+            ESP_LOGW(TAG, "Congestion notice expired");
+            s_cong_level = 0;
+            relay_apply_window();
+        }
+        if (g_reduce.window_ms && g_have_root && g_mesh_connected) relay_emit_summaries(now_ms, max_frames);
+
+        if (!batch_empty(&s_batch) &&
+            esp_timer_get_time() - s_batch_open_us >= RELAY_BATCH_WINDOW_MS * 1000LL) {
+            relay_flush(FLUSH_TIME);
+        }
+
+        int64_t now = esp_timer_get_time();
+        if (now - last_stats >= RELAY_STATS_PERIOD_MS * 1000LL) {
+            relay_log_stats((uint32_t)((now - last_stats) / 1000));
+            last_stats = now;
         }
     }
 }
@@ -174,5 +470,5 @@ void app_main(void) {
     ESP_LOGI(TAG, "RELAY STA MAC : " MACSTR, MAC2STR(sta_mac));
     ESP_LOGI(TAG, "RELAY BSSID   : " MACSTR " (Mesh SoftAP)", MAC2STR(ap_mac));
 
-    xTaskCreate(mesh_sniff_task, "mesh_sniff", 4096, NULL, 4, NULL);
+    xTaskCreate(relay_fwd_task, "relay_fwd", 4096, NULL, 4, NULL);
 }
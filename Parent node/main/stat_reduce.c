@@ -0,0 +1,95 @@
+#include <string.h>
+#include "stat_reduce.h"
+
+void sr_init(stat_reduce_t *sr, uint32_t window_ms) {
+    memset(sr, 0, sizeof(*sr));
+    sr->window_ms = window_ms;
+}
+
+sr_node_t *sr_node(stat_reduce_t *sr, const uint8_t mac[6], uint32_t now_ms) {
+    sr_node_t *free_slot = NULL;
+    uint32_t idle_ms = sr->window_ms * SR_IDLE_WINDOWS;
+
+    for (int i = 0; i < SR_MAX_NODES; i++) {
+        sr_node_t *n = &sr->nodes[i];
+        if (n->used && memcmp(n->mac, mac, 6) == 0) return n;
+        if (free_slot) continue;
+        if (!n->used) {
+            free_slot = n;
+            continue;
+        }
+        // entry cũ im lặng quá lâu và không còn mẫu dở thì dùng lại. Không đụng entry raw
+        // (lệnh relay_raw, không tự hết hạn) và không thu hồi khi tắt rút gọn: idle_ms = 0
+        // thì mỗi MAC mới sẽ lấy chỗ của MAC trước.
+        if (sr->window_ms && !n->raw && n->samples == 0 && now_ms - n->last_ms > idle_ms) free_slot = n;
+    }
+    if (!free_slot) {
+        sr->full_drops++;
+        return NULL;
+    }
+    memset(free_slot, 0, sizeof(*free_slot));
+    free_slot->used    = true;
+    free_slot->last_ms = now_ms;
+    memcpy(free_slot->mac, mac, 6);
+    return free_slot;
+}
+
+void sr_add(sr_node_t *n, uint16_t node_id, uint16_t seq,
+            const int32_t v[SUMMARY_FIELDS], uint32_t valid_mask, uint32_t now_ms) {
+    if (n->samples == 0) {
+        n->seq_first = seq;
+        n->first_ms  = now_ms;
+    }
+    n->node_id  = node_id;
+    n->seq_last = seq;
+    n->last_ms  = now_ms;
+    if (n->samples < UINT16_MAX) n->samples++;
+
+    for (int i = 0; i < SUMMARY_FIELDS; i++) {
+        sr_acc_t *a = &n->f[i];
+        if (!(valid_mask & (1u << i)) || a->count == UINT16_MAX) continue;
+        if (a->count == 0 || v[i] < a->min) a->min = v[i];
+        if (a->count == 0 || v[i] > a->max) a->max = v[i];
+        a->last = v[i];
+        a->sum += v[i];
+        a->count++;
+    }
+}
+
+bool sr_due(const stat_reduce_t *sr, const sr_node_t *n, uint32_t now_ms) {
+    return n->used && n->samples > 0 && now_ms - n->first_ms >= sr->window_ms;
+}
+
+static int16_t clamp16(int32_t v) {
+    return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : (int16_t)v;
+}
+
+bool sr_take(sr_node_t *n, summary_t *out) {
+    if (n->samples == 0) return false;
+
+    memset(out, 0, sizeof(*out));
+    out->node_id   = n->node_id;
+    out->seq_first = n->seq_first;
+    out->seq_last  = n->seq_last;
+    out->samples   = n->samples;
+    out->span_ms   = n->last_ms - n->first_ms;
+    for (int i = 0; i < SUMMARY_FIELDS; i++) {
+        const sr_acc_t *a = &n->f[i];
+        if (a->count == 0) continue;
+        // làm tròn về phía xa 0
+        int64_t x100 = (int64_t)a->sum * 100;
+        x100 += (x100 >= 0 ? a->count / 2 : -(a->count / 2));
+        out->field_mask |= (uint8_t)(1u << i);
+        out->f[i] = (summary_stat_t){
+            .count     = a->count,
+            .min       = clamp16(a->min),
+            .max       = clamp16(a->max),
+            .last      = clamp16(a->last),
+            .mean_x100 = (int32_t)(x100 / a->count),
+        };
+    }
+
+    n->samples = 0;
+    memset(n->f, 0, sizeof(n->f));
+    return true;
+}
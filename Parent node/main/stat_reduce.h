@@ -0,0 +1,56 @@
+#ifndef STAT_REDUCE_H_
+#define STAT_REDUCE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "summary.h"
+
+// ==== Rút gọn telemetry theo cửa sổ tại relay (không phụ thuộc ESP-IDF) ====
+// Mỗi leaf 1 entry cố định: min/max/tổng/đếm/giá trị cuối cho từng trường.
+// Hết cửa sổ -> sr_take ra summary_t rồi bắt đầu cửa sổ mới. Không cấp phát động.
+#define SR_MAX_NODES    16
+#define SR_IDLE_WINDOWS 4       // entry không có mẫu quá N cửa sổ -> được cấp cho leaf khác (trừ entry raw)
+
+typedef struct {
+    int32_t  min;
+    int32_t  max;
+    int32_t  last;
+    int32_t  sum;               // 65535 mẫu x 4095 vẫn vừa int32
+    uint16_t count;
+} sr_acc_t;
+
+typedef struct {
+    bool     used;
+    bool     raw;               // leaf này chuyển thô, không rút gọn
+    uint8_t  mac[6];
+    uint16_t node_id;
+    uint16_t seq_first;
+    uint16_t seq_last;
+    uint16_t samples;
+    uint32_t first_ms;          // mẫu đầu cửa sổ
+    uint32_t last_ms;           // mẫu gần nhất
+    sr_acc_t f[SUMMARY_FIELDS];
+} sr_node_t;
+
+typedef struct {
+    sr_node_t nodes[SR_MAX_NODES];
+    uint32_t  window_ms;        // 0 = tắt rút gọn
+    uint32_t  full_drops;       // bảng đầy, leaf mới đi thô
+} stat_reduce_t;
+
+void sr_init(stat_reduce_t *sr, uint32_t window_ms);
+
+// Tìm hoặc cấp entry cho mac, NULL nếu bảng đầy. window_ms = 0 thì không thu hồi entry nào.
+sr_node_t *sr_node(stat_reduce_t *sr, const uint8_t mac[6], uint32_t now_ms);
+
+// valid_mask: bit (1 << summary_field_t) = v[i] hợp lệ
+void sr_add(sr_node_t *n, uint16_t node_id, uint16_t seq,
+            const int32_t v[SUMMARY_FIELDS], uint32_t valid_mask, uint32_t now_ms);
+
+// true nếu entry có mẫu và cửa sổ đã hết
+bool sr_due(const stat_reduce_t *sr, const sr_node_t *n, uint32_t now_ms);
+
+// Xuất thống kê cửa sổ hiện tại rồi xóa, false nếu chưa có mẫu
+bool sr_take(sr_node_t *n, summary_t *out);
+
+#endif /* STAT_REDUCE_H_ */
@@ -0,0 +1,51 @@
+#include <string.h>
+#include "congest.h"
+#include "cong_monitor.h"
+
+// Ngưỡng vào mức 1..CONG_LEVEL_MAX
+static const uint8_t  s_ring_pct[CONG_LEVEL_MAX]   = { 25, 50, 75 };
+static const uint32_t s_outbox[CONG_LEVEL_MAX]     = { 8 * 1024, 16 * 1024, 32 * 1024 };
+static const uint32_t s_heap_below[CONG_LEVEL_MAX] = { 48 * 1024, 32 * 1024, 20 * 1024 };
+
+void cong_monitor_init(cong_monitor_t *c) {
+    memset(c, 0, sizeof(*c));
+}
+
+uint8_t cong_monitor_level_of(const cong_input_t *in) {
+    uint8_t level = 0;
+    for (int i = 0; i < CONG_LEVEL_MAX; i++) {
+        if (in->ring_pct >= s_ring_pct[i] || in->outbox_bytes >= s_outbox[i] ||
+            in->free_heap < s_heap_below[i]) {
+            level = (uint8_t)(i + 1);
+        }
+    }
+    return level;
+}
+
+bool cong_monitor_update(cong_monitor_t *c, const cong_input_t *in, uint32_t now_ms) {
+    c->raw = cong_monitor_level_of(in);
+
+    if (c->raw > c->level) {
+        c->level    = c->raw;
+        c->lowering = false;
+        c->changes++;
+        return true;
+    }
+    if (c->raw == c->level) {
+        c->lowering = false;
+        return false;
+    }
+
+    if (!c->lowering) {
+        c->lowering     = true;
+        c->low_since_ms = now_ms;
+        return false;
+    }
+    if (now_ms - c->low_since_ms < CONG_HOLD_MS) return false;
+
+    // xuống 1 bậc, bậc tiếp theo lại phải giữ đủ CONG_HOLD_MS
+    c->level--;
+    c->low_since_ms = now_ms;
+    c->changes++;
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef CONG_MONITOR_H_
+#define CONG_MONITOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==== Mức nghẽn của root từ độ đầy ring, outbox MQTT và heap (không phụ thuộc ESP-IDF) ====
+// Mức thô = max mức của từng đầu vào. Lên mức ngay, xuống từng bậc sau khi mức thô thấp
+// hơn liên tục CONG_HOLD_MS để leaf/relay không dao động theo từng đợt burst.
+#define CONG_HOLD_MS        10000
+
+typedef struct {
+    uint8_t  ring_pct;          // độ đầy lớn nhất của các ring trong kỳ đo (%)
+    uint32_t outbox_bytes;      // message MQTT chưa gửi/chưa được ACK
+    uint32_t free_heap;
+} cong_input_t;
+
+typedef struct {
+    uint8_t  level;
+    uint8_t  raw;               // mức thô lần đo gần nhất
+    bool     lowering;
+    uint32_t low_since_ms;
+    uint32_t changes;
+} cong_monitor_t;
+
+void cong_monitor_init(cong_monitor_t *c);
+
+// Mức thô 0..CONG_LEVEL_MAX của 1 lần đo
+uint8_t cong_monitor_level_of(const cong_input_t *in);
+
+// true nếu level đổi
+bool cong_monitor_update(cong_monitor_t *c, const cong_input_t *in, uint32_t now_ms);
+
+#endif /* CONG_MONITOR_H_ */
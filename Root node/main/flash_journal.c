@@ -0,0 +1,198 @@
+#include <string.h>
+#include "flash_journal.h"
+
+#define JOURNAL_MAGIC       0x4C4E524Au   // "JRNL"
+#define JOURNAL_REC_END     0xFFFF
+
+#define HDR_OFF_MAGIC       0
+#define HDR_OFF_SEQ         4
+#define HDR_OFF_CONSUMED    8
+
+static uint16_t crc16_ccitt(const uint8_t *p, size_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static inline uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void wr32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t page_addr(uint32_t page) {
+    return page * JOURNAL_PAGE_SIZE;
+}
+
+// Đánh dấu page đã replay xong: ghi 0 đè lên 0xFFFFFFFF (NOR chỉ kéo bit 1 -> 0)
+static void mark_consumed(journal_t *j, uint32_t page) {
+    static const uint8_t zero[4] = {0};
+    if (j->flash.write(j->flash.ctx, page_addr(page) + HDR_OFF_CONSUMED, zero, sizeof(zero)) != 0) {
+        j->stats.errors++;
+    }
+}
+
+static void reader_next_page(journal_t *j) {
+    j->r_page = (j->r_page + 1) % j->n_pages;
+    j->r_seq++;
+    j->r_off = JOURNAL_PAGE_HDR_LEN;
+}
+
+static int open_write_page(journal_t *j) {
+    // Đầy vòng: page sắp erase vẫn còn record chưa replay -> bỏ page cũ nhất
+    if (j->r_seq < j->w_seq && j->r_page == j->w_page) {
+        reader_next_page(j);
+        j->stats.dropped_pages++;
+    }
+    if (j->flash.erase(j->flash.ctx, page_addr(j->w_page), JOURNAL_PAGE_SIZE) != 0) {
+        j->stats.errors++;
+        return -1;
+    }
+    memset(j->page, 0xFF, sizeof(j->page));
+    wr32(&j->page[HDR_OFF_MAGIC], JOURNAL_MAGIC);
+    wr32(&j->page[HDR_OFF_SEQ], j->w_seq);
+    j->w_used    = JOURNAL_PAGE_HDR_LEN;
+    j->w_flushed = 0;
+    j->w_open    = true;
+    return 0;
+}
+
+int journal_mount(journal_t *j, const journal_flash_t *flash) {
+    memset(j, 0, sizeof(*j));
+    j->flash   = *flash;
+    j->n_pages = flash->size / JOURNAL_PAGE_SIZE;
+    if (j->n_pages < 2) return -1;
+
+    bool     have_any = false, have_tail = false;
+    uint32_t max_seq = 0, max_page = 0, min_seq = 0, min_page = 0;
+    uint8_t  hdr[JOURNAL_PAGE_HDR_LEN];
+
+    for (uint32_t p = 0; p < j->n_pages; p++) {
+        if (flash->read(flash->ctx, page_addr(p), hdr, sizeof(hdr)) != 0) return -1;
+        if (rd32(&hdr[HDR_OFF_MAGIC]) != JOURNAL_MAGIC) continue;
+
+        uint32_t seq = rd32(&hdr[HDR_OFF_SEQ]);
+        if (!have_any || seq > max_seq) { max_seq = seq; max_page = p; have_any = true; }
+        if (rd32(&hdr[HDR_OFF_CONSUMED]) == 0xFFFFFFFFu && (!have_tail || seq < min_seq)) {
+            min_seq = seq; min_page = p; have_tail = true;
+        }
+    }
+
+    // Luôn ghi tiếp sang page mới, không append vào page có thể bị ghi dở
+    j->w_page = have_any ? (max_page + 1) % j->n_pages : 0;
+    j->w_seq  = have_any ? max_seq + 1 : 1;
+
+    j->r_page = have_tail ? min_page : j->w_page;
+    j->r_seq  = have_tail ? min_seq  : j->w_seq;
+    j->r_off  = JOURNAL_PAGE_HDR_LEN;
+    return 0;
+}
+
+int journal_flush(journal_t *j) {
+    if (!j->w_open || j->w_flushed >= j->w_used) return 0;
+    if (j->flash.write(j->flash.ctx, page_addr(j->w_page) + j->w_flushed,
+                       &j->page[j->w_flushed], j->w_used - j->w_flushed) != 0) {
+        j->stats.errors++;
+        return -1;
+    }
+    j->w_flushed = j->w_used;
+    j->stats.flushes++;
+    return 0;
+}
+
+uint32_t journal_unflushed(const journal_t *j) {
+    return j->w_open ? j->w_used - j->w_flushed : 0;
+}
+
+int journal_append(journal_t *j, const void *data, size_t len) {
+    if (len == 0 || len > JOURNAL_MAX_RECORD) return -1;
+    size_t rec = JOURNAL_REC_HDR_LEN + len;
+
+    if (j->w_open && j->w_used + rec > JOURNAL_PAGE_SIZE) {
+        if (journal_flush(j) != 0) return -1;
+        j->w_page = (j->w_page + 1) % j->n_pages;
+        j->w_seq++;
+        j->w_open = false;
+    }
+    if (!j->w_open && open_write_page(j) != 0) return -1;
+
+    uint8_t *p = &j->page[j->w_used];
+    uint16_t crc = crc16_ccitt(data, len);
+    p[0] = (uint8_t)len; p[1] = (uint8_t)(len >> 8);
+    p[2] = (uint8_t)crc; p[3] = (uint8_t)(crc >> 8);
+    memcpy(&p[JOURNAL_REC_HDR_LEN], data, len);
+    j->w_used += rec;
+    j->stats.appended++;
+    return 0;
+}
+
+bool journal_empty(const journal_t *j) {
+    return j->r_seq == j->w_seq && (!j->w_open || j->r_off >= j->w_used);
+}
+
+int journal_peek(journal_t *j, void *buf, size_t cap) {
+    uint8_t rh[JOURNAL_PAGE_HDR_LEN];
+
+    for (;;) {
+        if (journal_empty(j)) return 0;
+
+        // Page đang ghi: toàn bộ nội dung có sẵn trong RAM
+        if (j->r_seq == j->w_seq) {
+            const uint8_t *p = &j->page[j->r_off];
+            uint16_t len = (uint16_t)(p[0] | (p[1] << 8));
+            if (len > cap) return -1;
+            memcpy(buf, &p[JOURNAL_REC_HDR_LEN], len);
+            j->r_len = len;
+            return len;
+        }
+
+        uint32_t base = page_addr(j->r_page);
+
+        // Mới vào page: kiểm tra header đúng page kế tiếp và chưa consumed
+        if (j->r_off == JOURNAL_PAGE_HDR_LEN) {
+            if (j->flash.read(j->flash.ctx, base, rh, sizeof(rh)) != 0) return -1;
+            if (rd32(&rh[HDR_OFF_MAGIC]) != JOURNAL_MAGIC || rd32(&rh[HDR_OFF_SEQ]) != j->r_seq
+                || rd32(&rh[HDR_OFF_CONSUMED]) != 0xFFFFFFFFu) {
+                reader_next_page(j);
+                continue;
+            }
+        }
+
+        uint16_t len = JOURNAL_REC_END, crc = 0;
+        if (j->r_off + JOURNAL_REC_HDR_LEN <= JOURNAL_PAGE_SIZE) {
+            if (j->flash.read(j->flash.ctx, base + j->r_off, rh, JOURNAL_REC_HDR_LEN) != 0) return -1;
+            len = (uint16_t)(rh[0] | (rh[1] << 8));
+            crc = (uint16_t)(rh[2] | (rh[3] << 8));
+        }
+
+        // Hết page (hoặc record ghi dở do mất điện) -> sang page sau
+        if (len == JOURNAL_REC_END || j->r_off + JOURNAL_REC_HDR_LEN + len > JOURNAL_PAGE_SIZE) {
+            mark_consumed(j, j->r_page);
+            reader_next_page(j);
+            continue;
+        }
+        if (len > cap) return -1;
+        if (j->flash.read(j->flash.ctx, base + j->r_off + JOURNAL_REC_HDR_LEN, buf, len) != 0) return -1;
+        if (crc16_ccitt(buf, len) != crc) {
+            j->stats.errors++;
+            mark_consumed(j, j->r_page);
+            reader_next_page(j);
+            continue;
+        }
+        j->r_len = len;
+        return len;
+    }
+}
+
+void journal_pop(journal_t *j) {
+    j->r_off += JOURNAL_REC_HDR_LEN + j->r_len;
+    j->r_len = 0;
+    j->stats.replayed++;
+}
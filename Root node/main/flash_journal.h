@@ -0,0 +1,80 @@
+#ifndef FLASH_JOURNAL_H_
+#define FLASH_JOURNAL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ==== Journal append-only trên flash (store-and-forward khi mất MQTT) ====
+// Vùng journal chia thành các page = 1 sector flash (4 KB), ghi vòng tròn
+// nên mọi sector mòn đều nhau. Mỗi page:
+//   header 16B: magic | seq | consumed (0xFFFFFFFF = chưa đọc xong) | reserved
+//   record    : len u16 | crc16 u16 | data[len]   (len = 0xFFFF -> hết page)
+// Record gom trong RAM, chỉ xuống flash khi đầy page hoặc khi flush,
+// nên mỗi frame không tốn 1 lần ghi flash. Page được đánh dấu consumed
+// khi replay xong toàn bộ; mất điện giữa chừng -> replay lại page đó
+// (at-least-once). Khi đầy, page cũ nhất bị ghi đè (dropped_pages++).
+#define JOURNAL_PAGE_SIZE       4096
+#define JOURNAL_PAGE_HDR_LEN    16
+#define JOURNAL_REC_HDR_LEN     4
+#define JOURNAL_MAX_RECORD      (JOURNAL_PAGE_SIZE - JOURNAL_PAGE_HDR_LEN - JOURNAL_REC_HDR_LEN)
+
+// Lớp flash trừu tượng: esp_partition trên chip, file trên Linux. Trả 0 nếu OK.
+typedef struct {
+    int (*read)(void *ctx, uint32_t off, void *buf, size_t len);
+    int (*write)(void *ctx, uint32_t off, const void *buf, size_t len);
+    int (*erase)(void *ctx, uint32_t off, size_t len);    // off/len bội số page
+    void     *ctx;
+    uint32_t  size;                                       // byte, bội số page
+} journal_flash_t;
+
+typedef struct {
+    uint32_t appended;
+    uint32_t replayed;
+    uint32_t flushes;
+    uint32_t dropped_pages;
+    uint32_t errors;
+} journal_stats_t;
+
+typedef struct {
+    journal_flash_t flash;
+    uint32_t n_pages;
+
+    // phía ghi
+    uint32_t w_page;
+    uint32_t w_seq;
+    uint32_t w_used;        // byte đã dùng trong page (kể cả header)
+    uint32_t w_flushed;     // byte đã xuống flash
+    bool     w_open;        // page ghi đã erase + có header
+    uint8_t  page[JOURNAL_PAGE_SIZE];
+
+    // phía đọc (replay)
+    uint32_t r_page;
+    uint32_t r_seq;
+    uint32_t r_off;
+    uint16_t r_len;         // len của record vừa peek
+
+    journal_stats_t stats;
+} journal_t;
+
+// Quét header các page để khôi phục vị trí đọc/ghi sau reboot
+int journal_mount(journal_t *j, const journal_flash_t *flash);
+
+// Thêm 1 record vào page RAM (tự flush khi page đầy)
+int journal_append(journal_t *j, const void *data, size_t len);
+
+// Ghi phần record còn trong RAM xuống flash
+int journal_flush(journal_t *j);
+
+// Số byte record chưa xuống flash
+uint32_t journal_unflushed(const journal_t *j);
+
+bool journal_empty(const journal_t *j);
+
+// Đọc record cũ nhất vào buf, trả về độ dài, 0 nếu rỗng, -1 nếu lỗi
+int journal_peek(journal_t *j, void *buf, size_t cap);
+
+// Bỏ record vừa peek (đã publish thành công)
+void journal_pop(journal_t *j);
+
+#endif /* FLASH_JOURNAL_H_ */
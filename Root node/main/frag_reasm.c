@@ -0,0 +1,125 @@
+#include <string.h>
+#include "frag_reasm.h"
+
+static unsigned ctx_state(frag_ctx_t *c) {
+    return atomic_load_explicit(&c->state, memory_order_acquire);
+}
+
+void frag_reasm_init(frag_reasm_t *r, frag_ctx_t *ctx, uint32_t n, uint32_t timeout_ms) {
+    memset(&r->stats, 0, sizeof(r->stats));
+    memset(r->done, 0xff, sizeof(r->done));     // MAC broadcast: không sender nào trùng
+    r->done_next  = 0;
+    r->ctx        = ctx;
+    r->n          = n;
+    r->timeout_ms = timeout_ms;
+    for (uint32_t i = 0; i < n; i++) atomic_init(&ctx[i].state, FRAG_CTX_FREE);
+}
+
+void frag_reasm_expire(frag_reasm_t *r, uint32_t now_ms) {
+    for (uint32_t i = 0; i < r->n; i++) {
+        frag_ctx_t *c = &r->ctx[i];
+        if (ctx_state(c) != FRAG_CTX_FILLING || now_ms - c->first_ms < r->timeout_ms) continue;
+        atomic_store_explicit(&c->state, FRAG_CTX_FREE, memory_order_relaxed);
+        r->stats.timeouts++;
+    }
+}
+
+// context đang ghép của sender, hoặc context trống
+static frag_ctx_t *ctx_for(frag_reasm_t *r, const uint8_t mac[6], frag_ctx_t **free_ctx) {
+    *free_ctx = NULL;
+    for (uint32_t i = 0; i < r->n; i++) {
+        frag_ctx_t *c = &r->ctx[i];
+        unsigned st = ctx_state(c);
+        if (st == FRAG_CTX_FILLING && memcmp(c->mac, mac, 6) == 0) return c;
+        if (st == FRAG_CTX_FREE && !*free_ctx) *free_ctx = c;
+    }
+    return NULL;
+}
+
+static bool recently_done(const frag_reasm_t *r, const uint8_t mac[6], uint16_t msg_id) {
+    for (int i = 0; i < FRAG_REASM_DONE_HIST; i++) {
+        if (r->done[i].msg_id == msg_id && memcmp(r->done[i].mac, mac, 6) == 0) return true;
+    }
+    return false;
+}
+
+uint8_t *frag_reasm_push(frag_reasm_t *r, const uint8_t mac[6], const frag_t *f,
+                         uint32_t now_ms, size_t *len) {
+    r->stats.fragments++;
+    frag_reasm_expire(r, now_ms);
+    // frag_t có thể không qua frag_decode: tự kiểm tra mọi thứ dùng để chép / dịch bit
+    if (f->total_len > FRAG_REASM_MSG_MAX || f->count == 0 || f->count > FRAG_MAX_COUNT ||
+        f->index >= f->count || (uint32_t)f->offset + f->len > f->total_len) {
+        r->stats.bad++;
+        return NULL;
+    }
+
+    // mảnh lặp của message đã giao: không được mở context mới hay đẩy message đang ghép
+    if (recently_done(r, mac, f->msg_id)) {
+        r->stats.dup++;
+        return NULL;
+    }
+
+    frag_ctx_t *free_ctx;
+    frag_ctx_t *c = ctx_for(r, mac, &free_ctx);
+    if (c && c->msg_id != f->msg_id) {
+        // sender đã chuyển sang message mới: message cũ không bao giờ đủ
+        r->stats.superseded++;
+        free_ctx = c;
+        c = NULL;
+    }
+    if (!c) {
+        if (!free_ctx) {
+            r->stats.no_ctx++;
+            return NULL;
+        }
+        c = free_ctx;
+        memcpy(c->mac, mac, 6);
+        c->msg_id    = f->msg_id;
+        c->total_len = f->total_len;
+        c->count     = f->count;
+        c->filled    = 0;
+        c->got       = 0;
+        c->first_ms  = now_ms;
+        atomic_store_explicit(&c->state, FRAG_CTX_FILLING, memory_order_relaxed);
+    }
+
+    if (f->count != c->count || f->total_len != c->total_len) {
+        r->stats.bad++;
+        return NULL;
+    }
+    uint32_t bit = 1u << f->index;
+    if (c->got & bit) {
+        r->stats.dup++;
+        return NULL;
+    }
+    memcpy(&c->buf[f->offset], f->payload, f->len);
+    c->got    |= bit;
+    c->filled += f->len;
+
+    uint32_t all = (c->count == 32) ? 0xFFFFFFFFu : ((1u << c->count) - 1);
+    if (c->got != all) return NULL;
+    if (c->filled != c->total_len) {
+        // mảnh chồng lấn / thiếu byte: message hỏng
+        r->stats.bad++;
+        atomic_store_explicit(&c->state, FRAG_CTX_FREE, memory_order_relaxed);
+        return NULL;
+    }
+
+    frag_done_t *d = &r->done[r->done_next++ % FRAG_REASM_DONE_HIST];
+    memcpy(d->mac, c->mac, 6);
+    d->msg_id = c->msg_id;
+    r->stats.completed++;
+    atomic_store_explicit(&c->state, FRAG_CTX_READY, memory_order_release);
+    *len = c->total_len;
+    return c->buf;
+}
+
+void frag_reasm_release(frag_reasm_t *r, const uint8_t *msg) {
+    for (uint32_t i = 0; i < r->n; i++) {
+        frag_ctx_t *c = &r->ctx[i];
+        if (c->buf != msg) continue;
+        atomic_store_explicit(&c->state, FRAG_CTX_FREE, memory_order_release);
+        return;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef FRAG_REASM_H_
+#define FRAG_REASM_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "frag.h"
+
+// ==== Ghép mảnh MESH_MSG_FRAG (không phụ thuộc ESP-IDF) ====
+// Pool context cố định, mỗi sender (MAC) tối đa 1 message đang ghép.
+// Producer (mesh_recv_task) push mảnh; message đủ mảnh được giao thẳng buffer của
+// context cho consumer (không copy), consumer xong thì release trả context về pool.
+// Bộ nhớ tối đa = số context x FRAG_REASM_MSG_MAX.
+#define FRAG_REASM_MSG_MAX      2048
+#define FRAG_REASM_DONE_HIST    8       // nhớ (MAC, msg_id) vừa ghép xong để bỏ mảnh lặp đến muộn
+
+typedef enum {
+    FRAG_CTX_FREE = 0,
+    FRAG_CTX_FILLING,       // producer sở hữu
+    FRAG_CTX_READY,         // đã giao consumer, producer không đụng tới
+} frag_ctx_state_t;
+
+typedef struct {
+    atomic_uint state;      // frag_ctx_state_t
+    uint8_t     mac[6];
+    uint16_t    msg_id;
+    uint16_t    total_len;
+    uint16_t    filled;     // tổng byte payload đã nhận
+    uint8_t     count;
+    uint32_t    got;        // bit i = đã có mảnh i
+    uint32_t    first_ms;
+    uint8_t     buf[FRAG_REASM_MSG_MAX];
+} frag_ctx_t;
+
+typedef struct {
+    uint32_t completed;
+    uint32_t fragments;
+    uint32_t dup;
+    uint32_t bad;           // mảnh không khớp context / quá FRAG_REASM_MSG_MAX
+    uint32_t timeouts;      // message thiếu mảnh quá hạn
+    uint32_t superseded;    // sender gửi msg_id mới khi message cũ chưa đủ
+    uint32_t no_ctx;        // pool hết context
+} frag_reasm_stats_t;
+
+typedef struct {
+    uint8_t  mac[6];
+    uint16_t msg_id;
+} frag_done_t;
+
+typedef struct {
+    frag_ctx_t        *ctx;
+    uint32_t           n;
+    uint32_t           timeout_ms;
+    frag_reasm_stats_t stats;   // chỉ producer ghi
+    frag_done_t        done[FRAG_REASM_DONE_HIST];
+    uint32_t           done_next;
+} frag_reasm_t;
+
+void frag_reasm_init(frag_reasm_t *r, frag_ctx_t *ctx, uint32_t n, uint32_t timeout_ms);
+
+// Producer: thêm 1 mảnh. Trả về message hoàn chỉnh (buffer của context, *len = độ dài)
+// hoặc NULL nếu còn thiếu / mảnh bị bỏ. Message trả về phải được frag_reasm_release.
+uint8_t *frag_reasm_push(frag_reasm_t *r, const uint8_t mac[6], const frag_t *f,
+                         uint32_t now_ms, size_t *len);
+
+// Producer: bỏ các message ghép dở quá timeout (push cũng tự gọi)
+void frag_reasm_expire(frag_reasm_t *r, uint32_t now_ms);
+
+// Consumer (hoặc producer nếu tự bỏ message): trả context về pool
+void frag_reasm_release(frag_reasm_t *r, const uint8_t *msg);
+
+#endif /* FRAG_REASM_H_ */
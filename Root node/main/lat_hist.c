@@ -0,0 +1,48 @@
+#include "lat_hist.h"
+
+void lat_hist_init(lat_hist_t *h) {
+    for (int i = 0; i < LAT_HIST_BUCKETS; i++) atomic_init(&h->b[i], 0);
+    atomic_init(&h->count, 0);
+    atomic_init(&h->max_ms, 0);
+}
+
+void lat_hist_add(lat_hist_t *h, uint32_t ms) {
+    atomic_fetch_add_explicit(&h->b[lat_hist_bucket(ms)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->count, 1, memory_order_relaxed);
+
+    unsigned cur = atomic_load_explicit(&h->max_ms, memory_order_relaxed);
+    while (ms > cur &&
+           !atomic_compare_exchange_weak_explicit(&h->max_ms, &cur, ms,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+uint32_t lat_hist_take(lat_hist_t *h, lat_hist_snap_t *out) {
+    for (int i = 0; i < LAT_HIST_BUCKETS; i++) {
+        out->b[i] = atomic_exchange_explicit(&h->b[i], 0, memory_order_relaxed);
+    }
+    out->count  = atomic_exchange_explicit(&h->count, 0, memory_order_relaxed);
+    out->max_ms = atomic_exchange_explicit(&h->max_ms, 0, memory_order_relaxed);
+    return out->count;
+}
+
+uint32_t lat_hist_percentile(const lat_hist_snap_t *s, uint32_t p) {
+    uint32_t total = 0;
+    for (int i = 0; i < LAT_HIST_BUCKETS; i++) total += s->b[i];
+    if (total == 0) return 0;
+
+    // số mẫu cần để đạt percentile, làm tròn lên
+    uint32_t need = (uint32_t)(((uint64_t)total * p + 99) / 100);
+    if (need == 0) need = 1;
+
+    uint32_t acc = 0;
+    for (int i = 0; i < LAT_HIST_BUCKETS; i++) {
+        acc += s->b[i];
+        if (acc >= need) {
+            // cận trên của bucket i, không vượt max thực tế
+            uint32_t ub = (i == LAT_HIST_BUCKETS - 1) ? s->max_ms : (1u << i);
+            return ub < s->max_ms ? ub : s->max_ms;
+        }
+    }
+    return s->max_ms;
+}
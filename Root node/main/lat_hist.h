@@ -0,0 +1,38 @@
+#ifndef LAT_HIST_H_
+#define LAT_HIST_H_
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+// ==== Histogram độ trễ chia bucket log2 ====
+// Bucket 0: < 1ms, bucket i: [2^(i-1), 2^i) ms, bucket cuối: >= 2^(N-2) ms.
+// Ghi bằng atomic relaxed, không khóa; đọc snapshot có thể lệch 1-2 mẫu.
+#define LAT_HIST_BUCKETS    16      // tới ~16s
+
+typedef struct {
+    atomic_uint b[LAT_HIST_BUCKETS];
+    atomic_uint count;
+    atomic_uint max_ms;
+} lat_hist_t;
+
+typedef struct {
+    uint32_t b[LAT_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t max_ms;
+} lat_hist_snap_t;
+
+void     lat_hist_init(lat_hist_t *h);
+void     lat_hist_add(lat_hist_t *h, uint32_t ms);
+
+// Lấy và xóa (chu kỳ publish), trả về số mẫu
+uint32_t lat_hist_take(lat_hist_t *h, lat_hist_snap_t *out);
+
+// Cận trên của bucket chứa percentile p (0-100), ms
+uint32_t lat_hist_percentile(const lat_hist_snap_t *s, uint32_t p);
+
+static inline uint32_t lat_hist_bucket(uint32_t ms) {
+    uint32_t i = ms ? 32u - (uint32_t)__builtin_clz(ms) : 0u;
+    return i < LAT_HIST_BUCKETS ? i : LAT_HIST_BUCKETS - 1;
+}
+
+#endif /* LAT_HIST_H_ */
@@ -0,0 +1,157 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "loadgen.h"
+#include "telemetry.h"
+#include "motion.h"
+#include "batch.h"
+
+#define LOADGEN_MAX_LEAVES  256
+
+static const char *TAG = "LOADGEN";
+
+static loadgen_cfg_t s_cfg;
+static uint16_t      s_seq[LOADGEN_MAX_LEAVES];
+static uint32_t      s_next;            // leaf kế tiếp (round-robin)
+static uint32_t      s_tick;            // số frame leaf đã lên lịch từ lúc init
+static int64_t       s_start_us;
+static int64_t       s_gap_us;          // khoảng cách giữa 2 frame bất kỳ (trải đều)
+static int64_t       s_alarm_due_us;
+static uint16_t      s_alarm_seq;
+static loadgen_stats_t s_stats;
+
+void loadgen_init(const loadgen_cfg_t *cfg) {
+    s_cfg = *cfg;
+    if (s_cfg.leaves == 0) s_cfg.leaves = 1;
+    if (s_cfg.leaves > LOADGEN_MAX_LEAVES) s_cfg.leaves = LOADGEN_MAX_LEAVES;
+    if (s_cfg.frame_size < TELEMETRY_FRAME_MAX) s_cfg.frame_size = TELEMETRY_FRAME_MAX;
+    if (s_cfg.max_layer == 0) s_cfg.max_layer = 1;
+    if (s_cfg.batch == 0) s_cfg.batch = 1;
+
+    memset(s_seq, 0, sizeof(s_seq));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_next     = 0;
+    s_tick     = 0;
+    s_gap_us   = (int64_t)s_cfg.period_ms * 1000 / s_cfg.leaves;
+    s_start_us = esp_timer_get_time();
+    s_alarm_due_us = s_start_us + (int64_t)s_cfg.alarm_ms * 1000;
+    s_alarm_seq    = 0;
+
+    ESP_LOGW(TAG, "%u leaf ảo x %ums, %uB/frame, batch %u, %s -> %.1f frame/s",
+             s_cfg.leaves, (unsigned)s_cfg.period_ms, s_cfg.frame_size, s_cfg.batch,
+             s_cfg.aligned ? "cùng pha" : "trải đều",
+             s_cfg.period_ms ? 1000.0f * s_cfg.leaves / s_cfg.period_ms : 0.0f);
+}
+
+// Thời điểm phát frame thứ tick
+static int64_t loadgen_due(uint32_t tick) {
+    if (s_cfg.aligned) return s_start_us + (int64_t)(tick / s_cfg.leaves) * s_cfg.period_ms * 1000;
+    return s_start_us + (int64_t)tick * s_gap_us;
+}
+
+static void leaf_mac(uint32_t leaf, uint8_t mac[6]) {
+    mac[0] = 0x02;                      // locally administered
+    mac[1] = 0x4c;
+    mac[2] = 0x47;
+    mac[3] = 0x00;
+    mac[4] = (uint8_t)(leaf >> 8);
+    mac[5] = (uint8_t)leaf;
+}
+
+static size_t leaf_frame(uint32_t leaf, int64_t now, uint8_t *buf, size_t cap) {
+    telemetry_t t = {
+        .node_id   = (uint16_t)leaf,
+        .seq       = s_seq[leaf]++,
+        .temp      = 25,
+        .humi      = 60,
+        .light_raw = (uint16_t)(leaf * 7 % 4096),
+        .flags     = TLM_FLAG_DHT_OK | TLM_FLAG_TX_TS,
+        .layer     = (uint8_t)(1 + leaf % s_cfg.max_layer),
+        .tx_us     = (uint32_t)now,
+    };
+    return telemetry_encode(&t, buf, cap);
+}
+
+// Relay ảo: gom frame của các leaf kế tiếp, mỗi leaf 1 lần
+static esp_err_t batch_frame(mesh_addr_t *from, mesh_data_t *data, int64_t now) {
+    batch_builder_t b;
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    size_t cap = data->size < BATCH_FRAME_MAX ? data->size : BATCH_FRAME_MAX;
+
+    batch_begin(&b, data->data, cap);
+    for (int i = 0; i < s_cfg.batch; i++) {
+        uint8_t mac[6];
+        leaf_mac(s_next, mac);
+        size_t len = leaf_frame(s_next, now, frame, sizeof(frame));
+        if (!batch_add(&b, mac, frame, len)) {
+            s_seq[s_next]--;            // không vừa batch, leaf này phát lại ở frame sau
+            break;
+        }
+        s_next = (s_next + 1) % s_cfg.leaves;
+        s_stats.generated++;
+    }
+    if (b.count == 0) return ESP_ERR_INVALID_SIZE;
+    s_tick += b.count;
+
+    leaf_mac(0xff00, from->addr);       // 02:4c:47:00:ff:00
+    data->size = (uint16_t)batch_finish(&b);
+    return ESP_OK;
+}
+
+// Sự kiện motion chen giữa luồng telemetry để đo trễ theo lớp
+static esp_err_t alarm_frame(mesh_addr_t *from, mesh_data_t *data, int64_t now) {
+    motion_event_t m = {
+        .node_id = 0,
+        .seq     = s_alarm_seq,
+        .level   = (uint8_t)(s_alarm_seq & 1),
+    };
+    size_t len = motion_encode(&m, data->data, data->size);
+    if (len == 0) return ESP_ERR_INVALID_SIZE;
+
+    s_alarm_seq++;
+    s_alarm_due_us += (int64_t)s_cfg.alarm_ms * 1000;
+    leaf_mac(0, from->addr);
+    data->size = (uint16_t)len;
+    s_stats.alarms++;
+    return ESP_OK;
+}
+
+esp_err_t loadgen_recv(mesh_addr_t *from, mesh_data_t *data, int timeout_ms,
+                       int *flag, mesh_opt_t opt[], int opt_count) {
+    int64_t now = esp_timer_get_time();
+    int64_t due = loadgen_due(s_tick);
+
+    // tick 10ms: chờ theo tick rồi phát dồn các frame đã tới hạn
+    if (now < due) {
+        TickType_t wait = pdMS_TO_TICKS((due - now + 999) / 1000);
+        vTaskDelay(wait ? wait : 1);
+        now = esp_timer_get_time();
+    } else if (now - due > (int64_t)s_cfg.period_ms * 1000) {
+        s_stats.late++;
+    }
+    if (flag) *flag = 0;
+    if (s_cfg.alarm_ms && now >= s_alarm_due_us) return alarm_frame(from, data, now);
+    if (s_cfg.batch > 1) return batch_frame(from, data, now);
+
+    s_tick++;
+    uint32_t leaf = s_next;
+    s_next = (s_next + 1) % s_cfg.leaves;
+    leaf_mac(leaf, from->addr);
+
+    size_t size = s_cfg.frame_size < data->size ? s_cfg.frame_size : data->size;
+    size_t len  = leaf_frame(leaf, now, data->data, size);
+    if (len == 0) return ESP_ERR_INVALID_SIZE;
+    memset(data->data + len, 0, size - len);
+    data->size = (uint16_t)size;
+
+    s_stats.generated++;
+    return ESP_OK;
+}
+
+void loadgen_get_stats(loadgen_stats_t *out) {
+    *out = s_stats;
+    out->elapsed_ms = (uint32_t)((esp_timer_get_time() - s_start_us) / 1000);
+}
@@ -0,0 +1,39 @@
+#ifndef LOADGEN_H_
+#define LOADGEN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_mesh.h"
+
+// ==== Giả lập tải cho pipeline root (bật bằng ROOT_LOADGEN trong main.c) ====
+// loadgen_recv thay esp_mesh_recv trong mesh_recv_task: sinh frame telemetry từ
+// N leaf ảo (MAC 02:4c:47:00:xx:xx) theo nhịp cố định, kèm seq + tx timestamp
+// nên toàn bộ đường recv -> ring -> MQTT/journal + metrics chạy như thật.
+typedef struct {
+    uint16_t leaves;
+    uint32_t period_ms;     // chu kỳ gửi của mỗi leaf
+    uint16_t frame_size;    // >= TELEMETRY_FRAME_MAX, phần dư đệm 0
+    uint8_t  max_layer;     // layer ảo 1..max_layer
+    uint8_t  batch;         // > 1: gói N frame / BATCH như relay gộp, 0/1 = frame lẻ
+    bool     aligned;       // true: mọi leaf phát cùng lúc mỗi chu kỳ (cùng pha từ boot),
+                            // false: trải đều chu kỳ như khi root cấp slot gửi
+    uint32_t alarm_ms;      // > 0: leaf ảo 0 phát thêm 1 sự kiện motion (lớp ALARM) mỗi N ms
+} loadgen_cfg_t;
+
+typedef struct {
+    uint32_t generated;
+    uint32_t alarms;
+    uint32_t late;          // frame phát trễ > 1 chu kỳ tổng (recv stage không theo kịp)
+    uint32_t elapsed_ms;
+} loadgen_stats_t;
+
+void loadgen_init(const loadgen_cfg_t *cfg);
+
+// Cùng chữ ký esp_mesh_recv, block tới frame kế tiếp theo lịch
+esp_err_t loadgen_recv(mesh_addr_t *from, mesh_data_t *data, int timeout_ms,
+                       int *flag, mesh_opt_t opt[], int opt_count);
+
+void loadgen_get_stats(loadgen_stats_t *out);
+
+#endif /* LOADGEN_H_ */
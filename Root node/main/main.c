@@ -1,19 +1,44 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <sys/time.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_err.h"
+#include "esp_system.h"
 #include "esp_event.h"
 #include "nvs_flash.h"
+#include "nvs.h"
 #include "esp_mac.h"
 #include "esp_netif.h"
 #include "esp_netif_ip_addr.h"
+#include "esp_netif_sntp.h"
 #include "esp_wifi.h"
 #include "esp_mesh.h"
 #include "mqtt_client.h"
+#include "telemetry.h"
+#include "motion.h"
+#include "link.h"
+#include "cmd.h"
+#include "batch.h"
+#include "summary.h"
+#include "series.h"
+#include "frag.h"
+#include "tsync.h"
+#include "congest.h"
+#include "frag_reasm.h"
+#include "cJSON.h"
+#include "esp_partition.h"
+#include "rx_ring.h"
+#include "flash_journal.h"
+#include "node_registry.h"
+#include "lat_hist.h"
+#include "stage_stats.h"
+#include "cong_monitor.h"
+#include "rule_engine.h"
 
 #define TAG "ROOT_NODE"
 
@@ -29,11 +54,178 @@ static const uint8_t MESH_ID[6] = { 0x7A,0x10,0x20,0x30,0x40,0x50 };
 #define MQTT_PASSWORD   NULL
 #define MQTT_BASE_TOPIC "mesh"                  
 
+#define RX_RING_SLOTS       16      // lũy thừa của 2, mỗi slot ~520B
+#define RAW_RING_SLOTS      8       // recv -> decode, decode chỉ chờ khi ring publish đầy
+#define ALARM_RING_SLOTS    4       // decode -> publish riêng cho lớp ALARM, đầy thì đi ring thường
+#define PUB_BULK_BURST      4       // publish tối đa N frame TELEMETRY rồi xem lại ring ALARM
+#define MQTT_QOS_ALARM      1       // TELEMETRY giữ QoS 0
+
+// Pipeline: recv cùng core với Wi-Fi/lwIP (mặc định core 0), decode + publish ở core còn lại
+#define ROOT_CORE_RECV      0
+#define ROOT_CORE_DECODE    1
+#define ROOT_CORE_PUB       1
+#define ROOT_PRIO_RECV      5
+#define ROOT_PRIO_DECODE    4
+#define ROOT_PRIO_PUB       3
+#define RX_STATS_PERIOD_MS  10000
+#define DECODE_WAIT_POLL_MS 10      // ring publish đầy: decode xem lại sau mỗi N ms dù chưa được báo
+
+#define ROOT_MAX_NODES      64      // số node tối đa root theo dõi
+#define METRICS_PERIOD_MS   30000   // publish mất/trùng/đảo + histogram trễ
+#define LAT_MAX_LAYER       6       // = esp_mesh_set_max_layer
+
+// Lệnh MQTT "<base>/<mac>/cmd" -> leaf, ACK -> "<base>/<mac>/cmd/ack"
+#define CMD_QUEUE_LEN       8
+#define CMD_PENDING         16      // lệnh chờ ACK cùng lúc
+#define CMD_TIMEOUT_MS      5000
+
+// Đo tải pipeline: 1 = thay esp_mesh_recv bằng leaf ảo (loadgen.c), trỏ MQTT_URI
+// về broker cục bộ rồi đọc log "Loadgen" + mesh/metrics. Build host (host_test) đặt qua -D.
+#ifndef ROOT_LOADGEN
+#define ROOT_LOADGEN        0
+#endif
+#ifndef LOADGEN_LEAVES
+#define LOADGEN_LEAVES      32
+#endif
+#ifndef LOADGEN_PERIOD_MS
+#define LOADGEN_PERIOD_MS   1000    // mỗi leaf ảo 1 frame / chu kỳ
+#endif
+#define LOADGEN_FRAME_SIZE  64
+#define LOADGEN_BATCH       1       // > 1: giả lập relay gộp, so sánh frame/s trên link root
+#define LOADGEN_ALIGNED     0       // 1: mọi leaf ảo gửi cùng pha (không slot), 0: trải đều như có slot
+#define LOADGEN_ALARM_MS    1000    // chen 1 motion (ALARM) mỗi N ms, so cls_alarm với cls_telemetry
+
+#if ROOT_LOADGEN
+#include "loadgen.h"
+#define root_mesh_recv      loadgen_recv
+#else
+#define root_mesh_recv      esp_mesh_recv
+#endif
+#define FRAG_CTX_COUNT      4       // message ghép dở cùng lúc, mỗi cái FRAG_REASM_MSG_MAX byte
+#define FRAG_TIMEOUT_MS     3000
+
+#define NODE_TABLE_CAP      128     // lũy thừa của 2 >= 2 * ROOT_MAX_NODES
+
+// Mesh time = UTC từ SNTP (chưa có thì esp_timer của root), beacon unicast tới từng leaf
+#define SNTP_SERVER         "pool.ntp.org"
+#define TSYNC_BEACON_MS     10000   // drift 20 ppm -> lệch 0.2 ms giữa 2 beacon
+#define TSYNC_NODE_IDLE_MS  120000  // không gửi beacon cho node im lặng lâu hơn
+#define TSYNC_RTT_MAX_US    2000000 // echo trễ hơn coi như hỏng
+// 1 = beacon kèm slot gửi (node_registry NODE_TX_SLOTS), leaf lệch pha nhau thay vì
+// cùng nhịp từ lúc boot. So sánh bằng "burst" trong log root link + trễ mesh p99.
+#define ROOT_SLOTTED_TX     1
+#define RX_BURST_WINDOW_MS  100     // đếm frame dồn trên link root trong 1 cửa sổ
+
+// Nghẽn: đo ring/outbox MQTT/heap mỗi CONG_EVAL_MS (cong_monitor.c), gửi level cho mọi
+// leaf + relay khi đổi và nhắc lại khi > 0. Leaf giãn chu kỳ, relay chuyển SUMMARY.
+#define CONG_EVAL_MS        1000
+#define CONG_REFRESH_MS     10000
+#define CONG_TTL_S          30      // leaf/relay tự về level 0 nếu mất các lần nhắc lại
+#define ROOT_MAX_RELAYS     8       // relay = nguồn của frame BATCH
+#define RELAY_TABLE_CAP     16
+
+// Luật cảnh báo tại root (rule_engine.c), chạy ở stage decode, không chờ cloud.
+// JSON {"rules":[...]} gửi lên "<base>/rules/set" (nên retain), lưu NVS, kết quả ở
+// "<base>/rules/status". Cảnh báo publish QoS 1 lên "<base>/alert".
+#define RULES_NVS_NS        "root"
+#define RULES_NVS_KEY       "rules"
+#define RULES_JSON_MAX      1024                // vừa 1 message MQTT, không ghép nhiều phần
+#define RULES_TZ_OFFSET_S   (7 * 3600)          // khung giờ của luật theo giờ VN
+#define RULES_CMD_REF       0x52000000u         // "ref" trong ACK lệnh do luật gửi = | chỉ số luật
+
+// Journal store-and-forward (partition "journal" trong partitions.csv)
+#define JOURNAL_PART_LABEL       "journal"
+#define JOURNAL_PART_SUBTYPE     0x40
+#define JOURNAL_FLUSH_MS         2000    // page chưa đầy vẫn xuống flash sau 2 s
+#define JOURNAL_REPLAY_PERIOD_MS 100
+#define JOURNAL_REPLAY_BURST     5       // ~50 frame/s khi replay
+
 static esp_netif_t *g_mesh_netif_sta = NULL;
 static esp_netif_t *g_mesh_netif_ap  = NULL;
 static esp_mqtt_client_handle_t g_mqtt = NULL;
 static bool g_mqtt_connected = false;
 
+static rx_slot_t    s_raw_slots[RAW_RING_SLOTS];
+static rx_ring_t    g_raw_ring;                 // recv -> decode
+static rx_slot_t    s_rx_slots[RX_RING_SLOTS];
+static rx_ring_t    g_rx_ring;                  // decode -> publish, lớp TELEMETRY
+static rx_slot_t    s_alarm_slots[ALARM_RING_SLOTS];
+static rx_ring_t    g_alarm_ring;               // decode -> publish, lớp ALARM (ưu tiên tuyệt đối)
+static TaskHandle_t g_recv_task = NULL;
+static TaskHandle_t g_decode_task = NULL;
+static TaskHandle_t g_pub_task = NULL;
+static volatile bool g_decode_waiting = false;  // decode đang chờ ring publish có slot
+
+typedef enum {
+    STAGE_RECV = 0,
+    STAGE_DECODE,
+    STAGE_PUB,
+    STAGE_COUNT
+} stage_id_t;
+
+static stage_stats_t g_stage[STAGE_COUNT];
+
+static frag_ctx_t   s_frag_ctx[FRAG_CTX_COUNT];
+static frag_reasm_t g_frag;
+
+static node_entry_t    s_node_slots[NODE_TABLE_CAP];
+static node_registry_t g_nodes;
+static node_entry_t    s_relay_slots[RELAY_TABLE_CAP];
+static node_registry_t g_relays;        // chỉ dùng MAC + last_seen để gửi level nghẽn
+
+static rule_engine_t   g_rules;         // chỉ mesh_decode_task truy cập
+static QueueHandle_t   g_rule_q;        // bảng luật mới -> decode (dài 1, bản mới nhất thắng)
+
+static cong_monitor_t  g_cong;          // chỉ mqtt_pub_task truy cập
+static uint8_t         g_cong_ring_pct; // độ đầy ring lớn nhất từ lần đánh giá trước
+
+// Histogram trễ: leaf gửi -> root nhận (theo layer leaf), root nhận -> publish
+static lat_hist_t   g_lat_mesh[LAT_MAX_LAYER];
+static lat_hist_t   g_lat_root;
+static lat_hist_t   g_lat_cmd;      // RTT lệnh root -> leaf -> root
+static lat_hist_t   g_lat_sync;     // |sai số đồng bộ| leaf so với root, đo qua echo
+static lat_hist_t   g_lat_class[MESH_CLASS_COUNT];  // root nhận -> publish theo lớp
+static lat_hist_t   g_lat_alarm_edge;               // cạnh PIR -> root, leaf đo qua ACK
+
+// mesh time = esp_timer + g_epoch_off_us; callback SNTP ghi, các stage đọc
+static portMUX_TYPE g_time_mux = portMUX_INITIALIZER_UNLOCKED;
+static int64_t      g_epoch_off_us = 0;
+static bool         g_time_utc = false;
+static bool         g_sntp_started = false;
+
+// Đếm ở stage publish (chỉ mqtt_pub_task ghi)
+static uint32_t     g_pub_ok = 0;
+static uint32_t     g_pub_fail = 0;
+// tải link root: frame mesh nhận được so với frame leaf sau khi tách BATCH
+static uint32_t     g_rx_link_frames = 0;
+static uint32_t     g_rx_batches = 0;
+static uint32_t     g_rx_leaf_frames = 0;
+static uint32_t     g_rx_burst_max = 0;     // frame/RX_BURST_WINDOW_MS lớn nhất, reset mỗi lần log
+
+// MQTT task chỉ parse + đẩy vào g_cmd_q; cmd_id và bảng chờ ACK thuộc mqtt_pub_task
+typedef struct {
+    uint8_t  mac[6];
+    uint32_t ref;           // "ref" của client, trả lại nguyên trong ACK
+    cmd_t    cmd;
+} cmd_req_t;
+
+typedef struct {
+    bool     used;
+    uint8_t  mac[6];
+    uint16_t cmd_id;
+    uint8_t  op;
+    uint32_t ref;
+    uint32_t t_send_us;
+} cmd_pending_t;
+
+static QueueHandle_t g_cmd_q;
+static cmd_pending_t s_cmd_pending[CMD_PENDING];
+static uint16_t      g_cmd_id = 0;
+
+static journal_t    g_journal;
+static bool         g_journal_ok = false;
+static TickType_t   g_journal_dirty_since = 0;
+
 // cho phép kết nối từ kênh 1 đến 13
 static void wifi_country_1_13(void) {
     wifi_country_t c = { .cc = "CN", .schan = 1, .nchan = 13, .policy = WIFI_COUNTRY_POLICY_MANUAL };
@@ -48,21 +240,260 @@ static void try_set_bw20(void) {
     if (m & WIFI_MODE_AP)  esp_wifi_set_bandwidth(WIFI_IF_AP,  WIFI_BW_HT20);
 }
 
+// "<base>/aa:bb:cc:dd:ee:ff/cmd" + {"op":"set_sample","ms":10000,"ref":7} -> cmd_req_t
+static bool cmd_parse(const esp_mqtt_event_t *ev, cmd_req_t *req) {
+    char topic[48];
+    unsigned m[6];
+    if (ev->topic_len >= (int)sizeof(topic)) return false;
+    memcpy(topic, ev->topic, ev->topic_len);
+    topic[ev->topic_len] = '\0';
+    if (sscanf(topic, MQTT_BASE_TOPIC "/%x:%x:%x:%x:%x:%x/cmd",
+               &m[0], &m[1], &m[2], &m[3], &m[4], &m[5]) != 6) return false;
+    for (int i = 0; i < 6; i++) req->mac[i] = (uint8_t)m[i];
+
+    cJSON *root = cJSON_ParseWithLength(ev->data, ev->data_len);
+    if (!root) return false;
+    const cJSON *op  = cJSON_GetObjectItemCaseSensitive(root, "op");
+    const cJSON *ms  = cJSON_GetObjectItemCaseSensitive(root, "ms");
+    const cJSON *ref = cJSON_GetObjectItemCaseSensitive(root, "ref");
+    const cJSON *node = cJSON_GetObjectItemCaseSensitive(root, "node");
+    const cJSON *on   = cJSON_GetObjectItemCaseSensitive(root, "on");
+    int code = cJSON_IsString(op) ? cmd_op_from_name(op->valuestring) : -1;
+
+    memset(&req->cmd, 0, sizeof(req->cmd));
+    req->cmd.op = (uint8_t)code;
+    req->ref    = cJSON_IsNumber(ref) ? (uint32_t)ref->valuedouble : 0;
+    if (cJSON_IsNumber(ms) && ms->valuedouble > 0) {
+        mp_put_u32(req->cmd.arg, (uint32_t)ms->valuedouble);
+        req->cmd.arg_len = 4;
+    }
+    // relay_raw: {"node":"aa:bb:cc:dd:ee:ff","on":1} -> arg mac[6] + on
+    if (code == CMD_OP_RELAY_RAW) {
+        if (!cJSON_IsString(node) || sscanf(node->valuestring, "%x:%x:%x:%x:%x:%x",
+                                            &m[0], &m[1], &m[2], &m[3], &m[4], &m[5]) != 6) code = -1;
+        for (int i = 0; i < 6; i++) req->cmd.arg[i] = (uint8_t)m[i];
+        req->cmd.arg[6]  = (cJSON_IsNumber(on) && on->valuedouble != 0) || cJSON_IsTrue(on);
+        req->cmd.arg_len = 7;
+    }
+    cJSON_Delete(root);
+    return code >= 0;
+}
+
+// {"name":"hot","node":"*"|"aa:bb:..","src":"temp","op":">","value":35,"count":3,"from":8,"to":18,
+//  "holdoff_s":300,"alert":true,"cmd":"read_now","ms":0,"target":"aa:bb:.."}
+// Không có "cmd" thì mặc định alert; "cmd" không kèm "target" = gửi tới chính node vừa khớp.
+static bool rule_parse(const cJSON *j, rule_t *r) {
+    const cJSON *name    = cJSON_GetObjectItemCaseSensitive(j, "name");
+    const cJSON *node    = cJSON_GetObjectItemCaseSensitive(j, "node");
+    const cJSON *src     = cJSON_GetObjectItemCaseSensitive(j, "src");
+    const cJSON *op      = cJSON_GetObjectItemCaseSensitive(j, "op");
+    const cJSON *value   = cJSON_GetObjectItemCaseSensitive(j, "value");
+    const cJSON *count   = cJSON_GetObjectItemCaseSensitive(j, "count");
+    const cJSON *from    = cJSON_GetObjectItemCaseSensitive(j, "from");
+    const cJSON *to      = cJSON_GetObjectItemCaseSensitive(j, "to");
+    const cJSON *holdoff = cJSON_GetObjectItemCaseSensitive(j, "holdoff_s");
+    const cJSON *alert   = cJSON_GetObjectItemCaseSensitive(j, "alert");
+    const cJSON *cmd     = cJSON_GetObjectItemCaseSensitive(j, "cmd");
+    const cJSON *ms      = cJSON_GetObjectItemCaseSensitive(j, "ms");
+    const cJSON *target  = cJSON_GetObjectItemCaseSensitive(j, "target");
+    unsigned m[6];
+
+    int code = cJSON_IsString(src) ? rule_src_from_name(src->valuestring) : -1;
+    if (code < 0) return false;
+    r->src = (uint8_t)code;
+    if (r->src != RULE_SRC_MOTION && !cJSON_IsNumber(value)) return false;
+
+    // tên đi thẳng vào JSON alert nên chỉ giữ ký tự an toàn
+    snprintf(r->name, sizeof(r->name), "%s", cJSON_IsString(name) ? name->valuestring : "rule");
+    for (char *c = r->name; *c; c++) {
+        if (!(*c == '_' || *c == '-' || (*c >= '0' && *c <= '9') ||
+              (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z'))) *c = '_';
+    }
+
+    r->any_node = !cJSON_IsString(node) || strcmp(node->valuestring, "*") == 0;
+    if (!r->any_node) {
+        if (sscanf(node->valuestring, "%x:%x:%x:%x:%x:%x", &m[0], &m[1], &m[2], &m[3], &m[4], &m[5]) != 6) return false;
+        for (int i = 0; i < 6; i++) r->mac[i] = (uint8_t)m[i];
+    }
+    r->op        = (cJSON_IsString(op) && strcmp(op->valuestring, "<") == 0) ? RULE_OP_LT : RULE_OP_GT;
+    r->threshold = cJSON_IsNumber(value) ? (int32_t)value->valuedouble : 0;
+    r->count     = (cJSON_IsNumber(count) && count->valuedouble >= 1)
+                   ? (uint8_t)(count->valuedouble > RULE_COUNT_MAX ? RULE_COUNT_MAX : count->valuedouble) : 1;
+    r->hour_from = cJSON_IsNumber(from) ? (int8_t)from->valuedouble : 0;
+    r->hour_to   = cJSON_IsNumber(to) ? (int8_t)to->valuedouble : 0;
+    r->holdoff_s = (cJSON_IsNumber(holdoff) && holdoff->valuedouble > 0)
+                   ? (uint16_t)(holdoff->valuedouble > UINT16_MAX ? UINT16_MAX : holdoff->valuedouble) : 0;
+
+    bool want_alert = cJSON_IsBool(alert) ? cJSON_IsTrue(alert) : !cJSON_IsString(cmd);
+    if (want_alert) r->actions |= RULE_ACT_ALERT;
+    if (cJSON_IsString(cmd)) {
+        code = cmd_op_from_name(cmd->valuestring);
+        if (code < 0 || code == CMD_OP_RELAY_RAW) return false;
+        r->actions |= RULE_ACT_CMD;
+        r->cmd_op = (uint8_t)code;
+        if (cJSON_IsNumber(ms) && ms->valuedouble > 0) {
+            mp_put_u32(r->cmd_arg, (uint32_t)ms->valuedouble);
+            r->cmd_arg_len = 4;
+        }
+        r->cmd_self = !cJSON_IsString(target);
+        if (!r->cmd_self) {
+            if (sscanf(target->valuestring, "%x:%x:%x:%x:%x:%x",
+                       &m[0], &m[1], &m[2], &m[3], &m[4], &m[5]) != 6) return false;
+            for (int i = 0; i < 6; i++) r->cmd_mac[i] = (uint8_t)m[i];
+        }
+    }
+    return true;
+}
+
+// {"rules":[...]} -> bảng đã biên dịch
+static bool rules_parse(const char *json, size_t len, rule_set_t *out) {
+    memset(out, 0, sizeof(*out));
+    cJSON *root = cJSON_ParseWithLength(json, len);
+    if (!root) return false;
+
+    const cJSON *arr = cJSON_GetObjectItemCaseSensitive(root, "rules");
+    const cJSON *item;
+    bool ok = cJSON_IsArray(arr) && cJSON_GetArraySize(arr) <= RULE_MAX;
+    if (ok) {
+        cJSON_ArrayForEach(item, arr) {
+            if (!cJSON_IsObject(item) || !rule_parse(item, &out->rules[out->count])) {
+                ok = false;
+                break;
+            }
+            out->count++;
+        }
+    }
+    cJSON_Delete(root);
+    return ok && rule_set_compile(out);
+}
+
+static void rules_save(const char *json, size_t len) {
+    static char buf[RULES_JSON_MAX + 1];
+    memcpy(buf, json, len);
+    buf[len] = '\0';
+
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(RULES_NVS_NS, NVS_READWRITE, &h);
+    if (err == ESP_OK) {
+        err = nvs_set_str(h, RULES_NVS_KEY, buf);
+        if (err == ESP_OK) err = nvs_commit(h);
+        nvs_close(h);
+    }
+    if (err != ESP_OK) ESP_LOGW(TAG, "Rules: lưu NVS fail: %s", esp_err_to_name(err));
+}
+
+// Lúc boot, trước khi tạo decode task nên nạp thẳng vào engine
+static void rules_load(void) {
+    static char buf[RULES_JSON_MAX + 1];
+    static rule_set_t set;
+    size_t len = sizeof(buf);
+    nvs_handle_t h;
+    bool ok = false;
+
+    rule_engine_init(&g_rules);
+    if (nvs_open(RULES_NVS_NS, NVS_READONLY, &h) == ESP_OK) {
+        ok = nvs_get_str(h, RULES_NVS_KEY, buf, &len) == ESP_OK && rules_parse(buf, strlen(buf), &set);
+        nvs_close(h);
+    }
+    if (ok) rule_engine_load(&g_rules, &set);
+    ESP_LOGI(TAG, "Rules: %u luật%s", ok ? set.count : 0, ok ? " (NVS)" : "");
+}
+
+// "<base>/rules/set": biên dịch ở task MQTT, decode task nhận bảng qua g_rule_q
+static void rules_on_config(const esp_mqtt_event_t *ev) {
+    static rule_set_t set;
+    const char *status = "ok";
+
+    if (ev->data_len != ev->total_data_len || ev->data_len > RULES_JSON_MAX) {
+        status = "too_large";
+    } else if (!rules_parse(ev->data, ev->data_len, &set)) {
+        status = "invalid";
+    } else {
+        xQueueOverwrite(g_rule_q, &set);
+        if (g_decode_task) xTaskNotifyGive(g_decode_task);
+        rules_save(ev->data, ev->data_len);
+    }
+    ESP_LOGI(TAG, "Rules config: %s (%u luật)", status, strcmp(status, "ok") ? 0 : set.count);
+
+    char json[64];
+    int n = snprintf(json, sizeof(json), "{\"status\":\"%s\",\"rules\":%u}",
+                     status, strcmp(status, "ok") ? 0 : set.count);
+    esp_mqtt_client_publish(g_mqtt, MQTT_BASE_TOPIC "/rules/status", json, n, 1, 0);
+}
+
 static void mqtt_evt_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data) {
+    esp_mqtt_event_handle_t ev = event_data;
+    cmd_req_t req;
+
     switch (event_id) {
         case MQTT_EVENT_CONNECTED:
             g_mqtt_connected = true;
             ESP_LOGI(TAG, "MQTT: CONNECTED");
+            esp_mqtt_client_subscribe(g_mqtt, MQTT_BASE_TOPIC "/+/cmd", 1);
+            esp_mqtt_client_subscribe(g_mqtt, MQTT_BASE_TOPIC "/rules/set", 1);
+            if (g_pub_task) xTaskNotifyGive(g_pub_task);   // bắt đầu replay journal
             break;
         case MQTT_EVENT_DISCONNECTED:
             g_mqtt_connected = false;
             ESP_LOGW(TAG, "MQTT: DISCONNECTED");
             break;
+        case MQTT_EVENT_DATA:
+            if (ev->topic_len == (int)strlen(MQTT_BASE_TOPIC "/rules/set") &&
+                memcmp(ev->topic, MQTT_BASE_TOPIC "/rules/set", ev->topic_len) == 0) {
+                rules_on_config(ev);
+                break;
+            }
+            // lệnh ngắn, không ghép payload bị chia nhiều phần
+            if (ev->data_len != ev->total_data_len || !cmd_parse(ev, &req)) {
+                ESP_LOGW(TAG, "CMD: bỏ lệnh sai định dạng (%.*s)", ev->topic_len, ev->topic);
+                break;
+            }
+            if (xQueueSend(g_cmd_q, &req, 0) != pdTRUE) {
+                ESP_LOGW(TAG, "CMD: queue đầy — bỏ");
+                break;
+            }
+            if (g_pub_task) xTaskNotifyGive(g_pub_task);
+            break;
         default:
             break;
     }
 }
 
+static int64_t mesh_time_off(bool *utc) {
+    portENTER_CRITICAL(&g_time_mux);
+    int64_t off = g_epoch_off_us;
+    if (utc) *utc = g_time_utc;
+    portEXIT_CRITICAL(&g_time_mux);
+    return off;
+}
+
+// Leaf thấy cờ UTC đổi sẽ nhảy offset; các lần SNTP sau chỉ chỉnh nhỏ, leaf bám dần
+static void sntp_sync_cb(struct timeval *tv) {
+    int64_t epoch_us = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+    int64_t off = epoch_us - esp_timer_get_time();
+
+    portENTER_CRITICAL(&g_time_mux);
+    int64_t step = off - g_epoch_off_us;
+    bool first = !g_time_utc;
+    g_epoch_off_us = off;
+    g_time_utc = true;
+    portEXIT_CRITICAL(&g_time_mux);
+    if (first) ESP_LOGI(TAG, "SNTP: mesh time = UTC (epoch %lld s)", (long long)tv->tv_sec);
+    else       ESP_LOGI(TAG, "SNTP: resync, step %lld us", (long long)step);
+}
+
+static void sntp_start_if_needed(void) {
+    if (g_sntp_started) return;
+    esp_sntp_config_t cfg = ESP_NETIF_SNTP_DEFAULT_CONFIG(SNTP_SERVER);
+    cfg.sync_cb = sntp_sync_cb;
+    if (esp_netif_sntp_init(&cfg) != ESP_OK) {
+        ESP_LOGW(TAG, "SNTP init fail — mesh time vẫn theo esp_timer của root");
+        return;
+    }
+    g_sntp_started = true;
+    ESP_LOGI(TAG, "SNTP: %s", SNTP_SERVER);
+}
+
 static void mqtt_start_if_needed(void) {
     if (g_mqtt) return; 
     esp_mqtt_client_config_t cfg = {
@@ -82,6 +513,7 @@ static void ip_evt_handler(void *arg, esp_event_base_t base, int32_t id, void *e
         ip_event_got_ip_t *ev = (ip_event_got_ip_t *)event_data;
         ESP_LOGI(TAG, "GOT IP: " IPSTR ", GW: " IPSTR ", MASK: " IPSTR,
                  IP2STR(&ev->ip_info.ip), IP2STR(&ev->ip_info.gw), IP2STR(&ev->ip_info.netmask));
+        sntp_start_if_needed();
         mqtt_start_if_needed(); 
     }
 }
@@ -121,42 +553,970 @@ static void mesh_event_handler(void *arg, esp_event_base_t base, int32_t id, voi
 }
 
 
+// ==== Journal flash: esp_partition <-> journal_flash_t ====
+static int jflash_read(void *ctx, uint32_t off, void *buf, size_t len) {
+    return esp_partition_read((const esp_partition_t*)ctx, off, buf, len) == ESP_OK ? 0 : -1;
+}
+
+static int jflash_write(void *ctx, uint32_t off, const void *buf, size_t len) {
+    return esp_partition_write((const esp_partition_t*)ctx, off, buf, len) == ESP_OK ? 0 : -1;
+}
+
+static int jflash_erase(void *ctx, uint32_t off, size_t len) {
+    return esp_partition_erase_range((const esp_partition_t*)ctx, off, len) == ESP_OK ? 0 : -1;
+}
+
+static void journal_init(void) {
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           JOURNAL_PART_SUBTYPE, JOURNAL_PART_LABEL);
+    if (!part) {
+        ESP_LOGW(TAG, "Journal: không thấy partition '%s' — tắt store-and-forward", JOURNAL_PART_LABEL);
+        return;
+    }
+    journal_flash_t fl = {
+        .read  = jflash_read,
+        .write = jflash_write,
+        .erase = jflash_erase,
+        .ctx   = (void*)part,
+        .size  = part->size - (part->size % JOURNAL_PAGE_SIZE),
+    };
+    if (journal_mount(&g_journal, &fl) != 0) {
+        ESP_LOGE(TAG, "Journal: mount fail");
+        return;
+    }
+    g_journal_ok = true;
+    ESP_LOGI(TAG, "Journal: %u pages, backlog=%s", (unsigned)g_journal.n_pages,
+             journal_empty(&g_journal) ? "empty" : "pending");
+}
+
+// ==== Lệnh xuống leaf: gửi, chờ ACK, đo RTT ====
+static void cmd_topic(const uint8_t mac[6], char *out, size_t cap) {
+    const node_entry_t *node = node_registry_find(&g_nodes, mac);
+    if (node) snprintf(out, cap, "%s/cmd/ack", node->topic);
+    else      snprintf(out, cap, "%s/" MACSTR "/cmd/ack", MQTT_BASE_TOPIC, MAC2STR(mac));
+}
+
+static void cmd_publish_result(const cmd_pending_t *p, const char *status, int32_t rtt_us, uint32_t leaf_us) {
+    char topic[NODE_TOPIC_LEN + 8];
+    char json[128];
+    if (!g_mqtt_connected || !g_mqtt) return;
+
+    cmd_topic(p->mac, topic, sizeof(topic));
+    int n = snprintf(json, sizeof(json), "{\"id\":%u,\"ref\":%u,\"op\":\"%s\",\"status\":\"%s\"",
+                     p->cmd_id, (unsigned)p->ref, cmd_op_name(p->op), status);
+    if (rtt_us >= 0 && n > 0 && n < (int)sizeof(json)) {
+        n += snprintf(json + n, sizeof(json) - n, ",\"rtt_us\":%d,\"leaf_us\":%u",
+                      (int)rtt_us, (unsigned)leaf_us);
+    }
+    if (n > 0 && n + 1 < (int)sizeof(json)) {
+        n += snprintf(json + n, sizeof(json) - n, "}");
+        esp_mqtt_client_publish(g_mqtt, topic, json, n, 1, 0);
+    }
+}
+
+static void cmd_send(const cmd_req_t *req) {
+    cmd_pending_t *p = NULL;
+    for (int i = 0; i < CMD_PENDING && !p; i++) {
+        if (!s_cmd_pending[i].used) p = &s_cmd_pending[i];
+    }
+    cmd_pending_t tmp = { .op = req->cmd.op, .ref = req->ref };
+    memcpy(tmp.mac, req->mac, 6);
+    if (!p) {
+        cmd_publish_result(&tmp, "busy", -1, 0);
+        return;
+    }
+
+    uint8_t buf[CMD_FRAME_MAX];
+    cmd_t c = req->cmd;
+    c.cmd_id = ++g_cmd_id;
+    mesh_data_t md = {
+        .data  = buf,
+        .size  = (uint16_t)cmd_encode(&c, buf, sizeof(buf)),
+        .proto = MESH_PROTO_BIN,
+        .tos   = MESH_TOS_P2P,
+    };
+    mesh_addr_t to;
+    memcpy(to.addr, req->mac, 6);
+
+    tmp.cmd_id    = c.cmd_id;
+    tmp.t_send_us = (uint32_t)esp_timer_get_time();
+    esp_err_t err = esp_mesh_send(&to, &md, MESH_DATA_P2P | MESH_DATA_NONBLOCK, NULL, 0);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "CMD %u -> " MACSTR " fail: %s", c.cmd_id, MAC2STR(req->mac), esp_err_to_name(err));
+        cmd_publish_result(&tmp, "send_fail", -1, 0);
+        return;
+    }
+    tmp.used = true;
+    *p = tmp;
+}
+
+// ACK đã qua ring: thời điểm nhận lấy từ slot->rx_us, không tính thời gian nằm trong ring
+static void cmd_on_ack(const rx_slot_t *slot, const cmd_ack_t *ack) {
+    for (int i = 0; i < CMD_PENDING; i++) {
+        cmd_pending_t *p = &s_cmd_pending[i];
+        if (!p->used || p->cmd_id != ack->cmd_id || memcmp(p->mac, slot->from, 6) != 0) continue;
+
+        int32_t rtt_us = (int32_t)(slot->rx_us - p->t_send_us);
+        lat_hist_add(&g_lat_cmd, (uint32_t)rtt_us / 1000);
+        ESP_LOGI(TAG, "CMD %u ACK " MACSTR ": %s, rtt=%dus (leaf %uus)", ack->cmd_id, MAC2STR(slot->from),
+                 cmd_status_name(ack->status), (int)rtt_us, (unsigned)ack->leaf_us);
+        cmd_publish_result(p, cmd_status_name(ack->status), rtt_us, ack->leaf_us);
+        p->used = false;
+        return;
+    }
+    ESP_LOGW(TAG, "CMD %u ACK " MACSTR ": không còn chờ (timeout?)", ack->cmd_id, MAC2STR(slot->from));
+}
+
+static void cmd_service(void) {
+    cmd_req_t req;
+    while (xQueueReceive(g_cmd_q, &req, 0) == pdTRUE) cmd_send(&req);
+
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    for (int i = 0; i < CMD_PENDING; i++) {
+        cmd_pending_t *p = &s_cmd_pending[i];
+        if (!p->used || now_us - p->t_send_us < CMD_TIMEOUT_MS * 1000u) continue;
+        ESP_LOGW(TAG, "CMD %u -> " MACSTR ": timeout", p->cmd_id, MAC2STR(p->mac));
+        cmd_publish_result(p, "timeout", -1, 0);
+        p->used = false;
+    }
+}
+
+// ==== Beacon thời gian: unicast tới từng leaf còn hoạt động để kèm owd riêng của leaf đó ====
+static uint16_t g_tsync_seq = 0;
+static uint32_t g_tsync_sent = 0;
+static uint32_t g_tsync_fail = 0;
+
+static void tsync_send_beacon(const node_entry_t *e, void *ctx) {
+    uint32_t now_ms = *(const uint32_t*)ctx;
+    if (now_ms - e->last_seen_ms > TSYNC_NODE_IDLE_MS) return;
+
+    uint8_t buf[TSYNC_BEACON_LEN];
+    bool utc;
+    int64_t off = mesh_time_off(&utc);
+    tsync_beacon_t b = {
+        .seq    = g_tsync_seq,
+        .flags  = utc ? TSYNC_FLAG_UTC : 0,
+        .owd_us = e->has_tsync ? e->tsync_owd_us : 0,
+    };
+#if ROOT_SLOTTED_TX
+    b.flags |= TSYNC_FLAG_SLOT;
+    b.slot   = e->tx_slot;
+    b.slots  = NODE_TX_SLOTS;
+#endif
+    mesh_addr_t to;
+    memcpy(to.addr, e->mac, 6);
+    // đóng dấu sát lúc gửi
+    b.root_us = (uint64_t)(esp_timer_get_time() + off);
+    mesh_data_t md = {
+        .data  = buf,
+        .size  = (uint16_t)tsync_beacon_encode(&b, buf, sizeof(buf)),
+        .proto = MESH_PROTO_BIN,
+        .tos   = MESH_TOS_P2P,
+    };
+    if (esp_mesh_send(&to, &md, MESH_DATA_P2P | MESH_DATA_NONBLOCK, NULL, 0) == ESP_OK) g_tsync_sent++;
+    else g_tsync_fail++;
+}
+
+static void tsync_service(void) {
+    static TickType_t last = 0;
+    if (xTaskGetTickCount() - last < pdMS_TO_TICKS(TSYNC_BEACON_MS)) return;
+    last = xTaskGetTickCount();
+
+    uint32_t now_ms = pdTICKS_TO_MS(last);
+    node_registry_foreach(&g_nodes, tsync_send_beacon, &now_ms);
+    g_tsync_seq++;
+}
+
+// ==== Nghẽn: level -> mọi leaf còn hoạt động + relay ====
+typedef struct {
+    uint32_t now_ms;
+    uint8_t  buf[CONG_FRAME_LEN];
+    uint16_t len;
+    uint32_t sent;
+    uint32_t fail;
+} cong_send_ctx_t;
+
+static void cong_send(const node_entry_t *e, void *ctx) {
+    cong_send_ctx_t *c = ctx;
+    if (c->now_ms - e->last_seen_ms > TSYNC_NODE_IDLE_MS) return;
+
+    mesh_addr_t to;
+    memcpy(to.addr, e->mac, 6);
+    mesh_data_t md = { .data = c->buf, .size = c->len, .proto = MESH_PROTO_BIN, .tos = MESH_TOS_P2P };
+    if (esp_mesh_send(&to, &md, MESH_DATA_P2P | MESH_DATA_NONBLOCK, NULL, 0) == ESP_OK) c->sent++;
+    else c->fail++;
+}
+
+// Gọi mỗi vòng trước khi drain để lấy độ sâu ring lúc còn tồn
+static void cong_sample(void) {
+    rx_ring_stats_t raw, st;
+    rx_ring_get_stats(&g_raw_ring, &raw);
+    rx_ring_get_stats(&g_rx_ring, &st);
+    uint32_t a = raw.depth * 100 / raw.capacity, b = st.depth * 100 / st.capacity;
+    uint8_t pct = (uint8_t)(a > b ? a : b);
+    if (pct > g_cong_ring_pct) g_cong_ring_pct = pct;
+}
+
+static void cong_service(void) {
+    static TickType_t last_eval = 0, last_sent = 0;
+    if (xTaskGetTickCount() - last_eval < pdMS_TO_TICKS(CONG_EVAL_MS)) return;
+    last_eval = xTaskGetTickCount();
+
+    cong_input_t in = {
+        .ring_pct     = g_cong_ring_pct,
+        .outbox_bytes = (g_mqtt && g_mqtt_connected) ? (uint32_t)esp_mqtt_client_get_outbox_size(g_mqtt) : 0,
+        .free_heap    = (uint32_t)esp_get_free_heap_size(),
+    };
+    g_cong_ring_pct = 0;
+    bool changed = cong_monitor_update(&g_cong, &in, pdTICKS_TO_MS(last_eval));
+    if (!changed && (g_cong.level == 0 || last_eval - last_sent < pdMS_TO_TICKS(CONG_REFRESH_MS))) return;
+    last_sent = last_eval;
+
+    cong_send_ctx_t ctx = { .now_ms = pdTICKS_TO_MS(last_eval) };
+    congest_t c = { .level = g_cong.level, .ttl_s = CONG_TTL_S };
+    ctx.len = (uint16_t)congest_encode(&c, ctx.buf, sizeof(ctx.buf));
+    node_registry_foreach(&g_relays, cong_send, &ctx);
+    node_registry_foreach(&g_nodes, cong_send, &ctx);
+    if (changed) {
+        ESP_LOGW(TAG, "Congestion level %u (ring %u%%, outbox %uB, heap %uB) -> %u node",
+                 g_cong.level, in.ring_pct, (unsigned)in.outbox_bytes, (unsigned)in.free_heap,
+                 (unsigned)ctx.sent);
+    }
+    if (ctx.fail) ESP_LOGW(TAG, "Congestion notice: %u send fail", (unsigned)ctx.fail);
+}
+
+// ==== Stage 3 (core app): drain ring -> MQTT (có thể chậm khi broker nghẽn) ====
+// Chèn ,"ts":<ms UTC> trước '}' cuối của JSON, -1 nếu hết chỗ
+static int json_add_ts(char *json, int len, size_t cap, int64_t ts_ms) {
+    int n = snprintf(json + len - 1, cap - (len - 1), ",\"ts\":%lld}", (long long)ts_ms);
+    return (n > 0 && len - 1 + n < (int)cap) ? len - 1 + n : -1;
+}
+
+// base_ms của SERIES là 32 bit thấp mesh time (ms) -> UTC đầy đủ, 0 nếu không biết
+static int64_t series_base_utc(const series_iter_t *it) {
+    bool utc;
+    int64_t off = mesh_time_off(&utc);
+    if (!utc || !(it->flags & SERIES_FLAG_SYNC)) return 0;
+    int64_t now = (esp_timer_get_time() + off) / 1000;
+    return now - (int32_t)((uint32_t)now - it->base_ms);
+}
+
+// SERIES: mỗi mẫu 1 message telemetry lên topic node như frame thường. Publish lỗi giữa
+// chừng thì cả frame vào journal (consumer thấy mẫu trùng seq, không mất mẫu).
+static bool publish_series(const char *topic, const uint8_t *data, size_t len, char *json, size_t cap) {
+    series_iter_t it;
+    telemetry_t tlm;
+    uint32_t off_ms;
+
+    series_iter_init(&it, data, len);
+    int64_t base = series_base_utc(&it);
+    while (series_next(&it, &tlm, &off_ms)) {
+        int n = telemetry_to_json(&tlm, json, cap);
+        if (n > 0 && base) n = json_add_ts(json, n, cap, base + off_ms);
+        if (n < 0) {
+            ESP_LOGW(TAG, "series -> JSON overflow");
+            continue;
+        }
+        if (esp_mqtt_client_publish(g_mqtt, topic, json, n, 0, 0) < 0) {
+            ESP_LOGW(TAG, "MQTT publish failed (series seq=%u)", tlm.seq);
+            return false;
+        }
+    }
+    if (it.left) ESP_LOGW(TAG, "SERIES Leaf_%02u hỏng, thiếu %u mẫu", it.node_id, it.left);
+    return true;
+}
+
+// ts_ms != 0: thời điểm leaf gửi theo UTC, thêm vào JSON telemetry
+static bool publish_frame(const uint8_t from[6], node_entry_t *node, const uint8_t *data, size_t len,
+                          int64_t ts_ms) {
+    static char fallback_topic[NODE_TOPIC_LEN];
+    static char event_topic[NODE_TOPIC_LEN + 8];
+    static char json[384];
+
+    // topic tính sẵn trong registry; chỉ format khi node chưa có (vd replay sau reboot)
+    const char *topic = node ? node->topic : fallback_topic;
+    if (!node) {
+        snprintf(fallback_topic, sizeof(fallback_topic), "%s/%02x:%02x:%02x:%02x:%02x:%02x",
+                 MQTT_BASE_TOPIC,
+                 from[0], from[1], from[2],
+                 from[3], from[4], from[5]);
+    }
+
+    if (mesh_proto_is_frame(data, len) && mesh_proto_type(data) == MESH_MSG_SERIES) {
+        return publish_series(topic, data, len, json, sizeof(json));
+    }
+
+    // Frame nhị phân -> dựng lại JSON cho consumer; payload JSON cũ thì giữ nguyên
+    const char *payload = (const char*)data;
+    int payload_len = (int)len;
+    telemetry_t tlm;
+    motion_event_t mev;
+    link_stats_t lnk;
+    summary_t sum;
+    if (telemetry_decode(data, len, &tlm)) {
+        payload_len = telemetry_to_json(&tlm, json, sizeof(json));
+        if (ts_ms && payload_len > 0) payload_len = json_add_ts(json, payload_len, sizeof(json), ts_ms);
+        payload = json;
+    } else if (motion_decode(data, len, &mev)) {
+        snprintf(event_topic, sizeof(event_topic), "%s/motion", topic);
+        topic = event_topic;
+        payload_len = motion_to_json(&mev, json, sizeof(json));
+        payload = json;
+    } else if (link_decode(data, len, &lnk)) {
+        snprintf(event_topic, sizeof(event_topic), "%s/link", topic);
+        topic = event_topic;
+        payload_len = link_to_json(&lnk, json, sizeof(json));
+        payload = json;
+    } else if (summary_decode(data, len, &sum)) {
+        snprintf(event_topic, sizeof(event_topic), "%s/summary", topic);
+        topic = event_topic;
+        payload_len = summary_to_json(&sum, json, sizeof(json));
+        payload = json;
+    }
+    if (payload_len < 0) {
+        ESP_LOGW(TAG, "frame -> JSON overflow");
+        return true;   // frame hỏng, không giữ lại
+    }
+
+    int qos = mesh_proto_class(data, len) == MESH_CLASS_ALARM ? MQTT_QOS_ALARM : 0;
+    int msg_id = esp_mqtt_client_publish(g_mqtt, topic, payload, payload_len, qos, 0);
+    if (msg_id < 0) {
+        ESP_LOGW(TAG, "MQTT publish failed");
+        return false;
+    }
+    return true;
+}
+
+// record journal = from[6] + payload
+static void journal_store(const uint8_t from[6], const uint8_t *data, size_t len) {
+    static uint8_t rec[6 + RX_RING_SLOT_SIZE];
+
+    if (!g_journal_ok) {
+        ESP_LOGW(TAG, "MQTT not connected — skip publish");
+        return;
+    }
+    if (len > RX_RING_SLOT_SIZE) {
+        ESP_LOGW(TAG, "Journal: bỏ message %uB (> record tối đa)", (unsigned)len);
+        return;
+    }
+    if (journal_unflushed(&g_journal) == 0) g_journal_dirty_since = xTaskGetTickCount();
+    memcpy(rec, from, 6);
+    memcpy(&rec[6], data, len);
+    if (journal_append(&g_journal, rec, 6 + len) != 0) {
+        ESP_LOGW(TAG, "Journal append fail (%uB)", (unsigned)len);
+    }
+}
+
+static void publish_payload(const rx_slot_t *slot, const uint8_t *data) {
+    ESP_LOGI(TAG, "RX %uB from " MACSTR, (unsigned)slot->len, MAC2STR(slot->from));
+
+    // ACK lệnh chỉ có ý nghĩa lúc này, không ghi journal
+    cmd_ack_t ack;
+    if (cmd_ack_decode(data, slot->len, &ack)) {
+        cmd_on_ack(slot, &ack);
+        return;
+    }
+
+    if (g_mqtt_connected && g_mqtt && publish_frame(slot->from, slot->tag, data, slot->len, slot->ts_ms)) {
+        // chỉ đo frame publish trực tiếp, frame replay từ journal không tính
+        uint32_t root_us = (uint32_t)esp_timer_get_time() - slot->rx_us;
+        lat_hist_add(&g_lat_root, root_us / 1000);
+        lat_hist_add(&g_lat_class[mesh_proto_class(data, slot->len)], root_us / 1000);
+        motion_event_t mev;
+        if (motion_decode(data, slot->len, &mev) && mev.last_latency_us) {
+            lat_hist_add(&g_lat_alarm_edge, mev.last_latency_us / 1000);
+        }
+        if (slot->layer) lat_hist_add(&g_lat_mesh[slot->layer - 1], slot->mesh_us / 1000);
+        g_pub_ok++;
+        return;
+    }
+    g_pub_fail++;
+    journal_store(slot->from, data, slot->len);
+}
+
+static void publish_slot(const rx_slot_t *slot, void *ctx) {
+    uint32_t t0 = (uint32_t)esp_timer_get_time();
+
+    // message ghép mảnh: đọc thẳng từ context reassembly rồi trả về pool
+    publish_payload(slot, slot->ext ? slot->ext : slot->data);
+    if (slot->ext) frag_reasm_release(&g_frag, slot->ext);
+    stage_stats_add(&g_stage[STAGE_PUB], (uint32_t)esp_timer_get_time() - t0, t0 - slot->enq_us);
+}
+
+// Mất MQTT: gom page rồi flush theo chu kỳ. Có MQTT: replay theo nhịp cố định.
+static void journal_service(void) {
+    static uint8_t rec[6 + RX_RING_SLOT_SIZE];
+    static TickType_t last_replay = 0;
+
+    if (!g_journal_ok) return;
+
+    if (!g_mqtt_connected || !g_mqtt) {
+        if (journal_unflushed(&g_journal) > 0 &&
+            xTaskGetTickCount() - g_journal_dirty_since >= pdMS_TO_TICKS(JOURNAL_FLUSH_MS)) {
+            journal_flush(&g_journal);
+        }
+        return;
+    }
+
+    if (journal_empty(&g_journal) ||
+        xTaskGetTickCount() - last_replay < pdMS_TO_TICKS(JOURNAL_REPLAY_PERIOD_MS)) return;
+    last_replay = xTaskGetTickCount();
+
+    for (int i = 0; i < JOURNAL_REPLAY_BURST; i++) {
+        int n = journal_peek(&g_journal, rec, sizeof(rec));
+        if (n <= 6) {
+            if (n < 0) ESP_LOGE(TAG, "Journal read fail");
+            else if (n > 0) journal_pop(&g_journal);
+            break;
+        }
+        if (!publish_frame(rec, node_registry_find(&g_nodes, rec), &rec[6], (size_t)n - 6, 0)) break;
+        journal_pop(&g_journal);
+    }
+    if (journal_empty(&g_journal)) {
+        ESP_LOGI(TAG, "Journal: replay xong (%u frames)", (unsigned)g_journal.stats.replayed);
+    }
+}
+
+static void log_node(const node_entry_t *e, void *ctx) {
+    uint32_t now_ms = *(const uint32_t*)ctx;
+    ESP_LOGI(TAG, "  " MACSTR ": frames=%u, bytes=%u, rate=%.2f/s, seq=%u, lost=%u, dup=%u, reorder=%u, seen %us ago",
+             MAC2STR(e->mac), (unsigned)e->frames, (unsigned)e->bytes, node_registry_rate(e),
+             e->seq.has ? (unsigned)e->seq.last : 0u, (unsigned)e->seq.lost, (unsigned)e->seq.dup,
+             (unsigned)e->seq.reorder, (unsigned)((now_ms - e->last_seen_ms) / 1000));
+    if (e->has_tsync) {
+        ESP_LOGI(TAG, "    sync: err=%dus (leaf %dus), owd=%uus, echoes=%u", (int)e->tsync_err_us,
+                 (int)e->tsync_leaf_err_us, (unsigned)e->tsync_owd_us, (unsigned)e->tsync_echoes);
+    }
+}
+
+// ==== Metrics: mỗi node -> "<topic node>/metrics", histogram -> "<base>/metrics" ====
+static void publish_node_metrics(const node_entry_t *e, void *ctx) {
+    char topic[NODE_TOPIC_LEN + 8];
+    char json[224];
+    const seq_track_t *s = &e->seq;
+    if (!s->has) return;
+
+    uint32_t expected = s->received + s->lost;
+    snprintf(topic, sizeof(topic), "%s/metrics", e->topic);
+    int n = snprintf(json, sizeof(json),
+                     "{\"rx\":%u,\"lost\":%u,\"dup\":%u,\"reorder\":%u,\"restarts\":%u,\"loss_pct\":%.2f",
+                     (unsigned)s->received, (unsigned)s->lost, (unsigned)s->dup, (unsigned)s->reorder,
+                     (unsigned)s->restarts, expected ? 100.0f * s->lost / expected : 0.0f);
+    if (n > 0 && n < (int)sizeof(json) && e->has_tsync) {
+        n += snprintf(json + n, sizeof(json) - n, ",\"sync_err_us\":%d,\"sync_leaf_err_us\":%d,\"sync_owd_us\":%u",
+                      (int)e->tsync_err_us, (int)e->tsync_leaf_err_us, (unsigned)e->tsync_owd_us);
+    }
+    if (n > 0 && n < (int)sizeof(json) - 1) n += snprintf(json + n, sizeof(json) - n, "}");
+    if (n > 0 && n < (int)sizeof(json)) esp_mqtt_client_publish(g_mqtt, topic, json, n, 0, 0);
+}
+
+// Nối 1 histogram vào JSON, trả về độ dài mới (giữ nguyên nếu hết chỗ)
+static int hist_json(char *out, int len, size_t cap, const char *name, const lat_hist_snap_t *s) {
+    int n = snprintf(out + len, cap - len,
+                     "%s\"%s\":{\"n\":%u,\"p50\":%u,\"p90\":%u,\"p99\":%u,\"max\":%u,\"b\":[",
+                     len > 1 ? "," : "", name, (unsigned)s->count,
+                     (unsigned)lat_hist_percentile(s, 50), (unsigned)lat_hist_percentile(s, 90),
+                     (unsigned)lat_hist_percentile(s, 99), (unsigned)s->max_ms);
+    for (int i = 0; i < LAT_HIST_BUCKETS && n > 0 && len + n < (int)cap; i++) {
+        n += snprintf(out + len + n, cap - len - n, "%s%u", i ? "," : "", (unsigned)s->b[i]);
+    }
+    if (n > 0 && len + n < (int)cap) n += snprintf(out + len + n, cap - len - n, "]}");
+    return (n > 0 && len + n < (int)cap) ? len + n : len;
+}
+
+static void publish_metrics(void) {
+    static char json[1536];
+    char topic[24];
+    lat_hist_snap_t snap;
+
+    node_registry_foreach(&g_nodes, publish_node_metrics, NULL);
+
+    // đơn vị ms, bucket i = [2^(i-1), 2^i)
+    int len = snprintf(json, sizeof(json), "{");
+    lat_hist_take(&g_lat_root, &snap);
+    ESP_LOGI(TAG, "Publish latency recv->publish: n=%u, p50=%ums, p90=%ums, p99=%ums, max=%ums",
+             (unsigned)snap.count, (unsigned)lat_hist_percentile(&snap, 50),
+             (unsigned)lat_hist_percentile(&snap, 90), (unsigned)lat_hist_percentile(&snap, 99),
+             (unsigned)snap.max_ms);
+    len = hist_json(json, len, sizeof(json), "root", &snap);
+    if (lat_hist_take(&g_lat_cmd, &snap)) len = hist_json(json, len, sizeof(json), "cmd_rtt", &snap);
+    if (lat_hist_take(&g_lat_sync, &snap)) len = hist_json(json, len, sizeof(json), "sync_err", &snap);
+    if (lat_hist_take(&g_lat_class[MESH_CLASS_TELEMETRY], &snap)) {
+        len = hist_json(json, len, sizeof(json), "cls_telemetry", &snap);
+    }
+    if (lat_hist_take(&g_lat_class[MESH_CLASS_ALARM], &snap)) len = hist_json(json, len, sizeof(json), "cls_alarm", &snap);
+    if (lat_hist_take(&g_lat_alarm_edge, &snap)) len = hist_json(json, len, sizeof(json), "alarm_edge", &snap);
+    for (int l = 0; l < LAT_MAX_LAYER; l++) {
+        char name[12];
+        if (!lat_hist_take(&g_lat_mesh[l], &snap)) continue;
+        snprintf(name, sizeof(name), "mesh_l%d", l + 1);
+        len = hist_json(json, len, sizeof(json), name, &snap);
+    }
+    if (len + 2 > (int)sizeof(json)) return;
+    len += snprintf(json + len, sizeof(json) - len, "}");
+
+    snprintf(topic, sizeof(topic), "%s/metrics", MQTT_BASE_TOPIC);
+    esp_mqtt_client_publish(g_mqtt, topic, json, len, 0, 0);
+}
+
+// Mỗi stage: core, item/s, % thời gian bận, chờ trong hàng đợi, stack còn trống
+static void report_pipeline(uint32_t period_ms) {
+    static const char *const names[STAGE_COUNT] = { "recv", "decode", "publish" };
+    static const int cores[STAGE_COUNT] = { ROOT_CORE_RECV, ROOT_CORE_DECODE, ROOT_CORE_PUB };
+    TaskHandle_t tasks[STAGE_COUNT] = { g_recv_task, g_decode_task, g_pub_task };
+    char json[448];
+    int len = snprintf(json, sizeof(json), "{");
+
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        stage_snap_t sn;
+        stage_stats_take(&g_stage[i], &sn);
+        unsigned stack_free = tasks[i] ? (unsigned)uxTaskGetStackHighWaterMark(tasks[i]) : 0;
+        float busy = 100.0f * sn.busy_us / (period_ms * 1000.0f);
+        unsigned wait_avg = sn.items ? (unsigned)(sn.wait_sum_us / sn.items) : 0;
+        ESP_LOGI(TAG, "Stage %-7s core%d: %.1f item/s, busy %.2f%%, wait avg=%uus max=%uus, stack free=%uB",
+                 names[i], cores[i], sn.items * 1000.0f / period_ms, busy, wait_avg,
+                 (unsigned)sn.wait_max_us, stack_free);
+        int n = snprintf(json + len, sizeof(json) - len,
+                         "%s\"%s\":{\"core\":%d,\"items\":%u,\"busy_pct\":%.2f,\"wait_avg_us\":%u,"
+                         "\"wait_max_us\":%u,\"stack_free\":%u}",
+                         i ? "," : "", names[i], cores[i], (unsigned)sn.items, busy, wait_avg,
+                         (unsigned)sn.wait_max_us, stack_free);
+        if (n < 0 || len + n >= (int)sizeof(json) - 1) return;
+        len += n;
+    }
+    // link root: frame dồn nhiều nhất trong 1 cửa sổ, giảm khi leaf gửi theo slot
+    len += snprintf(json + len, sizeof(json) - len, ",\"rx_burst_max\":%u,\"congestion\":%u}",
+                    (unsigned)g_rx_burst_max, g_cong.level);
+    if (len >= (int)sizeof(json)) return;
+
+    char topic[32];
+    snprintf(topic, sizeof(topic), "%s/metrics/pipeline", MQTT_BASE_TOPIC);
+    if (g_mqtt_connected && g_mqtt) esp_mqtt_client_publish(g_mqtt, topic, json, len, 0, 0);
+}
+
+// Slot trống của ring publish. Đầy thì chờ mqtt_pub_task nhả slot thay vì bỏ frame: decode
+// ưu tiên cao hơn publish trên cùng core, 1 raw slot BATCH ra tới RELAY_BATCH_FRAMES frame nên
+// không chờ thì 2-3 BATCH dồn là tràn ring. Trong lúc chờ, frame mới dồn ở raw ring, đầy thì
+// recv bỏ và đếm ở overflow của raw ring.
+static rx_slot_t *pub_slot_wait(void) {
+    rx_slot_t *slot;
+    // đặt cờ trước khi thử để không lỡ lần publish nhả slot ngay sau đó
+    g_decode_waiting = true;
+    while ((slot = rx_ring_acquire(&g_rx_ring)) == NULL) {
+        xTaskNotifyGive(g_pub_task);
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DECODE_WAIT_POLL_MS));
+    }
+    g_decode_waiting = false;
+    return slot;
+}
+
+// mqtt_pub_task vừa nhả slot: đánh thức decode nếu đang chờ
+static void pub_slot_freed(void) {
+    if (g_decode_waiting) xTaskNotifyGive(g_decode_task);
+}
+
+static void mqtt_pub_task(void *arg) {
+    TickType_t last_stats = xTaskGetTickCount();
+    TickType_t last_metrics = xTaskGetTickCount();
+
+    for (;;) {
+        bool replaying = g_journal_ok && g_mqtt_connected && !journal_empty(&g_journal);
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(replaying ? JOURNAL_REPLAY_PERIOD_MS : 1000));
+        cong_sample();
+        // ALARM trước hết; TELEMETRY từng đợt nhỏ, giữa 2 đợt xem lại ALARM
+        rx_ring_drain(&g_alarm_ring, publish_slot, NULL, 0);
+        while (rx_ring_drain(&g_rx_ring, publish_slot, NULL, PUB_BULK_BURST) == PUB_BULK_BURST) {
+            pub_slot_freed();
+            rx_ring_drain(&g_alarm_ring, publish_slot, NULL, 0);
+        }
+        pub_slot_freed();
+        rx_ring_drain(&g_alarm_ring, publish_slot, NULL, 0);
+        cmd_service();
+        tsync_service();
+        cong_service();
+        journal_service();
+
+        if (xTaskGetTickCount() - last_metrics >= pdMS_TO_TICKS(METRICS_PERIOD_MS)) {
+            last_metrics = xTaskGetTickCount();
+            if (g_mqtt_connected && g_mqtt) publish_metrics();
+        }
+
+        if (xTaskGetTickCount() - last_stats >= pdMS_TO_TICKS(RX_STATS_PERIOD_MS)) {
+            last_stats = xTaskGetTickCount();
+            rx_ring_stats_t st, raw;
+            rx_ring_get_stats(&g_raw_ring, &raw);
+            rx_ring_get_stats(&g_rx_ring, &st);
+            ESP_LOGI(TAG, "Raw ring: depth=%u/%u, hwm=%u, overflow=%u | RX ring: depth=%u/%u, hwm=%u, overflow=%u",
+                     (unsigned)raw.depth, (unsigned)raw.capacity, (unsigned)raw.hwm, (unsigned)raw.overflow,
+                     (unsigned)st.depth, (unsigned)st.capacity, (unsigned)st.hwm, (unsigned)st.overflow);
+            rx_ring_stats_t al;
+            rx_ring_get_stats(&g_alarm_ring, &al);
+            if (al.hwm) {
+                ESP_LOGI(TAG, "Alarm ring: depth=%u/%u, hwm=%u, overflow=%u (-> RX ring)",
+                         (unsigned)al.depth, (unsigned)al.capacity, (unsigned)al.hwm, (unsigned)al.overflow);
+            }
+            report_pipeline(RX_STATS_PERIOD_MS);
+            if (g_rules.set.count) {
+                ESP_LOGI(TAG, "Rules: %u luật, xét=%u, bắn=%u, holdoff=%u", g_rules.set.count,
+                         (unsigned)g_rules.evals, (unsigned)g_rules.fired, (unsigned)g_rules.held);
+            }
+            static uint32_t prev_link = 0, prev_leaf = 0;
+            ESP_LOGI(TAG, "Root link: %.1f frame/s (batch=%u), leaf frames %.1f/s, burst max=%u/%ums",
+                     (g_rx_link_frames - prev_link) * 1000.0f / RX_STATS_PERIOD_MS, (unsigned)g_rx_batches,
+                     (g_rx_leaf_frames - prev_leaf) * 1000.0f / RX_STATS_PERIOD_MS,
+                     (unsigned)g_rx_burst_max, RX_BURST_WINDOW_MS);
+            g_rx_burst_max = 0;
+            prev_link = g_rx_link_frames;
+            const frag_reasm_stats_t *fs = &g_frag.stats;
+            if (fs->fragments) {
+                ESP_LOGI(TAG, "Frag: msgs=%u (frags=%u), dup=%u, bad=%u, timeout=%u, superseded=%u, no_ctx=%u",
+                         (unsigned)fs->completed, (unsigned)fs->fragments, (unsigned)fs->dup, (unsigned)fs->bad,
+                         (unsigned)fs->timeouts, (unsigned)fs->superseded, (unsigned)fs->no_ctx);
+            }
+            prev_leaf = g_rx_leaf_frames;
+#if ROOT_LOADGEN
+            static uint32_t prev_gen = 0, prev_ok = 0, prev_ms = 0;
+            loadgen_stats_t lg;
+            loadgen_get_stats(&lg);
+            float dt = (lg.elapsed_ms - prev_ms) / 1000.0f;
+            ESP_LOGI(TAG, "Loadgen: gen=%u (%.1f/s), published=%u (%.1f/s), pub_fail=%u, overflow=%u, late=%u, alarms=%u",
+                     (unsigned)lg.generated, dt > 0 ? (lg.generated - prev_gen) / dt : 0.0f,
+                     (unsigned)g_pub_ok, dt > 0 ? (g_pub_ok - prev_ok) / dt : 0.0f,
+                     (unsigned)g_pub_fail, (unsigned)(st.overflow + raw.overflow), (unsigned)lg.late,
+                     (unsigned)lg.alarms);
+            prev_gen = lg.generated;
+            prev_ok  = g_pub_ok;
+            prev_ms  = lg.elapsed_ms;
+#endif
+            if (g_journal_ok) {
+                const journal_stats_t *js = &g_journal.stats;
+                ESP_LOGI(TAG, "Journal: appended=%u, replayed=%u, flushes=%u, dropped_pages=%u, errors=%u",
+                         (unsigned)js->appended, (unsigned)js->replayed, (unsigned)js->flushes,
+                         (unsigned)js->dropped_pages, (unsigned)js->errors);
+            }
+            bool utc;
+            mesh_time_off(&utc);
+            ESP_LOGI(TAG, "Time sync: mesh time=%s, beacons sent=%u, fail=%u", utc ? "UTC" : "root esp_timer",
+                     (unsigned)g_tsync_sent, (unsigned)g_tsync_fail);
+            uint32_t now_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+            ESP_LOGI(TAG, "Nodes: %u/%u (full_drops=%u)",
+                     (unsigned)g_nodes.count, (unsigned)g_nodes.max_nodes, (unsigned)g_nodes.full_drops);
+            node_registry_foreach(&g_nodes, log_node, &now_ms);
+        }
+    }
+}
+
+// ACK sự kiện PIR ngay tại stage nhận để leaf đo được độ trễ cạnh -> root
+static void ack_motion(const mesh_addr_t *to, const uint8_t *data, size_t len) {
+    motion_event_t mev;
+    uint8_t buf[MOTION_ACK_LEN];
+    if (ROOT_LOADGEN || !motion_decode(data, len, &mev)) return;   // leaf ảo không nhận ACK
+
+    mesh_data_t md = {
+        .data  = buf,
+        .size  = (uint16_t)motion_ack_encode(mev.node_id, mev.seq, buf, sizeof(buf)),
+        .proto = MESH_PROTO_BIN,
+        .tos   = MESH_TOS_P2P,
+    };
+    esp_err_t err = esp_mesh_send(to, &md, MESH_DATA_P2P | MESH_DATA_NONBLOCK, NULL, 0);
+    if (err != ESP_OK) ESP_LOGW(TAG, "Motion ACK fail: %s", esp_err_to_name(err));
+    if (mev.last_latency_us) {
+        ESP_LOGI(TAG, "Motion " MACSTR " seq=%u: edge->send=%uus, last edge->root=%uus",
+                 MAC2STR(to->addr), mev.seq, (unsigned)mev.edge_to_send_us, (unsigned)mev.last_latency_us);
+    }
+}
+
+// ==== Stage 1 (core Wi-Fi): esp_mesh_recv -> raw ring, chỉ nhận + đóng dấu thời gian ====
 static void mesh_recv_task(void *arg) {
     mesh_addr_t from;
-    uint8_t rx_buf[512];
+    static uint8_t drop_buf[RX_RING_SLOT_SIZE];   // nhận tạm khi ring đầy
     mesh_data_t rx = {
-        .data  = rx_buf,
-        .size  = sizeof(rx_buf),
         .proto = MESH_PROTO_BIN,
         .tos   = MESH_TOS_DEF
     };
     int flag = 0;
-    char topic[128];
+    uint32_t burst_start_us = 0, burst = 0;
 
     for(;;){
-        rx.size = sizeof(rx_buf);
-        esp_err_t err = esp_mesh_recv(&from, &rx, portMAX_DELAY, &flag, NULL, 0);
-        if (err == ESP_OK) {
-            size_t n = (rx.size < sizeof(rx_buf)) ? rx.size : sizeof(rx_buf)-1;
-            rx_buf[n] = '\0';
-            snprintf(topic, sizeof(topic), "%s/%02x:%02x:%02x:%02x:%02x:%02x",
-                     MQTT_BASE_TOPIC,
-                     from.addr[0], from.addr[1], from.addr[2],
-                     from.addr[3], from.addr[4], from.addr[5]);
-
-            ESP_LOGI(TAG, "RX %uB from " MACSTR " -> MQTT [%s]", (unsigned)rx.size, MAC2STR(from.addr), topic);
-
-            if (g_mqtt_connected && g_mqtt) {
-                int msg_id = esp_mqtt_client_publish(g_mqtt, topic, (const char*)rx.data, (int)rx.size, 0, 0);
-                if (msg_id < 0) {
-                    ESP_LOGW(TAG, "MQTT publish failed");
-                }
-            } else {
-                ESP_LOGW(TAG, "MQTT not connected — skip publish");
+        // nhận thẳng vào slot trống để khỏi copy
+        rx_slot_t *slot = rx_ring_acquire(&g_raw_ring);
+        rx.data = slot ? slot->data : drop_buf;
+        rx.size = RX_RING_SLOT_SIZE;
+        esp_err_t err = root_mesh_recv(&from, &rx, portMAX_DELAY, &flag, NULL, 0);
+        if (err != ESP_OK) continue;
+        flag = 0;
+
+        uint32_t rx_us = (uint32_t)esp_timer_get_time();
+        size_t n = (rx.size < RX_RING_SLOT_SIZE) ? rx.size : RX_RING_SLOT_SIZE;
+        g_rx_link_frames++;
+        if (rx_us - burst_start_us >= RX_BURST_WINDOW_MS * 1000u) {
+            burst_start_us = rx_us;
+            burst = 0;
+        }
+        if (++burst > g_rx_burst_max) g_rx_burst_max = burst;
+        ack_motion(&from, rx.data, n);
+
+        // decoder có thể đã nhả slot trong lúc chờ recv
+        if (!slot && (slot = rx_ring_acquire(&g_raw_ring)) != NULL) memcpy(slot->data, drop_buf, n);
+        if (!slot) {
+            rx_ring_count_overflow(&g_raw_ring);
+            ESP_LOGW(TAG, "Raw ring full — drop %uB from " MACSTR, (unsigned)n, MAC2STR(from.addr));
+            continue;
+        }
+        memcpy(slot->from, from.addr, 6);
+        slot->len    = (uint16_t)n;
+        slot->ext    = NULL;
+        slot->rx_us  = rx_us;
+        slot->enq_us = (uint32_t)esp_timer_get_time();
+        rx_ring_commit(&g_raw_ring);
+        xTaskNotifyGive(g_decode_task);
+        stage_stats_add(&g_stage[STAGE_RECV], slot->enq_us - rx_us, 0);
+    }
+}
+
+// ==== Stage 2 (core app): tách mảnh/BATCH, registry, seq, trễ -> pub ring ====
+static void rx_drop(uint8_t *ext) {
+    if (ext) frag_reasm_release(&g_frag, ext);
+}
+
+// Echo beacon: RTT theo mesh time của root (trừ thời gian leaf giữ), sai số = mesh time leaf
+// lúc gửi echo so với mesh time root ước lượng cùng lúc (giả sử đường lên = RTT/2)
+static void tsync_on_echo(node_entry_t *node, const tsync_echo_t *e, uint32_t rx_us) {
+    uint32_t rx_mesh = rx_us + (uint32_t)mesh_time_off(NULL);
+    int32_t rtt = (int32_t)(rx_mesh - e->root_us - e->hold_us);
+    if (rtt < 0 || rtt > TSYNC_RTT_MAX_US) {
+        ESP_LOGW(TAG, "Echo " MACSTR " seq=%u: RTT %dus bất thường — bỏ", MAC2STR(node->mac), e->seq, (int)rtt);
+        return;
+    }
+
+    int32_t err = 0;
+    if (e->flags & TSYNC_FLAG_SYNCED) err = (int32_t)(e->leaf_us - (rx_mesh - (uint32_t)rtt / 2));
+    node_registry_on_tsync(node, (uint32_t)rtt, err, e->err_us);
+    lat_hist_add(&g_lat_sync, (uint32_t)(err < 0 ? -err : err) / 1000);
+}
+
+// ==== Luật tại root: xét ngay ở stage decode, hành động không đi qua ring publish ====
+// Giờ địa phương cho khung giờ của luật, -1 nếu chưa có SNTP
+static int rules_hour(void) {
+    bool utc;
+    int64_t off = mesh_time_off(&utc);
+    if (!utc) return -1;
+    int64_t sec = (esp_timer_get_time() + off) / 1000000 + RULES_TZ_OFFSET_S;
+    return (int)((sec / 3600) % 24);
+}
+
+// Alert: enqueue vào outbox MQTT (không block decode), task MQTT gửi QoS 1.
+// Lệnh: qua g_cmd_q như lệnh từ MQTT, ACK về "<target>/cmd/ack" với ref = RULES_CMD_REF | idx.
+static void rule_fire(const rule_t *r, uint8_t idx, const uint8_t mac[6], int32_t value, void *ctx) {
+    ESP_LOGW(TAG, "Rule %s: " MACSTR " %s=%d", r->name, MAC2STR(mac), rule_src_name(r->src), (int)value);
+
+    if ((r->actions & RULE_ACT_ALERT) && g_mqtt) {
+        char json[160];
+        bool utc;
+        int64_t off = mesh_time_off(&utc);
+        int n = snprintf(json, sizeof(json),
+                         "{\"rule\":\"%s\",\"node\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"src\":\"%s\",\"value\":%d}",
+                         r->name, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
+                         rule_src_name(r->src), (int)value);
+        if (n > 0 && utc) n = json_add_ts(json, n, sizeof(json), (esp_timer_get_time() + off) / 1000);
+        if (n > 0 && esp_mqtt_client_enqueue(g_mqtt, MQTT_BASE_TOPIC "/alert", json, n, MQTT_QOS_ALARM, 0, true) < 0) {
+            ESP_LOGW(TAG, "Rule %s: alert enqueue fail", r->name);
+        }
+    }
+    if (r->actions & RULE_ACT_CMD) {
+        cmd_req_t req = { .ref = RULES_CMD_REF | idx };
+        memcpy(req.mac, r->cmd_self ? mac : r->cmd_mac, 6);
+        req.cmd.op      = r->cmd_op;
+        req.cmd.arg_len = r->cmd_arg_len;
+        memcpy(req.cmd.arg, r->cmd_arg, r->cmd_arg_len);
+        if (xQueueSend(g_cmd_q, &req, 0) != pdTRUE) {
+            ESP_LOGW(TAG, "Rule %s: CMD queue đầy — bỏ", r->name);
+            return;
+        }
+        xTaskNotifyGive(g_pub_task);
+    }
+}
+
+static void rules_sample_tlm(const telemetry_t *t, rule_sample_t *s) {
+    s->valid = 1u << RULE_SRC_LIGHT;
+    s->v[RULE_SRC_LIGHT] = t->light_raw;
+    if (t->flags & TLM_FLAG_DHT_OK) {
+        s->valid |= (1u << RULE_SRC_TEMP) | (1u << RULE_SRC_HUMI);
+        s->v[RULE_SRC_TEMP] = t->temp;
+        s->v[RULE_SRC_HUMI] = t->humi;
+    }
+}
+
+// Mẫu trong frame -> rule_engine_eval. Mẫu SERIES xét lần lượt theo thứ tự leaf lấy.
+static void rules_on_frame(const node_entry_t *node, const uint8_t *data, size_t n, uint32_t now_ms) {
+    if (g_rules.set.count == 0 || !mesh_proto_is_frame(data, n)) return;
+
+    uint32_t slot = (uint32_t)(node - s_node_slots);
+    int hour = rules_hour();
+    rule_sample_t smp = { 0 };
+    telemetry_t tlm;
+    motion_event_t mev;
+    series_iter_t it;
+    uint32_t off_ms;
+
+    switch (mesh_proto_type(data)) {
+        case MESH_MSG_MOTION:
+            if (!motion_decode(data, n, &mev)) break;
+            smp.valid = 1u << RULE_SRC_MOTION;
+            smp.v[RULE_SRC_MOTION] = mev.level;
+            rule_engine_eval(&g_rules, node->mac, slot, &smp, hour, now_ms, rule_fire, NULL);
+            break;
+        case MESH_MSG_TELEMETRY:
+            if (!telemetry_decode(data, n, &tlm)) break;
+            rules_sample_tlm(&tlm, &smp);
+            rule_engine_eval(&g_rules, node->mac, slot, &smp, hour, now_ms, rule_fire, NULL);
+            break;
+        case MESH_MSG_SERIES:
+            if (!series_iter_init(&it, data, n)) break;
+            while (series_next(&it, &tlm, &off_ms)) {
+                rules_sample_tlm(&tlm, &smp);
+                rule_engine_eval(&g_rules, node->mac, slot, &smp, hour, now_ms, rule_fire, NULL);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Xử lý 1 frame leaf (nhận trực tiếp hoặc tách từ BATCH của relay).
+// ext != NULL: data là message ghép mảnh, slot chỉ trỏ tới, bỏ frame thì trả context.
+static void rx_frame(const uint8_t mac[6], const uint8_t *data, size_t n,
+                     uint8_t *ext, uint32_t rx_us, uint32_t now_ms) {
+    // 1 lần tra bảng / frame, topic đã tính sẵn trong entry
+    node_entry_t *node = node_registry_get(&g_nodes, mac, now_ms);
+    if (node) node_registry_on_frame(node, now_ms, n);
+
+    // seq + timestamp telemetry: bỏ frame trùng ngay tại đây, đo trễ mesh
+    telemetry_t tlm;
+    summary_t sum;
+    series_iter_t ser;
+    tsync_echo_t echo;
+    uint32_t mesh_us = 0;
+    uint8_t  layer = 0;
+    int64_t  ts_ms = 0;
+    if (tsync_echo_decode(data, n, &echo)) {
+        // chỉ phục vụ đồng bộ, không publish; bảng node đầy thì bỏ luôn thay vì publish thô
+        if (node) tsync_on_echo(node, &echo, rx_us);
+        rx_drop(ext);
+        return;
+    } else if (node && summary_decode(data, n, &sum)) {
+        // relay đã gộp dải seq, không tính là mất
+        if (seq_track_update_range(&node->seq, sum.seq_first, sum.seq_last, sum.samples) == SEQ_DUP) {
+            rx_drop(ext);
+            return;
+        }
+    } else if (node && series_iter_init(&ser, data, n) && ser.left) {
+        // leaf gom N mẫu, seq liền nhau
+        uint16_t last = (uint16_t)(ser.seq + ser.left - 1);
+        if (seq_track_update_range(&node->seq, ser.seq, last, ser.left) == SEQ_DUP) {
+            rx_drop(ext);
+            return;
+        }
+    } else if (node && telemetry_decode(data, n, &tlm)) {
+        if (seq_track_update(&node->seq, tlm.seq) == SEQ_DUP) {
+            rx_drop(ext);
+            return;
+        }
+        if ((tlm.flags & TLM_FLAG_TX_SYNC) && tlm.layer) {
+            // leaf đã đồng bộ: trễ 1 chiều đo thẳng. Ngoài khoảng hợp lệ = leaf chưa bám
+            // kịp mesh time mới (vd root vừa có SNTP) -> bỏ mẫu này
+            bool utc;
+            int64_t off = mesh_time_off(&utc);
+            int32_t owd = (int32_t)(rx_us + (uint32_t)off - tlm.tx_us);
+            if (owd >= 0 && owd <= TSYNC_RTT_MAX_US) {
+                mesh_us = (uint32_t)owd;
+                layer = tlm.layer > LAT_MAX_LAYER ? LAT_MAX_LAYER : tlm.layer;
+                int64_t now_us = esp_timer_get_time();
+                int64_t rx_full = now_us - (uint32_t)((uint32_t)now_us - rx_us);
+                if (utc) ts_ms = (rx_full + off - mesh_us) / 1000;
             }
-            flag = 0;
+        } else if ((tlm.flags & TLM_FLAG_TX_TS) && tlm.layer) {
+            mesh_us = node_registry_on_owd(node, (int32_t)(rx_us - tlm.tx_us), now_ms);
+            layer = tlm.layer > LAT_MAX_LAYER ? LAT_MAX_LAYER : tlm.layer;
         }
     }
+
+    if (node) rules_on_frame(node, data, n, now_ms);
+
+    // ALARM vào ring riêng; ring đó đầy thì vẫn thử ring thường thay vì bỏ
+    rx_ring_t *ring = &g_rx_ring;
+    rx_slot_t *slot = NULL;
+    if (mesh_proto_class(data, n) == MESH_CLASS_ALARM) {
+        slot = rx_ring_acquire(&g_alarm_ring);
+        if (slot) ring = &g_alarm_ring;
+        else rx_ring_count_overflow(&g_alarm_ring);
+    }
+    if (!slot) slot = pub_slot_wait();
+    if (!ext) memcpy(slot->data, data, n);
+    memcpy(slot->from, mac, 6);
+    slot->len = (uint16_t)n;
+    slot->ext = ext;
+    slot->tag = node;
+    slot->rx_us   = rx_us;
+    slot->mesh_us = mesh_us;
+    slot->layer   = layer;
+    slot->ts_ms   = ts_ms;
+    slot->enq_us  = (uint32_t)esp_timer_get_time();
+    rx_ring_commit(ring);
+    xTaskNotifyGive(g_pub_task);
+}
+
+// 1 message hoàn chỉnh: frame lẻ hoặc BATCH của relay. Raw slot giữ nguyên tới khi
+// decode xong nên BATCH được tách tại chỗ.
+static void rx_message(const uint8_t from[6], const uint8_t *data, size_t n,
+                       uint8_t *ext, uint32_t rx_us, uint32_t now_ms) {
+    batch_iter_t it;
+
+    if (!batch_iter_init(&it, data, n)) {
+        g_rx_leaf_frames++;
+        rx_frame(from, data, n, ext, rx_us, now_ms);
+        return;
+    }
+
+    const uint8_t *mac, *entry;
+    size_t len;
+    g_rx_batches++;
+    node_entry_t *relay = node_registry_get(&g_relays, from, now_ms);
+    if (relay) node_registry_on_frame(relay, now_ms, n);
+    while (batch_next(&it, &mac, &entry, &len)) {
+        g_rx_leaf_frames++;
+        rx_frame(mac, entry, len, NULL, rx_us, now_ms);
+    }
+    if (it.left) ESP_LOGW(TAG, "BATCH từ " MACSTR " bị cắt, thiếu %u frame", MAC2STR(from), it.left);
+    rx_drop(ext);
+}
+
+static void decode_slot(const rx_slot_t *slot, void *ctx) {
+    uint32_t t0 = (uint32_t)esp_timer_get_time();
+    uint32_t now_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+
+    // mảnh: chép vào context, message đủ mảnh mới đi tiếp
+    frag_t frag;
+    if (frag_decode(slot->data, slot->len, &frag)) {
+        size_t len;
+        uint8_t *msg = frag_reasm_push(&g_frag, slot->from, &frag, now_ms, &len);
+        if (msg) rx_message(slot->from, msg, len, msg, slot->rx_us, now_ms);
+    } else {
+        rx_message(slot->from, slot->data, slot->len, NULL, slot->rx_us, now_ms);
+    }
+    stage_stats_add(&g_stage[STAGE_DECODE], (uint32_t)esp_timer_get_time() - t0, t0 - slot->enq_us);
+}
+
+static void mesh_decode_task(void *arg) {
+    static rule_set_t rules;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (xQueueReceive(g_rule_q, &rules, 0) == pdTRUE) {
+            rule_engine_load(&g_rules, &rules);
+            ESP_LOGI(TAG, "Rules: nạp %u luật", rules.count);
+        }
+        rx_ring_drain(&g_raw_ring, decode_slot, NULL, 0);
+    }
 }
 
 static void mesh_apply_config_open(void) {
@@ -188,6 +1548,9 @@ void app_main(void) {
     }
 
    
+    g_cmd_q = xQueueCreate(CMD_QUEUE_LEN, sizeof(cmd_req_t));
+    g_rule_q = xQueueCreate(1, sizeof(rule_set_t));
+    rules_load();
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
     ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &ip_evt_handler, NULL));
@@ -223,5 +1586,35 @@ void app_main(void) {
     ESP_LOGI(TAG, "ROOT BSSID   : " MACSTR " (Mesh SoftAP)", MAC2STR(ap_mac));
 
 
-    xTaskCreate(mesh_recv_task, "mesh_recv", 6144, NULL, 4, NULL);
+    rx_ring_init(&g_raw_ring, s_raw_slots, RAW_RING_SLOTS);
+    rx_ring_init(&g_rx_ring, s_rx_slots, RX_RING_SLOTS);
+    rx_ring_init(&g_alarm_ring, s_alarm_slots, ALARM_RING_SLOTS);
+    for (int i = 0; i < STAGE_COUNT; i++) stage_stats_init(&g_stage[i]);
+#if ROOT_LOADGEN
+    loadgen_cfg_t lg = {
+        .leaves     = LOADGEN_LEAVES,
+        .period_ms  = LOADGEN_PERIOD_MS,
+        .frame_size = LOADGEN_FRAME_SIZE,
+        .batch      = LOADGEN_BATCH,
+        .aligned    = LOADGEN_ALIGNED,
+        .alarm_ms   = LOADGEN_ALARM_MS,
+        .max_layer  = LAT_MAX_LAYER,
+    };
+    loadgen_init(&lg);
+#endif
+    lat_hist_init(&g_lat_root);
+    lat_hist_init(&g_lat_cmd);
+    lat_hist_init(&g_lat_sync);
+    lat_hist_init(&g_lat_alarm_edge);
+    for (int c = 0; c < MESH_CLASS_COUNT; c++) lat_hist_init(&g_lat_class[c]);
+    frag_reasm_init(&g_frag, s_frag_ctx, FRAG_CTX_COUNT, FRAG_TIMEOUT_MS);
+    for (int l = 0; l < LAT_MAX_LAYER; l++) lat_hist_init(&g_lat_mesh[l]);
+    node_registry_init(&g_nodes, s_node_slots, NODE_TABLE_CAP, ROOT_MAX_NODES, MQTT_BASE_TOPIC);
+    node_registry_init(&g_relays, s_relay_slots, RELAY_TABLE_CAP, ROOT_MAX_RELAYS, MQTT_BASE_TOPIC);
+    cong_monitor_init(&g_cong);
+    journal_init();
+    xTaskCreatePinnedToCore(mqtt_pub_task, "mqtt_pub", 6144, NULL, ROOT_PRIO_PUB, &g_pub_task, ROOT_CORE_PUB);
+    xTaskCreatePinnedToCore(mesh_decode_task, "mesh_decode", 4096, NULL, ROOT_PRIO_DECODE, &g_decode_task,
+                            ROOT_CORE_DECODE);
+    xTaskCreatePinnedToCore(mesh_recv_task, "mesh_recv", 4096, NULL, ROOT_PRIO_RECV, &g_recv_task, ROOT_CORE_RECV);
 }
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <string.h>
+#include "node_registry.h"
+
+// Trộn cả 48 bit MAC (các node cùng hãng có 3 byte OUI giống nhau)
+static inline uint32_t mac_hash(const uint8_t mac[6]) {
+    uint64_t k = ((uint64_t)mac[0] << 40) | ((uint64_t)mac[1] << 32) | ((uint64_t)mac[2] << 24) |
+                 ((uint64_t)mac[3] << 16) | ((uint64_t)mac[4] << 8)  |  (uint64_t)mac[5];
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    return (uint32_t)k;
+}
+
+// Đảo bit chỉ số trong log2(NODE_TX_SLOTS) bit
+static uint8_t tx_slot_of(uint32_t index) {
+    uint32_t slot = 0;
+    for (uint32_t bit = 1; bit < NODE_TX_SLOTS; bit <<= 1) {
+        slot = (slot << 1) | (index & 1);
+        index >>= 1;
+    }
+    return (uint8_t)slot;
+}
+
+bool node_registry_init(node_registry_t *r, node_entry_t *slots, uint32_t cap,
+                        uint32_t max_nodes, const char *base_topic) {
+    if (!slots || cap < 2 || (cap & (cap - 1)) != 0) return false;
+    if (max_nodes == 0 || cap < NODE_REGISTRY_CAP_MIN(max_nodes)) return false;
+
+    memset(slots, 0, cap * sizeof(*slots));
+    for (uint32_t i = 0; i < cap; i++) atomic_init(&slots[i].used, false);
+
+    r->slots      = slots;
+    r->mask       = cap - 1;
+    r->max_nodes  = max_nodes;
+    r->count      = 0;
+    r->full_drops = 0;
+    strncpy(r->base_topic, base_topic, sizeof(r->base_topic) - 1);
+    r->base_topic[sizeof(r->base_topic) - 1] = '\0';
+    return true;
+}
+
+node_entry_t *node_registry_find(node_registry_t *r, const uint8_t mac[6]) {
+    uint32_t i = mac_hash(mac) & r->mask;
+    for (uint32_t n = 0; n <= r->mask; n++, i = (i + 1) & r->mask) {
+        node_entry_t *e = &r->slots[i];
+        if (!atomic_load_explicit(&e->used, memory_order_acquire)) return NULL;
+        if (memcmp(e->mac, mac, 6) == 0) return e;
+    }
+    return NULL;
+}
+
+node_entry_t *node_registry_get(node_registry_t *r, const uint8_t mac[6], uint32_t now_ms) {
+    uint32_t i = mac_hash(mac) & r->mask;
+    for (uint32_t n = 0; n <= r->mask; n++, i = (i + 1) & r->mask) {
+        node_entry_t *e = &r->slots[i];
+        if (atomic_load_explicit(&e->used, memory_order_relaxed)) {
+            if (memcmp(e->mac, mac, 6) == 0) return e;
+            continue;
+        }
+
+        // Slot trống: thêm mới
+        if (r->count >= r->max_nodes) {
+            r->full_drops++;
+            return NULL;
+        }
+        memcpy(e->mac, mac, 6);
+        snprintf(e->topic, sizeof(e->topic), "%s/%02x:%02x:%02x:%02x:%02x:%02x",
+                 r->base_topic, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        e->first_seen_ms = now_ms;
+        e->last_seen_ms  = now_ms;
+        e->tx_slot       = tx_slot_of(r->count);
+        atomic_store_explicit(&e->used, true, memory_order_release);
+        r->count++;
+        return e;
+    }
+    r->full_drops++;
+    return NULL;
+}
+
+void node_registry_on_frame(node_entry_t *e, uint32_t now_ms, size_t bytes) {
+    if (e->frames > 0) {
+        float dt = (float)(now_ms - e->last_seen_ms);
+        e->interval_ms = (e->interval_ms == 0.0f) ? dt
+                       : e->interval_ms + NODE_RATE_ALPHA * (dt - e->interval_ms);
+    }
+    e->last_seen_ms = now_ms;
+    e->frames++;
+    e->bytes += (uint32_t)bytes;
+}
+
+uint32_t node_registry_on_owd(node_entry_t *e, int32_t owd_us, uint32_t now_ms) {
+    if (!e->has_owd) {
+        e->has_owd      = true;
+        e->owd_prev_us  = owd_us;
+        e->owd_cur_us   = owd_us;
+        e->owd_epoch_ms = now_ms;
+    } else if (now_ms - e->owd_epoch_ms >= NODE_OWD_EPOCH_MS) {
+        // đồng hồ leaf trôi: quên min cũ dần theo epoch
+        e->owd_prev_us  = e->owd_cur_us;
+        e->owd_cur_us   = owd_us;
+        e->owd_epoch_ms = now_ms;
+    } else if (owd_us < e->owd_cur_us) {
+        e->owd_cur_us = owd_us;
+    }
+
+    int32_t base = e->owd_prev_us < e->owd_cur_us ? e->owd_prev_us : e->owd_cur_us;
+    return owd_us > base ? (uint32_t)(owd_us - base) : 0;
+}
+
+void node_registry_on_tsync(node_entry_t *e, uint32_t rtt_us, int32_t err_us, int32_t leaf_err_us) {
+    uint32_t owd = rtt_us / 2;
+    if (!e->has_tsync || owd < e->tsync_owd_us) {
+        e->tsync_owd_us = owd;
+    } else {
+        // RTT lớn do hàng đợi thì chỉ nhích lên, đường đi đổi hẳn thì vẫn bám theo được
+        e->tsync_owd_us += (owd - e->tsync_owd_us) / NODE_TSYNC_CREEP;
+    }
+    e->tsync_err_us      = err_us;
+    e->tsync_leaf_err_us = leaf_err_us;
+    e->has_tsync    = true;
+    e->tsync_echoes++;
+}
+
+float node_registry_rate(const node_entry_t *e) {
+    return (e->interval_ms > 0.0f) ? 1000.0f / e->interval_ms : 0.0f;
+}
+
+void node_registry_foreach(node_registry_t *r, node_registry_cb_t cb, void *ctx) {
+    for (uint32_t i = 0; i <= r->mask; i++) {
+        if (atomic_load_explicit(&r->slots[i].used, memory_order_acquire)) cb(&r->slots[i], ctx);
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef NODE_REGISTRY_H_
+#define NODE_REGISTRY_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "seq_track.h"
+
+// ==== Bảng node theo MAC (open addressing, dò tuyến tính) ====
+// Cấp phát sẵn, không xóa entry. Một task ghi (insert + thống kê),
+// các task khác chỉ đọc: entry chỉ "hiện ra" khi used = true (release),
+// topic/mac không đổi sau khi insert nên đọc không cần khóa.
+#define NODE_TOPIC_LEN      40      // base_topic + "/xx:xx:xx:xx:xx:xx"
+#define NODE_RATE_ALPHA     0.2f    // hệ số EWMA cho khoảng cách giữa 2 frame
+#define NODE_OWD_EPOCH_MS   300000  // trễ nền = min (rx - tx) của 2 epoch gần nhất
+#define NODE_TSYNC_CREEP    8       // owd beacon bám min, tăng dần 1/8 khi RTT lớn hơn
+// Slot gửi trong 1 chu kỳ báo cáo: cấp theo thứ tự insert, đảo bit chỉ số để k node đầu
+// luôn trải đều chu kỳ (0, 1/2, 1/4, 3/4, ...). Lũy thừa của 2, <= 256.
+#define NODE_TX_SLOTS       64
+
+typedef struct {
+    uint8_t     mac[6];
+    atomic_bool used;
+    char        topic[NODE_TOPIC_LEN];  // tính sẵn lúc insert
+    seq_track_t seq;                    // seq telemetry: mất/trùng/đảo thứ tự
+    bool        has_owd;
+    int32_t     owd_prev_us;            // min (rx - tx) epoch trước
+    int32_t     owd_cur_us;             // min (rx - tx) epoch hiện tại
+    uint32_t    owd_epoch_ms;
+    uint32_t    first_seen_ms;
+    uint32_t    last_seen_ms;
+    uint32_t    frames;
+    uint32_t    bytes;
+    float       interval_ms;            // EWMA, 0 = chưa đủ mẫu
+    // đồng bộ thời gian (tsync.h): task ghi cập nhật khi nhận echo, task publish đọc để gửi beacon
+    bool        has_tsync;
+    uint32_t    tsync_owd_us;           // ước lượng trễ root -> leaf = RTT/2 đã lọc
+    int32_t     tsync_err_us;           // mesh time của leaf - mesh time root, echo gần nhất
+    int32_t     tsync_leaf_err_us;      // leaf tự đo: lệch trước khi sửa theo beacon đó
+    uint32_t    tsync_echoes;
+    uint8_t     tx_slot;                // cố định từ lúc insert, < NODE_TX_SLOTS
+} node_entry_t;
+
+typedef struct {
+    node_entry_t *slots;
+    uint32_t      mask;         // cap - 1
+    uint32_t      max_nodes;    // giới hạn tải để chuỗi dò ngắn
+    uint32_t      count;
+    uint32_t      full_drops;   // số lần insert thất bại vì đầy
+    char          base_topic[16];
+} node_registry_t;
+
+// cap là lũy thừa của 2 >= 2 * max_nodes (hệ số tải <= 0.5)
+#define NODE_REGISTRY_CAP_MIN(max_nodes)    (2u * (max_nodes))
+
+bool node_registry_init(node_registry_t *r, node_entry_t *slots, uint32_t cap,
+                        uint32_t max_nodes, const char *base_topic);
+
+// Chỉ tìm, NULL nếu chưa có (an toàn từ task đọc)
+node_entry_t *node_registry_find(node_registry_t *r, const uint8_t mac[6]);
+
+// Tìm hoặc thêm mới (chỉ task ghi), NULL nếu bảng đầy
+node_entry_t *node_registry_get(node_registry_t *r, const uint8_t mac[6], uint32_t now_ms);
+
+// Cập nhật thống kê khi nhận 1 frame (chỉ task ghi)
+void node_registry_on_frame(node_entry_t *e, uint32_t now_ms, size_t bytes);
+
+// Độ trễ leaf gửi -> root nhận (us). Đồng hồ 2 bên chưa đồng bộ nên owd_us = rx - tx
+// lệch 1 hằng số; trả về phần vượt trên trễ nền (min trong 1-2 epoch). Chỉ task ghi.
+uint32_t node_registry_on_owd(node_entry_t *e, int32_t owd_us, uint32_t now_ms);
+
+// Echo của beacon thời gian: RTT (đã trừ thời gian leaf giữ) + sai số đồng bộ. Chỉ task ghi.
+void node_registry_on_tsync(node_entry_t *e, uint32_t rtt_us, int32_t err_us, int32_t leaf_err_us);
+
+// Tốc độ nhận ước lượng (frame/s), 0 nếu chưa đủ mẫu
+float node_registry_rate(const node_entry_t *e);
+
+typedef void (*node_registry_cb_t)(const node_entry_t *e, void *ctx);
+void node_registry_foreach(node_registry_t *r, node_registry_cb_t cb, void *ctx);
+
+#endif /* NODE_REGISTRY_H_ */
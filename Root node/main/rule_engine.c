@@ -0,0 +1,98 @@
+#include <string.h>
+#include "rule_engine.h"
+
+static const char *const s_src_names[RULE_SRC_COUNT] = { "motion", "temp", "humi", "light" };
+
+const char *rule_src_name(uint8_t src) {
+    return src < RULE_SRC_COUNT ? s_src_names[src] : "?";
+}
+
+int rule_src_from_name(const char *name) {
+    for (int i = 0; i < RULE_SRC_COUNT; i++) {
+        if (strcmp(name, s_src_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static bool rule_valid(const rule_t *r) {
+    if (r->src >= RULE_SRC_COUNT || r->op > RULE_OP_LT || r->count == 0 || r->count > RULE_COUNT_MAX) return false;
+    if (r->hour_from < 0 || r->hour_from > 23 || r->hour_to < 0 || r->hour_to > 23) return false;
+    if (r->actions == 0 || r->cmd_arg_len > RULE_CMD_ARG_MAX) return false;
+    return true;
+}
+
+bool rule_set_compile(rule_set_t *s) {
+    memset(s->n_src, 0, sizeof(s->n_src));
+    if (s->count > RULE_MAX) s->count = 0;
+    for (uint8_t i = 0; i < s->count; i++) {
+        const rule_t *r = &s->rules[i];
+        if (!rule_valid(r)) {
+            s->count = 0;
+            memset(s->n_src, 0, sizeof(s->n_src));
+            return false;
+        }
+        s->by_src[r->src][s->n_src[r->src]++] = i;
+    }
+    return true;
+}
+
+void rule_engine_init(rule_engine_t *e) {
+    memset(e, 0, sizeof(*e));
+}
+
+void rule_engine_load(rule_engine_t *e, const rule_set_t *s) {
+    e->set = *s;
+    memset(e->run, 0, sizeof(e->run));
+    memset(e->fired_s, 0, sizeof(e->fired_s));
+}
+
+// khung giờ qua nửa đêm (vd 18 -> 6) tính vòng
+static bool rule_in_hours(const rule_t *r, int hour) {
+    if (r->hour_from == r->hour_to) return true;
+    if (hour < 0) return false;
+    if (r->hour_from < r->hour_to) return hour >= r->hour_from && hour < r->hour_to;
+    return hour >= r->hour_from || hour < r->hour_to;
+}
+
+uint32_t rule_engine_eval(rule_engine_t *e, const uint8_t mac[6], uint32_t slot,
+                          const rule_sample_t *s, int hour, uint32_t now_ms,
+                          rule_fire_cb_t cb, void *ctx) {
+    if (slot >= RULE_NODE_SLOTS) return 0;
+
+    uint32_t fired = 0;
+    uint16_t now_s = (uint16_t)(now_ms / 1000);
+    for (int src = 0; src < RULE_SRC_COUNT; src++) {
+        if (!(s->valid & (1u << src))) continue;
+        int32_t v = s->v[src];
+
+        for (uint8_t k = 0; k < e->set.n_src[src]; k++) {
+            uint8_t idx = e->set.by_src[src][k];
+            const rule_t *r = &e->set.rules[idx];
+            if (!r->any_node && memcmp(r->mac, mac, 6) != 0) continue;
+            e->evals++;
+
+            bool cond = src == RULE_SRC_MOTION ? v != 0
+                      : r->op == RULE_OP_GT    ? v > r->threshold
+                                               : v < r->threshold;
+            uint8_t *run = &e->run[idx][slot];
+            if (!cond || !rule_in_hours(r, hour)) {
+                *run = 0;
+                continue;
+            }
+            if (*run < UINT8_MAX) (*run)++;
+            if (*run != r->count) continue;
+
+            // fired_s = 0: chưa bắn lần nào
+            uint16_t *last = &e->fired_s[idx][slot];
+            if (*last && r->holdoff_s && (uint16_t)(now_s - *last) < r->holdoff_s) {
+                e->held++;
+                continue;
+            }
+            *last = now_s ? now_s : 1;
+            e->fired++;
+            fired++;
+            if (cb) cb(r, idx, mac, v, ctx);
+        }
+    }
+    return fired;
+}
@@ -0,0 +1,97 @@
+#ifndef RULE_ENGINE_H_
+#define RULE_ENGINE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==== Luật cảnh báo tại root, chạy ở stage decode (không phụ thuộc ESP-IDF) ====
+// Mỗi luật: nguồn (motion/temp/humi/light) của 1 node hoặc mọi node, so ngưỡng, đủ `count`
+// mẫu liên tiếp, trong khung giờ [hour_from, hour_to) -> hành động tại chỗ (alert QoS 1 /
+// lệnh mesh). Bắn 1 lần khi điều kiện vừa đủ, mẫu sai điều kiện mới tính lại; holdoff_s
+// chặn bắn lại quá dày. Motion: mẫu = sự kiện PIR, điều kiện = mức sau cạnh là 1.
+// rule_set_compile xếp chỉ số luật theo nguồn để 1 mẫu chỉ duyệt luật liên quan.
+#define RULE_MAX            16
+#define RULE_NAME_LEN       16
+#define RULE_CMD_ARG_MAX    8
+#define RULE_NODE_SLOTS     128     // >= NODE_TABLE_CAP, trạng thái theo chỉ số entry registry
+#define RULE_COUNT_MAX      254     // run bão hòa ở 255, count = 255 sẽ khớp lại mọi mẫu sau
+
+typedef enum {
+    RULE_SRC_MOTION = 0,
+    RULE_SRC_TEMP,
+    RULE_SRC_HUMI,
+    RULE_SRC_LIGHT,         // light_raw
+    RULE_SRC_COUNT
+} rule_src_t;
+
+typedef enum {
+    RULE_OP_GT = 0,
+    RULE_OP_LT,
+} rule_op_t;
+
+#define RULE_ACT_ALERT      0x01
+#define RULE_ACT_CMD        0x02
+
+typedef struct {
+    char     name[RULE_NAME_LEN];
+    bool     any_node;
+    uint8_t  mac[6];
+    uint8_t  src;               // rule_src_t
+    uint8_t  op;                // rule_op_t, motion bỏ qua
+    int32_t  threshold;
+    uint8_t  count;             // 1..RULE_COUNT_MAX
+    int8_t   hour_from;         // from == to = cả ngày
+    int8_t   hour_to;
+    uint16_t holdoff_s;
+    uint8_t  actions;           // RULE_ACT_*
+    // RULE_ACT_CMD: cmd.h op + arg, gửi tới cmd_mac hoặc chính node vừa khớp
+    bool     cmd_self;
+    uint8_t  cmd_mac[6];
+    uint8_t  cmd_op;
+    uint8_t  cmd_arg_len;
+    uint8_t  cmd_arg[RULE_CMD_ARG_MAX];
+} rule_t;
+
+// Bảng phẳng đã biên dịch, copy nguyên khối được (đưa qua queue)
+typedef struct {
+    rule_t  rules[RULE_MAX];
+    uint8_t count;
+    uint8_t by_src[RULE_SRC_COUNT][RULE_MAX];
+    uint8_t n_src[RULE_SRC_COUNT];
+} rule_set_t;
+
+// 1 mẫu của 1 node: bit (1 << rule_src_t) trong valid = có giá trị
+typedef struct {
+    uint8_t valid;
+    int32_t v[RULE_SRC_COUNT];
+} rule_sample_t;
+
+typedef struct {
+    rule_set_t set;
+    uint8_t    run[RULE_MAX][RULE_NODE_SLOTS];      // số mẫu liên tiếp thỏa, bão hòa 255
+    uint16_t   fired_s[RULE_MAX][RULE_NODE_SLOTS];  // giây (16 bit thấp) lần bắn trước
+    uint32_t   evals;           // số cặp (mẫu, luật) đã xét
+    uint32_t   fired;
+    uint32_t   held;            // đủ điều kiện nhưng còn trong holdoff
+} rule_engine_t;
+
+typedef void (*rule_fire_cb_t)(const rule_t *r, uint8_t idx, const uint8_t mac[6], int32_t value, void *ctx);
+
+// Kiểm tra + lập chỉ số, false nếu có luật sai (bảng giữ nguyên count = 0)
+bool rule_set_compile(rule_set_t *s);
+
+void rule_engine_init(rule_engine_t *e);
+// Thay bảng luật, xóa trạng thái
+void rule_engine_load(rule_engine_t *e, const rule_set_t *s);
+
+// hour: giờ địa phương 0..23, < 0 = chưa biết (luật có khung giờ không khớp).
+// slot: chỉ số node cố định (< RULE_NODE_SLOTS). Trả về số luật đã bắn.
+uint32_t rule_engine_eval(rule_engine_t *e, const uint8_t mac[6], uint32_t slot,
+                          const rule_sample_t *s, int hour, uint32_t now_ms,
+                          rule_fire_cb_t cb, void *ctx);
+
+const char *rule_src_name(uint8_t src);
+// -1 nếu không biết tên
+int         rule_src_from_name(const char *name);
+
+#endif /* RULE_ENGINE_H_ */
@@ -0,0 +1,70 @@
+#include "rx_ring.h"
+
+bool rx_ring_init(rx_ring_t *r, rx_slot_t *slots, uint32_t cap) {
+    if (!slots || cap < 2 || (cap & (cap - 1)) != 0) return false;
+    r->slots = slots;
+    r->mask  = cap - 1;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->hwm, 0);
+    atomic_init(&r->overflow, 0);
+    return true;
+}
+
+rx_slot_t *rx_ring_acquire(rx_ring_t *r) {
+    unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (head - tail > r->mask) return NULL;
+    return &r->slots[head & r->mask];
+}
+
+void rx_ring_commit(rx_ring_t *r) {
+    unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed) + 1;
+    atomic_store_explicit(&r->head, head, memory_order_release);
+
+    // hwm chỉ producer ghi nên không cần CAS
+    unsigned depth = head - atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (depth > atomic_load_explicit(&r->hwm, memory_order_relaxed)) {
+        atomic_store_explicit(&r->hwm, depth, memory_order_relaxed);
+    }
+}
+
+void rx_ring_count_overflow(rx_ring_t *r) {
+    atomic_fetch_add_explicit(&r->overflow, 1, memory_order_relaxed);
+}
+
+rx_slot_t *rx_ring_peek(rx_ring_t *r) {
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&r->head, memory_order_acquire);
+    if (head == tail) return NULL;
+    return &r->slots[tail & r->mask];
+}
+
+void rx_ring_release(rx_ring_t *r) {
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+}
+
+uint32_t rx_ring_drain(rx_ring_t *r, rx_ring_handler_t handler, void *ctx, uint32_t max) {
+    uint32_t done = 0;
+    rx_slot_t *slot;
+    while ((max == 0 || done < max) && (slot = rx_ring_peek(r)) != NULL) {
+        handler(slot, ctx);
+        rx_ring_release(r);
+        done++;
+    }
+    return done;
+}
+
+uint32_t rx_ring_depth(rx_ring_t *r) {
+    unsigned head = atomic_load_explicit(&r->head, memory_order_acquire);
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    return head - tail;
+}
+
+void rx_ring_get_stats(rx_ring_t *r, rx_ring_stats_t *out) {
+    out->depth    = rx_ring_depth(r);
+    out->hwm      = atomic_load_explicit(&r->hwm, memory_order_relaxed);
+    out->overflow = atomic_load_explicit(&r->overflow, memory_order_relaxed);
+    out->capacity = r->mask + 1;
+}
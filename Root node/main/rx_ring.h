@@ -0,0 +1,66 @@
+#ifndef RX_RING_H_
+#define RX_RING_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ==== Ring SPSC (1 producer / 1 consumer), không khóa ====
+// Producer: mesh_recv_task nhận thẳng vào slot rồi commit.
+// Consumer: task publish MQTT drain ra. Không cấp phát động.
+#define RX_RING_SLOT_SIZE   512
+
+typedef struct {
+    uint8_t  from[6];
+    uint16_t len;
+    void    *tag;                       // producer gắn tùy ý (vd entry node_registry)
+    uint32_t rx_us;                     // thời điểm esp_mesh_recv trả về
+    uint32_t enq_us;                    // thời điểm commit vào ring (đo thời gian chờ trong ring)
+    uint32_t mesh_us;                   // trễ leaf -> root (nếu có layer)
+    uint8_t  layer;                     // layer leaf lúc gửi, 0 = frame không có timestamp
+    int64_t  ts_ms;                     // thời điểm leaf gửi theo UTC (mesh time), 0 = không biết
+    uint8_t *ext;                       // != NULL: payload nằm ngoài slot (message ghép mảnh), giao không copy
+    uint8_t  data[RX_RING_SLOT_SIZE];
+} rx_slot_t;
+
+typedef struct {
+    rx_slot_t    *slots;
+    uint32_t      mask;        // cap - 1, cap là lũy thừa của 2
+    atomic_uint   head;        // chỉ producer ghi
+    atomic_uint   tail;        // chỉ consumer ghi
+    atomic_uint   hwm;         // độ sâu lớn nhất từng thấy
+    atomic_uint   overflow;    // số frame bị bỏ vì ring đầy (producer ghi)
+} rx_ring_t;
+
+typedef struct {
+    uint32_t depth;
+    uint32_t hwm;
+    uint32_t overflow;
+    uint32_t capacity;
+} rx_ring_stats_t;
+
+// cap phải là lũy thừa của 2 (slots có cap phần tử)
+bool rx_ring_init(rx_ring_t *r, rx_slot_t *slots, uint32_t cap);
+
+// Producer: lấy slot trống để ghi, NULL nếu đầy
+rx_slot_t *rx_ring_acquire(rx_ring_t *r);
+// Producer: đẩy slot vừa ghi vào hàng đợi
+void rx_ring_commit(rx_ring_t *r);
+// Producer: ghi nhận 1 frame bị bỏ vì không có slot
+void rx_ring_count_overflow(rx_ring_t *r);
+
+// Consumer: slot cũ nhất, NULL nếu rỗng
+rx_slot_t *rx_ring_peek(rx_ring_t *r);
+// Consumer: trả slot lại cho producer
+void rx_ring_release(rx_ring_t *r);
+
+typedef void (*rx_ring_handler_t)(const rx_slot_t *slot, void *ctx);
+
+// Consumer: xử lý tối đa max slot (0 = tới khi rỗng), trả về số slot đã xử lý
+uint32_t rx_ring_drain(rx_ring_t *r, rx_ring_handler_t handler, void *ctx, uint32_t max);
+
+uint32_t rx_ring_depth(rx_ring_t *r);
+void rx_ring_get_stats(rx_ring_t *r, rx_ring_stats_t *out);
+
+#endif /* RX_RING_H_ */
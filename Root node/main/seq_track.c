@@ -0,0 +1,69 @@
+#include <string.h>
+#include "seq_track.h"
+
+void seq_track_reset(seq_track_t *t) {
+    memset(t, 0, sizeof(*t));
+}
+
+static void _start(seq_track_t *t, uint16_t seq) {
+    t->last   = seq;
+    t->has    = true;
+    t->window = 1;
+}
+
+seq_result_t seq_track_update(seq_track_t *t, uint16_t seq) {
+    if (!t->has) {
+        _start(t, seq);
+        t->received++;
+        return SEQ_NEW;
+    }
+
+    int16_t d = (int16_t)(seq - t->last);
+    if (d > 0 && d < SEQ_TRACK_RESTART_GAP) {
+        t->window = (d >= SEQ_TRACK_WINDOW) ? 0 : t->window << d;
+        t->window |= 1;
+        t->last = seq;
+        t->lost += (uint32_t)(d - 1);
+        t->received++;
+        return SEQ_NEW;
+    }
+
+    uint32_t back = (uint32_t)(-(int32_t)d);
+    if (d <= 0 && back < SEQ_TRACK_WINDOW) {
+        uint64_t bit = 1ULL << back;
+        if (t->window & bit) {
+            t->dup++;
+            return SEQ_DUP;
+        }
+        t->window |= bit;
+        t->reorder++;
+        if (t->lost) t->lost--;
+        t->received++;
+        return SEQ_LATE;
+    }
+
+    // lùi quá xa hoặc nhảy quá xa: leaf reboot, seq đếm lại
+    _start(t, seq);
+    t->restarts++;
+    t->received++;
+    return SEQ_RESTART;
+}
+
+seq_result_t seq_track_update_range(seq_track_t *t, uint16_t first, uint16_t last, uint16_t count) {
+    uint16_t span = (uint16_t)(last - first);
+    if (count == 0 || span >= SEQ_TRACK_RESTART_GAP) return seq_track_update(t, last);
+
+    bool fresh = !t->has;
+    uint32_t lost0 = t->lost;
+    seq_result_t r = seq_track_update(t, last);
+    if (r == SEQ_DUP || r == SEQ_LATE) return r;
+
+    // update(last) chỉ tính 1 frame; phần còn lại của dải
+    uint32_t extra = (count > span + 1u ? span + 1u : count) - 1u;
+    uint32_t added = t->lost - lost0;
+    t->received += extra;
+    t->lost     -= (extra < added) ? extra : added;
+    if (r == SEQ_RESTART || fresh) t->lost += span - extra;
+    t->window |= (span + 1u >= SEQ_TRACK_WINDOW) ? ~0ULL : ((1ULL << (span + 1u)) - 1);
+    return r;
+}
@@ -0,0 +1,40 @@
+#ifndef SEQ_TRACK_H_
+#define SEQ_TRACK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==== Theo dõi seq 16-bit của 1 node: mất / trùng / đảo thứ tự ====
+// Cửa sổ 64 seq sau seq lớn nhất (bitmap như anti-replay): seq cũ trong cửa sổ
+// chưa thấy -> đến trễ (đảo thứ tự, trừ lại 1 mất), đã thấy -> trùng.
+// Nhảy lùi quá cửa sổ hoặc tiến quá SEQ_TRACK_RESTART_GAP -> coi như node khởi động lại.
+// Chỉ 1 task ghi; counter là word 32-bit nên task khác đọc không bị rách.
+#define SEQ_TRACK_WINDOW        64
+#define SEQ_TRACK_RESTART_GAP   1024
+
+typedef enum {
+    SEQ_NEW = 0,        // theo thứ tự (có thể kèm khoảng trống)
+    SEQ_LATE,           // đến trễ nhưng chưa thấy -> vẫn publish
+    SEQ_DUP,            // đã thấy -> bỏ
+    SEQ_RESTART,        // bắt đầu lại từ seq này
+} seq_result_t;
+
+typedef struct {
+    uint16_t last;          // seq lớn nhất đã nhận
+    bool     has;
+    uint64_t window;        // bit i = đã nhận (last - i)
+    uint32_t received;
+    uint32_t lost;          // khoảng trống chưa được lấp
+    uint32_t dup;
+    uint32_t reorder;
+    uint32_t restarts;
+} seq_track_t;
+
+void         seq_track_reset(seq_track_t *t);
+seq_result_t seq_track_update(seq_track_t *t, uint16_t seq);
+
+// Cả dải [first, last] đến cùng lúc dưới dạng 1 summary của relay, gộp `count` frame:
+// dải coi như đã thấy, chỉ (số seq trong dải - count) tính là mất.
+seq_result_t seq_track_update_range(seq_track_t *t, uint16_t first, uint16_t last, uint16_t count);
+
+#endif /* SEQ_TRACK_H_ */
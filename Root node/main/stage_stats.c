@@ -0,0 +1,28 @@
+#include "stage_stats.h"
+
+void stage_stats_init(stage_stats_t *s) {
+    atomic_init(&s->items, 0);
+    atomic_init(&s->busy_us, 0);
+    atomic_init(&s->wait_sum_us, 0);
+    atomic_init(&s->wait_max_us, 0);
+}
+
+void stage_stats_add(stage_stats_t *s, uint32_t busy_us, uint32_t wait_us) {
+    atomic_fetch_add_explicit(&s->items, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->busy_us, busy_us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->wait_sum_us, wait_us, memory_order_relaxed);
+
+    unsigned cur = atomic_load_explicit(&s->wait_max_us, memory_order_relaxed);
+    while (wait_us > cur &&
+           !atomic_compare_exchange_weak_explicit(&s->wait_max_us, &cur, wait_us,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+uint32_t stage_stats_take(stage_stats_t *s, stage_snap_t *out) {
+    out->items       = atomic_exchange_explicit(&s->items, 0, memory_order_relaxed);
+    out->busy_us     = atomic_exchange_explicit(&s->busy_us, 0, memory_order_relaxed);
+    out->wait_sum_us = atomic_exchange_explicit(&s->wait_sum_us, 0, memory_order_relaxed);
+    out->wait_max_us = atomic_exchange_explicit(&s->wait_max_us, 0, memory_order_relaxed);
+    return out->items;
+}
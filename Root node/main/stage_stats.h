@@ -0,0 +1,30 @@
+#ifndef STAGE_STATS_H_
+#define STAGE_STATS_H_
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+// ==== Thống kê 1 stage của pipeline root ====
+// Stage ghi sau mỗi item: thời gian bận (không tính lúc block chờ) và thời gian
+// item nằm trong hàng đợi trước stage. Task báo cáo lấy + xóa theo chu kỳ.
+typedef struct {
+    atomic_uint items;
+    atomic_uint busy_us;
+    atomic_uint wait_sum_us;
+    atomic_uint wait_max_us;
+} stage_stats_t;
+
+typedef struct {
+    uint32_t items;
+    uint32_t busy_us;
+    uint32_t wait_sum_us;
+    uint32_t wait_max_us;
+} stage_snap_t;
+
+void     stage_stats_init(stage_stats_t *s);
+void     stage_stats_add(stage_stats_t *s, uint32_t busy_us, uint32_t wait_us);
+
+// Lấy và xóa, trả về số item
+uint32_t stage_stats_take(stage_stats_t *s, stage_snap_t *out);
+
+#endif /* STAGE_STATS_H_ */
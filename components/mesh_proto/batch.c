@@ -0,0 +1,54 @@
+#include <string.h>
+#include "batch.h"
+
+void batch_begin(batch_builder_t *b, uint8_t *buf, size_t cap) {
+    b->buf   = buf;
+    b->cap   = cap;
+    b->len   = BATCH_HDR_LEN;
+    b->count = 0;
+}
+
+bool batch_add(batch_builder_t *b, const uint8_t mac[6], const uint8_t *data, size_t len) {
+    if (len == 0 || len > BATCH_ENTRY_MAX || b->count == UINT8_MAX) return false;
+    if (b->len + BATCH_ENTRY_HDR + len > b->cap) return false;
+
+    uint8_t *p = &b->buf[b->len];
+    memcpy(p, mac, 6);
+    p[6] = (uint8_t)len;
+    memcpy(&p[BATCH_ENTRY_HDR], data, len);
+    b->len += BATCH_ENTRY_HDR + len;
+    b->count++;
+    return true;
+}
+
+size_t batch_finish(batch_builder_t *b) {
+    if (b->count == 0 || b->cap < BATCH_HDR_LEN) return 0;
+
+    mesh_proto_put_hdr(b->buf, MESH_MSG_BATCH, 0);
+    b->buf[4] = b->count;
+    return b->len;
+}
+
+bool batch_iter_init(batch_iter_t *it, const uint8_t *buf, size_t len) {
+    if (len < BATCH_HDR_LEN || !mesh_proto_is_frame(buf, len)) return false;
+    if (mesh_proto_type(buf) != MESH_MSG_BATCH) return false;
+
+    it->p    = &buf[BATCH_HDR_LEN];
+    it->end  = buf + len;
+    it->left = buf[4];
+    return true;
+}
+
+bool batch_next(batch_iter_t *it, const uint8_t **mac, const uint8_t **data, size_t *len) {
+    if (it->left == 0 || it->end - it->p < BATCH_ENTRY_HDR) return false;
+
+    size_t n = it->p[6];
+    if ((size_t)(it->end - it->p) < BATCH_ENTRY_HDR + n) return false;
+
+    *mac  = it->p;
+    *data = &it->p[BATCH_ENTRY_HDR];
+    *len  = n;
+    it->p += BATCH_ENTRY_HDR + n;
+    it->left--;
+    return true;
+}
@@ -0,0 +1,82 @@
+#include <string.h>
+#include "cmd.h"
+
+static const char *const s_op_names[] = {
+    [CMD_OP_PING]          = "ping",
+    [CMD_OP_SET_SAMPLE]    = "set_sample",
+    [CMD_OP_SET_HEARTBEAT] = "set_heartbeat",
+    [CMD_OP_READ_NOW]      = "read_now",
+    [CMD_OP_RELAY_WINDOW]  = "relay_window",
+    [CMD_OP_RELAY_RAW]     = "relay_raw",
+};
+
+static const char *const s_status_names[] = {
+    [CMD_OK]       = "ok",
+    [CMD_ERR_OP]   = "bad_op",
+    [CMD_ERR_ARG]  = "bad_arg",
+    [CMD_ERR_FAIL] = "fail",
+};
+
+#define ARRAY_LEN(a) (sizeof(a) / sizeof((a)[0]))
+
+size_t cmd_encode(const cmd_t *c, uint8_t *buf, size_t cap) {
+    if (c->arg_len > CMD_ARG_MAX || cap < (size_t)CMD_HDR_LEN + c->arg_len) return 0;
+
+    mesh_proto_put_hdr(buf, MESH_MSG_CMD, 0);
+    mp_put_u16(&buf[4], c->cmd_id);
+    buf[6] = c->op;
+    buf[7] = c->arg_len;
+    memcpy(&buf[8], c->arg, c->arg_len);
+    return CMD_HDR_LEN + c->arg_len;
+}
+
+bool cmd_decode(const uint8_t *buf, size_t len, cmd_t *out) {
+    if (len < CMD_HDR_LEN || !mesh_proto_is_frame(buf, len)) return false;
+    if (mesh_proto_type(buf) != MESH_MSG_CMD) return false;
+    if (buf[7] > CMD_ARG_MAX || len < (size_t)CMD_HDR_LEN + buf[7]) return false;
+
+    out->cmd_id  = mp_get_u16(&buf[4]);
+    out->op      = buf[6];
+    out->arg_len = buf[7];
+    memcpy(out->arg, &buf[8], out->arg_len);
+    return true;
+}
+
+size_t cmd_ack_encode(const cmd_ack_t *a, uint8_t *buf, size_t cap) {
+    if (cap < CMD_ACK_LEN) return 0;
+
+    mesh_proto_put_hdr(buf, MESH_MSG_CMD_ACK, 0);
+    mp_put_u16(&buf[4], a->node_id);
+    mp_put_u16(&buf[6], a->cmd_id);
+    buf[8] = a->status;
+    buf[9] = a->op;
+    mp_put_u32(&buf[10], a->leaf_us);
+    return CMD_ACK_LEN;
+}
+
+bool cmd_ack_decode(const uint8_t *buf, size_t len, cmd_ack_t *out) {
+    if (len < CMD_ACK_LEN || !mesh_proto_is_frame(buf, len)) return false;
+    if (mesh_proto_type(buf) != MESH_MSG_CMD_ACK) return false;
+
+    out->node_id = mp_get_u16(&buf[4]);
+    out->cmd_id  = mp_get_u16(&buf[6]);
+    out->status  = buf[8];
+    out->op      = buf[9];
+    out->leaf_us = mp_get_u32(&buf[10]);
+    return true;
+}
+
+const char *cmd_op_name(uint8_t op) {
+    return op < ARRAY_LEN(s_op_names) ? s_op_names[op] : NULL;
+}
+
+int cmd_op_from_name(const char *name) {
+    for (size_t i = 0; i < ARRAY_LEN(s_op_names); i++) {
+        if (s_op_names[i] && strcmp(s_op_names[i], name) == 0) return (int)i;
+    }
+    return -1;
+}
+
+const char *cmd_status_name(uint8_t status) {
+    return status < ARRAY_LEN(s_status_names) ? s_status_names[status] : "unknown";
+}
@@ -0,0 +1,20 @@
+#include "congest.h"
+
+size_t congest_encode(const congest_t *c, uint8_t *buf, size_t cap) {
+    if (cap < CONG_FRAME_LEN) return 0;
+
+    mesh_proto_put_hdr(buf, MESH_MSG_CONGESTION, 0);
+    buf[4] = c->level > CONG_LEVEL_MAX ? CONG_LEVEL_MAX : c->level;
+    buf[5] = 0;
+    mp_put_u16(&buf[6], c->ttl_s);
+    return CONG_FRAME_LEN;
+}
+
+bool congest_decode(const uint8_t *buf, size_t len, congest_t *out) {
+    if (len < CONG_FRAME_LEN || !mesh_proto_is_frame(buf, len)) return false;
+    if (mesh_proto_type(buf) != MESH_MSG_CONGESTION) return false;
+
+    out->level = buf[4] > CONG_LEVEL_MAX ? CONG_LEVEL_MAX : buf[4];
+    out->ttl_s = mp_get_u16(&buf[6]);
+    return true;
+}
@@ -0,0 +1,48 @@
+#include <string.h>
+#include "frag.h"
+
+uint8_t frag_count(size_t msg_len) {
+    size_t n = (msg_len + FRAG_PAYLOAD_MAX - 1) / FRAG_PAYLOAD_MAX;
+    return (n == 0 || n > FRAG_MAX_COUNT) ? 0 : (uint8_t)n;
+}
+
+size_t frag_encode(const uint8_t *msg, size_t msg_len, uint16_t msg_id, uint8_t index,
+                   uint8_t *buf, size_t cap) {
+    uint8_t count = frag_count(msg_len);
+    if (index >= count) return 0;
+
+    size_t off = (size_t)index * FRAG_PAYLOAD_MAX;
+    size_t n   = msg_len - off < FRAG_PAYLOAD_MAX ? msg_len - off : FRAG_PAYLOAD_MAX;
+    if (cap < FRAG_HDR_LEN + n) return 0;
+
+    mesh_proto_put_hdr(buf, MESH_MSG_FRAG, 0);
+    mp_put_u16(&buf[4], msg_id);
+    buf[6] = index;
+    buf[7] = count;
+    mp_put_u16(&buf[8], (uint16_t)msg_len);
+    mp_put_u16(&buf[10], (uint16_t)off);
+    memcpy(&buf[FRAG_HDR_LEN], msg + off, n);
+    return FRAG_HDR_LEN + n;
+}
+
+bool frag_decode(const uint8_t *buf, size_t len, frag_t *out) {
+    if (len <= FRAG_HDR_LEN || !mesh_proto_is_frame(buf, len)) return false;
+    if (mesh_proto_type(buf) != MESH_MSG_FRAG) return false;
+
+    out->msg_id    = mp_get_u16(&buf[4]);
+    out->index     = buf[6];
+    out->count     = buf[7];
+    out->total_len = mp_get_u16(&buf[8]);
+    out->offset    = mp_get_u16(&buf[10]);
+    out->len       = (uint16_t)(len - FRAG_HDR_LEN);
+    out->payload   = &buf[FRAG_HDR_LEN];
+
+    // count phải đúng số mảnh của total_len: mảnh giữa đầy nên count lớn hơn sẽ đẩy offset
+    // ra ngoài message (bên ghép tin offset để chép)
+    if (out->count == 0 || out->count != frag_count(out->total_len) || out->index >= out->count) return false;
+    // cắt cố định FRAG_PAYLOAD_MAX: mảnh giữa luôn đầy, mảnh cuối kết thúc đúng total_len
+    bool last = out->index == out->count - 1;
+    if (out->offset != (uint32_t)out->index * FRAG_PAYLOAD_MAX) return false;
+    if (last ? (uint32_t)out->offset + out->len != out->total_len : out->len != FRAG_PAYLOAD_MAX) return false;
+    return (uint32_t)out->offset + out->len <= out->total_len;
+}
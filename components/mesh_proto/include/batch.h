@@ -0,0 +1,46 @@
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mesh_proto.h"
+
+// ==== Frame gộp của relay (MESH_MSG_BATCH) ====
+//  off  size  field
+//   0    4    header
+//   4    1    count
+//   5    ...  count x { mac[6] (leaf gốc), len u8, frame[len] }
+// Frame con giữ nguyên byte như leaf gửi, root tách ra rồi xử lý như frame nhận trực tiếp.
+#define BATCH_HDR_LEN           5
+#define BATCH_ENTRY_HDR         7
+#define BATCH_ENTRY_MAX         255
+#define BATCH_FRAME_MAX         480     // vừa 1 frame root nhận được; lớn hơn phải gửi qua FRAG
+
+typedef struct {
+    uint8_t *buf;
+    size_t   cap;
+    size_t   len;
+    uint8_t  count;
+} batch_builder_t;
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint8_t        left;
+} batch_iter_t;
+
+void   batch_begin(batch_builder_t *b, uint8_t *buf, size_t cap);
+// false nếu không còn chỗ (frame chưa được thêm)
+bool   batch_add(batch_builder_t *b, const uint8_t mac[6], const uint8_t *data, size_t len);
+// Ghi count, trả về độ dài frame (0 nếu rỗng). Gọi batch_begin lại trước batch kế tiếp.
+size_t batch_finish(batch_builder_t *b);
+
+static inline bool batch_empty(const batch_builder_t *b) { return b->count == 0; }
+
+// false nếu buf không phải frame BATCH
+bool   batch_iter_init(batch_iter_t *it, const uint8_t *buf, size_t len);
+// false khi hết hoặc frame bị cắt cụt
+bool   batch_next(batch_iter_t *it, const uint8_t **mac, const uint8_t **data, size_t *len);
+
+#endif /* BATCH_H_ */
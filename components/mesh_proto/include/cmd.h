@@ -0,0 +1,73 @@
+#ifndef CMD_H_
+#define CMD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mesh_proto.h"
+
+// ==== Lệnh xuống leaf (MESH_MSG_CMD) ====
+//  off  size  field
+//   0    4    header
+//   4    2    cmd_id     (root cấp, leaf trả lại trong ACK)
+//   6    1    op         (cmd_op_t)
+//   7    1    arg_len
+//   8    n    arg        (tùy op, LE)
+#define CMD_HDR_LEN             8
+#define CMD_ARG_MAX             16
+#define CMD_FRAME_MAX           (CMD_HDR_LEN + CMD_ARG_MAX)
+
+// ==== ACK (MESH_MSG_CMD_ACK) ====
+//   0    4    header
+//   4    2    node_id
+//   6    2    cmd_id
+//   8    1    status     (cmd_status_t)
+//   9    1    op
+//  10    4    leaf_us    (leaf nhận -> gửi ACK, để tách phần xử lý khỏi RTT)
+#define CMD_ACK_LEN             14
+
+typedef enum {
+    CMD_OP_PING          = 0x00,   // chỉ ACK, đo RTT
+    CMD_OP_SET_SAMPLE    = 0x01,   // arg u32 sample_ms
+    CMD_OP_SET_HEARTBEAT = 0x02,   // arg u32 max_interval_ms (mọi cảm biến)
+    CMD_OP_READ_NOW      = 0x03,   // lấy mẫu + gửi ngay, bỏ qua deadband
+    // gửi tới relay
+    CMD_OP_RELAY_WINDOW  = 0x04,   // arg u32 cửa sổ rút gọn ms, 0 = chuyển thô tất cả
+    CMD_OP_RELAY_RAW     = 0x05,   // arg mac[6] + u8 on: leaf đó chuyển thô / rút gọn
+} cmd_op_t;
+
+typedef enum {
+    CMD_OK = 0,
+    CMD_ERR_OP,         // op không hỗ trợ
+    CMD_ERR_ARG,
+    CMD_ERR_FAIL,
+} cmd_status_t;
+
+typedef struct {
+    uint16_t cmd_id;
+    uint8_t  op;
+    uint8_t  arg_len;
+    uint8_t  arg[CMD_ARG_MAX];
+} cmd_t;
+
+typedef struct {
+    uint16_t node_id;
+    uint16_t cmd_id;
+    uint8_t  status;
+    uint8_t  op;
+    uint32_t leaf_us;
+} cmd_ack_t;
+
+size_t cmd_encode(const cmd_t *c, uint8_t *buf, size_t cap);
+bool   cmd_decode(const uint8_t *buf, size_t len, cmd_t *out);
+
+size_t cmd_ack_encode(const cmd_ack_t *a, uint8_t *buf, size_t cap);
+bool   cmd_ack_decode(const uint8_t *buf, size_t len, cmd_ack_t *out);
+
+// Tên op cho MQTT ("ping", "set_sample", ...), NULL nếu không biết
+const char *cmd_op_name(uint8_t op);
+// -1 nếu không biết tên
+int         cmd_op_from_name(const char *name);
+const char *cmd_status_name(uint8_t status);
+
+#endif /* CMD_H_ */
@@ -0,0 +1,31 @@
+#ifndef CONGEST_H_
+#define CONGEST_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mesh_proto.h"
+
+// ==== Mức nghẽn của root (MESH_MSG_CONGESTION), root -> leaf + relay ====
+//  off  size  field
+//   0    4    header
+//   4    1    level      (0 = bình thường .. CONG_LEVEL_MAX)
+//   5    1    reserved
+//   6    2    ttl_s      (hết hạn mà không được gửi lại -> tự về level 0)
+// Root gửi khi level đổi và nhắc lại định kỳ khi level > 0.
+#define CONG_FRAME_LEN          8
+#define CONG_LEVEL_MAX          3
+#define CONG_LEVEL_SUMMARY      2       // từ mức này relay chuyển sang gửi SUMMARY
+
+// Leaf giãn chu kỳ lấy mẫu x2 mỗi mức (x1, x2, x4, x8)
+#define CONG_STRETCH(level)     (1u << (level))
+
+typedef struct {
+    uint8_t  level;
+    uint16_t ttl_s;
+} congest_t;
+
+size_t congest_encode(const congest_t *c, uint8_t *buf, size_t cap);
+bool   congest_decode(const uint8_t *buf, size_t len, congest_t *out);
+
+#endif /* CONGEST_H_ */
@@ -0,0 +1,45 @@
+#ifndef FRAG_H_
+#define FRAG_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mesh_proto.h"
+
+// ==== Mảnh của message lớn (MESH_MSG_FRAG) ====
+// Message (bất kỳ frame nào, kể cả BATCH) dài hơn FRAG_RX_MAX được cắt thành
+// tối đa FRAG_MAX_COUNT mảnh, root ghép lại rồi xử lý như frame nhận nguyên.
+//  off  size  field
+//   0    4    header
+//   4    2    msg_id     (sender tự tăng, phân biệt message của cùng 1 MAC)
+//   6    1    index
+//   7    1    count
+//   8    2    total_len
+//  10    2    offset     (vị trí payload trong message)
+//  12    n    payload
+#define FRAG_HDR_LEN            12
+#define FRAG_RX_MAX             512     // buffer nhận nhỏ nhất trên đường lên (slot ring của root)
+#define FRAG_PAYLOAD_MAX        (FRAG_RX_MAX - FRAG_HDR_LEN)
+#define FRAG_MAX_COUNT          32
+
+typedef struct {
+    uint16_t       msg_id;
+    uint8_t        index;
+    uint8_t        count;
+    uint16_t       total_len;
+    uint16_t       offset;
+    uint16_t       len;
+    const uint8_t *payload;     // trỏ vào buf đã decode, không copy
+} frag_t;
+
+// Số mảnh cho message msg_len byte, 0 nếu quá FRAG_MAX_COUNT mảnh
+uint8_t frag_count(size_t msg_len);
+
+// Ghi mảnh thứ index vào buf, trả về độ dài frame (0 nếu index sai / buf thiếu chỗ)
+size_t frag_encode(const uint8_t *msg, size_t msg_len, uint16_t msg_id, uint8_t index,
+                   uint8_t *buf, size_t cap);
+
+// false nếu không phải mảnh hợp lệ (header, count, offset, độ dài không khớp total_len)
+bool frag_decode(const uint8_t *buf, size_t len, frag_t *out);
+
+#endif /* FRAG_H_ */
@@ -0,0 +1,35 @@
+#ifndef LINK_H_
+#define LINK_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mesh_proto.h"
+
+// ==== Thống kê kết nối lại parent (MESH_MSG_LINK), leaf gửi sau mỗi lần nối lại ====
+//  off  size  field
+//   0    4    header
+//   4    2    node_id
+//   6    2    reconnects      (số lần nối lại kể từ boot)
+//   8    4    reconnect_ms    (mất parent -> PARENT_CONNECTED của lần gần nhất)
+//  12    2    scans           (số lần scan của lần nối lại đó)
+//  14    1    rssi            (int8, parent mới)
+//  15    1    layer
+#define LINK_FRAME_LEN          16
+
+typedef struct {
+    uint16_t node_id;
+    uint16_t reconnects;
+    uint32_t reconnect_ms;
+    uint16_t scans;
+    int8_t   rssi;
+    uint8_t  layer;
+} link_stats_t;
+
+size_t link_encode(const link_stats_t *l, uint8_t *buf, size_t cap);
+bool   link_decode(const uint8_t *buf, size_t len, link_stats_t *out);
+
+// JSON publish lên "<topic node>/link", -1 nếu out không đủ chỗ
+int link_to_json(const link_stats_t *l, char *out, size_t cap);
+
+#endif /* LINK_H_ */
@@ -0,0 +1,92 @@
+#ifndef MESH_PROTO_H_
+#define MESH_PROTO_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ==== Header chung cho mọi frame nhị phân trong mesh ====
+//  byte 0 : magic   (MESH_PROTO_MAGIC)
+//  byte 1 : version (MESH_PROTO_VERSION)
+//  byte 2 : type    (bit 0-6 = mesh_msg_type_t, bit 7 = lớp ALARM)
+//  byte 3 : flags   (tùy theo type)
+// Payload JSON cũ luôn bắt đầu bằng '{' nên không bị nhầm với magic.
+#define MESH_PROTO_MAGIC        0xA5
+#define MESH_PROTO_VERSION      1
+#define MESH_PROTO_HDR_LEN      4
+#define MESH_PROTO_TYPE_MASK    0x7F
+#define MESH_PROTO_CLASS_ALARM  0x80
+
+// Lớp lưu lượng: mỗi hop giữ hàng đợi riêng, ALARM đi trước TELEMETRY (ưu tiên tuyệt đối)
+typedef enum {
+    MESH_CLASS_TELEMETRY = 0,
+    MESH_CLASS_ALARM,
+    MESH_CLASS_COUNT
+} mesh_class_t;
+
+typedef enum {
+    MESH_MSG_TELEMETRY  = 0x01,
+    MESH_MSG_MOTION     = 0x02,   // leaf -> root, sự kiện PIR
+    MESH_MSG_MOTION_ACK = 0x03,   // root -> leaf
+    MESH_MSG_LINK       = 0x04,   // leaf -> root, thống kê kết nối lại parent
+    MESH_MSG_CMD        = 0x05,   // root -> leaf, lệnh từ MQTT
+    MESH_MSG_CMD_ACK    = 0x06,   // leaf -> root
+    MESH_MSG_BATCH      = 0x07,   // relay -> root, gói nhiều frame của các leaf con
+    MESH_MSG_SUMMARY    = 0x08,   // relay -> root, thống kê theo cửa sổ thay cho mẫu thô
+    MESH_MSG_FRAG       = 0x09,   // 1 mảnh của message lớn hơn buffer nhận của root
+    MESH_MSG_TIME_BEACON = 0x0A,  // root -> leaf, mesh time để leaf đồng bộ đồng hồ
+    MESH_MSG_TIME_ECHO  = 0x0B,   // leaf -> root, trả lời beacon: RTT + sai số đồng bộ
+    MESH_MSG_CONGESTION = 0x0C,   // root -> leaf/relay, mức nghẽn để giảm tải
+    MESH_MSG_SERIES     = 0x0D,   // leaf -> root, N mẫu telemetry nén delta + varint
+} mesh_msg_type_t;
+
+// ==== Đọc/ghi little-endian, không phụ thuộc alignment ====
+static inline void mp_put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void mp_put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint16_t mp_get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t mp_get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void mesh_proto_put_hdr(uint8_t *p, mesh_msg_type_t type, uint8_t flags) {
+    p[0] = MESH_PROTO_MAGIC;
+    p[1] = MESH_PROTO_VERSION;
+    p[2] = (uint8_t)type;
+    p[3] = flags;
+}
+
+// true nếu buf là frame nhị phân hợp lệ (đúng magic + version)
+static inline bool mesh_proto_is_frame(const uint8_t *buf, size_t len) {
+    return len >= MESH_PROTO_HDR_LEN && buf[0] == MESH_PROTO_MAGIC && buf[1] == MESH_PROTO_VERSION;
+}
+
+static inline mesh_msg_type_t mesh_proto_type(const uint8_t *buf) {
+    return (mesh_msg_type_t)(buf[2] & MESH_PROTO_TYPE_MASK);
+}
+
+// Gọi sau mesh_proto_put_hdr / *_encode
+static inline void mesh_proto_set_class(uint8_t *buf, mesh_class_t cls) {
+    if (cls == MESH_CLASS_ALARM) buf[2] |= MESH_PROTO_CLASS_ALARM;
+    else                         buf[2] &= MESH_PROTO_TYPE_MASK;
+}
+
+// Payload không phải frame nhị phân (JSON cũ) tính là TELEMETRY
+static inline mesh_class_t mesh_proto_class(const uint8_t *buf, size_t len) {
+    if (!mesh_proto_is_frame(buf, len)) return MESH_CLASS_TELEMETRY;
+    return (buf[2] & MESH_PROTO_CLASS_ALARM) ? MESH_CLASS_ALARM : MESH_CLASS_TELEMETRY;
+}
+
+#endif /* MESH_PROTO_H_ */
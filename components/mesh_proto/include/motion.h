@@ -0,0 +1,42 @@
+#ifndef MOTION_H_
+#define MOTION_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mesh_proto.h"
+
+// ==== Sự kiện PIR (MESH_MSG_MOTION), gửi ngay khi có cạnh, lớp MESH_CLASS_ALARM ====
+//  off  size  field
+//   0    4    header (flags bit0 = mức PIR sau cạnh)
+//   4    2    node_id
+//   6    2    event seq
+//   8    4    edge_to_send_us  (từ lúc ISR bắt cạnh tới lúc esp_mesh_send)
+//  12    4    last_latency_us  (cạnh -> root đo được của sự kiện trước, 0 = chưa có)
+#define MOTION_FRAME_LEN        16
+#define MOTION_FLAG_LEVEL       0x01
+
+// ==== Root xác nhận sự kiện (MESH_MSG_MOTION_ACK) để leaf đo RTT ====
+//   0    4    header
+//   4    2    node_id
+//   6    2    event seq
+#define MOTION_ACK_LEN          8
+
+typedef struct {
+    uint16_t node_id;
+    uint16_t seq;
+    uint8_t  level;
+    uint32_t edge_to_send_us;
+    uint32_t last_latency_us;
+} motion_event_t;
+
+size_t motion_encode(const motion_event_t *m, uint8_t *buf, size_t cap);
+bool   motion_decode(const uint8_t *buf, size_t len, motion_event_t *out);
+
+size_t motion_ack_encode(uint16_t node_id, uint16_t seq, uint8_t *buf, size_t cap);
+bool   motion_ack_decode(const uint8_t *buf, size_t len, uint16_t *node_id, uint16_t *seq);
+
+// JSON publish lên "<topic node>/motion", -1 nếu out không đủ chỗ
+int motion_to_json(const motion_event_t *m, char *out, size_t cap);
+
+#endif /* MOTION_H_ */
@@ -0,0 +1,78 @@
+#ifndef SERIES_H_
+#define SERIES_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mesh_proto.h"
+#include "telemetry.h"
+#include "batch.h"
+
+// ==== Chuỗi mẫu telemetry nén của 1 leaf (MESH_MSG_SERIES) ====
+// Leaf gom N mẫu rồi gửi 1 frame thay cho N frame telemetry (bớt header mesh + airtime).
+//  off  size  field
+//   0    4    header (flags = SERIES_FLAG_*)
+//   4    2    node_id
+//   6    2    seq_first  (seq mẫu đầu, mẫu i có seq_first + i)
+//   8    1    count
+//   9    4    base_ms    (thời điểm mẫu đầu, ms, 32 bit thấp)
+//  13    ...  count x mẫu, mỗi trường là varint (7 bit/byte, LSB trước):
+//             h = zigzag(dod) << 3 | SERIES_S_*   dod = delta-of-delta thời điểm (SERIES_TICK_MS)
+//             zigzag(dtemp), zigzag(dhumi)        chỉ khi SERIES_S_DHT_OK
+//             zigzag(dlight_raw)
+//             zigzag(dlight_mv)                   chỉ khi SERIES_S_LIGHT_MV
+// Delta tính với giá trị hợp lệ gần nhất trong frame (mẫu đầu so với 0). Lấy mẫu đều chu kỳ
+// và giá trị ít đổi -> ~4-5 byte/mẫu thay vì 13-20 byte + header mesh.
+#define SERIES_HDR_LEN          13
+#define SERIES_SAMPLE_MAX       15      // varint xấu nhất của 1 mẫu
+#define SERIES_FRAME_MAX        BATCH_ENTRY_MAX     // phải lọt 1 entry BATCH của relay
+#define SERIES_TICK_MS          10      // = tick FreeRTOS, mẫu không mịn hơn
+#define SERIES_SPAN_MAX_MS      (1 << 24)   // mẫu đầu -> mẫu cuối, giữ zigzag(dod) << 3 trong 32 bit
+
+#define SERIES_FLAG_SYNC        0x01    // base_ms theo mesh time (tsync.h), không thì đồng hồ leaf
+
+#define SERIES_S_DHT_OK         0x01
+#define SERIES_S_MOTION         0x02
+#define SERIES_S_LIGHT_MV       0x04
+
+typedef struct {
+    uint8_t *buf;
+    size_t   cap;
+    size_t   len;
+    uint8_t  count;
+    uint32_t base_ms;
+    uint32_t last_tick;     // offset mẫu trước so với base_ms
+    int32_t  last_dt;
+    int32_t  temp, humi, light_raw, light_mv;   // giá trị trước để tính delta
+} series_builder_t;
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint8_t        left;
+    uint8_t        flags;
+    uint16_t       node_id;
+    uint16_t       seq;
+    uint32_t       base_ms;
+    uint32_t       tick;
+    int32_t        dt;
+    int32_t        temp, humi, light_raw, light_mv;
+} series_iter_t;
+
+// cap nên <= SERIES_FRAME_MAX
+void   series_begin(series_builder_t *b, uint8_t *buf, size_t cap);
+// Mẫu đầu đặt base_ms = t_ms. false nếu có thể không vừa, đã đủ 255 mẫu hoặc t_ms lùi/quá
+// SERIES_SPAN_MAX_MS: gửi frame rồi begin lại.
+bool   series_add(series_builder_t *b, const telemetry_t *t, uint32_t t_ms);
+// Ghi header, trả về độ dài frame (0 nếu rỗng). node_id/seq_first/flags lấy theo mẫu đầu.
+size_t series_finish(series_builder_t *b, uint16_t node_id, uint16_t seq_first, uint8_t flags);
+
+static inline bool series_empty(const series_builder_t *b) { return b->count == 0; }
+
+// false nếu buf không phải frame SERIES
+bool   series_iter_init(series_iter_t *it, const uint8_t *buf, size_t len);
+// Mẫu kế tiếp dưới dạng telemetry (node_id, seq, cờ TLM_FLAG_DHT_OK/LIGHT_MV), off_ms = thời điểm - base_ms.
+// false khi hết hoặc frame hỏng.
+bool   series_next(series_iter_t *it, telemetry_t *out, uint32_t *off_ms);
+
+#endif /* SERIES_H_ */
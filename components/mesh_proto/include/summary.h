@@ -0,0 +1,56 @@
+#ifndef SUMMARY_H_
+#define SUMMARY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mesh_proto.h"
+
+// ==== Thống kê 1 cửa sổ telemetry của 1 leaf (MESH_MSG_SUMMARY) ====
+// Relay gửi thay cho các frame telemetry thô khi bật rút gọn.
+//  off  size  field
+//   0    4    header
+//   4    2    node_id
+//   6    2    seq_first   (seq telemetry đầu cửa sổ)
+//   8    2    seq_last
+//  10    2    samples     (số frame telemetry đã gộp)
+//  12    4    span_ms     (mẫu đầu -> mẫu cuối, theo đồng hồ relay)
+//  16    1    field_mask  (bit (1 << summary_field_t) = trường có mẫu hợp lệ)
+//  17    1    reserved
+//  18   12    x SUMMARY_FIELDS: count u16, min i16, max i16, last i16, mean_x100 i32
+#define SUMMARY_FIELD_LEN       12
+#define SUMMARY_FRAME_LEN       (18 + SUMMARY_FIELDS * SUMMARY_FIELD_LEN)
+
+typedef enum {
+    SUMMARY_TEMP = 0,
+    SUMMARY_HUMI,
+    SUMMARY_LIGHT,      // light_raw
+    SUMMARY_MOTION,
+    SUMMARY_FIELDS
+} summary_field_t;
+
+typedef struct {
+    uint16_t count;
+    int16_t  min;
+    int16_t  max;
+    int16_t  last;
+    int32_t  mean_x100;     // trung bình x100, làm tròn
+} summary_stat_t;
+
+typedef struct {
+    uint16_t       node_id;
+    uint16_t       seq_first;
+    uint16_t       seq_last;
+    uint16_t       samples;
+    uint32_t       span_ms;
+    uint8_t        field_mask;
+    summary_stat_t f[SUMMARY_FIELDS];
+} summary_t;
+
+size_t summary_encode(const summary_t *s, uint8_t *buf, size_t cap);
+bool   summary_decode(const uint8_t *buf, size_t len, summary_t *out);
+
+// JSON publish lên "<topic node>/summary", -1 nếu out không đủ chỗ
+int summary_to_json(const summary_t *s, char *out, size_t cap);
+
+#endif /* SUMMARY_H_ */
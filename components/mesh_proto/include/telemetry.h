@@ -0,0 +1,58 @@
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mesh_proto.h"
+
+// ==== Frame telemetry (MESH_MSG_TELEMETRY) ====
+//  off  size  field
+//   0    4    header (flags = TLM_FLAG_*)
+//   4    2    node_id    (LE)
+//   6    2    seq        (LE, tăng mỗi lần gửi, tràn về 0)
+//   8    1    temp       (int8, °C)
+//   9    1    humi       (%)
+//  10    2    light_raw  (LE, ADC 12-bit)
+//  12    1    motion     (0/1)
+//  Phần tùy chọn, nối tiếp theo thứ tự khi cờ tương ứng bật:
+//   +2   light_mv   (LE, TLM_FLAG_LIGHT_MV)
+//   +4   tx_us      (LE, esp_timer của leaf lúc gửi, 32 bit thấp, TLM_FLAG_TX_TS;
+//                    có thêm TLM_FLAG_TX_SYNC thì là mesh time đã đồng bộ với root)
+//   +1   layer      (layer mesh của leaf lúc gửi, TLM_FLAG_TX_TS)
+#define TELEMETRY_FRAME_LEN     13
+#define TELEMETRY_FRAME_MAX     20
+
+#define TLM_FLAG_DHT_OK         0x01   // temp/humi hợp lệ
+#define TLM_FLAG_LIGHT_MV       0x02   // có light_mv đã hiệu chuẩn eFuse
+#define TLM_FLAG_TX_TS          0x04   // có tx_us + layer để root đo độ trễ
+#define TLM_FLAG_TX_SYNC        0x08   // tx_us theo mesh time (tsync.h), root đo trễ 1 chiều trực tiếp
+
+// Chuyển đổi raw ADC -> điện áp, giống phía leaf
+#define TLM_LIGHT_VREF          3.3f
+#define TLM_LIGHT_RAW_MAX       4095.0f
+
+typedef struct {
+    uint16_t node_id;
+    uint16_t seq;
+    int8_t   temp;
+    uint8_t  humi;
+    uint16_t light_raw;
+    uint8_t  motion;
+    uint16_t light_mv;          // bỏ qua nếu không có TLM_FLAG_LIGHT_MV
+    uint32_t tx_us;             // bỏ qua nếu không có TLM_FLAG_TX_TS
+    uint8_t  layer;
+    uint8_t  flags;
+} telemetry_t;
+
+// Trả về số byte đã ghi, 0 nếu buf không đủ chỗ
+size_t telemetry_encode(const telemetry_t *t, uint8_t *buf, size_t cap);
+
+// false nếu không phải frame telemetry hợp lệ
+bool telemetry_decode(const uint8_t *buf, size_t len, telemetry_t *out);
+
+// Dựng lại JSON giống định dạng cJSON cũ của leaf cho MQTT consumer.
+// Trả về độ dài chuỗi, hoặc -1 nếu out không đủ chỗ.
+int telemetry_to_json(const telemetry_t *t, char *out, size_t cap);
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,58 @@
+#ifndef TSYNC_H_
+#define TSYNC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mesh_proto.h"
+
+// ==== Beacon thời gian (MESH_MSG_TIME_BEACON), root -> từng leaf ====
+// "Mesh time" = đồng hồ root: epoch UTC (us) khi đã có SNTP, chưa có thì esp_timer của root.
+//  off  size  field
+//   0    4    header (flags = TSYNC_FLAG_*)
+//   4    2    seq
+//   6    8    root_us    (mesh time lúc root gửi, LE 64 bit)
+//  14    4    owd_us     (root ước lượng trễ root -> leaf này, 0 = chưa biết)
+//  18    1    slot       (slot gửi của leaf trong chu kỳ báo cáo, TSYNC_FLAG_SLOT)
+//  19    1    slots      (số slot chia đều 1 chu kỳ, 0 = không xếp lịch)
+#define TSYNC_BEACON_LEN        20
+#define TSYNC_FLAG_UTC          0x01
+#define TSYNC_FLAG_SLOT         0x02   // có slot/slots: leaf gửi tại mốc slot * chu kỳ / slots
+
+// ==== Leaf trả lời beacon (MESH_MSG_TIME_ECHO) để root đo RTT + sai số đồng bộ ====
+//   0    4    header (flags = TSYNC_FLAG_SYNCED nếu leaf_us hợp lệ)
+//   4    2    node_id
+//   6    2    seq        (của beacon)
+//   8    4    root_us    (32 bit thấp root_us của beacon, trả lại nguyên)
+//  12    4    hold_us    (leaf nhận beacon -> gửi echo)
+//  16    4    leaf_us    (mesh time theo đồng hồ leaf lúc gửi echo, 32 bit thấp)
+//  20    4    err_us     (int32, lệch của mẫu beacon này so với ước lượng của leaf)
+#define TSYNC_ECHO_LEN          24
+#define TSYNC_FLAG_SYNCED       0x01
+
+typedef struct {
+    uint16_t seq;
+    uint8_t  flags;
+    uint64_t root_us;
+    uint32_t owd_us;
+    uint8_t  slot;
+    uint8_t  slots;
+} tsync_beacon_t;
+
+typedef struct {
+    uint16_t node_id;
+    uint16_t seq;
+    uint8_t  flags;
+    uint32_t root_us;
+    uint32_t hold_us;
+    uint32_t leaf_us;
+    int32_t  err_us;
+} tsync_echo_t;
+
+size_t tsync_beacon_encode(const tsync_beacon_t *b, uint8_t *buf, size_t cap);
+bool   tsync_beacon_decode(const uint8_t *buf, size_t len, tsync_beacon_t *out);
+
+size_t tsync_echo_encode(const tsync_echo_t *e, uint8_t *buf, size_t cap);
+bool   tsync_echo_decode(const uint8_t *buf, size_t len, tsync_echo_t *out);
+
+#endif /* TSYNC_H_ */
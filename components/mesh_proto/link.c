@@ -0,0 +1,38 @@
+#include <stdio.h>
+#include "link.h"
+
+size_t link_encode(const link_stats_t *l, uint8_t *buf, size_t cap) {
+    if (cap < LINK_FRAME_LEN) return 0;
+
+    mesh_proto_put_hdr(buf, MESH_MSG_LINK, 0);
+    mp_put_u16(&buf[4], l->node_id);
+    mp_put_u16(&buf[6], l->reconnects);
+    mp_put_u32(&buf[8], l->reconnect_ms);
+    mp_put_u16(&buf[12], l->scans);
+    buf[14] = (uint8_t)l->rssi;
+    buf[15] = l->layer;
+    return LINK_FRAME_LEN;
+}
+
+bool link_decode(const uint8_t *buf, size_t len, link_stats_t *out) {
+    if (len < LINK_FRAME_LEN || !mesh_proto_is_frame(buf, len)) return false;
+    if (mesh_proto_type(buf) != MESH_MSG_LINK) return false;
+
+    out->node_id      = mp_get_u16(&buf[4]);
+    out->reconnects   = mp_get_u16(&buf[6]);
+    out->reconnect_ms = mp_get_u32(&buf[8]);
+    out->scans        = mp_get_u16(&buf[12]);
+    out->rssi         = (int8_t)buf[14];
+    out->layer        = buf[15];
+    return true;
+}
+
+int link_to_json(const link_stats_t *l, char *out, size_t cap) {
+    int n = snprintf(out, cap,
+                     "{\"node_id\":\"Leaf_%02u\",\"event\":\"link\",\"reconnects\":%u,"
+                     "\"reconnect_ms\":%u,\"scans\":%u,\"rssi\":%d,\"layer\":%u}",
+                     (unsigned)l->node_id, (unsigned)l->reconnects, (unsigned)l->reconnect_ms,
+                     (unsigned)l->scans, (int)l->rssi, (unsigned)l->layer);
+    if (n < 0 || (size_t)n >= cap) return -1;
+    return n;
+}
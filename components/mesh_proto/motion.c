@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include "motion.h"
+
+size_t motion_encode(const motion_event_t *m, uint8_t *buf, size_t cap) {
+    if (cap < MOTION_FRAME_LEN) return 0;
+
+    mesh_proto_put_hdr(buf, MESH_MSG_MOTION, m->level ? MOTION_FLAG_LEVEL : 0);
+    mp_put_u16(&buf[4], m->node_id);
+    mp_put_u16(&buf[6], m->seq);
+    mp_put_u32(&buf[8], m->edge_to_send_us);
+    mp_put_u32(&buf[12], m->last_latency_us);
+    mesh_proto_set_class(buf, MESH_CLASS_ALARM);
+    return MOTION_FRAME_LEN;
+}
+
+bool motion_decode(const uint8_t *buf, size_t len, motion_event_t *out) {
+    if (len < MOTION_FRAME_LEN || !mesh_proto_is_frame(buf, len)) return false;
+    if (mesh_proto_type(buf) != MESH_MSG_MOTION) return false;
+
+    out->level           = (buf[3] & MOTION_FLAG_LEVEL) ? 1 : 0;
+    out->node_id         = mp_get_u16(&buf[4]);
+    out->seq             = mp_get_u16(&buf[6]);
+    out->edge_to_send_us = mp_get_u32(&buf[8]);
+    out->last_latency_us = mp_get_u32(&buf[12]);
+    return true;
+}
+
+size_t motion_ack_encode(uint16_t node_id, uint16_t seq, uint8_t *buf, size_t cap) {
+    if (cap < MOTION_ACK_LEN) return 0;
+
+    mesh_proto_put_hdr(buf, MESH_MSG_MOTION_ACK, 0);
+    mp_put_u16(&buf[4], node_id);
+    mp_put_u16(&buf[6], seq);
+    return MOTION_ACK_LEN;
+}
+
+bool motion_ack_decode(const uint8_t *buf, size_t len, uint16_t *node_id, uint16_t *seq) {
+    if (len < MOTION_ACK_LEN || !mesh_proto_is_frame(buf, len)) return false;
+    if (mesh_proto_type(buf) != MESH_MSG_MOTION_ACK) return false;
+
+    *node_id = mp_get_u16(&buf[4]);
+    *seq     = mp_get_u16(&buf[6]);
+    return true;
+}
+
+int motion_to_json(const motion_event_t *m, char *out, size_t cap) {
+    int n = snprintf(out, cap,
+                     "{\"node_id\":\"Leaf_%02u\",\"event\":\"motion\",\"motion\":%u,\"seq\":%u,"
+                     "\"edge_to_send_us\":%u,\"last_latency_us\":%u}",
+                     (unsigned)m->node_id, (unsigned)m->level, (unsigned)m->seq,
+                     (unsigned)m->edge_to_send_us, (unsigned)m->last_latency_us);
+    if (n < 0 || (size_t)n >= cap) return -1;
+    return n;
+}
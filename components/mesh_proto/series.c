@@ -0,0 +1,153 @@
+#include "series.h"
+
+static inline uint32_t zz_enc(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t  zz_dec(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+static uint8_t *varint_put(uint8_t *p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+// NULL nếu hết buffer hoặc dài quá 5 byte
+static const uint8_t *varint_get(const uint8_t *p, const uint8_t *end, uint32_t *v) {
+    uint32_t r = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        r |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *v = r;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+void series_begin(series_builder_t *b, uint8_t *buf, size_t cap) {
+    b->buf       = buf;
+    b->cap       = cap;
+    b->len       = SERIES_HDR_LEN;
+    b->count     = 0;
+    b->base_ms   = 0;
+    b->last_tick = 0;
+    b->last_dt   = 0;
+    b->temp = b->humi = b->light_raw = b->light_mv = 0;
+}
+
+bool series_add(series_builder_t *b, const telemetry_t *t, uint32_t t_ms) {
+    if (b->count == UINT8_MAX || b->len + SERIES_SAMPLE_MAX > b->cap) return false;
+
+    if (b->count == 0) b->base_ms = t_ms;
+    // đồng hồ lùi (vd leaf vừa nhảy mesh time) hoặc cách quá xa: mở frame mới
+    int32_t span = (int32_t)(t_ms - b->base_ms);
+    if (span < 0 || span >= SERIES_SPAN_MAX_MS) return false;
+    uint32_t tick = ((uint32_t)span + SERIES_TICK_MS / 2) / SERIES_TICK_MS;
+    int32_t  dt   = (int32_t)(tick - b->last_tick);
+    if (dt < 0) return false;
+
+    uint8_t s = 0;
+    if (t->flags & TLM_FLAG_DHT_OK)   s |= SERIES_S_DHT_OK;
+    if (t->motion)                    s |= SERIES_S_MOTION;
+    if (t->flags & TLM_FLAG_LIGHT_MV) s |= SERIES_S_LIGHT_MV;
+
+    uint8_t *p = &b->buf[b->len];
+    p = varint_put(p, zz_enc(dt - b->last_dt) << 3 | s);
+    if (s & SERIES_S_DHT_OK) {
+        p = varint_put(p, zz_enc(t->temp - b->temp));
+        p = varint_put(p, zz_enc(t->humi - b->humi));
+        b->temp = t->temp;
+        b->humi = t->humi;
+    }
+    p = varint_put(p, zz_enc(t->light_raw - b->light_raw));
+    b->light_raw = t->light_raw;
+    if (s & SERIES_S_LIGHT_MV) {
+        p = varint_put(p, zz_enc(t->light_mv - b->light_mv));
+        b->light_mv = t->light_mv;
+    }
+
+    b->len       = (size_t)(p - b->buf);
+    b->last_tick = tick;
+    b->last_dt   = dt;
+    b->count++;
+    return true;
+}
+
+size_t series_finish(series_builder_t *b, uint16_t node_id, uint16_t seq_first, uint8_t flags) {
+    if (b->count == 0 || b->cap < SERIES_HDR_LEN) return 0;
+
+    mesh_proto_put_hdr(b->buf, MESH_MSG_SERIES, flags);
+    mp_put_u16(&b->buf[4], node_id);
+    mp_put_u16(&b->buf[6], seq_first);
+    b->buf[8] = b->count;
+    mp_put_u32(&b->buf[9], b->base_ms);
+    return b->len;
+}
+
+bool series_iter_init(series_iter_t *it, const uint8_t *buf, size_t len) {
+    if (len < SERIES_HDR_LEN || !mesh_proto_is_frame(buf, len)) return false;
+    if (mesh_proto_type(buf) != MESH_MSG_SERIES) return false;
+
+    it->p       = &buf[SERIES_HDR_LEN];
+    it->end     = buf + len;
+    it->flags   = buf[3];
+    it->node_id = mp_get_u16(&buf[4]);
+    it->seq     = mp_get_u16(&buf[6]);
+    it->left    = buf[8];
+    it->base_ms = mp_get_u32(&buf[9]);
+    it->tick    = 0;
+    it->dt      = 0;
+    it->temp = it->humi = it->light_raw = it->light_mv = 0;
+    return true;
+}
+
+bool series_next(series_iter_t *it, telemetry_t *out, uint32_t *off_ms) {
+    if (it->left == 0) return false;
+
+    uint32_t h, v;
+    const uint8_t *p = varint_get(it->p, it->end, &h);
+    if (!p) return false;
+    uint8_t s = (uint8_t)(h & 0x07);
+    int32_t dt = it->dt + zz_dec(h >> 3);
+
+    int32_t temp = it->temp, humi = it->humi, light_mv = it->light_mv;
+    if (s & SERIES_S_DHT_OK) {
+        if (!(p = varint_get(p, it->end, &v))) return false;
+        temp += zz_dec(v);
+        if (!(p = varint_get(p, it->end, &v))) return false;
+        humi += zz_dec(v);
+    }
+    if (!(p = varint_get(p, it->end, &v))) return false;
+    int32_t light_raw = it->light_raw + zz_dec(v);
+    if (s & SERIES_S_LIGHT_MV) {
+        if (!(p = varint_get(p, it->end, &v))) return false;
+        light_mv += zz_dec(v);
+    }
+
+    // chỉ nhận mẫu khi đọc đủ, frame cắt cụt giữa chừng không làm lệch trạng thái
+    it->p         = p;
+    it->dt        = dt;
+    it->tick     += (uint32_t)dt;
+    it->temp      = temp;
+    it->humi      = humi;
+    it->light_raw = light_raw;
+    it->light_mv  = light_mv;
+    it->left--;
+
+    // DHT lỗi: leaf gửi 0 như frame telemetry thường
+    bool dht = (s & SERIES_S_DHT_OK) != 0;
+    out->node_id   = it->node_id;
+    out->seq       = it->seq++;
+    out->temp      = dht ? (int8_t)temp : 0;
+    out->humi      = dht ? (uint8_t)humi : 0;
+    out->light_raw = (uint16_t)light_raw;
+    out->light_mv  = (s & SERIES_S_LIGHT_MV) ? (uint16_t)light_mv : 0;
+    out->motion    = (s & SERIES_S_MOTION) ? 1 : 0;
+    out->tx_us     = 0;
+    out->layer     = 0;
+    out->flags     = (dht ? TLM_FLAG_DHT_OK : 0) | ((s & SERIES_S_LIGHT_MV) ? TLM_FLAG_LIGHT_MV : 0);
+    *off_ms = it->tick * SERIES_TICK_MS;
+    return true;
+}
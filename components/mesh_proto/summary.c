@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "summary.h"
+
+static const char *const s_field_names[SUMMARY_FIELDS] = {
+    [SUMMARY_TEMP]   = "temp",
+    [SUMMARY_HUMI]   = "humi",
+    [SUMMARY_LIGHT]  = "light_raw",
+    [SUMMARY_MOTION] = "motion",
+};
+
+size_t summary_encode(const summary_t *s, uint8_t *buf, size_t cap) {
+    if (cap < SUMMARY_FRAME_LEN) return 0;
+
+    mesh_proto_put_hdr(buf, MESH_MSG_SUMMARY, 0);
+    mp_put_u16(&buf[4], s->node_id);
+    mp_put_u16(&buf[6], s->seq_first);
+    mp_put_u16(&buf[8], s->seq_last);
+    mp_put_u16(&buf[10], s->samples);
+    mp_put_u32(&buf[12], s->span_ms);
+    buf[16] = s->field_mask;
+    buf[17] = 0;
+    for (int i = 0; i < SUMMARY_FIELDS; i++) {
+        uint8_t *p = &buf[18 + i * SUMMARY_FIELD_LEN];
+        mp_put_u16(&p[0], s->f[i].count);
+        mp_put_u16(&p[2], (uint16_t)s->f[i].min);
+        mp_put_u16(&p[4], (uint16_t)s->f[i].max);
+        mp_put_u16(&p[6], (uint16_t)s->f[i].last);
+        mp_put_u32(&p[8], (uint32_t)s->f[i].mean_x100);
+    }
+    return SUMMARY_FRAME_LEN;
+}
+
+bool summary_decode(const uint8_t *buf, size_t len, summary_t *out) {
+    if (len < SUMMARY_FRAME_LEN || !mesh_proto_is_frame(buf, len)) return false;
+    if (mesh_proto_type(buf) != MESH_MSG_SUMMARY) return false;
+
+    out->node_id    = mp_get_u16(&buf[4]);
+    out->seq_first  = mp_get_u16(&buf[6]);
+    out->seq_last   = mp_get_u16(&buf[8]);
+    out->samples    = mp_get_u16(&buf[10]);
+    out->span_ms    = mp_get_u32(&buf[12]);
+    out->field_mask = buf[16];
+    for (int i = 0; i < SUMMARY_FIELDS; i++) {
+        const uint8_t *p = &buf[18 + i * SUMMARY_FIELD_LEN];
+        out->f[i].count     = mp_get_u16(&p[0]);
+        out->f[i].min       = (int16_t)mp_get_u16(&p[2]);
+        out->f[i].max       = (int16_t)mp_get_u16(&p[4]);
+        out->f[i].last      = (int16_t)mp_get_u16(&p[6]);
+        out->f[i].mean_x100 = (int32_t)mp_get_u32(&p[8]);
+    }
+    return true;
+}
+
+int summary_to_json(const summary_t *s, char *out, size_t cap) {
+    int n = snprintf(out, cap,
+                     "{\"node_id\":\"Leaf_%02u\",\"event\":\"summary\",\"samples\":%u,"
+                     "\"seq_first\":%u,\"seq_last\":%u,\"span_ms\":%u",
+                     (unsigned)s->node_id, (unsigned)s->samples, (unsigned)s->seq_first,
+                     (unsigned)s->seq_last, (unsigned)s->span_ms);
+    for (int i = 0; i < SUMMARY_FIELDS && n > 0 && (size_t)n < cap; i++) {
+        if (!(s->field_mask & (1u << i))) continue;
+        const summary_stat_t *f = &s->f[i];
+        int32_t m = f->mean_x100;
+        n += snprintf(out + n, cap - n,
+                      ",\"%s\":{\"n\":%u,\"min\":%d,\"max\":%d,\"mean\":%s%d.%02d,\"last\":%d}",
+                      s_field_names[i], (unsigned)f->count, f->min, f->max,
+                      m < 0 ? "-" : "", (int)(abs(m) / 100), (int)(abs(m) % 100), f->last);
+    }
+    if (n > 0 && (size_t)n < cap) n += snprintf(out + n, cap - n, "}");
+    if (n < 0 || (size_t)n >= cap) return -1;
+    return n;
+}
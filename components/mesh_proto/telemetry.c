@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include "telemetry.h"
+
+// Độ dài frame theo các cờ trường tùy chọn
+static size_t telemetry_len(uint8_t flags) {
+    size_t len = TELEMETRY_FRAME_LEN;
+    if (flags & TLM_FLAG_LIGHT_MV) len += 2;
+    if (flags & TLM_FLAG_TX_TS)    len += 5;
+    return len;
+}
+
+size_t telemetry_encode(const telemetry_t *t, uint8_t *buf, size_t cap) {
+    size_t len = telemetry_len(t->flags);
+    if (cap < len) return 0;
+
+    mesh_proto_put_hdr(buf, MESH_MSG_TELEMETRY, t->flags);
+    mp_put_u16(&buf[4], t->node_id);
+    mp_put_u16(&buf[6], t->seq);
+    buf[8]  = (uint8_t)t->temp;
+    buf[9]  = t->humi;
+    mp_put_u16(&buf[10], t->light_raw);
+    buf[12] = t->motion ? 1 : 0;
+    size_t off = TELEMETRY_FRAME_LEN;
+    if (t->flags & TLM_FLAG_LIGHT_MV) {
+        mp_put_u16(&buf[off], t->light_mv);
+        off += 2;
+    }
+    if (t->flags & TLM_FLAG_TX_TS) {
+        mp_put_u32(&buf[off], t->tx_us);
+        buf[off + 4] = t->layer;
+    }
+    return len;
+}
+
+bool telemetry_decode(const uint8_t *buf, size_t len, telemetry_t *out) {
+    if (len < TELEMETRY_FRAME_LEN || !mesh_proto_is_frame(buf, len)) return false;
+    if (mesh_proto_type(buf) != MESH_MSG_TELEMETRY) return false;
+
+    out->flags     = buf[3];
+    out->node_id   = mp_get_u16(&buf[4]);
+    out->seq       = mp_get_u16(&buf[6]);
+    out->temp      = (int8_t)buf[8];
+    out->humi      = buf[9];
+    out->light_raw = mp_get_u16(&buf[10]);
+    out->motion    = buf[12];
+    out->light_mv  = 0;
+    out->tx_us     = 0;
+    out->layer     = 0;
+    if (len < telemetry_len(out->flags)) return false;
+
+    size_t off = TELEMETRY_FRAME_LEN;
+    if (out->flags & TLM_FLAG_LIGHT_MV) {
+        out->light_mv = mp_get_u16(&buf[off]);
+        off += 2;
+    }
+    if (out->flags & TLM_FLAG_TX_TS) {
+        out->tx_us = mp_get_u32(&buf[off]);
+        out->layer = buf[off + 4];
+    }
+    return true;
+}
+
+int telemetry_to_json(const telemetry_t *t, char *out, size_t cap) {
+    // leaf cũ không gửi light_mv -> ước lượng từ raw với Vref cố định
+    bool  cal     = (t->flags & TLM_FLAG_LIGHT_MV) != 0;
+    float light_v = cal ? (float)t->light_mv / 1000.0f
+                        : ((float)t->light_raw / TLM_LIGHT_RAW_MAX) * TLM_LIGHT_VREF;
+    int n = snprintf(out, cap,
+                     "{\"node_id\":\"Leaf_%02u\",\"role\":\"leaf\",\"temp\":%d,\"humi\":%u,"
+                     "\"light_v\":%.2f,\"light_raw\":%u,\"light_cal\":%s,\"motion\":%u,\"seq\":%u}",
+                     (unsigned)t->node_id, (int)t->temp, (unsigned)t->humi,
+                     light_v, (unsigned)t->light_raw, cal ? "true" : "false",
+                     (unsigned)t->motion, (unsigned)t->seq);
+    if (n < 0 || (size_t)n >= cap) return -1;
+    return n;
+}
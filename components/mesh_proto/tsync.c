@@ -0,0 +1,56 @@
+#include "tsync.h"
+
+size_t tsync_beacon_encode(const tsync_beacon_t *b, uint8_t *buf, size_t cap) {
+    if (cap < TSYNC_BEACON_LEN) return 0;
+
+    mesh_proto_put_hdr(buf, MESH_MSG_TIME_BEACON, b->flags);
+    mp_put_u16(&buf[4], b->seq);
+    mp_put_u32(&buf[6], (uint32_t)b->root_us);
+    mp_put_u32(&buf[10], (uint32_t)(b->root_us >> 32));
+    mp_put_u32(&buf[14], b->owd_us);
+    buf[18] = b->slot;
+    buf[19] = b->slots;
+    return TSYNC_BEACON_LEN;
+}
+
+bool tsync_beacon_decode(const uint8_t *buf, size_t len, tsync_beacon_t *out) {
+    if (len < TSYNC_BEACON_LEN || !mesh_proto_is_frame(buf, len)) return false;
+    if (mesh_proto_type(buf) != MESH_MSG_TIME_BEACON) return false;
+
+    out->flags   = buf[3];
+    out->seq     = mp_get_u16(&buf[4]);
+    out->root_us = mp_get_u32(&buf[6]) | ((uint64_t)mp_get_u32(&buf[10]) << 32);
+    out->owd_us  = mp_get_u32(&buf[14]);
+    out->slot    = buf[18];
+    out->slots   = buf[19];
+    // slot ngoài khoảng = không xếp lịch
+    if (!(out->flags & TSYNC_FLAG_SLOT) || out->slot >= out->slots) out->slots = 0;
+    return true;
+}
+
+size_t tsync_echo_encode(const tsync_echo_t *e, uint8_t *buf, size_t cap) {
+    if (cap < TSYNC_ECHO_LEN) return 0;
+
+    mesh_proto_put_hdr(buf, MESH_MSG_TIME_ECHO, e->flags);
+    mp_put_u16(&buf[4], e->node_id);
+    mp_put_u16(&buf[6], e->seq);
+    mp_put_u32(&buf[8], e->root_us);
+    mp_put_u32(&buf[12], e->hold_us);
+    mp_put_u32(&buf[16], e->leaf_us);
+    mp_put_u32(&buf[20], (uint32_t)e->err_us);
+    return TSYNC_ECHO_LEN;
+}
+
+bool tsync_echo_decode(const uint8_t *buf, size_t len, tsync_echo_t *out) {
+    if (len < TSYNC_ECHO_LEN || !mesh_proto_is_frame(buf, len)) return false;
+    if (mesh_proto_type(buf) != MESH_MSG_TIME_ECHO) return false;
+
+    out->flags   = buf[3];
+    out->node_id = mp_get_u16(&buf[4]);
+    out->seq     = mp_get_u16(&buf[6]);
+    out->root_us = mp_get_u32(&buf[8]);
+    out->hold_us = mp_get_u32(&buf[12]);
+    out->leaf_us = mp_get_u32(&buf[16]);
+    out->err_us  = (int32_t)mp_get_u32(&buf[20]);
+    return true;
+}
@@ -0,0 +1,52 @@
+#include <string.h>
+#include "test_util.h"
+#include "ldr_filter.h"
+
+// ==== Thông lượng ldr_filter: frame DMA 128 mẫu, cửa sổ 100ms @20 kHz, median 5..9 ====
+// 4 accumulator nhắm Xtensa (không SIMD); trên x86 gcc tự vector hóa vòng 1 accumulator
+// nên cột đó ở đây có thể nhanh hơn. Con số dùng để so giữa các lần đổi code trên cùng máy.
+#define FRAMES  200000
+
+// vòng cộng 1 accumulator như trước khi tách 4 accumulator
+static uint32_t __attribute__((noinline)) naive_sum(const uint16_t *x, size_t n) {
+    uint32_t s = 0;
+    for (size_t i = 0; i < n; i++) s += x[i];
+    return s;
+}
+
+int main(void) {
+    static uint16_t frame[128], win[2000];
+    uint32_t rng = 1;
+    for (int i = 0; i < 128; i++) frame[i] = (uint16_t)(test_rand(&rng) & 0x0FFF);
+    for (int i = 0; i < 2000; i++) win[i] = (uint16_t)(test_rand(&rng) & 0x0FFF);
+
+    uint64_t t0 = test_now_ns();
+    for (int k = 0; k < FRAMES; k++) {
+        frame[k & 127] ^= 1;
+        g_bench_sink += naive_sum(frame, 128);
+    }
+    uint64_t t1 = test_now_ns();
+    for (int k = 0; k < FRAMES; k++) {
+        frame[k & 127] ^= 1;
+        g_bench_sink += ldr_sum_u16(frame, 128);
+    }
+    uint64_t t2 = test_now_ns();
+    for (int k = 0; k < FRAMES / 16; k++) {
+        win[k % 2000] ^= 1;
+        g_bench_sink += ldr_mean_u16(win, 2000);
+    }
+    uint64_t t3 = test_now_ns();
+
+    printf("sum 128 mẫu: 1 accumulator %6.1f ns, ldr_sum_u16 %6.1f ns (%.2f ns/mẫu)\n",
+           (double)(t1 - t0) / FRAMES, (double)(t2 - t1) / FRAMES, (double)(t2 - t1) / FRAMES / 128);
+    printf("mean cửa sổ 2000 mẫu: %.0f ns\n", (double)(t3 - t2) / (FRAMES / 16));
+
+    for (uint8_t size = 1; size <= LDR_MEDIAN_MAX; size += 2) {
+        ldr_median_t m;
+        ldr_median_init(&m, size);
+        uint64_t a = test_now_ns();
+        for (int k = 0; k < FRAMES; k++) g_bench_sink += ldr_median_push(&m, (uint16_t)(test_rand(&rng) & 0x0FFF));
+        printf("median_push size %u: %5.1f ns\n", size, (double)(test_now_ns() - a) / FRAMES);
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <string.h>
+#include "test_util.h"
+#include "ssd1306_fb.h"
+#include "font8x8_basic.h"
+
+// ==== Byte trên bus I2C mỗi lần refresh OLED của leaf ====
+// Cách cũ: clear gửi cả 8 page, mỗi dòng text lại 3 lệnh + data,
+// mỗi lệnh / khối data là 1 transaction riêng (+1 byte địa chỉ, +1 control).
+// Cách mới: ssd1306_fb + 1 transaction cho hộp bao vùng đổi.
+#define REFRESHES   10000
+
+static uint32_t s_old_bytes;
+
+static void old_cmd(void)              { s_old_bytes += 1 + 2; }
+static void old_data(size_t n)         { s_old_bytes += 1 + 1 + (uint32_t)n; }
+
+static void old_clear(void) {
+    for (int p = 0; p < SSD1306_FB_PAGES; p++) {
+        old_cmd(); old_cmd(); old_cmd();
+        old_data(SSD1306_FB_COLS);
+    }
+}
+
+static void old_text(const char *s) {
+    size_t len = strlen(s);
+    if (len > 16) len = 16;
+    old_cmd(); old_cmd(); old_cmd();
+    old_data(len * 8);
+}
+
+static void fb_text(ssd1306_fb_t *fb, int row, const char *s) {
+    size_t len = strlen(s);
+    if (len > 16) len = 16;
+    for (size_t i = 0; i < len; i++) {
+        ssd1306_fb_write(fb, row, (int)i * 8, font8x8_basic_tr[(uint8_t)s[i]], 8, false);
+    }
+}
+
+int main(void) {
+    static ssd1306_fb_t fb;
+    static uint8_t tx[SSD1306_FB_FLUSH_MAX];
+    ssd1306_fb_init(&fb);
+
+    // Trace cảm biến trong phòng: nhiệt/ẩm đổi chậm, ánh sáng dao động nhỏ, motion thưa
+    uint32_t rng = 5, new_bytes = 0, flushes = 0;
+    int temp = 27, hum = 60, light_cv = 150, motion = 0;
+    uint64_t ns = 0;
+    for (int k = 0; k < REFRESHES; k++) {
+        if (test_rand(&rng) % 20 == 0) temp += (int)(test_rand(&rng) % 3) - 1;
+        if (test_rand(&rng) % 10 == 0) hum  += (int)(test_rand(&rng) % 3) - 1;
+        light_cv += (int)(test_rand(&rng) % 5) - 2;
+        if (light_cv < 0) light_cv = 0;
+        if (test_rand(&rng) % 30 == 0) motion = !motion;
+
+        char l2[24], l3[24], l4[24], l5[24];
+        snprintf(l2, sizeof(l2), "Temp:%dC", temp);
+        snprintf(l3, sizeof(l3), "Humi:%d%%", hum);
+        snprintf(l4, sizeof(l4), "Light:%d.%02dV", light_cv / 100, light_cv % 100);
+        snprintf(l5, sizeof(l5), "Motion:%s", motion ? "YES" : "NO");
+
+        old_clear();
+        old_text("Node: Leaf_01"); old_text(l2); old_text(l3); old_text(l4); old_text(l5);
+
+        uint64_t t0 = test_now_ns();
+        ssd1306_fb_clear(&fb);
+        fb_text(&fb, 0, "Node: Leaf_01");
+        fb_text(&fb, 2, l2); fb_text(&fb, 3, l3); fb_text(&fb, 4, l4); fb_text(&fb, 5, l5);
+        ssd1306_region_t r;
+        if (ssd1306_fb_dirty_region(&fb, &r)) {
+            size_t n = ssd1306_fb_build_flush(&fb, &r, tx, sizeof(tx));
+            ssd1306_fb_commit(&fb, &r);
+            new_bytes += (uint32_t)n + 1;
+            flushes++;
+            g_bench_sink += tx[n - 1];
+        }
+        ns += test_now_ns() - t0;
+    }
+
+    double old_avg = (double)s_old_bytes / REFRESHES, new_avg = (double)new_bytes / REFRESHES;
+    printf("cũ : %7.1f B/refresh, %u transaction/refresh\n", old_avg, 8 * 4 + 5 * 4);
+    printf("mới: %7.1f B/refresh, %u/%u refresh có gửi, %.0f ns CPU/refresh\n",
+           new_avg, flushes, REFRESHES, (double)ns / REFRESHES);
+    printf("bus @400 kHz (~9 bit/byte): %.2f ms -> %.2f ms mỗi refresh, giảm %.0fx\n",
+           old_avg * 9 / 400.0, new_avg * 9 / 400.0, old_avg / new_avg);
+    return 0;
+}
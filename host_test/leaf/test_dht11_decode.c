@@ -0,0 +1,159 @@
+#include <string.h>
+#include "test_util.h"
+#include "dht11_decode.h"
+
+// ==== dht11_decode với chuỗi xung dạng RMT capture ====
+// Thứ tự xung như _symbolsToPulses đưa ra: đuôi HIGH của tín hiệu start,
+// preamble LOW/HIGH ~80us, 40 bit, LOW kết thúc. Độ rộng dao động trong
+// khoảng datasheet (LOW 48-56us, bit 0 HIGH 23-29us, bit 1 HIGH 68-74us).
+
+// humi 55.0 %, temp 27.0 C, checksum 0x52
+static const dht11_pulse_t k_frame_55_27[] = {
+    {1, 31}, {0, 82}, {1, 86}, {0, 55}, {1, 29}, {0, 56}, {1, 29}, {0, 55}, {1, 71}, {0, 56},
+    {1, 74}, {0, 51}, {1, 24}, {0, 56}, {1, 71}, {0, 50}, {1, 68}, {0, 55}, {1, 70}, {0, 50},
+    {1, 23}, {0, 56}, {1, 29}, {0, 48}, {1, 27}, {0, 54}, {1, 26}, {0, 50}, {1, 27}, {0, 48},
+    {1, 29}, {0, 56}, {1, 23}, {0, 48}, {1, 23}, {0, 51}, {1, 24}, {0, 48}, {1, 29}, {0, 55},
+    {1, 25}, {0, 55}, {1, 72}, {0, 51}, {1, 72}, {0, 51}, {1, 28}, {0, 52}, {1, 71}, {0, 48},
+    {1, 73}, {0, 49}, {1, 26}, {0, 52}, {1, 26}, {0, 56}, {1, 29}, {0, 49}, {1, 28}, {0, 52},
+    {1, 25}, {0, 51}, {1, 27}, {0, 52}, {1, 23}, {0, 49}, {1, 27}, {0, 49}, {1, 26}, {0, 49},
+    {1, 74}, {0, 52}, {1, 26}, {0, 49}, {1, 68}, {0, 48}, {1, 24}, {0, 51}, {1, 23}, {0, 55},
+    {1, 71}, {0, 54}, {1, 26}, {0, 54},
+};
+
+// humi 65.0 %, temp 24.5 C, checksum 0x5E
+static const dht11_pulse_t k_frame_65_24[] = {
+    {1, 31}, {0, 82}, {1, 86}, {0, 49}, {1, 27}, {0, 51}, {1, 74}, {0, 52}, {1, 25}, {0, 49},
+    {1, 25}, {0, 53}, {1, 23}, {0, 54}, {1, 29}, {0, 49}, {1, 24}, {0, 51}, {1, 73}, {0, 49},
+    {1, 23}, {0, 48}, {1, 26}, {0, 55}, {1, 24}, {0, 56}, {1, 24}, {0, 55}, {1, 27}, {0, 51},
+    {1, 28}, {0, 50}, {1, 26}, {0, 54}, {1, 23}, {0, 54}, {1, 26}, {0, 51}, {1, 23}, {0, 52},
+    {1, 29}, {0, 52}, {1, 68}, {0, 51}, {1, 69}, {0, 54}, {1, 29}, {0, 49}, {1, 23}, {0, 50},
+    {1, 24}, {0, 55}, {1, 25}, {0, 48}, {1, 29}, {0, 53}, {1, 29}, {0, 52}, {1, 26}, {0, 49},
+    {1, 23}, {0, 49}, {1, 69}, {0, 51}, {1, 23}, {0, 53}, {1, 70}, {0, 55}, {1, 24}, {0, 55},
+    {1, 74}, {0, 50}, {1, 29}, {0, 54}, {1, 69}, {0, 50}, {1, 70}, {0, 51}, {1, 74}, {0, 51},
+    {1, 73}, {0, 51}, {1, 24}, {0, 54},
+};
+
+#define N_FRAME     (sizeof(k_frame_55_27) / sizeof(k_frame_55_27[0]))
+#define FIRST_BIT   3       // chỉ số xung LOW của bit 0
+
+static dht11_decode_result_t decode(const dht11_pulse_t *p, size_t n, uint8_t out[5]) {
+    memset(out, 0xAA, 5);
+    return dht11_decode(p, n, out);
+}
+
+static void test_recorded(void) {
+    uint8_t out[5];
+    CHECK_EQ(decode(k_frame_55_27, N_FRAME, out), DHT11_DECODE_OK);
+    CHECK_EQ(out[0], 55);
+    CHECK_EQ(out[1], 0);
+    CHECK_EQ(out[2], 27);
+    CHECK_EQ(out[3], 0);
+
+    CHECK_EQ(decode(k_frame_65_24, N_FRAME, out), DHT11_DECODE_OK);
+    CHECK_EQ(out[0], 65);
+    CHECK_EQ(out[2], 24);
+    CHECK_EQ(out[3], 5);
+
+    // capture bắt đầu trễ: mất preamble, vẫn đủ 40 bit
+    CHECK_EQ(decode(&k_frame_55_27[FIRST_BIT], N_FRAME - FIRST_BIT, out), DHT11_DECODE_OK);
+    CHECK_EQ(out[0], 55);
+
+    // thiếu LOW kết thúc (RMT dừng sớm)
+    CHECK_EQ(decode(k_frame_55_27, N_FRAME - 1, out), DHT11_DECODE_OK);
+
+    // xung rác + line idle trước frame: lấy 40 cặp cuối
+    dht11_pulse_t p[DHT11_MAX_PULSES];
+    const dht11_pulse_t junk[] = { {0, 40}, {1, 30}, {0, 60}, {1, 900}, {0, 50}, {1, 25} };
+    memcpy(p, junk, sizeof(junk));
+    memcpy(&p[6], k_frame_65_24, sizeof(k_frame_65_24));
+    CHECK_EQ(decode(p, 6 + N_FRAME, out), DHT11_DECODE_OK);
+    CHECK_EQ(out[0], 65);
+}
+
+static void test_truncated(void) {
+    uint8_t out[5];
+    // mỗi bit = 2 xung. Thiếu 1 bit: cặp preamble (LOW 82 / HIGH 86) lọt vào làm bit 1,
+    // cả frame lệch 1 bit -> checksum bắt được. Thiếu từ 2 bit: không đủ 40 cặp.
+    CHECK_EQ(decode(k_frame_55_27, N_FRAME - 1 - 2, out), DHT11_DECODE_CRC_ERROR);
+    for (size_t cut = 2; cut <= 40; cut += 7) {
+        CHECK_EQ(decode(k_frame_55_27, N_FRAME - 1 - 2 * cut, out), DHT11_DECODE_FRAME_ERROR);
+    }
+    // mất preamble và 1 bit đầu
+    CHECK_EQ(decode(&k_frame_55_27[FIRST_BIT + 2], N_FRAME - FIRST_BIT - 2, out), DHT11_DECODE_FRAME_ERROR);
+
+    // idle dài bất thường (> HIGH_MAX) giữa frame: cặp đó bị bỏ
+    dht11_pulse_t p[N_FRAME];
+    memcpy(p, k_frame_55_27, sizeof(p));
+    p[FIRST_BIT + 2 * 20 + 1].us = DHT11_BIT_HIGH_MAX_US + 1;
+    CHECK(decode(p, N_FRAME, out) != DHT11_DECODE_OK);
+    CHECK_EQ(decode(&p[FIRST_BIT], N_FRAME - FIRST_BIT, out), DHT11_DECODE_FRAME_ERROR);
+
+    CHECK_EQ(decode(k_frame_55_27, 0, out), DHT11_DECODE_FRAME_ERROR);
+    CHECK_EQ(decode(k_frame_55_27, 1, out), DHT11_DECODE_FRAME_ERROR);
+}
+
+static void test_crc_error(void) {
+    uint8_t out[5];
+    dht11_pulse_t p[N_FRAME];
+
+    // bit cao nhất của humi: 0 -> 1
+    memcpy(p, k_frame_55_27, sizeof(p));
+    p[FIRST_BIT + 1].us = 70;
+    CHECK_EQ(decode(p, N_FRAME, out), DHT11_DECODE_CRC_ERROR);
+
+    // bit checksum: 1 -> 0
+    memcpy(p, k_frame_65_24, sizeof(p));
+    p[FIRST_BIT + 2 * 33 + 1].us = 26;
+    CHECK_EQ(decode(p, N_FRAME, out), DHT11_DECODE_CRC_ERROR);
+}
+
+// Biên độ rộng xung
+static void test_edges(void) {
+    uint8_t out[5];
+    dht11_pulse_t p[N_FRAME];
+    size_t hi0 = FIRST_BIT + 2 * 1 + 1;     // bit 1 của humi = 0
+    size_t hi1 = FIRST_BIT + 2 * 2 + 1;     // bit 2 của humi = 1
+
+    memcpy(p, k_frame_55_27, sizeof(p));
+    p[hi0].us = DHT11_BIT_ONE_US;
+    p[hi1].us = DHT11_BIT_ONE_US + 1;
+    CHECK_EQ(decode(p, N_FRAME, out), DHT11_DECODE_OK);
+
+    p[hi1].us = DHT11_BIT_HIGH_MAX_US;
+    CHECK_EQ(decode(p, N_FRAME, out), DHT11_DECODE_OK);
+
+    p[hi0].us = DHT11_BIT_HIGH_MIN_US;
+    CHECK_EQ(decode(p, N_FRAME, out), DHT11_DECODE_OK);
+    p[hi0].us = DHT11_BIT_HIGH_MIN_US - 1;
+    CHECK_EQ(decode(p, N_FRAME, out), DHT11_DECODE_FRAME_ERROR);
+
+    memcpy(p, k_frame_55_27, sizeof(p));
+    p[FIRST_BIT].us = DHT11_BIT_LOW_MIN_US;
+    p[FIRST_BIT + 2].us = DHT11_BIT_LOW_MAX_US;
+    CHECK_EQ(decode(p, N_FRAME, out), DHT11_DECODE_OK);
+    p[FIRST_BIT].us = DHT11_BIT_LOW_MIN_US - 1;
+    CHECK_EQ(decode(p, N_FRAME, out), DHT11_DECODE_FRAME_ERROR);
+    p[FIRST_BIT].us = DHT11_BIT_LOW_MAX_US + 1;
+    CHECK_EQ(decode(p, N_FRAME, out), DHT11_DECODE_FRAME_ERROR);
+}
+
+// Nhiều xung hơn DHT11_MAX_PULSES: chỉ xét phần đầu, không tràn mảng tạm
+static void test_overlong(void) {
+    uint8_t out[5];
+    dht11_pulse_t p[2 * DHT11_MAX_PULSES];
+    for (size_t i = 0; i < 2 * DHT11_MAX_PULSES; i++) {
+        p[i] = (dht11_pulse_t){ (uint8_t)(i & 1 ? 1 : 0), (uint16_t)(i & 1 ? 26 : 50) };
+    }
+    // 64 cặp bit 0: checksum 0 == tổng 0
+    CHECK_EQ(decode(p, 2 * DHT11_MAX_PULSES, out), DHT11_DECODE_OK);
+    CHECK_EQ(out[0], 0);
+}
+
+int main(void) {
+    test_recorded();
+    test_truncated();
+    test_crc_error();
+    test_edges();
+    test_overlong();
+    return TEST_RESULT();
+}
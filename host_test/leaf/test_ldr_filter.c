@@ -0,0 +1,124 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_util.h"
+#include "ldr_filter.h"
+
+// ==== ldr_filter: so với cài đặt tham chiếu đơn giản ====
+static int cmp_u16(const void *a, const void *b) {
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+static uint16_t ref_median(const uint16_t *x, size_t n) {
+    uint16_t t[64];
+    memcpy(t, x, n * sizeof(t[0]));
+    qsort(t, n, sizeof(t[0]), cmp_u16);
+    return (n & 1) ? t[n / 2] : (uint16_t)(((uint32_t)t[n / 2 - 1] + t[n / 2] + 1) / 2);
+}
+
+static void test_sum_mean(void) {
+    uint32_t rng = 3;
+    uint16_t x[300] = {0};
+    // mọi độ dài quanh bội số 4 (phần đuôi), giá trị ADC 12 bit tối đa
+    for (size_t n = 0; n <= 300; n++) {
+        uint32_t ref = 0;
+        for (size_t i = 0; i < n; i++) {
+            x[i] = (n % 7 == 0) ? 4095 : (uint16_t)(test_rand(&rng) & 0x0FFF);
+            ref += x[i];
+        }
+        CHECK_EQ(ldr_sum_u16(x, n), ref);
+        CHECK_EQ(ldr_mean_u16(x, n), n ? (ref + n / 2) / n : 0);
+    }
+    // làm tròn: 1,2 -> 2 ; 1,1,2 -> 1
+    const uint16_t a[] = { 1, 2 }, b[] = { 1, 1, 2 };
+    CHECK_EQ(ldr_mean_u16(a, 2), 2);
+    CHECK_EQ(ldr_mean_u16(b, 3), 1);
+    // 65535 mẫu 16 bit vẫn không tràn uint32
+    static uint16_t big[65535];
+    for (size_t i = 0; i < 65535; i++) big[i] = 65535;
+    CHECK_EQ(ldr_sum_u16(big, 65535), 65535u * 65535u);
+    CHECK_EQ(ldr_mean_u16(big, 65535), 65535);
+}
+
+static void test_median(void) {
+    uint32_t rng = 17;
+    for (int round = 0; round < 2000; round++) {
+        size_t n = 1 + test_rand(&rng) % 40;
+        uint16_t x[64];
+        for (size_t i = 0; i < n; i++) x[i] = (uint16_t)(test_rand(&rng) % (round % 3 ? 4096 : 4));
+        uint16_t want = ref_median(x, n);
+        CHECK_EQ(ldr_median_u16(x, n), want);
+        for (size_t i = 1; i < n; i++) CHECK(x[i - 1] <= x[i]);
+    }
+    CHECK_EQ(ldr_median_u16(NULL, 0), 0);
+    uint16_t e[] = { 4095, 4094 };
+    CHECK_EQ(ldr_median_u16(e, 2), 4095);
+}
+
+static void test_window(void) {
+    ldr_median_t m;
+    ldr_median_init(&m, 0);
+    CHECK_EQ(m.size, 1);
+    ldr_median_init(&m, 4);
+    CHECK_EQ(m.size, 5);
+    ldr_median_init(&m, 200);
+    CHECK_EQ(m.size, LDR_MEDIAN_MAX);
+
+    // trong lúc đầy dần: trung vị của những gì đã có; sau đó cửa sổ trượt đúng 5 phần tử cuối
+    ldr_median_init(&m, 5);
+    uint32_t rng = 5;
+    uint16_t hist[200];
+    for (size_t k = 0; k < 200; k++) {
+        hist[k] = (uint16_t)(test_rand(&rng) % 4096);
+        size_t have = k + 1 < 5 ? k + 1 : 5;
+        CHECK_EQ(ldr_median_push(&m, hist[k]), ref_median(&hist[k + 1 - have], have));
+    }
+
+    // gai đơn lẻ (đèn flash, nhiễu WiFi) bị loại hoàn toàn
+    ldr_median_init(&m, 5);
+    for (int k = 0; k < 5; k++) ldr_median_push(&m, 1200);
+    CHECK_EQ(ldr_median_push(&m, 4095), 1200);
+    CHECK_EQ(ldr_median_push(&m, 1210), 1200);
+    CHECK_EQ(ldr_median_push(&m, 0), 1200);
+    // bậc thang thật được theo sau size/2 + 1 cửa sổ
+    uint16_t out = 0;
+    for (int k = 0; k < 3; k++) out = ldr_median_push(&m, 2000);
+    CHECK_EQ(out, 2000);
+}
+
+// Đèn 50 Hz nhấp nháy 100 Hz quanh mức thật + gai: 1 mẫu đơn lệch lớn,
+// boxcar 100ms (5 chu kỳ) + trung vị 5 cửa sổ bám sát mức thật
+static void test_flicker(void) {
+    const double rate = 20000, level = 1800, flicker = 400;
+    uint32_t rng = 77;
+    ldr_median_t m;
+    ldr_median_init(&m, 5);
+    double worst_single = 0, worst_filtered = 0;
+    uint16_t win[2000];
+
+    for (int w = 0; w < 50; w++) {
+        for (int i = 0; i < 2000; i++) {
+            double t = (w * 2000 + i) / rate;
+            double v = level + flicker * sin(2 * M_PI * 100 * t) + (int)(test_rand(&rng) % 41) - 20;
+            if (test_rand(&rng) % 5000 == 0) v = 4095;
+            win[i] = (uint16_t)(v < 0 ? 0 : v > 4095 ? 4095 : v);
+        }
+        // 1 cửa sổ trong 10 bị gai dài (vd bóng người che)
+        if (w % 10 == 3) for (int i = 0; i < 2000; i++) win[i] = 200;
+        double single = fabs((double)win[w * 37 % 2000] - level);
+        uint16_t out = ldr_median_push(&m, ldr_mean_u16(win, 2000));
+        if (w % 10 != 3 && single > worst_single) worst_single = single;
+        if (w >= 5 && fabs((double)out - level) > worst_filtered) worst_filtered = fabs((double)out - level);
+    }
+    printf("flicker 100Hz ±%.0f: 1 mẫu lệch tới %.0f, sau lọc lệch tới %.0f\n",
+           flicker, worst_single, worst_filtered);
+    CHECK(worst_filtered <= 10);
+}
+
+int main(void) {
+    test_sum_mean();
+    test_median();
+    test_window();
+    test_flicker();
+    return TEST_RESULT();
+}
@@ -0,0 +1,187 @@
+#include <string.h>
+#include "test_util.h"
+#include "parent_select.h"
+
+// ==== parent_select: công thức điểm, điều kiện loại, hysteresis / dwell ====
+static ps_obs_t obs(uint8_t id, int8_t rssi, uint8_t layer, uint8_t assoc, uint8_t cap) {
+    ps_obs_t o = { .bssid = { 0x24, 0x6F, 0x28, 0, 0, id }, .channel = 6, .rssi = rssi,
+                   .layer = layer, .assoc = assoc, .assoc_cap = cap };
+    strcpy(o.ssid, "MESH");
+    return o;
+}
+
+static ps_cand_t *cand_of(parent_select_t *ps, uint8_t id) {
+    for (int i = 0; i < PS_MAX_CAND; i++) {
+        if (ps->cand[i].used && ps->cand[i].obs.bssid[5] == id) return &ps->cand[i];
+    }
+    return NULL;
+}
+
+static int32_t score_of(parent_select_t *ps, uint8_t id, uint32_t now) {
+    ps_cand_t *c = cand_of(ps, id);
+    return c ? ps_score(ps, c, now) : PS_SCORE_INVALID;
+}
+
+static void test_score(void) {
+    parent_select_t ps;
+    ps_init(&ps, NULL);
+    ps_obs_t o;
+
+    // 2*(−60+90) − 15*(2−1) − 40*(3+1)/6 = 60 − 15 − 26
+    o = obs(1, -60, 2, 3, 6); ps_observe(&ps, &o, 0);
+    CHECK_EQ(score_of(&ps, 1, 0), 19);
+    // RSSI trên trần không cộng thêm; không rõ cap thì không trừ tải
+    o = obs(2, -30, 1, 9, 0); ps_observe(&ps, &o, 0);
+    CHECK_EQ(score_of(&ps, 2, 0), 2 * (-45 + 90));
+
+    // loại: RSSI dưới sàn, layer 0 / quá sâu, parent đầy, lâu không thấy
+    o = obs(3, -91, 1, 0, 6); ps_observe(&ps, &o, 0);
+    CHECK_EQ(score_of(&ps, 3, 0), PS_SCORE_INVALID);
+    o = obs(3, -90, 1, 0, 6); ps_observe(&ps, &o, 0);
+    CHECK(score_of(&ps, 3, 0) != PS_SCORE_INVALID);
+    o = obs(4, -50, 0, 0, 6); ps_observe(&ps, &o, 0);
+    CHECK_EQ(score_of(&ps, 4, 0), PS_SCORE_INVALID);
+    o = obs(4, -50, 6, 0, 6); ps_observe(&ps, &o, 0);
+    CHECK_EQ(score_of(&ps, 4, 0), PS_SCORE_INVALID);
+    o = obs(4, -50, 5, 0, 6); ps_observe(&ps, &o, 0);
+    CHECK(score_of(&ps, 4, 0) != PS_SCORE_INVALID);
+    o = obs(5, -50, 1, 6, 6); ps_observe(&ps, &o, 0);
+    CHECK_EQ(score_of(&ps, 5, 0), PS_SCORE_INVALID);
+    CHECK(score_of(&ps, 1, ps.cfg.stale_ms) != PS_SCORE_INVALID);
+    CHECK_EQ(score_of(&ps, 1, ps.cfg.stale_ms + 1), PS_SCORE_INVALID);
+
+    // parent hiện tại đã đếm mình trong assoc: đầy vẫn hợp lệ, tải tính như trước khi vào
+    uint8_t b5[6] = { 0x24, 0x6F, 0x28, 0, 0, 5 };
+    ps_set_current(&ps, b5, 0);
+    CHECK_EQ(score_of(&ps, 5, 0), 2 * 40 - 40 * 6 / 6);
+}
+
+static void test_fail_decay(void) {
+    parent_select_t ps;
+    ps_init(&ps, NULL);
+    ps_obs_t o = obs(1, -60, 1, 0, 0);
+    ps_observe(&ps, &o, 0);
+    int32_t base = score_of(&ps, 1, 0);
+
+    ps_link_failed(&ps, o.bssid, 1000);
+    ps_link_failed(&ps, o.bssid, 2000);
+    CHECK_EQ(score_of(&ps, 1, 2000), base - 2 * ps.cfg.w_fail);
+    CHECK_EQ(score_of(&ps, 1, 2000 + ps.cfg.fail_decay_ms - 1), base - 2 * ps.cfg.w_fail);
+    CHECK_EQ(score_of(&ps, 1, 2000 + ps.cfg.fail_decay_ms), base - ps.cfg.w_fail);
+    ps_observe(&ps, &o, 200000);
+    CHECK_EQ(score_of(&ps, 1, 200000), base);
+
+    // bssid lạ: bỏ qua
+    uint8_t other[6] = { 1, 2, 3, 4, 5, 6 };
+    ps_link_failed(&ps, other, 0);
+}
+
+static void test_select(void) {
+    parent_select_t ps;
+    ps_init(&ps, NULL);
+    CHECK(ps_select(&ps, 0) == NULL);
+
+    // chưa có parent: chọn điểm cao nhất; RSSI như nhau thì relay rảnh hơn
+    ps_obs_t a = obs(1, -55, 2, 5, 6), b = obs(2, -55, 2, 1, 6), c = obs(3, -40, 4, 0, 6);
+    ps_observe(&ps, &a, 0);
+    ps_observe(&ps, &b, 0);
+    ps_observe(&ps, &c, 0);
+    const ps_cand_t *best = ps_select(&ps, 0);
+    CHECK(best && best->obs.bssid[5] == 2);
+
+    // đang ở b: không đề xuất chính nó
+    ps_set_current(&ps, b.bssid, 0);
+    CHECK(ps_select(&ps, 1000) == NULL);
+
+    // a trở nên tốt hơn hẳn nhưng chưa đủ dwell
+    a = obs(1, -45, 1, 0, 6);
+    ps_observe(&ps, &a, 1000);
+    CHECK(ps_select(&ps, ps.cfg.min_dwell_ms - 1) == NULL);
+    ps_observe(&ps, &a, ps.cfg.min_dwell_ms);
+    ps_observe(&ps, &b, ps.cfg.min_dwell_ms);
+    ps_observe(&ps, &c, ps.cfg.min_dwell_ms);
+    best = ps_select(&ps, ps.cfg.min_dwell_ms);
+    CHECK(best && best->obs.bssid[5] == 1);
+
+    // hysteresis: hơn hysteresis - 1 thì giữ, hơn đúng hysteresis thì đổi
+    ps_init(&ps, NULL);
+    uint32_t t = 0;
+    a = obs(1, -70, 1, 0, 0);
+    b = obs(2, -70, 1, 0, 0);
+    ps_observe(&ps, &a, t);
+    ps_observe(&ps, &b, t);
+    ps_set_current(&ps, a.bssid, t);
+    t += ps.cfg.min_dwell_ms;
+    b.rssi = (int8_t)(-70 + (ps.cfg.hysteresis - 1) / ps.cfg.w_rssi);
+    ps_observe(&ps, &b, t);
+    CHECK(score_of(&ps, 2, t) - score_of(&ps, 1, t) < ps.cfg.hysteresis);
+    CHECK(ps_select(&ps, t) == NULL);
+    b.rssi = (int8_t)(-70 + ps.cfg.hysteresis / ps.cfg.w_rssi);
+    ps_observe(&ps, &b, t);
+    CHECK_EQ(score_of(&ps, 2, t) - score_of(&ps, 1, t), ps.cfg.hysteresis);
+    CHECK(ps_select(&ps, t) != NULL);
+
+    // parent hiện tại không còn dùng được (RSSI dưới sàn): đổi không cần hysteresis
+    a.rssi = -95;
+    b.rssi = -88;
+    ps_observe(&ps, &a, t);
+    ps_observe(&ps, &b, t);
+    best = ps_select(&ps, t);
+    CHECK(best && best->obs.bssid[5] == 2);
+}
+
+// Bảng đầy: ứng viên thấy lâu nhất bị thay
+static void test_table_full(void) {
+    parent_select_t ps;
+    ps_init(&ps, NULL);
+    for (int i = 0; i < PS_MAX_CAND; i++) {
+        ps_obs_t o = obs((uint8_t)(10 + i), -60, 1, 0, 0);
+        ps_observe(&ps, &o, (uint32_t)(i == 5 ? 0 : 1000 + i));
+    }
+    ps_obs_t o = obs(99, -60, 1, 0, 0);
+    ps_observe(&ps, &o, 5000);
+    CHECK(cand_of(&ps, 99) != NULL);
+    CHECK(cand_of(&ps, 15) == NULL);
+    CHECK(cand_of(&ps, 14) != NULL && cand_of(&ps, 16) != NULL);
+}
+
+// 2 relay ngang nhau, RSSI dao động ±4 dB mỗi lần scan (30s) trong 24h:
+// đếm số lần đổi parent có và không có hysteresis/dwell
+static uint32_t count_switches(const ps_cfg_t *cfg) {
+    parent_select_t ps;
+    ps_init(&ps, cfg);
+    uint32_t rng = 42, switches = 0;
+    for (uint32_t t = 0; t < 24u * 3600 * 1000; t += 30000) {
+        for (uint8_t id = 1; id <= 2; id++) {
+            ps_obs_t o = obs(id, (int8_t)(-68 + (int)(test_rand(&rng) % 9) - 4), 2, 2, 6);
+            ps_observe(&ps, &o, t);
+        }
+        const ps_cand_t *c = ps_select(&ps, t);
+        if (c) {
+            if (ps.has_cur) switches++;
+            ps_set_current(&ps, c->obs.bssid, t);
+        }
+    }
+    return switches;
+}
+
+static void test_flap(void) {
+    ps_cfg_t cfg;
+    ps_default_cfg(&cfg);
+    uint32_t with = count_switches(&cfg);
+    cfg.hysteresis = 0;
+    cfg.min_dwell_ms = 0;
+    uint32_t without = count_switches(&cfg);
+    printf("RSSI ±4 dB, 24h: %u lần đổi parent không hysteresis, %u lần với mặc định\n", without, with);
+    CHECK(without > 200);
+    CHECK(with * 20 < without);
+}
+
+int main(void) {
+    test_score();
+    test_fail_decay();
+    test_select();
+    test_table_full();
+    test_flap();
+    return TEST_RESULT();
+}
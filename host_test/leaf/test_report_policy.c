@@ -0,0 +1,142 @@
+#include <math.h>
+#include <string.h>
+#include "test_util.h"
+#include "report_policy.h"
+
+// ==== report_policy: quy tắc từng nhánh + phát lại trace 24h ====
+#define ALL_VALID   ((1u << RP_SENSOR_COUNT) - 1)
+
+static void test_rules(void) {
+    report_policy_cfg_t cfg;
+    report_policy_t rp;
+    report_policy_default(&cfg);
+    CHECK(report_policy_validate(&cfg));
+    report_policy_init(&rp, &cfg);
+
+    int32_t v[RP_SENSOR_COUNT] = { 27, 60, 1500, 0 };
+    CHECK_EQ(report_policy_evaluate(&rp, 0, v, ALL_VALID), RP_REASON_FIRST);
+    report_policy_commit(&rp, 0, v, ALL_VALID);
+
+    // không đổi: im lặng tới heartbeat; slot lệch vài tick vẫn tính đủ 60s
+    CHECK_EQ(report_policy_evaluate(&rp, 55000, v, ALL_VALID), RP_REASON_NONE);
+    CHECK_EQ(report_policy_evaluate(&rp, 60000 - REPORT_SLACK_MS, v, ALL_VALID), RP_REASON_HEARTBEAT);
+    report_policy_commit(&rp, 59950, v, ALL_VALID);
+
+    // dưới deadband / trong min_interval -> không gửi
+    v[RP_HUMI] = 62;
+    v[RP_LIGHT] = 1599;
+    CHECK_EQ(report_policy_evaluate(&rp, 64950, v, ALL_VALID), RP_REASON_NONE);
+    v[RP_TEMP] = 28;
+    CHECK_EQ(report_policy_evaluate(&rp, 62000, v, ALL_VALID), RP_REASON_NONE);
+    CHECK_EQ(report_policy_evaluate(&rp, 64950, v, ALL_VALID), RP_REASON_CHANGE);
+    report_policy_commit(&rp, 64950, v, ALL_VALID);
+
+    // motion: min_interval 0, gửi ngay
+    v[RP_MOTION] = 1;
+    CHECK_EQ(report_policy_evaluate(&rp, 65000, v, ALL_VALID), RP_REASON_CHANGE);
+    report_policy_commit(&rp, 65000, v, ALL_VALID);
+
+    // DHT11 lỗi: temp/humi không hợp lệ, không gây gửi và không đè mốc cũ
+    int32_t bad[RP_SENSOR_COUNT] = { 0, 0, 1500, 1 };
+    uint32_t no_dht = ALL_VALID & ~((1u << RP_TEMP) | (1u << RP_HUMI));
+    CHECK_EQ(report_policy_evaluate(&rp, 80000, bad, no_dht), RP_REASON_NONE);
+    report_policy_commit(&rp, 80000, bad, no_dht);
+    CHECK_EQ(rp.last[RP_TEMP], 28);
+    CHECK_EQ(rp.last[RP_HUMI], 62);
+    CHECK_EQ(rp.last[RP_LIGHT], 1500);
+
+    // đổi tham số lúc chạy: giữ mốc, deadband mới có hiệu lực ngay
+    report_policy_cfg_t tight = cfg;
+    tight.sensor[RP_LIGHT].deadband = 50;
+    report_policy_apply(&rp, &tight);
+    v[RP_LIGHT] = 1560;
+    CHECK_EQ(report_policy_evaluate(&rp, 86000, v, ALL_VALID), RP_REASON_CHANGE);
+    CHECK_EQ(rp.last_tx_ms, 80000);
+
+    // validate kẹp tham số, từ chối version lạ
+    report_policy_cfg_t c = cfg;
+    c.sample_ms = 500;
+    c.sensor[RP_TEMP].deadband = -4;
+    c.sensor[RP_HUMI].max_interval_ms = 1000;
+    c.sensor[RP_LIGHT].min_interval_ms = 120000;
+    CHECK(report_policy_validate(&c));
+    CHECK_EQ(c.sample_ms, REPORT_MIN_SAMPLE_MS);
+    CHECK_EQ(c.sensor[RP_TEMP].deadband, 0);
+    CHECK_EQ(c.sensor[RP_HUMI].max_interval_ms, REPORT_MIN_SAMPLE_MS);
+    CHECK_EQ(c.sensor[RP_LIGHT].min_interval_ms, c.sensor[RP_LIGHT].max_interval_ms);
+    c.version = REPORT_POLICY_VERSION + 1;
+    CHECK(!report_policy_validate(&c));
+}
+
+// Trace 24h lấy mẫu 5s: nhiệt/ẩm theo ngày đêm (DHT11 số nguyên), ánh sáng mV theo
+// mặt trời + mây, PIR theo cụm trong giờ hành chính, DHT11 lỗi ~1%.
+// Trước đây leaf gửi mọi mẫu; giờ chỉ gửi theo report_policy.
+static void test_trace_replay(void) {
+    report_policy_cfg_t cfg;
+    report_policy_t rp;
+    report_policy_default(&cfg);
+    report_policy_init(&rp, &cfg);
+
+    const uint32_t step = cfg.sample_ms, n = 24u * 3600 * 1000 / step;
+    uint32_t rng = 2024, motion_left = 0;
+    uint32_t by_reason[4] = {0}, max_gap = 0, last_tx = 0, stale_violations = 0;
+    int32_t cloud = 0;
+
+    for (uint32_t k = 0; k < n; k++) {
+        uint32_t t = k * step;
+        double h = (double)t / 3600000.0;
+        double day = sin((h - 9.0) / 24.0 * 2 * M_PI);
+        double sun = sin((h - 6.0) / 12.0 * M_PI);
+
+        int32_t v[RP_SENSOR_COUNT];
+        v[RP_TEMP] = (int32_t)lround(27.5 + 3.5 * day + ((int)(test_rand(&rng) % 3) - 1) * 0.3);
+        v[RP_HUMI] = (int32_t)lround(65.0 - 10.0 * day) + (int32_t)(test_rand(&rng) % 3) - 1;
+        cloud += (int32_t)(test_rand(&rng) % 41) - 20;
+        if (cloud < -300) cloud = -300;
+        if (cloud > 0) cloud = 0;
+        v[RP_LIGHT] = (sun > 0 ? (int32_t)(2800 * sun) + cloud : 40) + (int32_t)(test_rand(&rng) % 21) - 10;
+        if (v[RP_LIGHT] < 0) v[RP_LIGHT] = 0;
+        if (!motion_left && h > 8 && h < 18 && test_rand(&rng) % 400 == 0) motion_left = 2 + test_rand(&rng) % 12;
+        v[RP_MOTION] = motion_left ? 1 : 0;
+        if (motion_left) motion_left--;
+
+        uint32_t valid = ALL_VALID;
+        if (test_rand(&rng) % 100 == 0) valid &= ~((1u << RP_TEMP) | (1u << RP_HUMI));
+
+        uint32_t reason = report_policy_evaluate(&rp, t, v, valid);
+        if (reason == RP_REASON_NONE) {
+            // im lặng thì mọi giá trị hợp lệ phải còn trong deadband (trừ khi đang trong min_interval)
+            for (int i = 0; i < RP_SENSOR_COUNT; i++) {
+                const rp_sensor_cfg_t *s = &cfg.sensor[i];
+                int32_t d = v[i] - rp.last[i];
+                if ((valid & (1u << i)) && t - rp.last_tx_ms + REPORT_SLACK_MS >= s->min_interval_ms
+                    && (d >= s->deadband || -d >= s->deadband)) {
+                    stale_violations++;
+                }
+            }
+            continue;
+        }
+        if (reason & RP_REASON_FIRST) by_reason[0]++;
+        else if (reason & RP_REASON_CHANGE) by_reason[1]++;
+        else by_reason[2]++;
+        if (k && t - last_tx > max_gap) max_gap = t - last_tx;
+        last_tx = t;
+        report_policy_commit(&rp, t, v, valid);
+    }
+
+    printf("trace 24h @%us: %u mẫu -> %u frame (first %u, change %u, heartbeat %u), "
+           "giảm %.1fx, khoảng lặng dài nhất %us\n",
+           step / 1000, n, rp.sent, by_reason[0], by_reason[1], by_reason[2],
+           (double)n / rp.sent, max_gap / 1000);
+    CHECK_EQ(rp.samples, n);
+    CHECK_EQ(stale_violations, 0);
+    CHECK(max_gap <= cfg.sensor[RP_TEMP].max_interval_ms);
+    CHECK(by_reason[2] > 0);
+    CHECK(rp.sent * 3 < n);
+}
+
+int main(void) {
+    test_rules();
+    test_trace_replay();
+    return TEST_RESULT();
+}
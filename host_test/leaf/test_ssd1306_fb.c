@@ -0,0 +1,134 @@
+#include <string.h>
+#include "test_util.h"
+#include "ssd1306_fb.h"
+
+// ==== ssd1306_fb: diff dirty-page -> transaction I2C -> RAM panel ====
+// Panel giả lập giải mã đúng transaction ssd1306_fb_build_flush dựng ra
+// (Co=1 từng lệnh, rồi data stream, chế độ địa chỉ ngang như ssd1306_init).
+typedef struct {
+    uint8_t ram[SSD1306_FB_PAGES][SSD1306_FB_COLS];
+    uint8_t c0, c1, p0, p1;
+} panel_t;
+
+static bool panel_apply(panel_t *pn, const uint8_t *tx, size_t n) {
+    uint8_t cmd[8];
+    size_t nc = 0, i = 0;
+    while (i + 1 < n && tx[i] == 0x80) {
+        if (nc == sizeof(cmd)) return false;
+        cmd[nc++] = tx[i + 1];
+        i += 2;
+    }
+    if (nc != 6 || cmd[0] != 0x21 || cmd[3] != 0x22 || i >= n || tx[i] != 0x40) return false;
+    pn->c0 = cmd[1]; pn->c1 = cmd[2]; pn->p0 = cmd[4]; pn->p1 = cmd[5];
+    if (pn->c1 >= SSD1306_FB_COLS || pn->p1 >= SSD1306_FB_PAGES) return false;
+
+    uint8_t col = pn->c0, page = pn->p0;
+    for (i++; i < n; i++) {
+        pn->ram[page][col] = tx[i];
+        if (++col > pn->c1) {
+            col = pn->c0;
+            if (++page > pn->p1) page = pn->p0;
+        }
+    }
+    return true;
+}
+
+// flush như ssd1306_flush; trả về số byte data (không kể lệnh), -1 nếu lỗi
+static int flush(ssd1306_fb_t *fb, panel_t *pn, ssd1306_region_t *r) {
+    static uint8_t tx[SSD1306_FB_FLUSH_MAX];
+    if (!ssd1306_fb_dirty_region(fb, r)) return 0;
+    size_t n = ssd1306_fb_build_flush(fb, r, tx, sizeof(tx));
+    if (n == 0 || !panel_apply(pn, tx, n)) return -1;
+    ssd1306_fb_commit(fb, r);
+    return (int)(n - 13);
+}
+
+static const uint8_t k_glyph[8] = { 0x00, 0x7C, 0x12, 0x11, 0x12, 0x7C, 0x00, 0x00 };
+
+static void test_diff(void) {
+    static ssd1306_fb_t fb;
+    static panel_t pn;
+    ssd1306_region_t r;
+    memset(&pn, 0x5A, sizeof(pn));
+
+    // lần đầu: RAM panel không xác định -> gửi cả 1 KB
+    ssd1306_fb_init(&fb);
+    CHECK_EQ(flush(&fb, &pn, &r), SSD1306_FB_PAGES * SSD1306_FB_COLS);
+    CHECK_EQ(memcmp(pn.ram, fb.buf, sizeof(pn.ram)), 0);
+    CHECK_EQ(fb.dirty_pages, 0);
+    CHECK(!ssd1306_fb_dirty_region(&fb, &r));
+
+    // 1 ký tự: đúng 1 page, 8 cột (bỏ cột đầu/cuối trùng 0)
+    ssd1306_fb_write(&fb, 3, 16, k_glyph, 8, false);
+    CHECK(ssd1306_fb_dirty_region(&fb, &r));
+    CHECK_EQ(r.page0, 3); CHECK_EQ(r.page1, 3);
+    CHECK_EQ(r.col0, 17); CHECK_EQ(r.col1, 21);
+    CHECK_EQ(flush(&fb, &pn, &r), 5);
+    CHECK_EQ(memcmp(pn.ram, fb.buf, sizeof(pn.ram)), 0);
+
+    // ghi lại y nguyên: page bẩn nhưng không khác shadow -> không gửi
+    ssd1306_fb_write(&fb, 3, 16, k_glyph, 8, false);
+    CHECK_EQ(fb.dirty_pages, 1u << 3);
+    CHECK(!ssd1306_fb_dirty_region(&fb, &r));
+
+    // clear + vẽ lại cùng nội dung (vòng lặp send_sensor_task) -> không gửi
+    ssd1306_fb_clear(&fb);
+    ssd1306_fb_write(&fb, 3, 16, k_glyph, 8, false);
+    CHECK(!ssd1306_fb_dirty_region(&fb, &r));
+
+    // 2 page xa nhau: hộp bao gồm cả page giữa
+    ssd1306_fb_write(&fb, 1, 100, k_glyph, 8, true);
+    ssd1306_fb_write(&fb, 6, 0, k_glyph, 3, false);
+    CHECK(ssd1306_fb_dirty_region(&fb, &r));
+    CHECK_EQ(r.page0, 1); CHECK_EQ(r.page1, 6);
+    CHECK_EQ(r.col0, 1);  CHECK_EQ(r.col1, 107);
+    CHECK_EQ(flush(&fb, &pn, &r), 6 * 107);
+    CHECK_EQ(memcmp(pn.ram, fb.buf, sizeof(pn.ram)), 0);
+
+    // cắt ở mép phải, ngoài màn hình bỏ qua
+    ssd1306_fb_write(&fb, 7, 124, k_glyph, 8, true);
+    ssd1306_fb_write(&fb, 8, 0, k_glyph, 8, true);
+    ssd1306_fb_write(&fb, 0, 128, k_glyph, 8, true);
+    ssd1306_fb_write(&fb, -1, 0, k_glyph, 8, true);
+    CHECK(ssd1306_fb_dirty_region(&fb, &r));
+    CHECK_EQ(r.page0, 7); CHECK_EQ(r.page1, 7);
+    CHECK_EQ(r.col0, 124); CHECK_EQ(r.col1, 127);
+
+    // buffer thiếu chỗ: không dựng, shadow giữ nguyên
+    uint8_t small[13 + 4];
+    CHECK_EQ(ssd1306_fb_build_flush(&fb, &r, small, 13 + 3), 0);
+    CHECK_EQ(ssd1306_fb_build_flush(&fb, &r, small, 13 + 4), 13 + 4);
+    CHECK(ssd1306_fb_dirty_region(&fb, &r));
+}
+
+// Vẽ ngẫu nhiên nhiều vòng: sau mỗi flush panel luôn khớp buf
+static void test_random(void) {
+    static ssd1306_fb_t fb;
+    static panel_t pn;
+    ssd1306_region_t r;
+    uint32_t rng = 99;
+    ssd1306_fb_init(&fb);
+
+    for (int round = 0; round < 5000; round++) {
+        if (test_rand(&rng) % 16 == 0) ssd1306_fb_clear(&fb);
+        int writes = (int)(test_rand(&rng) % 4);
+        for (int k = 0; k < writes; k++) {
+            uint8_t data[16];
+            for (int i = 0; i < 16; i++) data[i] = (uint8_t)test_rand(&rng);
+            ssd1306_fb_write(&fb, (int)(test_rand(&rng) % 9), (int)(test_rand(&rng) % 130),
+                             data, test_rand(&rng) % 17, test_rand(&rng) & 1);
+        }
+        CHECK(flush(&fb, &pn, &r) >= 0);
+        if (memcmp(pn.ram, fb.buf, sizeof(pn.ram)) != 0) {
+            CHECK(!"panel lệch framebuffer");
+            break;
+        }
+        CHECK(!ssd1306_fb_dirty_region(&fb, &r));
+    }
+}
+
+int main(void) {
+    test_diff();
+    test_random();
+    return TEST_RESULT();
+}
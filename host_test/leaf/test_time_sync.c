@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include "test_util.h"
+#include "time_sync.h"
+#include "tsync.h"
+
+// ==== Beacon / echo codec + bộ ước lượng mesh time của leaf ====
+// Mô phỏng: đồng hồ leaf lệch gốc + trôi 20 ppm, trễ beacon 5 ms + jitter, thỉnh thoảng
+// beacon kẹt hàng đợi thêm hàng chục ms (phải bị bỏ như outlier).
+#define LEAF_PPM        20
+#define OWD_US          5000
+#define BEACON_US       1000000
+#define BEACONS         600
+
+static void test_codec(void) {
+    uint8_t buf[TSYNC_ECHO_LEN];
+    tsync_echo_t eo;
+    tsync_beacon_t b = {
+        .seq = 513, .flags = TSYNC_FLAG_UTC | TSYNC_FLAG_SLOT,
+        .root_us = 1760000000123456ull, .owd_us = 4200, .slot = 3, .slots = 8,
+    }, bo;
+    CHECK_EQ(tsync_beacon_encode(&b, buf, TSYNC_BEACON_LEN - 1), 0);
+    CHECK_EQ(tsync_beacon_encode(&b, buf, sizeof(buf)), TSYNC_BEACON_LEN);
+    CHECK(tsync_beacon_decode(buf, TSYNC_BEACON_LEN, &bo));
+    CHECK_EQ(bo.seq, 513);
+    CHECK_EQ(bo.flags, TSYNC_FLAG_UTC | TSYNC_FLAG_SLOT);
+    CHECK(bo.root_us == b.root_us);
+    CHECK_EQ(bo.owd_us, 4200);
+    CHECK_EQ(bo.slot, 3);
+    CHECK_EQ(bo.slots, 8);
+    CHECK(!tsync_beacon_decode(buf, TSYNC_BEACON_LEN - 1, &bo));
+    CHECK(!tsync_echo_decode(buf, sizeof(buf), &eo));             // beacon không phải echo
+
+    // slot ngoài khoảng hoặc thiếu cờ: không xếp lịch
+    b.slot = 8;
+    tsync_beacon_encode(&b, buf, sizeof(buf));
+    CHECK(tsync_beacon_decode(buf, TSYNC_BEACON_LEN, &bo));
+    CHECK_EQ(bo.slots, 0);
+    b.slot  = 1;
+    b.flags = TSYNC_FLAG_UTC;
+    tsync_beacon_encode(&b, buf, sizeof(buf));
+    CHECK(tsync_beacon_decode(buf, TSYNC_BEACON_LEN, &bo));
+    CHECK_EQ(bo.slots, 0);
+
+    tsync_echo_t e = {
+        .node_id = 7, .seq = 513, .flags = TSYNC_FLAG_SYNCED, .root_us = 0xfedcba98u,
+        .hold_us = 150, .leaf_us = 0x01234567u, .err_us = -1234,
+    };
+    CHECK_EQ(tsync_echo_encode(&e, buf, sizeof(buf)), TSYNC_ECHO_LEN);
+    CHECK(tsync_echo_decode(buf, TSYNC_ECHO_LEN, &eo));
+    CHECK_EQ(eo.node_id, 7);
+    CHECK_EQ(eo.seq, 513);
+    CHECK_EQ(eo.flags, TSYNC_FLAG_SYNCED);
+    CHECK_EQ(eo.root_us, 0xfedcba98u);
+    CHECK_EQ(eo.hold_us, 150);
+    CHECK_EQ(eo.leaf_us, 0x01234567u);
+    CHECK_EQ(eo.err_us, -1234);
+    CHECK(!tsync_echo_decode(buf, TSYNC_ECHO_LEN - 1, &eo));
+    CHECK(!tsync_beacon_decode(buf, TSYNC_ECHO_LEN, &bo));
+}
+
+// Đồng hồ leaf theo thời gian thật của root
+static int64_t leaf_clock(int64_t root_us) {
+    return 987654321 + root_us + root_us * LEAF_PPM / 1000000;
+}
+
+static void test_converge(void) {
+    time_sync_t ts;
+    uint32_t seed = 42;
+    int64_t worst = 0;
+    int queued = 0;
+    double drift_sum = 0;
+
+    time_sync_init(&ts);
+    CHECK(!ts.synced);
+    for (int i = 0; i < BEACONS; i++) {
+        int64_t root_tx = 5000000 + (int64_t)i * BEACON_US;
+        int64_t delay = OWD_US + (int64_t)(test_rand(&seed) % 400) - 200;
+        if (i > 10 && test_rand(&seed) % 20 == 0) {
+            delay += 10000 + test_rand(&seed) % 30000;
+            queued++;
+        }
+        int64_t rx = leaf_clock(root_tx + delay);
+        time_sync_on_beacon(&ts, root_tx, OWD_US, false, rx);
+        CHECK(ts.synced);
+
+        // sai số ước lượng giữa 2 beacon, bỏ 20 beacon đầu cho drift hội tụ
+        if (i < 20) continue;
+        int64_t t = root_tx + BEACON_US / 2;
+        int64_t e = llabs(time_sync_now(&ts, leaf_clock(t)) - t);
+        if (e > worst) worst = e;
+        drift_sum += ts.drift;
+    }
+    // jitter ±200 us / 1 s làm drift từng mẫu nhiễu cỡ trăm ppm, trung bình phải về đúng -20 ppm
+    double drift_ppm = drift_sum / (BEACONS - 20) * 1e6;
+    printf("time_sync: %d beacon, %d kẹt hàng đợi, outliers %u, steps %u, sai số lớn nhất %lld us, drift tb %.1f ppm\n",
+           BEACONS, queued, (unsigned)ts.outliers, (unsigned)ts.steps, (long long)worst, drift_ppm);
+    CHECK(worst < 500);
+    CHECK_EQ(ts.steps, 1);
+    CHECK(ts.outliers >= (uint32_t)queued / 2);
+    CHECK(drift_ppm < -LEAF_PPM * 0.5 && drift_ppm > -LEAF_PPM * 1.5);
+}
+
+static void test_steps(void) {
+    time_sync_t ts;
+    time_sync_init(&ts);
+    int64_t local = 1000000;
+
+    // lần đầu: nhảy thẳng, sai số 0
+    CHECK_EQ(time_sync_on_beacon(&ts, 500000, 1000, false, local), 0);
+    CHECK_EQ(time_sync_now(&ts, local), 501000);
+    CHECK_EQ(ts.steps, 1);
+
+    // root có SNTP: gốc đổi sang UTC, nhảy ngay dù chỉ 1 mẫu
+    local += BEACON_US;
+    time_sync_on_beacon(&ts, 1760000000000000ll, 1000, true, local);
+    CHECK(ts.utc);
+    CHECK_EQ(ts.steps, 2);
+    CHECK_EQ(time_sync_now(&ts, local), 1760000000001000ll);
+
+    // lệch dương quá TS_STEP_US (đường đi dài hẳn ra rồi ngắn lại): nhảy
+    local += BEACON_US;
+    int64_t root = 1760000000000000ll + BEACON_US;
+    CHECK_EQ(time_sync_on_beacon(&ts, root + TS_STEP_US + 1, 1000, true, local), TS_STEP_US + 1);
+    CHECK_EQ(ts.steps, 3);
+    root += TS_STEP_US + 1;
+
+    // lệch âm vừa phải: bỏ TS_STEP_AFTER - 1 lần, lần thứ TS_STEP_AFTER thì nhảy
+    for (int i = 1; i <= TS_STEP_AFTER; i++) {
+        local += BEACON_US;
+        root  += BEACON_US;
+        time_sync_on_beacon(&ts, root - 10000, 1000, true, local);
+        CHECK_EQ(ts.outliers, i);
+        CHECK_EQ(ts.steps, i < TS_STEP_AFTER ? 3 : 4);
+    }
+    CHECK_EQ(time_sync_now(&ts, local), root - 10000 + 1000);
+    CHECK_EQ(ts.rejects, 0);
+}
+
+static void test_slot_wait(void) {
+    const int64_t P = 10000000;         // 10 s, 4 slot: slot 1 ở mốc 2.5 s
+    CHECK_EQ(time_sync_slot_wait(0, 10000, 1, 4), 2500000);
+    CHECK_EQ(time_sync_slot_wait(2400000, 10000, 1, 4), 100000 + P);       // gần mốc: coi như vừa gửi
+    CHECK_EQ(time_sync_slot_wait(2500000, 10000, 1, 4), P);
+    CHECK_EQ(time_sync_slot_wait(2500001, 10000, 1, 4), P - 1);
+    CHECK_EQ(time_sync_slot_wait(7 * P + 2000000, 10000, 3, 4), 5500000);
+    CHECK_EQ(time_sync_slot_wait(1760000000000000ll, 10000, 0, 4), P);
+    CHECK_EQ(time_sync_slot_wait(-1000000, 10000, 0, 4), 1000000 + P);
+    CHECK_EQ(time_sync_slot_wait(123, 10000, 2, 0), P);                    // không xếp lịch
+}
+
+int main(void) {
+    test_codec();
+    test_converge();
+    test_steps();
+    test_slot_wait();
+    return TEST_RESULT();
+}
@@ -0,0 +1,71 @@
+#include <string.h>
+#include "test_util.h"
+#include "batch.h"
+#include "telemetry.h"
+
+// ==== Relay gộp N frame leaf / BATCH: số frame + byte trên link root, chi phí codec ====
+// Link root là chỗ nghẽn (root chỉ 2 child): mỗi frame mesh tốn airtime cố định
+// (preamble, MAC header, ACK) nên số frame giảm mới là lợi chính, byte tăng 7 B / entry.
+// Leaf giống loadgen: telemetry 20 B có đủ cờ tùy chọn.
+#define LEAF_FRAMES     200000
+
+static size_t leaf_frame(uint32_t i, uint8_t *buf, size_t cap) {
+    telemetry_t t = {
+        .node_id = (uint16_t)(i & 63), .seq = (uint16_t)(i >> 6), .temp = 25, .humi = 60,
+        .light_raw = (uint16_t)(i * 7 % 4096), .light_mv = 1500, .tx_us = i, .layer = 2,
+        .flags = TLM_FLAG_DHT_OK | TLM_FLAG_LIGHT_MV | TLM_FLAG_TX_TS,
+    };
+    return telemetry_encode(&t, buf, cap);
+}
+
+int main(void) {
+    static const int sizes[] = { 1, 2, 4, 8, 17 };
+    uint8_t buf[BATCH_FRAME_MAX], f[TELEMETRY_FRAME_MAX];
+    uint8_t mac[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x00 };
+
+    printf("%d leaf frame, telemetry %zu B\n", LEAF_FRAMES, leaf_frame(0, f, sizeof(f)));
+    printf("batch  link frames  link bytes  frames/leaf  bytes/leaf  build ns/entry  parse ns/entry\n");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int per = sizes[s];
+        uint64_t link_frames = 0, link_bytes = 0, t_build, t_parse;
+        size_t len = 0;
+        batch_builder_t b;
+        batch_iter_t it;
+        const uint8_t *m, *d;
+        size_t dl;
+
+        // gộp: encode telemetry + batch_add + finish, đồng hồ đo cả vòng (không đo từng batch)
+        uint64_t t0 = test_now_ns();
+        for (uint32_t i = 0; i < LEAF_FRAMES; ) {
+            batch_begin(&b, buf, sizeof(buf));
+            for (int k = 0; k < per && i < LEAF_FRAMES; k++, i++) {
+                mac[5] = (uint8_t)(i & 63);
+                batch_add(&b, mac, f, leaf_frame(i, f, sizeof(f)));
+            }
+            len = batch_finish(&b);
+            g_bench_sink += buf[len - 1];
+            link_frames++;
+            link_bytes += len;
+        }
+        t_build = test_now_ns() - t0;
+
+        // tách: frame cuối ở buf, lặp cho đủ LEAF_FRAMES entry
+        uint32_t got = 0;
+        t0 = test_now_ns();
+        while (got < LEAF_FRAMES) {
+            batch_iter_init(&it, buf, len);
+            while (batch_next(&it, &m, &d, &dl)) {
+                g_bench_sink += d[dl - 1];
+                got++;
+            }
+        }
+        t_parse = test_now_ns() - t0;
+        printf("%5d  %11llu  %10llu  %11.3f  %10.1f  %14.1f  %14.1f\n", per,
+               (unsigned long long)link_frames, (unsigned long long)link_bytes,
+               (double)link_frames / LEAF_FRAMES, (double)link_bytes / LEAF_FRAMES,
+               (double)t_build / LEAF_FRAMES, (double)t_parse / got);
+    }
+    // frame lẻ không gộp (RELAY_AGGREGATE 0 vẫn bọc 1 entry): mốc so sánh byte
+    printf("raw leaf frames: %d link frames, %.1f bytes/leaf\n", LEAF_FRAMES, (double)leaf_frame(0, f, sizeof(f)));
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "test_util.h"
+#include "series.h"
+#include "series_trace.h"
+
+// ==== SERIES so với frame telemetry lẻ: byte/mẫu, tỉ lệ nén, tốc độ encode + decode ====
+// Trace 20000 mẫu (~28 giờ lấy mẫu 5 s) của 1 leaf, gom N mẫu / frame.
+// Mốc so sánh: telemetry có TLM_FLAG_TX_TS như leaf gửi khi không gom.
+#define TRACE_N     20000
+
+static telemetry_t s_tr[TRACE_N];
+static uint32_t    s_ts[TRACE_N];
+
+int main(void) {
+    series_trace(s_tr, s_ts, TRACE_N, 1);
+
+    size_t raw = 0;
+    for (int i = 0; i < TRACE_N; i++) {
+        uint8_t f[TELEMETRY_FRAME_MAX];
+        telemetry_t x = s_tr[i];
+        x.flags |= TLM_FLAG_TX_TS;
+        raw += telemetry_encode(&x, f, sizeof(f));
+    }
+    printf("%d mẫu, telemetry lẻ %.2f B/mẫu\n", TRACE_N, (double)raw / TRACE_N);
+    printf("    N   frames  B/sample  ratio  enc ns/sample  dec ns/sample  errs\n");
+
+    for (int batch = 4; batch <= 64; batch *= 2) {
+        size_t bytes = 0, frames = 0;
+        uint64_t t_enc = 0, t_dec = 0;
+        int errs = 0;
+        uint8_t buf[SERIES_FRAME_MAX];
+
+        for (int i = 0; i < TRACE_N; ) {
+            series_builder_t b;
+            int first = i;
+            uint64_t t0 = test_now_ns();
+            series_begin(&b, buf, sizeof(buf));
+            while (i < TRACE_N && b.count < batch && series_add(&b, &s_tr[i], s_ts[i])) i++;
+            size_t len = series_finish(&b, 7, s_tr[first].seq, SERIES_FLAG_SYNC);
+            uint64_t t1 = test_now_ns();
+
+            series_iter_t it;
+            telemetry_t o;
+            uint32_t off;
+            int k = first;
+            if (!series_iter_init(&it, buf, len)) errs++;
+            while (series_next(&it, &o, &off)) {
+                g_bench_sink += o.light_raw + off;
+                k++;
+            }
+            uint64_t t2 = test_now_ns();
+
+            if (k != i) errs++;
+            t_enc += t1 - t0;
+            t_dec += t2 - t1;
+            bytes += len;
+            frames++;
+        }
+        printf("%5d  %7zu  %8.2f  %4.1fx  %13.1f  %13.1f  %4d\n", batch, frames,
+               (double)bytes / TRACE_N, (double)raw / bytes,
+               (double)t_enc / TRACE_N, (double)t_dec / TRACE_N, errs);
+    }
+    return 0;
+}
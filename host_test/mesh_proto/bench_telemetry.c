@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_util.h"
+#include "telemetry.h"
+#ifndef HAVE_CJSON
+#define HAVE_CJSON 0
+#endif
+#if HAVE_CJSON
+#include "cJSON.h"
+#endif
+
+// ==== Frame telemetry nhị phân so với đường JSON cũ của leaf ====
+// Leaf cũ: cJSON_CreateObject + Add* + PrintUnformatted, root chuyển nguyên chuỗi.
+// Leaf mới: telemetry_encode; root: telemetry_decode + telemetry_to_json.
+// Không có cJSON trên máy thì đo JSON bằng snprintf cùng định dạng (cận dưới của cJSON).
+#define ITERS   200000
+
+static size_t json_leaf(const telemetry_t *t, char *out, size_t cap) {
+    float vout = (float)t->light_raw / TLM_LIGHT_RAW_MAX * TLM_LIGHT_VREF;
+#if HAVE_CJSON
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "node_id", "Leaf_01");
+    cJSON_AddStringToObject(root, "role", "leaf");
+    cJSON_AddNumberToObject(root, "temp", t->temp);
+    cJSON_AddNumberToObject(root, "humi", t->humi);
+    cJSON_AddNumberToObject(root, "light_v", vout);
+    cJSON_AddNumberToObject(root, "light_raw", t->light_raw);
+    cJSON_AddNumberToObject(root, "motion", t->motion);
+    char *s = cJSON_PrintUnformatted(root);
+    size_t n = strlen(s);
+    if (n >= cap) n = cap - 1;
+    memcpy(out, s, n);
+    out[n] = '\0';
+    cJSON_free(s);
+    cJSON_Delete(root);
+    return n;
+#else
+    int n = snprintf(out, cap, "{\"node_id\":\"Leaf_01\",\"role\":\"leaf\",\"temp\":%d,\"humi\":%u,"
+                     "\"light_v\":%.15g,\"light_raw\":%u,\"motion\":%u}",
+                     t->temp, t->humi, (double)vout, t->light_raw, t->motion);
+    return n > 0 ? (size_t)n : 0;
+#endif
+}
+
+int main(void) {
+    uint32_t rng = 1;
+    static telemetry_t trace[256];
+    for (int i = 0; i < 256; i++) {
+        trace[i] = (telemetry_t){
+            .node_id = 1, .seq = (uint16_t)i, .temp = (int8_t)(20 + test_rand(&rng) % 15),
+            .humi = (uint8_t)(40 + test_rand(&rng) % 50), .light_raw = (uint16_t)(test_rand(&rng) % 4096),
+            .motion = test_rand(&rng) % 2, .light_mv = (uint16_t)(test_rand(&rng) % 3300),
+            .tx_us = test_rand(&rng), .layer = 2,
+            .flags = TLM_FLAG_DHT_OK | TLM_FLAG_LIGHT_MV | TLM_FLAG_TX_TS,
+        };
+    }
+
+    uint8_t bin[TELEMETRY_FRAME_MAX];
+    char json[256];
+    size_t bin_bytes = 0, json_bytes = 0;
+
+    uint64_t t0 = test_now_ns();
+    for (int i = 0; i < ITERS; i++) {
+        size_t n = telemetry_encode(&trace[i & 255], bin, sizeof(bin));
+        bin_bytes += n;
+        g_bench_sink += bin[n - 1];
+    }
+    uint64_t t1 = test_now_ns();
+    for (int i = 0; i < ITERS; i++) {
+        telemetry_t out;
+        size_t n = telemetry_encode(&trace[i & 255], bin, sizeof(bin));
+        if (!telemetry_decode(bin, n, &out)) return 1;
+        g_bench_sink += (uint32_t)telemetry_to_json(&out, json, sizeof(json));
+    }
+    uint64_t t2 = test_now_ns();
+    for (int i = 0; i < ITERS; i++) {
+        size_t n = json_leaf(&trace[i & 255], json, sizeof(json));
+        json_bytes += n;
+        g_bench_sink += (uint8_t)json[n - 1];
+    }
+    uint64_t t3 = test_now_ns();
+
+    printf("JSON path: %s\n", HAVE_CJSON ? "cJSON" : "snprintf (cJSON không có trên máy)");
+    printf("leaf binary encode      : %7.1f ns/frame, %5.1f B/frame\n",
+           (double)(t1 - t0) / ITERS, (double)bin_bytes / ITERS);
+    printf("root decode + to_json   : %7.1f ns/frame\n", (double)(t2 - t1) / ITERS - (double)(t1 - t0) / ITERS);
+    printf("leaf JSON build + print : %7.1f ns/frame, %5.1f B/frame\n",
+           (double)(t3 - t2) / ITERS, (double)json_bytes / ITERS);
+    printf("payload ratio JSON/binary: %.1fx\n", (double)json_bytes / (double)bin_bytes);
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef SERIES_TRACE_H_
+#define SERIES_TRACE_H_
+
+#include "test_util.h"
+#include "telemetry.h"
+
+// ==== Trace leaf dùng chung test_series / bench_series ====
+// Lấy mẫu 5 s, tick lệch ±10 ms, nhiệt độ/độ ẩm trôi chậm, ánh sáng nhiễu ±10,
+// 1% mẫu DHT lỗi, 2% mẫu có chuyển động.
+static inline void series_trace(telemetry_t *tr, uint32_t *ts, int n, uint32_t seed) {
+    int temp = 27, humi = 60, light = 1800;
+    uint32_t t = 123456789;
+    for (int i = 0; i < n; i++) {
+        if (test_rand(&seed) % 20 == 0) temp += (int)(test_rand(&seed) % 3) - 1;
+        if (test_rand(&seed) % 10 == 0) humi += (int)(test_rand(&seed) % 3) - 1;
+        light += (int)(test_rand(&seed) % 21) - 10;
+        if (light < 0) light = 0;
+        if (light > 4095) light = 4095;
+        tr[i] = (telemetry_t){
+            .node_id = 7, .seq = (uint16_t)i, .temp = (int8_t)temp, .humi = (uint8_t)humi,
+            .light_raw = (uint16_t)light, .light_mv = (uint16_t)(light * 3300 / 4095),
+            .motion = test_rand(&seed) % 50 == 0,
+            .flags = (test_rand(&seed) % 100 ? TLM_FLAG_DHT_OK : 0) | TLM_FLAG_LIGHT_MV,
+        };
+        t += 5000 + ((int)(test_rand(&seed) % 3) - 1) * 10;
+        ts[i] = t;
+    }
+}
+
+#endif /* SERIES_TRACE_H_ */
@@ -0,0 +1,177 @@
+#include <string.h>
+#include "test_util.h"
+#include "batch.h"
+#include "telemetry.h"
+
+static void mac_of(uint32_t i, uint8_t mac[6]) {
+    const uint8_t m[6] = { 0x24, 0x0a, 0xc4, 0x00, (uint8_t)(i >> 8), (uint8_t)i };
+    memcpy(mac, m, 6);
+}
+
+static size_t tlm(uint16_t id, uint16_t seq, uint8_t *buf, size_t cap) {
+    telemetry_t t = {
+        .node_id = id, .seq = seq, .temp = 25, .humi = 60, .light_raw = 1234,
+        .light_mv = 1500, .tx_us = 0x01020304u + seq, .layer = 2,
+        .flags = TLM_FLAG_DHT_OK | TLM_FLAG_LIGHT_MV | TLM_FLAG_TX_TS,
+    };
+    return telemetry_encode(&t, buf, cap);
+}
+
+// Gộp rồi tách: MAC, độ dài, byte frame con y nguyên, đúng thứ tự
+static void test_roundtrip(void) {
+    uint8_t buf[BATCH_FRAME_MAX];
+    uint8_t want[32][TELEMETRY_FRAME_MAX];
+    size_t want_len[32];
+    batch_builder_t b;
+
+    batch_begin(&b, buf, sizeof(buf));
+    CHECK(batch_empty(&b));
+    int n = 0;
+    for (; n < 32; n++) {
+        uint8_t mac[6];
+        mac_of((uint32_t)n, mac);
+        want_len[n] = tlm((uint16_t)n, (uint16_t)(100 + n), want[n], sizeof(want[n]));
+        if (!batch_add(&b, mac, want[n], want_len[n])) break;
+    }
+    // 480 B, frame 20 B + 7 B header mỗi entry: (480 - 5) / 27 = 17
+    CHECK_EQ(want_len[0], 20);
+    CHECK_EQ(n, 17);
+    CHECK_EQ(b.count, 17);
+    size_t len = batch_finish(&b);
+    CHECK_EQ(len, BATCH_HDR_LEN + 17 * (BATCH_ENTRY_HDR + 20));
+    CHECK(mesh_proto_is_frame(buf, len));
+    CHECK_EQ(mesh_proto_type(buf), MESH_MSG_BATCH);
+
+    batch_iter_t it;
+    const uint8_t *mac, *data;
+    size_t dlen;
+    CHECK(batch_iter_init(&it, buf, len));
+    CHECK_EQ(it.left, 17);
+    for (int i = 0; i < n; i++) {
+        uint8_t m[6];
+        mac_of((uint32_t)i, m);
+        CHECK(batch_next(&it, &mac, &data, &dlen));
+        CHECK_EQ(memcmp(mac, m, 6), 0);
+        CHECK_EQ(dlen, want_len[i]);
+        CHECK_EQ(memcmp(data, want[i], dlen), 0);
+        telemetry_t t;
+        CHECK(telemetry_decode(data, dlen, &t));
+        CHECK_EQ(t.seq, 100 + i);
+    }
+    CHECK(!batch_next(&it, &mac, &data, &dlen));
+    CHECK_EQ(it.left, 0);
+
+    // entry dài tối đa 255 B, frame con không cần là frame mesh_proto (JSON cũ)
+    static uint8_t big[1024];
+    batch_begin(&b, big, sizeof(big));
+    uint8_t m0[6];
+    mac_of(0, m0);
+    uint8_t blob[BATCH_ENTRY_MAX];
+    for (size_t i = 0; i < sizeof(blob); i++) blob[i] = (uint8_t)i;
+    CHECK(batch_add(&b, m0, blob, sizeof(blob)));
+    CHECK(batch_add(&b, m0, (const uint8_t *)"{}", 2));
+    len = batch_finish(&b);
+    CHECK(batch_iter_init(&it, big, len));
+    CHECK(batch_next(&it, &mac, &data, &dlen));
+    CHECK_EQ(dlen, BATCH_ENTRY_MAX);
+    CHECK_EQ(memcmp(data, blob, dlen), 0);
+    CHECK(batch_next(&it, &mac, &data, &dlen));
+    CHECK_EQ(dlen, 2);
+    CHECK_EQ(memcmp(data, "{}", 2), 0);
+}
+
+static void test_builder_limits(void) {
+    uint8_t buf[BATCH_FRAME_MAX], f[BATCH_ENTRY_MAX + 1] = { 0 };
+    uint8_t mac[6] = { 0 };
+    batch_builder_t b;
+
+    batch_begin(&b, buf, sizeof(buf));
+    CHECK(!batch_add(&b, mac, f, 0));
+    CHECK(!batch_add(&b, mac, f, BATCH_ENTRY_MAX + 1));
+    CHECK_EQ(batch_finish(&b), 0);              // rỗng: không có frame
+
+    // vừa khít cap, thêm 1 byte nữa thì không vào và không làm hỏng entry trước
+    batch_begin(&b, buf, BATCH_HDR_LEN + BATCH_ENTRY_HDR + 10);
+    CHECK(!batch_add(&b, mac, f, 11));
+    CHECK(batch_add(&b, mac, f, 10));
+    CHECK(!batch_add(&b, mac, f, 1));
+    CHECK_EQ(batch_finish(&b), BATCH_HDR_LEN + BATCH_ENTRY_HDR + 10);
+
+    // count là 1 byte: tối đa 255 entry
+    static uint8_t big[BATCH_HDR_LEN + 300 * (BATCH_ENTRY_HDR + 1)];
+    batch_begin(&b, big, sizeof(big));
+    int added = 0;
+    while (batch_add(&b, mac, f, 1)) added++;
+    CHECK_EQ(added, UINT8_MAX);
+    CHECK_EQ(big[4], 0);                        // count chỉ ghi lúc finish
+    batch_finish(&b);
+    CHECK_EQ(big[4], UINT8_MAX);
+}
+
+// Frame bị cắt cụt / count khai man: iterator dừng, left > 0 báo thiếu
+static void test_truncated(void) {
+    uint8_t buf[BATCH_FRAME_MAX], f[TELEMETRY_FRAME_MAX];
+    batch_builder_t b;
+    batch_iter_t it;
+    const uint8_t *mac, *data;
+    size_t dlen;
+
+    batch_begin(&b, buf, sizeof(buf));
+    for (int i = 0; i < 4; i++) {
+        uint8_t m[6];
+        mac_of((uint32_t)i, m);
+        CHECK(batch_add(&b, m, f, tlm((uint16_t)i, (uint16_t)i, f, sizeof(f))));
+    }
+    size_t len = batch_finish(&b);
+
+    // mọi điểm cắt: số entry đọc được = số entry còn nguyên, không đọc quá len
+    for (size_t cut = BATCH_HDR_LEN; cut < len; cut++) {
+        CHECK(batch_iter_init(&it, buf, cut));
+        int got = 0;
+        while (batch_next(&it, &mac, &data, &dlen)) {
+            CHECK(data + dlen <= buf + cut);
+            got++;
+        }
+        CHECK_EQ(got, (int)((cut - BATCH_HDR_LEN) / (BATCH_ENTRY_HDR + 20)));
+        CHECK_EQ(it.left, 4 - got);
+    }
+    for (size_t cut = 0; cut < BATCH_HDR_LEN; cut++) CHECK(!batch_iter_init(&it, buf, cut));
+
+    // count lớn hơn thật
+    buf[4] = 9;
+    CHECK(batch_iter_init(&it, buf, len));
+    int got = 0;
+    while (batch_next(&it, &mac, &data, &dlen)) got++;
+    CHECK_EQ(got, 4);
+    CHECK_EQ(it.left, 5);
+
+    // count nhỏ hơn thật: đọc đúng count rồi dừng
+    buf[4] = 2;
+    CHECK(batch_iter_init(&it, buf, len));
+    got = 0;
+    while (batch_next(&it, &mac, &data, &dlen)) got++;
+    CHECK_EQ(got, 2);
+
+    // len của entry vượt cuối frame
+    buf[4] = 4;
+    buf[BATCH_HDR_LEN + 6] = 200;
+    CHECK(batch_iter_init(&it, buf, len));
+    CHECK(!batch_next(&it, &mac, &data, &dlen));
+}
+
+static void test_not_batch(void) {
+    uint8_t f[TELEMETRY_FRAME_MAX];
+    batch_iter_t it;
+    size_t n = tlm(1, 1, f, sizeof(f));
+    CHECK(!batch_iter_init(&it, f, n));
+    const char *json = "{\"node_id\":\"Leaf_01\"}";
+    CHECK(!batch_iter_init(&it, (const uint8_t *)json, strlen(json)));
+}
+
+int main(void) {
+    test_roundtrip();
+    test_builder_limits();
+    test_truncated();
+    test_not_batch();
+    return TEST_RESULT();
+}
@@ -0,0 +1,93 @@
+#include <string.h>
+#include "test_util.h"
+#include "mesh_proto.h"
+#include "telemetry.h"
+#include "motion.h"
+#include "batch.h"
+#include "summary.h"
+
+// ==== Lớp lưu lượng ở bit 7 byte type: đặt/xóa/đọc, decoder của từng type không bị ảnh hưởng ====
+
+static void test_helpers(void) {
+    uint8_t buf[MESH_PROTO_HDR_LEN];
+    for (int t = MESH_MSG_TELEMETRY; t <= MESH_MSG_SERIES; t++) {
+        mesh_proto_put_hdr(buf, (mesh_msg_type_t)t, 0x5a);
+        CHECK_EQ(mesh_proto_class(buf, sizeof(buf)), MESH_CLASS_TELEMETRY);
+
+        mesh_proto_set_class(buf, MESH_CLASS_ALARM);
+        CHECK_EQ(mesh_proto_class(buf, sizeof(buf)), MESH_CLASS_ALARM);
+        CHECK_EQ(mesh_proto_type(buf), t);
+        CHECK_EQ(buf[3], 0x5a);                         // flags không đổi
+        mesh_proto_set_class(buf, MESH_CLASS_ALARM);    // đặt lại: giữ nguyên
+        CHECK_EQ(buf[2], t | MESH_PROTO_CLASS_ALARM);
+
+        mesh_proto_set_class(buf, MESH_CLASS_TELEMETRY);
+        CHECK_EQ(mesh_proto_class(buf, sizeof(buf)), MESH_CLASS_TELEMETRY);
+        CHECK_EQ(buf[2], t);
+    }
+
+    // JSON cũ, frame ngắn, sai version: luôn là TELEMETRY
+    const char *json = "{\"node_id\":\"Leaf_01\",\"temp\":25}";
+    CHECK_EQ(mesh_proto_class((const uint8_t *)json, strlen(json)), MESH_CLASS_TELEMETRY);
+    mesh_proto_put_hdr(buf, MESH_MSG_MOTION, 0);
+    mesh_proto_set_class(buf, MESH_CLASS_ALARM);
+    CHECK_EQ(mesh_proto_class(buf, MESH_PROTO_HDR_LEN - 1), MESH_CLASS_TELEMETRY);
+    buf[1] = MESH_PROTO_VERSION + 1;
+    CHECK_EQ(mesh_proto_class(buf, sizeof(buf)), MESH_CLASS_TELEMETRY);
+}
+
+static void test_decoders(void) {
+    uint8_t buf[BATCH_FRAME_MAX];
+
+    // motion luôn mang lớp ALARM, decode vẫn đúng type
+    motion_event_t m = { .node_id = 3, .seq = 9, .level = 1, .edge_to_send_us = 420 }, mo;
+    size_t n = motion_encode(&m, buf, sizeof(buf));
+    CHECK_EQ(mesh_proto_class(buf, n), MESH_CLASS_ALARM);
+    CHECK(motion_decode(buf, n, &mo));
+    CHECK_EQ(mo.seq, 9);
+    CHECK_EQ(mo.edge_to_send_us, 420);
+    uint16_t id, seq;
+    n = motion_ack_encode(3, 9, buf, sizeof(buf));
+    CHECK_EQ(mesh_proto_class(buf, n), MESH_CLASS_TELEMETRY);
+    CHECK(motion_ack_decode(buf, n, &id, &seq));
+
+    // telemetry / summary bị gắn ALARM vẫn decode được, và không bị nhầm thành type khác
+    telemetry_t t = { .node_id = 4, .seq = 77, .temp = 21, .humi = 50, .flags = TLM_FLAG_DHT_OK }, to;
+    n = telemetry_encode(&t, buf, sizeof(buf));
+    mesh_proto_set_class(buf, MESH_CLASS_ALARM);
+    CHECK(telemetry_decode(buf, n, &to));
+    CHECK_EQ(to.seq, 77);
+    CHECK(!motion_decode(buf, n, &mo));
+    summary_t s = { .node_id = 4, .seq_first = 1, .seq_last = 9, .samples = 9 }, so;
+    n = summary_encode(&s, buf, sizeof(buf));
+    mesh_proto_set_class(buf, MESH_CLASS_ALARM);
+    CHECK(summary_decode(buf, n, &so));
+    CHECK_EQ(so.seq_last, 9);
+
+    // relay: BATCH 1 phần tử gắn ALARM, frame con giữ nguyên lớp của leaf
+    uint8_t ev[MOTION_FRAME_LEN];
+    const uint8_t mac[6] = { 0x24, 0x0a, 0xc4, 0x11, 0x22, 0x03 };
+    size_t en = motion_encode(&m, ev, sizeof(ev));
+    batch_builder_t b;
+    batch_begin(&b, buf, sizeof(buf));
+    CHECK(batch_add(&b, mac, ev, en));
+    n = batch_finish(&b);
+    mesh_proto_set_class(buf, MESH_CLASS_ALARM);
+    CHECK_EQ(mesh_proto_class(buf, n), MESH_CLASS_ALARM);
+
+    batch_iter_t it;
+    const uint8_t *emac, *data;
+    size_t dlen;
+    CHECK(batch_iter_init(&it, buf, n));
+    CHECK(batch_next(&it, &emac, &data, &dlen));
+    CHECK_EQ(memcmp(emac, mac, 6), 0);
+    CHECK_EQ(mesh_proto_class(data, dlen), MESH_CLASS_ALARM);
+    CHECK(motion_decode(data, dlen, &mo));
+    CHECK(!batch_next(&it, &emac, &data, &dlen));
+}
+
+int main(void) {
+    test_helpers();
+    test_decoders();
+    return TEST_RESULT();
+}
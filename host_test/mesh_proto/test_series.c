@@ -0,0 +1,213 @@
+#include <string.h>
+#include "test_util.h"
+#include "series.h"
+#include "series_trace.h"
+
+// ==== series: nén/giải nén khứ hồi, giá trị cực trị, giới hạn builder, frame cắt cụt, fuzz ====
+#define TRACE_N     2000
+#define FUZZ_ITERS  200000
+
+static telemetry_t s_tr[TRACE_N];
+static uint32_t    s_ts[TRACE_N];
+
+// Mẫu sau khi qua series: DHT lỗi thì temp/humi = 0, không có tx_us/layer
+static telemetry_t expect_of(telemetry_t t) {
+    if (!(t.flags & TLM_FLAG_DHT_OK)) t.temp = t.humi = 0;
+    if (!(t.flags & TLM_FLAG_LIGHT_MV)) t.light_mv = 0;
+    t.motion = t.motion ? 1 : 0;
+    t.flags &= TLM_FLAG_DHT_OK | TLM_FLAG_LIGHT_MV;
+    t.tx_us = 0;
+    t.layer = 0;
+    return t;
+}
+
+static bool same(const telemetry_t *a, const telemetry_t *b) {
+    return a->node_id == b->node_id && a->seq == b->seq && a->temp == b->temp && a->humi == b->humi &&
+           a->light_raw == b->light_raw && a->light_mv == b->light_mv && a->motion == b->motion &&
+           a->flags == b->flags;
+}
+
+// Gói tr[from..] vào 1 frame (tối đa max mẫu), tách lại, so từng trường + thời điểm làm tròn tick
+static int pack_check(const telemetry_t *tr, const uint32_t *ts, int from, int n, int max,
+                      uint8_t *buf, size_t cap) {
+    series_builder_t b;
+    series_begin(&b, buf, cap);
+    CHECK(series_empty(&b));
+    int i = from;
+    while (i < n && b.count < max && series_add(&b, &tr[i], ts[i])) i++;
+    size_t len = series_finish(&b, tr[from].node_id, tr[from].seq, SERIES_FLAG_SYNC);
+    CHECK(len > SERIES_HDR_LEN && len <= cap);
+
+    series_iter_t it;
+    telemetry_t o;
+    uint32_t off;
+    CHECK(series_iter_init(&it, buf, len));
+    CHECK_EQ(it.left, i - from);
+    CHECK_EQ(it.flags, SERIES_FLAG_SYNC);
+    CHECK_EQ(it.base_ms, ts[from]);
+    int k = from;
+    while (series_next(&it, &o, &off)) {
+        telemetry_t e = expect_of(tr[k]);
+        CHECK(same(&o, &e));
+        uint32_t q = (ts[k] - ts[from] + SERIES_TICK_MS / 2) / SERIES_TICK_MS * SERIES_TICK_MS;
+        CHECK_EQ(off, q);
+        k++;
+    }
+    CHECK_EQ(k, i);
+    CHECK_EQ(it.left, 0);
+    return i;
+}
+
+static void test_roundtrip(void) {
+    uint8_t buf[SERIES_FRAME_MAX];
+    series_trace(s_tr, s_ts, TRACE_N, 1);
+    for (int max = 1; max <= 64; max *= 2) {
+        for (int i = 0; i < TRACE_N; ) i = pack_check(s_tr, s_ts, i, TRACE_N, max, buf, sizeof(buf));
+    }
+    // không giới hạn số mẫu: dừng vì cap, frame vẫn vừa 1 entry BATCH
+    for (int i = 0; i < TRACE_N; ) i = pack_check(s_tr, s_ts, i, TRACE_N, 255, buf, sizeof(buf));
+}
+
+// Delta lớn nhất mỗi trường + khoảng thời gian thất thường: mỗi mẫu <= SERIES_SAMPLE_MAX
+static void test_extremes(void) {
+    static telemetry_t tr[600];
+    static uint32_t ts[600];
+    uint8_t buf[SERIES_FRAME_MAX];
+    uint32_t seed = 3, t = UINT32_MAX - 5000;     // qua mốc wrap của đồng hồ ms
+    for (int i = 0; i < 600; i++) {
+        bool hi = i & 1;
+        tr[i] = (telemetry_t){
+            .node_id = 0xffff, .seq = (uint16_t)(65500 + i), .temp = hi ? INT8_MAX : INT8_MIN,
+            .humi = hi ? UINT8_MAX : 0, .light_raw = hi ? UINT16_MAX : 0, .light_mv = hi ? 0 : UINT16_MAX,
+            .motion = hi, .flags = (i % 3 ? TLM_FLAG_DHT_OK : 0) | (i % 5 ? TLM_FLAG_LIGHT_MV : 0),
+        };
+        ts[i] = t;
+        // khoảng cách lúc 0, lúc vài tick, lúc vài giờ
+        uint32_t r = test_rand(&seed) % 4;
+        t += r == 0 ? 0 : r == 1 ? 7 : r == 2 ? 5000 : 3600000u * (1 + test_rand(&seed) % 3);
+    }
+
+    int i = 0, frames = 0;
+    while (i < 600) {
+        series_builder_t b;
+        series_begin(&b, buf, sizeof(buf));
+        int from = i;
+        while (i < 600 && series_add(&b, &tr[i], ts[i])) {
+            CHECK(b.len <= sizeof(buf));
+            i++;
+        }
+        CHECK(i > from);
+        if (i == from) break;
+        frames++;
+        CHECK_EQ(pack_check(tr, ts, from, 600, 255, buf, sizeof(buf)), i);
+    }
+    CHECK(frames > 1);
+}
+
+static void test_builder_limits(void) {
+    static uint8_t big[255 * SERIES_SAMPLE_MAX + SERIES_HDR_LEN];
+    uint8_t buf[SERIES_FRAME_MAX];
+    telemetry_t t = { .node_id = 1, .light_raw = 100 };
+    series_builder_t b;
+
+    series_begin(&b, buf, sizeof(buf));
+    CHECK_EQ(series_finish(&b, 1, 0, 0), 0);
+
+    // đồng hồ lùi / vượt SERIES_SPAN_MAX_MS: từ chối, builder giữ nguyên
+    CHECK(series_add(&b, &t, 1000));
+    CHECK(!series_add(&b, &t, 999));
+    CHECK(!series_add(&b, &t, 1000 + SERIES_SPAN_MAX_MS));
+    CHECK(series_add(&b, &t, 1000 + SERIES_SPAN_MAX_MS - 1000));
+    CHECK_EQ(b.count, 2);
+    // 2 mẫu cùng tick sau làm tròn: dt = 0 vẫn nhận
+    CHECK(series_add(&b, &t, 1000 + SERIES_SPAN_MAX_MS - 998));
+
+    // count 1 byte: tối đa 255 mẫu dù còn chỗ
+    series_begin(&b, big, sizeof(big));
+    int n = 0;
+    while (series_add(&b, &t, (uint32_t)n * 5000)) n++;
+    CHECK_EQ(n, UINT8_MAX);
+    size_t len = series_finish(&b, 1, 0, 0);
+    series_iter_t it;
+    telemetry_t o;
+    uint32_t off;
+    CHECK(series_iter_init(&it, big, len));
+    n = 0;
+    while (series_next(&it, &o, &off)) n++;
+    CHECK_EQ(n, UINT8_MAX);
+    CHECK_EQ(off, 254u * 5000);
+
+    // cap nhỏ: dừng khi có thể không vừa mẫu xấu nhất
+    series_begin(&b, buf, SERIES_HDR_LEN + SERIES_SAMPLE_MAX);
+    CHECK(series_add(&b, &t, 0));
+    CHECK(!series_add(&b, &t, 5000));
+}
+
+// Cắt cụt ở mọi điểm: chỉ mẫu đọc đủ được trả, trạng thái không lệch, không đọc quá len
+static void test_truncated(void) {
+    uint8_t buf[SERIES_FRAME_MAX];
+    series_builder_t b;
+    series_begin(&b, buf, sizeof(buf));
+    size_t end_of[32];
+    int n = 0;
+    while (n < 32 && series_add(&b, &s_tr[n], s_ts[n])) end_of[n++] = b.len;
+    size_t len = series_finish(&b, 7, 0, 0);
+
+    for (size_t cut = SERIES_HDR_LEN; cut <= len; cut++) {
+        series_iter_t it;
+        telemetry_t o;
+        uint32_t off;
+        CHECK(series_iter_init(&it, buf, cut));
+        int got = 0;
+        while (series_next(&it, &o, &off)) {
+            telemetry_t e = expect_of(s_tr[got]);
+            CHECK(same(&o, &e));
+            got++;
+        }
+        CHECK(it.p <= buf + cut);
+        int want = 0;
+        while (want < n && end_of[want] <= cut) want++;
+        CHECK_EQ(got, want);
+    }
+    for (size_t cut = 0; cut < SERIES_HDR_LEN; cut++) {
+        series_iter_t it;
+        CHECK(!series_iter_init(&it, buf, cut));
+    }
+    uint8_t tlm[TELEMETRY_FRAME_MAX];
+    series_iter_t it;
+    CHECK(!series_iter_init(&it, tlm, telemetry_encode(&s_tr[0], tlm, sizeof(tlm))));
+}
+
+// Header hợp lệ + thân ngẫu nhiên (varint dài, count khai man): không đọc ra ngoài buffer
+static void test_fuzz(void) {
+    uint8_t frame[SERIES_FRAME_MAX];
+    uint32_t seed = 0xabcdef01u;
+    uint32_t samples = 0;
+    for (int iter = 0; iter < FUZZ_ITERS; iter++) {
+        size_t len = SERIES_HDR_LEN + test_rand(&seed) % (sizeof(frame) - SERIES_HDR_LEN + 1);
+        mesh_proto_put_hdr(frame, MESH_MSG_SERIES, 0);
+        for (size_t i = 4; i < len; i++) {
+            uint32_t r = test_rand(&seed);
+            // nhiều byte có bit nối tiếp để varint dài / chạm cuối buffer
+            frame[i] = (uint8_t)((r & 3) == 0 ? (r >> 8) | 0x80 : r >> 8);
+        }
+        series_iter_t it;
+        telemetry_t o;
+        uint32_t off;
+        CHECK(series_iter_init(&it, frame, len));
+        while (series_next(&it, &o, &off)) {
+            samples++;
+            CHECK(it.p <= frame + len);
+        }
+    }
+    CHECK(samples > 0);
+}
+
+int main(void) {
+    test_roundtrip();
+    test_extremes();
+    test_builder_limits();
+    test_truncated();
+    test_fuzz();
+    return TEST_RESULT();
+}
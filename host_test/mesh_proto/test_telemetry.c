@@ -0,0 +1,110 @@
+#include <string.h>
+#include "test_util.h"
+#include "telemetry.h"
+
+static telemetry_t sample(uint8_t flags) {
+    telemetry_t t = {
+        .node_id = 7, .seq = 0xBEEF, .temp = -5, .humi = 81, .light_raw = 4095,
+        .motion = 1, .light_mv = 3299, .tx_us = 0xDEADBEEF, .layer = 3, .flags = flags,
+    };
+    return t;
+}
+
+// Mọi tổ hợp cờ tùy chọn: độ dài đúng, decode ra y nguyên
+static void test_roundtrip(void) {
+    const uint8_t combos[] = {
+        0, TLM_FLAG_DHT_OK, TLM_FLAG_LIGHT_MV, TLM_FLAG_TX_TS,
+        TLM_FLAG_DHT_OK | TLM_FLAG_LIGHT_MV | TLM_FLAG_TX_TS,
+        TLM_FLAG_DHT_OK | TLM_FLAG_LIGHT_MV | TLM_FLAG_TX_TS | TLM_FLAG_TX_SYNC,
+    };
+    for (size_t i = 0; i < sizeof(combos); i++) {
+        telemetry_t in = sample(combos[i]), out;
+        uint8_t buf[TELEMETRY_FRAME_MAX];
+        size_t len = telemetry_encode(&in, buf, sizeof(buf));
+        size_t want = TELEMETRY_FRAME_LEN + ((in.flags & TLM_FLAG_LIGHT_MV) ? 2 : 0)
+                                          + ((in.flags & TLM_FLAG_TX_TS) ? 5 : 0);
+        CHECK_EQ(len, want);
+        CHECK(mesh_proto_is_frame(buf, len));
+        CHECK_EQ(mesh_proto_type(buf), MESH_MSG_TELEMETRY);
+        CHECK(telemetry_decode(buf, len, &out));
+        CHECK_EQ(out.node_id, in.node_id);
+        CHECK_EQ(out.seq, in.seq);
+        CHECK_EQ(out.temp, in.temp);
+        CHECK_EQ(out.humi, in.humi);
+        CHECK_EQ(out.light_raw, in.light_raw);
+        CHECK_EQ(out.motion, 1);
+        CHECK_EQ(out.flags, in.flags);
+        CHECK_EQ(out.light_mv, (in.flags & TLM_FLAG_LIGHT_MV) ? in.light_mv : 0);
+        CHECK_EQ(out.tx_us, (in.flags & TLM_FLAG_TX_TS) ? in.tx_us : 0);
+        CHECK_EQ(out.layer, (in.flags & TLM_FLAG_TX_TS) ? in.layer : 0);
+    }
+}
+
+static void test_reject(void) {
+    telemetry_t in = sample(TLM_FLAG_LIGHT_MV | TLM_FLAG_TX_TS), out;
+    uint8_t buf[TELEMETRY_FRAME_MAX];
+    size_t len = telemetry_encode(&in, buf, sizeof(buf));
+
+    // buffer thiếu chỗ
+    CHECK_EQ(telemetry_encode(&in, buf, len - 1), 0);
+    len = telemetry_encode(&in, buf, sizeof(buf));
+
+    // cắt cụt: thiếu phần cờ đã báo
+    for (size_t n = 0; n < len; n++) CHECK(!telemetry_decode(buf, n, &out));
+
+    uint8_t bad[TELEMETRY_FRAME_MAX];
+    memcpy(bad, buf, len);
+    bad[0] ^= 0xFF;
+    CHECK(!telemetry_decode(bad, len, &out));
+    memcpy(bad, buf, len);
+    bad[1] = MESH_PROTO_VERSION + 1;
+    CHECK(!telemetry_decode(bad, len, &out));
+    memcpy(bad, buf, len);
+    bad[2] = MESH_MSG_MOTION;
+    CHECK(!telemetry_decode(bad, len, &out));
+
+    // JSON cũ không bị nhầm là frame
+    const char *json = "{\"node_id\":\"Leaf_01\"}";
+    CHECK(!mesh_proto_is_frame((const uint8_t *)json, strlen(json)));
+    CHECK(!telemetry_decode((const uint8_t *)json, strlen(json), &out));
+}
+
+// Bit lớp ALARM trong byte type không làm hỏng decode
+static void test_class_bit(void) {
+    telemetry_t in = sample(0), out;
+    uint8_t buf[TELEMETRY_FRAME_MAX];
+    size_t len = telemetry_encode(&in, buf, sizeof(buf));
+    CHECK_EQ(mesh_proto_class(buf, len), MESH_CLASS_TELEMETRY);
+    mesh_proto_set_class(buf, MESH_CLASS_ALARM);
+    CHECK_EQ(mesh_proto_class(buf, len), MESH_CLASS_ALARM);
+    CHECK(telemetry_decode(buf, len, &out));
+    mesh_proto_set_class(buf, MESH_CLASS_TELEMETRY);
+    CHECK_EQ(buf[2], MESH_MSG_TELEMETRY);
+}
+
+// Cùng định dạng JSON cJSON cũ của leaf cho MQTT consumer
+static void test_json(void) {
+    telemetry_t t = sample(TLM_FLAG_DHT_OK | TLM_FLAG_LIGHT_MV);
+    t.node_id = 1;
+    char out[256];
+    int n = telemetry_to_json(&t, out, sizeof(out));
+    CHECK(n > 0);
+    CHECK_EQ(strcmp(out, "{\"node_id\":\"Leaf_01\",\"role\":\"leaf\",\"temp\":-5,\"humi\":81,"
+                         "\"light_v\":3.30,\"light_raw\":4095,\"light_cal\":true,\"motion\":1,\"seq\":48879}"), 0);
+
+    // chưa hiệu chuẩn: ước lượng từ raw
+    t.flags = TLM_FLAG_DHT_OK;
+    t.light_raw = 0;
+    n = telemetry_to_json(&t, out, sizeof(out));
+    CHECK(n > 0 && strstr(out, "\"light_v\":0.00") && strstr(out, "\"light_cal\":false"));
+
+    CHECK_EQ(telemetry_to_json(&t, out, 16), -1);
+}
+
+int main(void) {
+    test_roundtrip();
+    test_reject();
+    test_class_bit();
+    test_json();
+    return TEST_RESULT();
+}
@@ -0,0 +1,214 @@
+#include <string.h>
+#include "test_util.h"
+#include "stat_reduce.h"
+
+// ==== stat_reduce: số liệu cửa sổ (min/max/last/mean làm tròn), hạn cửa sổ, cấp/thu hồi entry ====
+#define ALL_FIELDS  ((1u << SUMMARY_FIELDS) - 1)
+
+static void mac_of(uint8_t i, uint8_t mac[6]) {
+    const uint8_t m[6] = { 0x24, 0x0a, 0xc4, 0x11, 0x22, i };
+    memcpy(mac, m, 6);
+}
+
+static void add4(sr_node_t *n, uint16_t seq, int32_t temp, int32_t humi, int32_t light,
+                 int32_t motion, uint32_t mask, uint32_t now_ms) {
+    const int32_t v[SUMMARY_FIELDS] = { temp, humi, light, motion };
+    sr_add(n, 7, seq, v, mask, now_ms);
+}
+
+static void test_stats(void) {
+    stat_reduce_t sr;
+    summary_t s;
+    uint8_t mac[6];
+    sr_init(&sr, 10000);
+    mac_of(1, mac);
+
+    sr_node_t *n = sr_node(&sr, mac, 1000);
+    CHECK(n != NULL);
+    CHECK(!sr_take(n, &s));                     // chưa có mẫu
+    CHECK(!sr_due(&sr, n, 1000000));
+
+    // temp 24, 27, 25 -> mean 25.33; humi 60, 61 (mẫu giữa DHT lỗi) -> 60.5
+    add4(n, 100, 24, 60, 4095, 0, ALL_FIELDS, 1000);
+    add4(n, 101, 99, 99, 0, 1, ALL_FIELDS & ~((1u << SUMMARY_TEMP) | (1u << SUMMARY_HUMI)), 3000);
+    add4(n, 102, 27, 61, 1000, 0, ALL_FIELDS, 5000);
+    add4(n, 103, 25, 99, 2000, 1, ALL_FIELDS & ~(1u << SUMMARY_HUMI), 7000);
+    CHECK(!sr_due(&sr, n, 10999));
+    CHECK(sr_due(&sr, n, 11000));               // tính từ mẫu đầu, không từ lúc cấp entry
+
+    CHECK(sr_take(n, &s));
+    CHECK_EQ(s.node_id, 7);
+    CHECK_EQ(s.seq_first, 100);
+    CHECK_EQ(s.seq_last, 103);
+    CHECK_EQ(s.samples, 4);
+    CHECK_EQ(s.span_ms, 6000);
+    CHECK_EQ(s.field_mask, ALL_FIELDS);
+
+    CHECK_EQ(s.f[SUMMARY_TEMP].count, 3);
+    CHECK_EQ(s.f[SUMMARY_TEMP].min, 24);
+    CHECK_EQ(s.f[SUMMARY_TEMP].max, 27);
+    CHECK_EQ(s.f[SUMMARY_TEMP].last, 25);
+    CHECK_EQ(s.f[SUMMARY_TEMP].mean_x100, 2533);
+    CHECK_EQ(s.f[SUMMARY_HUMI].count, 2);
+    CHECK_EQ(s.f[SUMMARY_HUMI].last, 61);
+    CHECK_EQ(s.f[SUMMARY_HUMI].mean_x100, 6050);
+    CHECK_EQ(s.f[SUMMARY_LIGHT].count, 4);
+    CHECK_EQ(s.f[SUMMARY_LIGHT].min, 0);
+    CHECK_EQ(s.f[SUMMARY_LIGHT].max, 4095);
+    CHECK_EQ(s.f[SUMMARY_LIGHT].mean_x100, 177375);     // 7095 / 4
+    CHECK_EQ(s.f[SUMMARY_MOTION].mean_x100, 50);
+
+    // take xóa cửa sổ, entry giữ MAC cho cửa sổ sau
+    CHECK(!sr_take(n, &s));
+    CHECK(!sr_due(&sr, n, 50000));
+    CHECK(sr_node(&sr, mac, 50000) == n);
+
+    // trường không có mẫu nào: không có bit trong field_mask
+    add4(n, 200, 0, 0, 10, 0, 1u << SUMMARY_LIGHT, 60000);
+    CHECK(sr_take(n, &s));
+    CHECK_EQ(s.field_mask, 1u << SUMMARY_LIGHT);
+    CHECK_EQ(s.f[SUMMARY_TEMP].count, 0);
+    CHECK_EQ(s.span_ms, 0);
+}
+
+// mean_x100 làm tròn về phía xa 0, min/max/last ép về int16
+static void test_rounding(void) {
+    stat_reduce_t sr;
+    summary_t s;
+    uint8_t mac[6];
+    sr_init(&sr, 1000);
+    mac_of(2, mac);
+    sr_node_t *n = sr_node(&sr, mac, 0);
+
+    // 1, 0, 0: 33.33 -> 33; 2, 0, 0: 66.67 -> 67; -2, 0, 0: -66.67 -> -67; 1, 0: 50 -> 50
+    static const struct { int32_t v[3]; int cnt; int32_t want; } cases[] = {
+        { { 1, 0, 0 }, 3, 33 }, { { 2, 0, 0 }, 3, 67 }, { { -2, 0, 0 }, 3, -67 },
+        { { -1, 0, 0 }, 3, -33 }, { { 1, 0, 0 }, 2, 50 }, { { -1, 0, 0 }, 2, -50 },
+        { { -5, -6, 0 }, 2, -550 }, { { 0, 0, 0 }, 1, 0 },
+    };
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        for (int k = 0; k < cases[c].cnt; k++) {
+            add4(n, (uint16_t)k, cases[c].v[k], 0, 0, 0, 1u << SUMMARY_TEMP, (uint32_t)k);
+        }
+        CHECK(sr_take(n, &s));
+        CHECK_EQ(s.f[SUMMARY_TEMP].mean_x100, cases[c].want);
+    }
+
+    add4(n, 1, 40000, 0, 0, 0, 1u << SUMMARY_TEMP, 0);
+    add4(n, 2, -40000, 0, 0, 0, 1u << SUMMARY_TEMP, 0);
+    CHECK(sr_take(n, &s));
+    CHECK_EQ(s.f[SUMMARY_TEMP].max, INT16_MAX);
+    CHECK_EQ(s.f[SUMMARY_TEMP].min, INT16_MIN);
+    CHECK_EQ(s.f[SUMMARY_TEMP].last, INT16_MIN);
+    CHECK_EQ(s.f[SUMMARY_TEMP].mean_x100, 0);
+
+    // 65535 mẫu ADC max: tổng không tràn, mẫu thứ 65536 bị bỏ thay vì wrap count
+    for (uint32_t k = 0; k < UINT16_MAX + 10u; k++) {
+        add4(n, (uint16_t)k, 0, 0, 4095, 0, 1u << SUMMARY_LIGHT, k);
+    }
+    CHECK(sr_take(n, &s));
+    CHECK_EQ(s.samples, UINT16_MAX);
+    CHECK_EQ(s.f[SUMMARY_LIGHT].count, UINT16_MAX);
+    CHECK_EQ(s.f[SUMMARY_LIGHT].mean_x100, 409500);
+}
+
+// Hạn cửa sổ qua mốc wrap 32 bit của đồng hồ ms (~49 ngày)
+static void test_due_wrap(void) {
+    stat_reduce_t sr;
+    uint8_t mac[6];
+    sr_init(&sr, 5000);
+    mac_of(3, mac);
+    uint32_t t0 = UINT32_MAX - 2000;
+    sr_node_t *n = sr_node(&sr, mac, t0);
+    add4(n, 1, 1, 1, 1, 0, ALL_FIELDS, t0);
+    CHECK(!sr_due(&sr, n, t0 + 4999));
+    CHECK(sr_due(&sr, n, t0 + 5000));
+}
+
+static void test_alloc(void) {
+    stat_reduce_t sr;
+    summary_t s;
+    uint8_t mac[6];
+
+    // bảng đầy: leaf mới đi thô, không lấy chỗ entry đang có mẫu
+    sr_init(&sr, 1000);
+    for (uint8_t i = 0; i < SR_MAX_NODES; i++) {
+        mac_of(i, mac);
+        sr_node_t *n = sr_node(&sr, mac, 0);
+        CHECK(n != NULL);
+        add4(n, 1, 1, 1, 1, 0, ALL_FIELDS, 0);
+    }
+    mac_of(100, mac);
+    CHECK(sr_node(&sr, mac, 1000000) == NULL);
+    CHECK_EQ(sr.full_drops, 1);
+
+    // xả mẫu rồi im lặng quá SR_IDLE_WINDOWS cửa sổ -> được thu hồi; đúng mốc thì chưa
+    for (int i = 0; i < SR_MAX_NODES; i++) sr_take(&sr.nodes[i], &s);
+    CHECK(sr_node(&sr, mac, 1000 * SR_IDLE_WINDOWS) == NULL);
+    sr_node_t *n = sr_node(&sr, mac, 1000 * SR_IDLE_WINDOWS + 1);
+    CHECK(n == &sr.nodes[0]);
+    CHECK_EQ(memcmp(n->mac, mac, 6), 0);
+    CHECK_EQ(n->samples, 0);
+
+    // entry raw (lệnh relay_raw) không bao giờ bị thu hồi
+    sr_init(&sr, 1000);
+    for (uint8_t i = 0; i < SR_MAX_NODES; i++) {
+        mac_of(i, mac);
+        sr_node(&sr, mac, 0)->raw = (i % 2) == 0;
+    }
+    for (uint8_t i = 0; i < SR_MAX_NODES / 2; i++) {
+        mac_of((uint8_t)(100 + i), mac);
+        n = sr_node(&sr, mac, 1000000);
+        CHECK(n != NULL);
+        CHECK(n == &sr.nodes[2 * i + 1]);
+        CHECK(!n->raw);
+    }
+    // leaf mới vừa cấp chưa hết hạn, entry raw thì không bao giờ
+    uint32_t later = 1000000 + 1000 * SR_IDLE_WINDOWS;
+    mac_of(200, mac);
+    CHECK(sr_node(&sr, mac, later) == NULL);
+    for (uint8_t i = 0; i < SR_MAX_NODES; i += 2) {
+        mac_of(i, mac);
+        n = sr_node(&sr, mac, later);
+        CHECK(n == &sr.nodes[i]);
+        CHECK(n->raw);
+    }
+}
+
+// RELAY_REDUCE_WINDOW_MS = 0: relay_raw lần lượt cho nhiều leaf phải giữ đủ cờ,
+// trước đây idle_ms = 0 nên mỗi MAC mới lấy chỗ của MAC trước
+static void test_window_off(void) {
+    stat_reduce_t sr;
+    uint8_t mac[6];
+    sr_init(&sr, 0);
+    for (uint8_t i = 0; i < SR_MAX_NODES; i++) {
+        mac_of(i, mac);
+        sr_node_t *n = sr_node(&sr, mac, 1000u * i);
+        CHECK(n == &sr.nodes[i]);
+        n->raw = true;
+    }
+    for (uint8_t i = 0; i < SR_MAX_NODES; i++) {
+        mac_of(i, mac);
+        sr_node_t *n = sr_node(&sr, mac, 100000);
+        CHECK(n == &sr.nodes[i]);
+        CHECK(n && n->raw);
+    }
+    mac_of(100, mac);
+    CHECK(sr_node(&sr, mac, 100000) == NULL);
+    CHECK_EQ(sr.full_drops, 1);
+
+    // relay_raw tắt cờ khi rút gọn vẫn tắt: entry vẫn giữ chỗ
+    sr.nodes[3].raw = false;
+    CHECK(sr_node(&sr, mac, 200000) == NULL);
+    mac_of(3, mac);
+    CHECK(sr_node(&sr, mac, 200000) == &sr.nodes[3]);
+}
+
+int main(void) {
+    test_stats();
+    test_rounding();
+    test_due_wrap();
+    test_alloc();
+    test_window_off();
+    return TEST_RESULT();
+}
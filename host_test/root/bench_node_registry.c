@@ -0,0 +1,98 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test_util.h"
+#include "node_registry.h"
+
+// ==== node_registry: insert / tra cứu ở 64..4096 node, so với quét tuyến tính ====
+// MAC thật của ESP32 cùng lô: chung 3 byte OUI, 3 byte cuối gần liên tiếp.
+#define LOOKUPS     2000000
+
+static void make_mac(uint32_t i, uint8_t mac[6]) {
+    mac[0] = 0x24; mac[1] = 0x6F; mac[2] = 0x28;
+    uint32_t nic = 0x1A0000u + i * 4u;      // esp_mesh dùng MAC base + 0..3
+    mac[3] = (uint8_t)(nic >> 16); mac[4] = (uint8_t)(nic >> 8); mac[5] = (uint8_t)nic;
+}
+
+// Cách cũ: mảng + memcmp lần lượt
+static int linear_find(uint8_t (*macs)[6], uint32_t n, const uint8_t mac[6]) {
+    for (uint32_t i = 0; i < n; i++) {
+        if (memcmp(macs[i], mac, 6) == 0) return (int)i;
+    }
+    return -1;
+}
+
+static void run(uint32_t max_nodes) {
+    uint32_t cap = 2;
+    while (cap < NODE_REGISTRY_CAP_MIN(max_nodes)) cap <<= 1;
+    node_entry_t *slots = calloc(cap, sizeof(*slots));
+    uint8_t (*macs)[6] = calloc(max_nodes + 1, 6);
+    node_registry_t reg;
+    CHECK(node_registry_init(&reg, slots, cap, max_nodes, "mesh"));
+
+    for (uint32_t i = 0; i <= max_nodes; i++) make_mac(i, macs[i]);
+
+    uint64_t t0 = test_now_ns();
+    for (uint32_t i = 0; i < max_nodes; i++) {
+        node_entry_t *e = node_registry_get(&reg, macs[i], i);
+        CHECK(e != NULL);
+    }
+    uint64_t t1 = test_now_ns();
+    CHECK_EQ(reg.count, max_nodes);
+    CHECK(node_registry_get(&reg, macs[max_nodes], 0) == NULL);
+    CHECK_EQ(reg.full_drops, 1);
+
+    // lookup theo thứ tự frame ngẫu nhiên, đúng entry, đúng topic
+    uint32_t rng = 7, hit = 0;
+    uint64_t t2 = test_now_ns();
+    for (uint32_t k = 0; k < LOOKUPS; k++) {
+        uint32_t i = test_rand(&rng) % max_nodes;
+        node_entry_t *e = node_registry_get(&reg, macs[i], k);
+        hit += e && e->mac[5] == macs[i][5];
+    }
+    uint64_t t3 = test_now_ns();
+    CHECK_EQ(hit, LOOKUPS);
+
+    for (uint32_t k = 0; k < LOOKUPS; k++) {
+        uint8_t mac[6];
+        make_mac(max_nodes + 1 + test_rand(&rng) % 100000, mac);
+        hit += node_registry_find(&reg, mac) != NULL;
+    }
+    uint64_t t4 = test_now_ns();
+    CHECK_EQ(hit, LOOKUPS);
+
+    for (uint32_t k = 0; k < LOOKUPS; k++) {
+        uint32_t i = test_rand(&rng) % max_nodes;
+        hit += linear_find(macs, max_nodes, macs[i]) == (int)i;
+    }
+    uint64_t t5 = test_now_ns();
+    CHECK_EQ(hit, 2 * LOOKUPS);
+
+    // tx_slot trải đều: mỗi slot có max_nodes / NODE_TX_SLOTS node (±1)
+    uint32_t per_slot[NODE_TX_SLOTS] = {0};
+    for (uint32_t i = 0; i < max_nodes; i++) per_slot[node_registry_find(&reg, macs[i])->tx_slot]++;
+    uint32_t lo = UINT32_MAX, hi = 0;
+    for (int s = 0; s < NODE_TX_SLOTS; s++) {
+        if (per_slot[s] < lo) lo = per_slot[s];
+        if (per_slot[s] > hi) hi = per_slot[s];
+    }
+    CHECK(hi - lo <= 1);
+
+    printf("%5u node / %5u slot: insert %6.1f ns, get hit %6.1f ns, find miss %6.1f ns, "
+           "quét tuyến tính %8.1f ns\n", max_nodes, cap,
+           (double)(t1 - t0) / max_nodes, (double)(t3 - t2) / LOOKUPS,
+           (double)(t4 - t3) / LOOKUPS, (double)(t5 - t4) / LOOKUPS);
+    free(macs);
+    free(slots);
+}
+
+int main(void) {
+    node_registry_t reg;
+    node_entry_t slots[8];
+    CHECK(!node_registry_init(&reg, slots, 6, 3, "mesh"));
+    CHECK(!node_registry_init(&reg, slots, 8, 5, "mesh"));
+
+    run(64);
+    run(1024);
+    run(4096);
+    return TEST_RESULT();
+}
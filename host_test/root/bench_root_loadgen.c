@@ -0,0 +1,39 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include "test_util.h"
+#include "idf_shim.h"
+#include "loadgen.h"
+
+// ==== main.c build với ROOT_LOADGEN=1: leaf ảo của loadgen.c thay esp_mesh_recv ====
+// Đo phía host cùng đường recv -> decode -> publish như trên ESP32 (MQTT giả, không mạng).
+// Số đo chỉ để so sánh giữa các commit, không phải thông lượng thật của ESP32.
+// Tham số: [giây chạy], mặc định 2.
+
+void app_main(void);
+
+int main(int argc, char **argv) {
+    int secs = argc > 1 ? atoi(argv[1]) : 2;
+    if (secs <= 0) secs = 2;
+
+    // "Raw ring full" mỗi frame bỏ sẽ lấn kết quả; tỉ lệ giao đủ thấy ở dòng delivered
+    setenv("SHIM_LOG", "E", 0);
+    app_main();
+    ip_event_got_ip_t ip = { .ip_info.ip.addr = 0x0a01a8c0 };
+    shim_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &ip);
+    shim_mqtt_event(MQTT_EVENT_CONNECTED, NULL, NULL);
+
+    loadgen_stats_t a, b;
+    loadgen_get_stats(&a);
+    size_t pub0 = shim_mqtt_count();
+    sleep((unsigned)secs);
+    loadgen_get_stats(&b);
+    size_t pub1 = shim_mqtt_count();
+
+    float dt = (b.elapsed_ms - a.elapsed_ms) / 1000.0f;
+    uint32_t gen = (b.generated + b.alarms) - (a.generated + a.alarms);
+    printf("loadgen %u leaf x %u ms, %d s\n", LOADGEN_LEAVES, LOADGEN_PERIOD_MS, secs);
+    printf("generated : %8.0f frame/s (late %u)\n", gen / dt, (unsigned)(b.late - a.late));
+    printf("published : %8.0f msg/s\n", (pub1 - pub0) / dt);
+    printf("delivered : %7.1f %%\n", gen ? 100.0 * (double)(pub1 - pub0) / gen : 0.0);
+    return 0;
+}
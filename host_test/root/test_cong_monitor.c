@@ -0,0 +1,137 @@
+#include "test_util.h"
+#include "cong_monitor.h"
+#include "congest.h"
+
+// ==== cong_monitor: ngưỡng từng đầu vào, lên ngay / xuống từng bậc sau CONG_HOLD_MS ====
+#define HEAP_OK     (200 * 1024)
+
+static cong_input_t in_of(uint8_t ring_pct, uint32_t outbox, uint32_t heap) {
+    return (cong_input_t){ .ring_pct = ring_pct, .outbox_bytes = outbox, .free_heap = heap };
+}
+
+static uint8_t lvl(uint8_t ring_pct, uint32_t outbox, uint32_t heap) {
+    cong_input_t in = in_of(ring_pct, outbox, heap);
+    return cong_monitor_level_of(&in);
+}
+
+static void test_level_of(void) {
+    CHECK_EQ(lvl(0, 0, HEAP_OK), 0);
+    CHECK_EQ(lvl(24, 0, HEAP_OK), 0);
+    CHECK_EQ(lvl(25, 0, HEAP_OK), 1);
+    CHECK_EQ(lvl(50, 0, HEAP_OK), 2);
+    CHECK_EQ(lvl(75, 0, HEAP_OK), 3);
+    CHECK_EQ(lvl(100, 0, HEAP_OK), CONG_LEVEL_MAX);
+
+    CHECK_EQ(lvl(0, 8 * 1024 - 1, HEAP_OK), 0);
+    CHECK_EQ(lvl(0, 8 * 1024, HEAP_OK), 1);
+    CHECK_EQ(lvl(0, 32 * 1024, HEAP_OK), 3);
+
+    CHECK_EQ(lvl(0, 0, 48 * 1024), 0);
+    CHECK_EQ(lvl(0, 0, 48 * 1024 - 1), 1);
+    CHECK_EQ(lvl(0, 0, 20 * 1024 - 1), 3);
+
+    // mức thô = max của các đầu vào
+    CHECK_EQ(lvl(30, 20 * 1024, 40 * 1024), 2);
+    CHECK_EQ(lvl(80, 0, 40 * 1024), 3);
+}
+
+static bool upd(cong_monitor_t *c, uint8_t ring_pct, uint32_t now_ms) {
+    cong_input_t in = in_of(ring_pct, 0, HEAP_OK);
+    return cong_monitor_update(c, &in, now_ms);
+}
+
+static void test_hysteresis(void) {
+    cong_monitor_t c;
+    cong_monitor_init(&c);
+
+    // lên thẳng mức 3
+    CHECK(!upd(&c, 10, 0));
+    CHECK(upd(&c, 90, 1000));
+    CHECK_EQ(c.level, 3);
+
+    // xuống: mốc bắt đầu từ lần đo thấp đầu tiên, mỗi bậc giữ đủ CONG_HOLD_MS
+    uint32_t t = 2000;
+    CHECK(!upd(&c, 0, t));
+    CHECK(!upd(&c, 0, t + CONG_HOLD_MS - 1));
+    CHECK(upd(&c, 0, t + CONG_HOLD_MS));
+    CHECK_EQ(c.level, 2);
+    CHECK(!upd(&c, 0, t + 2 * CONG_HOLD_MS - 1));
+    CHECK(upd(&c, 0, t + 2 * CONG_HOLD_MS));
+    CHECK_EQ(c.level, 1);
+
+    // mức thô quay về bằng level: hủy đếm, phải giữ lại từ đầu
+    CHECK(!upd(&c, 30, t + 2 * CONG_HOLD_MS + 100));
+    CHECK(!upd(&c, 0, t + 2 * CONG_HOLD_MS + 200));
+    CHECK(!upd(&c, 0, t + 3 * CONG_HOLD_MS + 199));
+    CHECK(upd(&c, 0, t + 3 * CONG_HOLD_MS + 200));
+    CHECK_EQ(c.level, 0);
+    CHECK_EQ(c.changes, 4);
+
+    // đồng hồ ms wrap giữa lúc đang hạ
+    cong_monitor_init(&c);
+    t = UINT32_MAX - 1000;
+    upd(&c, 60, t);
+    CHECK(!upd(&c, 0, t + 1));
+    CHECK(!upd(&c, 0, t + CONG_HOLD_MS));
+    CHECK(upd(&c, 0, t + 1 + CONG_HOLD_MS));
+    CHECK_EQ(c.level, 1);
+}
+
+// Burst mỗi vài giây (ring lên 80% rồi rỗng): level giữ ở 3, không dao động theo từng burst
+static void test_burst_trace(void) {
+    cong_monitor_t c;
+    cong_monitor_init(&c);
+    uint32_t seed = 5, flips = 0, next_burst = 0, last_burst = 0;
+    uint8_t prev = 0;
+    for (uint32_t t = 0; t < 600000; t += 500) {
+        uint8_t ring = 5;
+        if (t >= next_burst) {
+            ring = 80;
+            last_burst = t;
+            next_burst = t + 2000 + test_rand(&seed) % (CONG_HOLD_MS - 2000);
+        }
+        upd(&c, ring, t);
+        flips += c.level != prev;
+        prev = c.level;
+    }
+    CHECK_EQ(c.level, 3);
+    CHECK_EQ(flips, 1);
+
+    // hết burst: về 0 sau đúng 3 bậc, tính từ lần đo thấp đầu tiên sau burst cuối
+    uint32_t t = 600000;
+    while (c.level && t < 600000 + 10 * CONG_HOLD_MS) {
+        upd(&c, 5, t);
+        t += 500;
+    }
+    CHECK_EQ(c.level, 0);
+    CHECK_EQ(t - 500 - (last_burst + 500), 3 * CONG_HOLD_MS);
+    CHECK_EQ(c.changes, 4);
+}
+
+static void test_codec(void) {
+    uint8_t buf[CONG_FRAME_LEN];
+    congest_t c = { .level = 2, .ttl_s = 300 }, o;
+    CHECK_EQ(congest_encode(&c, buf, sizeof(buf) - 1), 0);
+    CHECK_EQ(congest_encode(&c, buf, sizeof(buf)), CONG_FRAME_LEN);
+    CHECK(congest_decode(buf, sizeof(buf), &o));
+    CHECK_EQ(o.level, 2);
+    CHECK_EQ(o.ttl_s, 300);
+    CHECK(!congest_decode(buf, sizeof(buf) - 1, &o));
+
+    // mức ngoài khoảng bị kẹp cả hai phía
+    c.level = 9;
+    congest_encode(&c, buf, sizeof(buf));
+    CHECK_EQ(buf[4], CONG_LEVEL_MAX);
+    buf[4] = 200;
+    CHECK(congest_decode(buf, sizeof(buf), &o));
+    CHECK_EQ(o.level, CONG_LEVEL_MAX);
+    CHECK_EQ(CONG_STRETCH(CONG_LEVEL_MAX), 8);
+}
+
+int main(void) {
+    test_level_of();
+    test_hysteresis();
+    test_burst_trace();
+    test_codec();
+    return TEST_RESULT();
+}
@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "test_util.h"
+#include "flash_journal.h"
+
+// ==== flash_journal trên file giả lập NOR flash ====
+// write chỉ kéo bit 1 -> 0 (AND với nội dung cũ), erase trả về 0xFF như chip thật.
+// write_budget giới hạn số byte còn ghi được để mô phỏng mất điện giữa lúc flush.
+#define TEST_PAGES      4
+
+typedef struct {
+    int      fd;
+    long     write_budget;     // < 0: không giới hạn
+    uint32_t erases[TEST_PAGES];
+} file_flash_t;
+
+static int ff_read(void *ctx, uint32_t off, void *buf, size_t len) {
+    file_flash_t *f = ctx;
+    return pread(f->fd, buf, len, off) == (ssize_t)len ? 0 : -1;
+}
+
+static int ff_write(void *ctx, uint32_t off, const void *buf, size_t len) {
+    file_flash_t *f = ctx;
+    uint8_t cur[JOURNAL_PAGE_SIZE];
+    const uint8_t *src = buf;
+    size_t n = len;
+    if (f->write_budget >= 0 && (long)n > f->write_budget) n = (size_t)f->write_budget;
+    if (len > sizeof(cur) || pread(f->fd, cur, n, off) != (ssize_t)n) return -1;
+    for (size_t i = 0; i < n; i++) cur[i] &= src[i];
+    if (pwrite(f->fd, cur, n, off) != (ssize_t)n) return -1;
+    if (f->write_budget >= 0) {
+        f->write_budget -= (long)n;
+        if (n < len) return -1;
+    }
+    return 0;
+}
+
+static int ff_erase(void *ctx, uint32_t off, size_t len) {
+    file_flash_t *f = ctx;
+    uint8_t ff[JOURNAL_PAGE_SIZE];
+    memset(ff, 0xFF, sizeof(ff));
+    for (size_t p = 0; p < len; p += JOURNAL_PAGE_SIZE) {
+        if (pwrite(f->fd, ff, sizeof(ff), off + p) != (ssize_t)sizeof(ff)) return -1;
+        f->erases[(off + p) / JOURNAL_PAGE_SIZE]++;
+    }
+    return 0;
+}
+
+static journal_flash_t ff_open(file_flash_t *f) {
+    FILE *fp = tmpfile();
+    memset(f, 0, sizeof(*f));
+    f->fd = fileno(fp);
+    f->write_budget = -1;
+    uint8_t blank[JOURNAL_PAGE_SIZE];
+    memset(blank, 0xFF, sizeof(blank));
+    for (int p = 0; p < TEST_PAGES; p++) {
+        if (pwrite(f->fd, blank, sizeof(blank), (off_t)p * JOURNAL_PAGE_SIZE) != (ssize_t)sizeof(blank)) {
+            CHECK(!"không tạo được file flash");
+        }
+    }
+    return (journal_flash_t){ ff_read, ff_write, ff_erase, f, TEST_PAGES * JOURNAL_PAGE_SIZE };
+}
+
+// Record i: 4 byte chỉ số + phần đệm dài thay đổi 20..219 byte
+static size_t make_rec(uint32_t i, uint8_t *buf) {
+    size_t len = 4 + 20 + (i * 37u) % 200;
+    memcpy(buf, &i, 4);
+    for (size_t k = 4; k < len; k++) buf[k] = (uint8_t)(i + k);
+    return len;
+}
+
+static bool rec_ok(const uint8_t *buf, int len, uint32_t *idx) {
+    uint8_t want[JOURNAL_MAX_RECORD];
+    if (len < 4) return false;
+    memcpy(idx, buf, 4);
+    return (size_t)len == make_rec(*idx, want) && memcmp(buf, want, (size_t)len) == 0;
+}
+
+static void append_range(journal_t *j, uint32_t from, uint32_t to) {
+    uint8_t buf[JOURNAL_MAX_RECORD];
+    for (uint32_t i = from; i < to; i++) {
+        size_t len = make_rec(i, buf);
+        CHECK_EQ(journal_append(j, buf, len), 0);
+    }
+}
+
+// Đọc hết, trả về số record; *first / *last là chỉ số đầu / cuối, kiểm tra liên tục
+static uint32_t drain_all(journal_t *j, uint32_t *first, uint32_t *last, uint32_t *gaps) {
+    uint8_t buf[JOURNAL_MAX_RECORD];
+    uint32_t n = 0, idx = 0;
+    int len;
+    *gaps = 0;
+    while ((len = journal_peek(j, buf, sizeof(buf))) > 0) {
+        CHECK(rec_ok(buf, len, &idx));
+        if (n == 0) *first = idx;
+        else if (idx != *last + 1) (*gaps)++;
+        *last = idx;
+        journal_pop(j);
+        n++;
+    }
+    CHECK_EQ(len, 0);
+    return n;
+}
+
+// ~28 record trung bình 128B mỗi page
+#define RECS_PER_PAGE   28
+
+static void test_mount_roundtrip(void) {
+    file_flash_t f;
+    journal_flash_t fl = ff_open(&f);
+    journal_t j;
+    uint8_t buf[JOURNAL_MAX_RECORD];
+
+    CHECK_EQ(journal_mount(&j, &fl), 0);
+    CHECK(journal_empty(&j));
+    CHECK_EQ(journal_peek(&j, buf, sizeof(buf)), 0);
+
+    // record đầu tiên đọc được ngay từ page RAM, chưa cần flush
+    append_range(&j, 0, 1);
+    CHECK(journal_unflushed(&j) > 0);
+    uint32_t idx;
+    CHECK(rec_ok(buf, journal_peek(&j, buf, sizeof(buf)), &idx) && idx == 0);
+    journal_pop(&j);
+    CHECK(journal_empty(&j));
+
+    // buffer nhỏ hơn record -> lỗi, record vẫn còn
+    append_range(&j, 1, 2);
+    CHECK_EQ(journal_peek(&j, buf, 8), -1);
+    CHECK(!journal_empty(&j));
+    CHECK_EQ(journal_append(&j, buf, 0), -1);
+    CHECK_EQ(journal_append(&j, buf, JOURNAL_MAX_RECORD + 1), -1);
+
+    // qua nhiều page, đọc theo đúng thứ tự
+    append_range(&j, 2, 2 * RECS_PER_PAGE);
+    uint32_t first = 0, last = 0, gaps;
+    CHECK_EQ(drain_all(&j, &first, &last, &gaps), 2 * RECS_PER_PAGE - 1);
+    CHECK_EQ(first, 1);
+    CHECK_EQ(last, 2 * RECS_PER_PAGE - 1);
+    CHECK_EQ(gaps, 0);
+    CHECK_EQ(j.stats.errors, 0);
+    close(f.fd);
+}
+
+// Ghi + đọc song song quanh vòng nhiều lần: không mất record, mọi page mòn đều nhau
+static void test_wrap(void) {
+    file_flash_t f;
+    journal_flash_t fl = ff_open(&f);
+    journal_t j;
+    CHECK_EQ(journal_mount(&j, &fl), 0);
+
+    uint32_t next = 0, expect = 0, last = 0, first = 0, gaps;
+    for (int round = 0; round < 40; round++) {
+        append_range(&j, next, next + RECS_PER_PAGE / 2);
+        next += RECS_PER_PAGE / 2;
+        uint32_t n = drain_all(&j, &first, &last, &gaps);
+        CHECK_EQ(n, RECS_PER_PAGE / 2);
+        CHECK_EQ(first, expect);
+        CHECK_EQ(gaps, 0);
+        expect = last + 1;
+    }
+    CHECK_EQ(j.stats.dropped_pages, 0);
+    uint32_t lo = f.erases[0], hi = f.erases[0];
+    for (int p = 1; p < TEST_PAGES; p++) {
+        if (f.erases[p] < lo) lo = f.erases[p];
+        if (f.erases[p] > hi) hi = f.erases[p];
+    }
+    printf("wrap: %u record, erase/page %u..%u\n", next, lo, hi);
+    CHECK(lo >= 3);
+    CHECK(hi - lo <= 1);
+    close(f.fd);
+}
+
+// Không ai đọc: journal đầy thì page cũ nhất bị bỏ, phần còn lại liên tục tới record mới nhất
+static void test_drop_oldest(void) {
+    file_flash_t f;
+    journal_flash_t fl = ff_open(&f);
+    journal_t j;
+    CHECK_EQ(journal_mount(&j, &fl), 0);
+
+    const uint32_t total = 3 * TEST_PAGES * RECS_PER_PAGE;
+    append_range(&j, 0, total);
+    CHECK(j.stats.dropped_pages >= 2 * TEST_PAGES - 1);
+
+    uint32_t first = 0, last = 0, gaps;
+    uint32_t n = drain_all(&j, &first, &last, &gaps);
+    printf("drop: %u/%u record còn, dropped_pages=%u, từ #%u\n", n, total, j.stats.dropped_pages, first);
+    CHECK(first > 0);
+    CHECK_EQ(last, total - 1);
+    CHECK_EQ(gaps, 0);
+    CHECK_EQ(n, total - first);
+    // còn ít nhất (n_pages - 1) page đầy
+    CHECK(n >= (TEST_PAGES - 1) * (RECS_PER_PAGE - 4));
+    close(f.fd);
+}
+
+// Hỏng 1 byte dữ liệu trong page giữa: bỏ phần còn lại của page đó, đọc tiếp page sau
+static void test_crc_skip(void) {
+    file_flash_t f;
+    journal_flash_t fl = ff_open(&f);
+    journal_t j;
+    CHECK_EQ(journal_mount(&j, &fl), 0);
+
+    append_range(&j, 0, 3 * RECS_PER_PAGE);
+    CHECK_EQ(journal_flush(&j), 0);
+
+    // record thứ 3 của page 1 (page 0 = header seq 1)
+    uint8_t rh[JOURNAL_REC_HDR_LEN];
+    uint32_t off = JOURNAL_PAGE_SIZE + JOURNAL_PAGE_HDR_LEN;
+    for (int k = 0; k < 2; k++) {
+        CHECK_EQ(pread(f.fd, rh, sizeof(rh), off), (ssize_t)sizeof(rh));
+        off += JOURNAL_REC_HDR_LEN + (uint32_t)(rh[0] | (rh[1] << 8));
+    }
+    uint8_t b;
+    CHECK_EQ(pread(f.fd, &b, 1, off + JOURNAL_REC_HDR_LEN + 6), 1);
+    b ^= 0x10;
+    CHECK_EQ(pwrite(f.fd, &b, 1, off + JOURNAL_REC_HDR_LEN + 6), 1);
+
+    uint8_t buf[JOURNAL_MAX_RECORD];
+    uint32_t idx, prev = 0, n = 0, jumps = 0;
+    int len;
+    while ((len = journal_peek(&j, buf, sizeof(buf))) > 0) {
+        CHECK(rec_ok(buf, len, &idx));
+        if (n && idx != prev + 1) jumps++;
+        prev = idx;
+        n++;
+        journal_pop(&j);
+    }
+    CHECK_EQ(j.stats.errors, 1);
+    CHECK_EQ(jumps, 1);
+    CHECK_EQ(prev, 3 * RECS_PER_PAGE - 1);
+    CHECK(n < 3 * RECS_PER_PAGE - 2);
+    close(f.fd);
+}
+
+// Mất điện: page đã replay xong không phát lại, page đang đọc dở phát lại từ đầu
+// (at-least-once), record còn trong RAM mất, record ghi dở bị CRC loại.
+static void test_power_loss(void) {
+    file_flash_t f;
+    journal_flash_t fl = ff_open(&f);
+    journal_t j;
+    uint8_t buf[JOURNAL_MAX_RECORD];
+    uint32_t idx, first = 0, last = 0, gaps;
+
+    CHECK_EQ(journal_mount(&j, &fl), 0);
+    append_range(&j, 0, 2 * RECS_PER_PAGE);
+    CHECK_EQ(journal_flush(&j), 0);
+
+    // replay hết page 1, đọc dở page 2
+    uint32_t page2_first = 0;
+    for (uint32_t n = 0;; n++) {
+        CHECK(rec_ok(buf, journal_peek(&j, buf, sizeof(buf)), &idx));
+        if (j.r_seq == 2 && page2_first == 0) page2_first = idx;
+        journal_pop(&j);
+        if (page2_first && idx >= page2_first + 3) break;
+        if (n > 2 * RECS_PER_PAGE) break;
+    }
+    CHECK(page2_first > 0);
+
+    // thêm record chỉ nằm trong RAM rồi "mất điện"
+    append_range(&j, 2 * RECS_PER_PAGE, 2 * RECS_PER_PAGE + 5);
+
+    journal_t j2;
+    CHECK_EQ(journal_mount(&j2, &fl), 0);
+    uint32_t n = drain_all(&j2, &first, &last, &gaps);
+    CHECK_EQ(first, page2_first);
+    CHECK_EQ(last, 2 * RECS_PER_PAGE - 1);
+    CHECK_EQ(gaps, 0);
+    CHECK(n > 0);
+
+    // record sau reboot nối tiếp bình thường
+    append_range(&j2, 1000, 1010);
+    CHECK_EQ(drain_all(&j2, &first, &last, &gaps), 10);
+    CHECK_EQ(first, 1000);
+
+    // Flush bị cắt giữa record: lần mount sau giữ các record đầy đủ, bỏ record rách
+    CHECK_EQ(journal_flush(&j2), 0);
+    append_range(&j2, 2000, 2010);
+    CHECK_EQ(journal_flush(&j2), 0);
+    append_range(&j2, 2010, 2020);
+    f.write_budget = 4 * 100;
+    CHECK_EQ(journal_flush(&j2), -1);
+    f.write_budget = -1;
+
+    journal_t j3;
+    CHECK_EQ(journal_mount(&j3, &fl), 0);
+    n = drain_all(&j3, &first, &last, &gaps);
+    printf("power loss: replay %u record #%u..#%u sau flush rách\n", n, first, last);
+    // page chưa consumed: #1000..#1009 đã pop vẫn phát lại, rồi nhảy sang #2000
+    CHECK_EQ(first, 1000);
+    CHECK_EQ(gaps, 1);
+    CHECK(last >= 2010 && last < 2019);
+    CHECK(j3.stats.errors <= 1);
+    close(f.fd);
+}
+
+int main(void) {
+    test_mount_roundtrip();
+    test_wrap();
+    test_drop_oldest();
+    test_crc_skip();
+    test_power_loss();
+    return TEST_RESULT();
+}
@@ -0,0 +1,233 @@
+#include <stdbool.h>
+#include <string.h>
+#include "test_util.h"
+#include "frag.h"
+#include "frag_reasm.h"
+
+// ==== frag + frag_reasm: cắt/ghép khứ hồi, mảnh lặp/thiếu/hết hạn, fuzz header mảnh ====
+// Chạy với -DHOST_TEST_SANITIZE=ON để ASan bắt mọi memcpy ra ngoài buffer context.
+#define CTX_N       3
+#define TIMEOUT_MS  2000
+#define FUZZ_ITERS  200000
+
+static frag_ctx_t   s_ctx[CTX_N];
+static frag_reasm_t s_r;
+static uint8_t      s_msg[FRAG_REASM_MSG_MAX];
+
+static const uint8_t MAC_A[6] = { 0x24, 0x0a, 0xc4, 0x11, 0x22, 0x01 };
+static const uint8_t MAC_B[6] = { 0x24, 0x0a, 0xc4, 0x11, 0x22, 0x02 };
+
+static void fill_msg(size_t len, uint32_t seed) {
+    for (size_t i = 0; i < len; i++) s_msg[i] = (uint8_t)test_rand(&seed);
+}
+
+// Đẩy 1 mảnh qua đúng đường của root: frag_decode rồi frag_reasm_push
+static uint8_t *push_frame(const uint8_t mac[6], const uint8_t *frame, size_t n,
+                           uint32_t now_ms, size_t *len) {
+    frag_t f;
+    if (!frag_decode(frame, n, &f)) return NULL;
+    return frag_reasm_push(&s_r, mac, &f, now_ms, len);
+}
+
+static void test_codec(void) {
+    uint8_t buf[FRAG_RX_MAX];
+    frag_t f;
+
+    CHECK_EQ(frag_count(0), 0);
+    CHECK_EQ(frag_count(1), 1);
+    CHECK_EQ(frag_count(FRAG_PAYLOAD_MAX), 1);
+    CHECK_EQ(frag_count(FRAG_PAYLOAD_MAX + 1), 2);
+    CHECK_EQ(frag_count(FRAG_MAX_COUNT * FRAG_PAYLOAD_MAX), FRAG_MAX_COUNT);
+    CHECK_EQ(frag_count(FRAG_MAX_COUNT * FRAG_PAYLOAD_MAX + 1), 0);
+
+    fill_msg(1200, 1);
+    CHECK_EQ(frag_encode(s_msg, 1200, 9, 3, buf, sizeof(buf)), 0);     // chỉ có 3 mảnh
+    for (uint8_t i = 0; i < 3; i++) {
+        size_t n = frag_encode(s_msg, 1200, 9, i, buf, sizeof(buf));
+        CHECK_EQ(n, FRAG_HDR_LEN + (i < 2 ? FRAG_PAYLOAD_MAX : 200));
+        CHECK(frag_decode(buf, n, &f));
+        CHECK_EQ(f.msg_id, 9);
+        CHECK_EQ(f.index, i);
+        CHECK_EQ(f.count, 3);
+        CHECK_EQ(f.total_len, 1200);
+        CHECK_EQ(f.offset, i * FRAG_PAYLOAD_MAX);
+        CHECK_EQ(memcmp(f.payload, s_msg + f.offset, f.len), 0);
+        CHECK(!frag_decode(buf, n - 1, &f));                            // thiếu byte
+    }
+}
+
+// Header mảnh khai man: total_len nhỏ, count lớn -> offset vượt xa message
+static void test_decode_rejects(void) {
+    uint8_t buf[FRAG_RX_MAX];
+    frag_t f;
+    fill_msg(FRAG_PAYLOAD_MAX, 2);
+
+    // total_len = 100, count = 32, index = 30, offset = 15000, len = 500
+    size_t n = frag_encode(s_msg, FRAG_PAYLOAD_MAX * 2, 1, 0, buf, sizeof(buf));
+    buf[6] = 30;
+    buf[7] = 32;
+    mp_put_u16(&buf[8], 100);
+    mp_put_u16(&buf[10], 30 * FRAG_PAYLOAD_MAX);
+    CHECK(!frag_decode(buf, n, &f));
+
+    // count đúng nhưng total_len nhỏ hơn mảnh giữa
+    n = frag_encode(s_msg, 1200, 1, 1, buf, sizeof(buf));
+    mp_put_u16(&buf[8], 700);
+    CHECK(!frag_decode(buf, n, &f));
+    // count sai lệch 1 so với total_len
+    n = frag_encode(s_msg, 1200, 1, 0, buf, sizeof(buf));
+    buf[7] = 4;
+    CHECK(!frag_decode(buf, n, &f));
+    buf[7] = 2;
+    CHECK(!frag_decode(buf, n, &f));
+    // total_len = 0
+    n = frag_encode(s_msg, 10, 1, 0, buf, sizeof(buf));
+    mp_put_u16(&buf[8], 0);
+    CHECK(!frag_decode(buf, n, &f));
+}
+
+// frag_t không qua frag_decode cũng không được chép ra ngoài buffer context
+static void test_push_rejects(void) {
+    static const uint8_t payload[FRAG_PAYLOAD_MAX];
+    size_t len;
+    frag_reasm_init(&s_r, s_ctx, CTX_N, TIMEOUT_MS);
+
+    frag_t bad[] = {
+        { .msg_id = 1, .index = 30, .count = 32, .total_len = 100, .offset = 15000, .len = 500 },
+        { .msg_id = 2, .index = 0, .count = 1, .total_len = 100, .offset = 0, .len = 101 },
+        { .msg_id = 3, .index = 1, .count = 2, .total_len = FRAG_REASM_MSG_MAX, .offset = FRAG_REASM_MSG_MAX - 10, .len = 20 },
+        { .msg_id = 4, .index = 40, .count = 41, .total_len = 100, .offset = 0, .len = 1 },
+        { .msg_id = 5, .index = 0, .count = 0, .total_len = 100, .offset = 0, .len = 1 },
+        { .msg_id = 6, .index = 2, .count = 2, .total_len = 100, .offset = 0, .len = 1 },
+        { .msg_id = 7, .index = 0, .count = 1, .total_len = FRAG_REASM_MSG_MAX + 1, .offset = 0, .len = 1 },
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        bad[i].payload = payload;
+        CHECK(frag_reasm_push(&s_r, MAC_A, &bad[i], 0, &len) == NULL);
+    }
+    CHECK_EQ(s_r.stats.bad, sizeof(bad) / sizeof(bad[0]));
+    CHECK_EQ(s_r.stats.completed, 0);
+}
+
+static void test_roundtrip(void) {
+    uint8_t frames[FRAG_REASM_MSG_MAX / FRAG_PAYLOAD_MAX + 1][FRAG_RX_MAX];
+    size_t  flen[sizeof(frames) / sizeof(frames[0])];
+    static const size_t sizes[] = { 1, 499, FRAG_PAYLOAD_MAX, FRAG_PAYLOAD_MAX + 1, 1234, FRAG_REASM_MSG_MAX };
+    uint32_t seed = 7;
+    size_t len;
+
+    frag_reasm_init(&s_r, s_ctx, CTX_N, TIMEOUT_MS);
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t total = sizes[s];
+        uint8_t count = frag_count(total);
+        fill_msg(total, (uint32_t)s + 100);
+        for (uint8_t i = 0; i < count; i++) flen[i] = frag_encode(s_msg, total, (uint16_t)s, i, frames[i], FRAG_RX_MAX);
+
+        // thứ tự ngẫu nhiên, mảnh đầu gửi lặp 1 lần
+        uint8_t order[8];
+        for (uint8_t i = 0; i < count; i++) order[i] = i;
+        for (uint8_t i = count; i > 1; i--) {
+            uint8_t j = (uint8_t)(test_rand(&seed) % i), t = order[i - 1];
+            order[i - 1] = order[j];
+            order[j] = t;
+        }
+        uint8_t *out = NULL;
+        for (uint8_t k = 0; k < count; k++) {
+            if (k == 1) CHECK(push_frame(MAC_A, frames[order[0]], flen[order[0]], 10, &len) == NULL);
+            CHECK(out == NULL);
+            out = push_frame(MAC_A, frames[order[k]], flen[order[k]], 10, &len);
+        }
+        CHECK(out != NULL);
+        if (!out) continue;
+        CHECK_EQ(len, total);
+        CHECK_EQ(memcmp(out, s_msg, total), 0);
+        // mảnh lặp đến sau khi giao: không mở context mới
+        CHECK(push_frame(MAC_A, frames[0], flen[0], 10, &len) == NULL);
+        frag_reasm_release(&s_r, out);
+    }
+    CHECK_EQ(s_r.stats.completed, sizeof(sizes) / sizeof(sizes[0]));
+    CHECK_EQ(s_r.stats.bad, 0);
+
+    // thiếu mảnh: hết hạn thì trả context; msg_id mới thay message cũ
+    fill_msg(1200, 3);
+    size_t n = frag_encode(s_msg, 1200, 50, 0, frames[0], FRAG_RX_MAX);
+    CHECK(push_frame(MAC_B, frames[0], n, 100, &len) == NULL);
+    frag_reasm_expire(&s_r, 100 + TIMEOUT_MS);
+    CHECK_EQ(s_r.stats.timeouts, 1);
+    CHECK(push_frame(MAC_B, frames[0], n, 5000, &len) == NULL);
+    n = frag_encode(s_msg, 1200, 51, 0, frames[0], FRAG_RX_MAX);
+    CHECK(push_frame(MAC_B, frames[0], n, 5001, &len) == NULL);
+    CHECK_EQ(s_r.stats.superseded, 1);
+}
+
+// Fuzz: 4 sender gửi mảnh ngẫu nhiên của message hiện tại (thỉnh thoảng đổi message),
+// header + độ dài bị đột biến ngẫu nhiên, pool chỉ 3 context.
+// Không crash / không ASan; message giao ra luôn nằm trong context và đúng total_len.
+#define FUZZ_SENDERS    4
+
+static void test_fuzz(void) {
+    uint8_t frame[FRAG_RX_MAX + 16];
+    uint8_t mac[6];
+    uint16_t msg_id[FUZZ_SENDERS] = { 0 };
+    size_t total[FUZZ_SENDERS];
+    uint32_t seed = 0x5eed1234u, now = 0, delivered = 0, intact = 0;
+
+    frag_reasm_init(&s_r, s_ctx, CTX_N, TIMEOUT_MS);
+    fill_msg(FRAG_REASM_MSG_MAX, 4);
+    for (int k = 0; k < FUZZ_SENDERS; k++) total[k] = 1 + test_rand(&seed) % FRAG_REASM_MSG_MAX;
+
+    for (uint32_t it = 0; it < FUZZ_ITERS; it++) {
+        uint32_t r = test_rand(&seed);
+        int who = (int)(r & (FUZZ_SENDERS - 1));
+        if ((r >> 2 & 15) == 0) {
+            msg_id[who]++;
+            total[who] = 1 + test_rand(&seed) % FRAG_REASM_MSG_MAX;
+        }
+        uint8_t count = frag_count(total[who]);
+        size_t n = frag_encode(s_msg, total[who], msg_id[who], (uint8_t)(test_rand(&seed) % count),
+                               frame, sizeof(frame));
+
+        // 1/4 số frame: 1-3 byte header bị thay, hoặc bị cắt / nối đuôi
+        bool mutated = (r >> 6 & 3) == 0;
+        if (mutated) {
+            int flips = 1 + (int)(r >> 8 & 1) + (int)(r >> 9 & 1);
+            for (int k = 0; k < flips; k++) {
+                frame[4 + test_rand(&seed) % (FRAG_HDR_LEN - 4)] = (uint8_t)test_rand(&seed);
+            }
+            if ((r >> 10 & 3) == 0) n = test_rand(&seed) % (n + 1);
+            else if ((r >> 10 & 3) == 1) n += 1 + test_rand(&seed) % 16;
+        }
+
+        memcpy(mac, MAC_A, 6);
+        mac[5] = (uint8_t)who;
+        now += r >> 24 & 15;
+
+        size_t len = 0;
+        uint8_t *out = push_frame(mac, frame, n, now, &len);
+        if (!out) continue;
+        delivered++;
+        CHECK(len >= 1 && len <= FRAG_REASM_MSG_MAX);
+        int in_pool = 0;
+        for (int c = 0; c < CTX_N; c++) in_pool |= out == s_ctx[c].buf;
+        CHECK(in_pool);
+        // payload luôn lấy từ s_msg tại đúng offset, trừ khi đột biến lọt qua decode
+        intact += memcmp(out, s_msg, len) == 0;
+        frag_reasm_release(&s_r, out);
+    }
+    // đủ message lọt qua để fuzz thật sự đi tới nhánh giao
+    CHECK(delivered > 1000);
+    CHECK(intact > delivered * 9 / 10);
+    printf("fuzz: %u iter, %u delivered (%u intact), bad %u, dup %u, superseded %u, timeouts %u, no_ctx %u\n",
+           FUZZ_ITERS, (unsigned)delivered, (unsigned)intact, (unsigned)s_r.stats.bad,
+           (unsigned)s_r.stats.dup, (unsigned)s_r.stats.superseded, (unsigned)s_r.stats.timeouts,
+           (unsigned)s_r.stats.no_ctx);
+}
+
+int main(void) {
+    test_codec();
+    test_decode_rejects();
+    test_push_rejects();
+    test_roundtrip();
+    test_fuzz();
+    return TEST_RESULT();
+}
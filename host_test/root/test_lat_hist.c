@@ -0,0 +1,89 @@
+#include <pthread.h>
+#include "test_util.h"
+#include "lat_hist.h"
+
+// ==== lat_hist: biên bucket log2, percentile, take, ghi đồng thời ====
+static void test_buckets(void) {
+    CHECK_EQ(lat_hist_bucket(0), 0);
+    CHECK_EQ(lat_hist_bucket(1), 1);
+    // bucket i = [2^(i-1), 2^i)
+    for (uint32_t i = 2; i < LAT_HIST_BUCKETS; i++) {
+        CHECK_EQ(lat_hist_bucket((1u << (i - 1)) - 1), i - 1);
+        CHECK_EQ(lat_hist_bucket(1u << (i - 1)), i);
+        CHECK_EQ(lat_hist_bucket((1u << i) - 1), i);
+    }
+    // bucket cuối gom mọi thứ >= 2^(N-2)
+    CHECK_EQ(lat_hist_bucket(1u << (LAT_HIST_BUCKETS - 1)), LAT_HIST_BUCKETS - 1);
+    CHECK_EQ(lat_hist_bucket(UINT32_MAX), LAT_HIST_BUCKETS - 1);
+}
+
+static void test_percentile(void) {
+    lat_hist_t h;
+    lat_hist_snap_t s;
+    lat_hist_init(&h);
+    CHECK_EQ(lat_hist_take(&h, &s), 0);
+    CHECK_EQ(lat_hist_percentile(&s, 50), 0);
+
+    for (int i = 0; i < 90; i++) lat_hist_add(&h, 3);
+    for (int i = 0; i < 10; i++) lat_hist_add(&h, 100);
+    CHECK_EQ(lat_hist_take(&h, &s), 100);
+    CHECK_EQ(s.max_ms, 100);
+    CHECK_EQ(s.b[2], 90);
+    CHECK_EQ(s.b[7], 10);
+    CHECK_EQ(lat_hist_percentile(&s, 0), 4);
+    CHECK_EQ(lat_hist_percentile(&s, 50), 4);
+    CHECK_EQ(lat_hist_percentile(&s, 90), 4);
+    // p91 rơi vào [64,128): cận trên kẹp về max thực tế
+    CHECK_EQ(lat_hist_percentile(&s, 91), 100);
+    CHECK_EQ(lat_hist_percentile(&s, 100), 100);
+
+    // take đã xóa
+    CHECK_EQ(lat_hist_take(&h, &s), 0);
+    CHECK_EQ(s.max_ms, 0);
+
+    // toàn mẫu < 1ms
+    lat_hist_add(&h, 0);
+    lat_hist_take(&h, &s);
+    CHECK_EQ(lat_hist_percentile(&s, 99), 0);
+
+    // bucket cuối: cận trên là max
+    lat_hist_add(&h, 5);
+    lat_hist_add(&h, 60000);
+    lat_hist_take(&h, &s);
+    CHECK_EQ(lat_hist_percentile(&s, 99), 60000);
+    CHECK_EQ(lat_hist_percentile(&s, 50), 8);
+}
+
+// 2 task ghi cùng lúc (recv + publish): không mất mẫu, max đúng
+#define PER_THREAD  200000
+static lat_hist_t s_shared;
+
+static void *writer(void *arg) {
+    uint32_t rng = (uint32_t)(uintptr_t)arg;
+    for (int i = 0; i < PER_THREAD; i++) lat_hist_add(&s_shared, test_rand(&rng) % 5000);
+    return NULL;
+}
+
+static void test_concurrent(void) {
+    lat_hist_init(&s_shared);
+    pthread_t a, b;
+    pthread_create(&a, NULL, writer, (void *)(uintptr_t)11);
+    pthread_create(&b, NULL, writer, (void *)(uintptr_t)22);
+    lat_hist_add(&s_shared, 9999);
+    pthread_join(a, NULL);
+    pthread_join(b, NULL);
+
+    lat_hist_snap_t s;
+    CHECK_EQ(lat_hist_take(&s_shared, &s), 2 * PER_THREAD + 1);
+    uint32_t sum = 0;
+    for (int i = 0; i < LAT_HIST_BUCKETS; i++) sum += s.b[i];
+    CHECK_EQ(sum, 2 * PER_THREAD + 1);
+    CHECK_EQ(s.max_ms, 9999);
+}
+
+int main(void) {
+    test_buckets();
+    test_percentile();
+    test_concurrent();
+    return TEST_RESULT();
+}
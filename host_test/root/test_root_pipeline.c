@@ -0,0 +1,354 @@
+#include <string.h>
+#include <unistd.h>
+#include "test_util.h"
+#include "idf_shim.h"
+#include "telemetry.h"
+#include "motion.h"
+#include "batch.h"
+#include "frag.h"
+#include "cmd.h"
+#include "tsync.h"
+
+// ==== Pipeline root thật (main.c) trên host: recv -> decode -> publish ====
+// esp_mesh_recv lấy frame test đẩy vào, MQTT publish / esp_mesh_send chỉ ghi lại (root_shim/).
+// 3 task chạy trên pthread như trên ESP32, test chỉ quan sát từ ngoài: topic, payload, QoS.
+
+void app_main(void);
+
+#define WAIT_MS         3000
+#define ROOT_MAX_NODES  64      // main.c
+
+static const uint8_t LEAF_A[6]  = { 0x24, 0x0a, 0xc4, 0x11, 0x22, 0x01 };
+static const uint8_t LEAF_B[6]  = { 0x24, 0x0a, 0xc4, 0x11, 0x22, 0x02 };
+static const uint8_t LEAF_C[6]  = { 0x24, 0x0a, 0xc4, 0x11, 0x22, 0x03 };
+static const uint8_t LEAF_D[6]  = { 0x24, 0x0a, 0xc4, 0x11, 0x22, 0x04 };
+static const uint8_t RELAY_R[6] = { 0x24, 0x0a, 0xc4, 0x11, 0x22, 0xf0 };
+
+static void topic_of(const uint8_t mac[6], const char *suffix, char *out, size_t cap) {
+    snprintf(out, cap, "mesh/" MACSTR "%s", MAC2STR(mac), suffix);
+}
+
+// Số message trên topic (payload chứa sub nếu sub != NULL)
+static int count_msgs(const char *topic, const char *sub) {
+    shim_mqtt_msg_t m;
+    int n = 0;
+    for (size_t i = 0; shim_mqtt_get(i, &m); i++) {
+        if (strcmp(m.topic, topic) == 0 && (!sub || strstr(m.payload, sub))) n++;
+    }
+    return n;
+}
+
+static bool wait_msgs(const char *topic, const char *sub, int want) {
+    for (int t = 0; t < WAIT_MS; t++) {
+        if (count_msgs(topic, sub) >= want) return true;
+        usleep(1000);
+    }
+    return false;
+}
+
+static bool last_msg(const char *topic, shim_mqtt_msg_t *out) {
+    shim_mqtt_msg_t m;
+    bool found = false;
+    for (size_t i = 0; shim_mqtt_get(i, &m); i++) {
+        if (strcmp(m.topic, topic) == 0) {
+            *out = m;
+            found = true;
+        }
+    }
+    return found;
+}
+
+static size_t tlm_frame(uint16_t node_id, uint16_t seq, int8_t temp, uint8_t *buf, size_t cap) {
+    telemetry_t t = {
+        .node_id = node_id, .seq = seq, .temp = temp, .humi = 60, .light_raw = 1000,
+        .flags = TLM_FLAG_DHT_OK,
+    };
+    return telemetry_encode(&t, buf, cap);
+}
+
+static void inject_tlm(const uint8_t mac[6], uint16_t seq, int8_t temp) {
+    uint8_t buf[TELEMETRY_FRAME_MAX];
+    shim_mesh_inject(mac, buf, tlm_frame(mac[5], seq, temp, buf, sizeof(buf)));
+}
+
+// Frame root gửi xuống mac có type = type, bắt đầu từ log thứ first
+static bool find_sent(size_t first, const uint8_t mac[6], mesh_msg_type_t type, shim_mesh_tx_t *out) {
+    static shim_mesh_tx_t log[512];
+    for (int t = 0; t < WAIT_MS; t++) {
+        size_t n = shim_mesh_sent(0, log, 512);
+        for (size_t i = first; i < n && i < 512; i++) {
+            if (memcmp(log[i].to, mac, 6) == 0 && mesh_proto_is_frame(log[i].data, log[i].len) &&
+                mesh_proto_type(log[i].data) == type) {
+                *out = log[i];
+                return true;
+            }
+        }
+        usleep(1000);
+    }
+    return false;
+}
+
+// Chưa có MQTT: frame vào journal (partition RAM), kết nối rồi thì replay ra đúng topic
+static void test_journal_before_connect(void) {
+    char topic[48];
+    topic_of(LEAF_A, "", topic, sizeof(topic));
+
+    inject_tlm(LEAF_A, 10, 20);
+    usleep(100 * 1000);
+    CHECK_EQ(shim_mqtt_count(), 0);
+
+    ip_event_got_ip_t ip = { .ip_info.ip.addr = 0x0a01a8c0 };
+    shim_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &ip);
+    shim_mqtt_event(MQTT_EVENT_CONNECTED, NULL, NULL);
+    CHECK(wait_msgs(topic, "\"seq\":10", 1));
+}
+
+// Telemetry trực tiếp: JSON đúng, QoS 0, frame trùng seq bị bỏ ở stage decode
+static void test_telemetry_and_dup(void) {
+    char topic[48];
+    shim_mqtt_msg_t m;
+    topic_of(LEAF_A, "", topic, sizeof(topic));
+
+    inject_tlm(LEAF_A, 11, 21);
+    inject_tlm(LEAF_A, 11, 21);
+    inject_tlm(LEAF_A, 12, 22);
+    CHECK(wait_msgs(topic, "\"seq\":12", 1));
+    CHECK_EQ(count_msgs(topic, "\"seq\":11"), 1);
+    CHECK(last_msg(topic, &m));
+    CHECK_EQ(m.qos, 0);
+    CHECK(strstr(m.payload, "\"node_id\":\"Leaf_01\"") != NULL);
+    CHECK(strstr(m.payload, "\"temp\":22") != NULL);
+}
+
+// Motion: ACK xuống leaf ngay ở stage recv, publish "<topic>/motion" QoS 1
+static void test_motion(void) {
+    char topic[48];
+    shim_mqtt_msg_t m;
+    shim_mesh_tx_t tx;
+    uint8_t buf[MOTION_FRAME_LEN];
+    size_t sent0 = shim_mesh_sent(0, NULL, 0);
+    topic_of(LEAF_B, "/motion", topic, sizeof(topic));
+
+    motion_event_t ev = { .node_id = 2, .seq = 5, .level = 1, .edge_to_send_us = 800 };
+    shim_mesh_inject(LEAF_B, buf, motion_encode(&ev, buf, sizeof(buf)));
+    CHECK(wait_msgs(topic, NULL, 1));
+    CHECK(last_msg(topic, &m));
+    CHECK_EQ(m.qos, 1);
+
+    uint16_t node_id = 0, seq = 0;
+    CHECK(find_sent(sent0, LEAF_B, MESH_MSG_MOTION_ACK, &tx));
+    CHECK(motion_ack_decode(tx.data, tx.len, &node_id, &seq));
+    CHECK_EQ(node_id, 2);
+    CHECK_EQ(seq, 5);
+}
+
+// BATCH của relay: tách thành frame từng leaf, không publish gì cho relay
+static void test_batch(void) {
+    char tc[48], td[48], tr[48];
+    uint8_t f[TELEMETRY_FRAME_MAX], buf[BATCH_FRAME_MAX];
+    batch_builder_t b;
+    topic_of(LEAF_C, "", tc, sizeof(tc));
+    topic_of(LEAF_D, "", td, sizeof(td));
+    topic_of(RELAY_R, "", tr, sizeof(tr));
+
+    batch_begin(&b, buf, sizeof(buf));
+    CHECK(batch_add(&b, LEAF_C, f, tlm_frame(3, 1, 23, f, sizeof(f))));
+    CHECK(batch_add(&b, LEAF_D, f, tlm_frame(4, 1, 24, f, sizeof(f))));
+    CHECK(batch_add(&b, LEAF_C, f, tlm_frame(3, 2, 25, f, sizeof(f))));
+    shim_mesh_inject(RELAY_R, buf, batch_finish(&b));
+
+    CHECK(wait_msgs(tc, "\"seq\":2", 1));
+    CHECK(wait_msgs(td, "\"temp\":24", 1));
+    CHECK_EQ(count_msgs(tc, NULL), 2);
+    CHECK_EQ(count_msgs(tr, NULL), 0);
+}
+
+// BATCH lớn hơn 1 slot nhận -> FRAG, mảnh tới ngược thứ tự. Frame con là JSON cũ (chuyển
+// nguyên) cho đủ dài mà vẫn ít frame.
+static void test_fragmented_batch(void) {
+    enum { LEAVES = 12 };
+    static uint8_t msg[1024];
+    uint8_t frame[FRAG_RX_MAX];
+    char json[64];
+    batch_builder_t b;
+
+    batch_begin(&b, msg, sizeof(msg));
+    for (int i = 0; i < LEAVES; i++) {
+        uint8_t mac[6] = { 0x24, 0x0a, 0xc4, 0x33, 0x00, (uint8_t)(0x40 + i) };
+        int n = snprintf(json, sizeof(json), "{\"node_id\":\"Leaf_%02u\",\"seq\":7,\"pad\":\"%016u\"}",
+                         0x40 + i, i);
+        CHECK(batch_add(&b, mac, (const uint8_t *)json, (size_t)n));
+    }
+    size_t len = batch_finish(&b);
+    uint8_t count = frag_count(len);
+    CHECK(count >= 2);
+    for (int i = count - 1; i >= 0; i--) {
+        size_t n = frag_encode(msg, len, 0x77, (uint8_t)i, frame, sizeof(frame));
+        CHECK(n > 0);
+        shim_mesh_inject(RELAY_R, frame, n);
+    }
+    for (int i = 0; i < LEAVES; i++) {
+        char topic[48];
+        uint8_t mac[6] = { 0x24, 0x0a, 0xc4, 0x33, 0x00, (uint8_t)(0x40 + i) };
+        snprintf(json, sizeof(json), "\"node_id\":\"Leaf_%02u\"", 0x40 + i);
+        topic_of(mac, "", topic, sizeof(topic));
+        CHECK(wait_msgs(topic, json, 1));
+        CHECK_EQ(count_msgs(topic, NULL), 1);
+    }
+}
+
+// Publish bị chặn trong lúc nhiều BATCH dồn tới: tổng frame con gấp đôi ring publish
+// (RX_RING_SLOTS = 16 trong main.c). Decode phải chờ publish nhả slot, không frame nào bị bỏ.
+static void test_pub_backpressure(void) {
+    enum { BATCHES = 4, PER_BATCH = 8 };
+    uint8_t f[TELEMETRY_FRAME_MAX], buf[BATCH_FRAME_MAX];
+    char topic[48];
+    size_t before = shim_mqtt_count();
+
+    shim_mqtt_set_hold(true);
+    for (int k = 0; k < BATCHES; k++) {
+        batch_builder_t b;
+        batch_begin(&b, buf, sizeof(buf));
+        for (int i = 0; i < PER_BATCH; i++) {
+            uint8_t mac[6] = { 0x24, 0x0a, 0xc4, 0x44, 0x00, (uint8_t)(k * PER_BATCH + i) };
+            CHECK(batch_add(&b, mac, f, tlm_frame(mac[5], 3, 20, f, sizeof(f))));
+        }
+        shim_mesh_inject(RELAY_R, buf, batch_finish(&b));
+    }
+    usleep(200 * 1000);             // decode chạy hết phần nó làm được trong lúc publish kẹt
+    CHECK_EQ(shim_mqtt_count(), before);
+    shim_mqtt_set_hold(false);
+
+    for (int i = 0; i < BATCHES * PER_BATCH; i++) {
+        uint8_t mac[6] = { 0x24, 0x0a, 0xc4, 0x44, 0x00, (uint8_t)i };
+        topic_of(mac, "", topic, sizeof(topic));
+        CHECK(wait_msgs(topic, "\"seq\":3", 1));
+        CHECK_EQ(count_msgs(topic, NULL), 1);
+    }
+}
+
+// Echo beacon chỉ để đo đồng bộ, không lên MQTT
+static void test_echo_not_published(void) {
+    char topic[48];
+    uint8_t buf[TSYNC_ECHO_LEN];
+    topic_of(LEAF_A, "", topic, sizeof(topic));
+    int before = count_msgs(topic, NULL);
+
+    tsync_echo_t e = { .node_id = 1, .seq = 1, .root_us = (uint32_t)esp_timer_get_time() };
+    shim_mesh_inject(LEAF_A, buf, tsync_echo_encode(&e, buf, sizeof(buf)));
+    inject_tlm(LEAF_A, 13, 20);     // mốc: frame sau echo đã publish thì echo đã xử lý xong
+    CHECK(wait_msgs(topic, "\"seq\":13", 1));
+    CHECK_EQ(count_msgs(topic, NULL), before + 1);
+}
+
+// Bảng node đầy (ROOT_MAX_NODES của main.c): frame của MAC mới vẫn publish qua topic
+// dựng tại chỗ, riêng echo vẫn phải bị bỏ chứ không lên MQTT dạng thô
+static void test_echo_registry_full(void) {
+    char topic[48];
+    uint8_t mac[6] = { 0x24, 0x0a, 0xc4, 0x33, 0x00, 0x00 };
+    for (int i = 0; i < ROOT_MAX_NODES; i++) {
+        mac[5] = (uint8_t)i;
+        topic_of(mac, "", topic, sizeof(topic));
+        inject_tlm(mac, 1, 20);
+        CHECK(wait_msgs(topic, "\"seq\":1", 1));
+    }
+
+    uint8_t buf[TSYNC_ECHO_LEN];
+    mac[4] = 0x01;
+    topic_of(mac, "", topic, sizeof(topic));
+    tsync_echo_t e = { .node_id = 1, .seq = 2, .root_us = (uint32_t)esp_timer_get_time() };
+    shim_mesh_inject(mac, buf, tsync_echo_encode(&e, buf, sizeof(buf)));
+    inject_tlm(mac, 7, 20);
+    CHECK(wait_msgs(topic, "\"seq\":7", 1));
+    CHECK_EQ(count_msgs(topic, NULL), 1);
+}
+
+// Lệnh MQTT -> CMD xuống leaf, ACK của leaf -> "<topic>/cmd/ack" kèm ref của client
+static void test_command(void) {
+    char topic[64], ack_topic[64];
+    shim_mesh_tx_t tx;
+    shim_mqtt_msg_t m;
+    cmd_t c;
+    size_t sent0 = shim_mesh_sent(0, NULL, 0);
+    topic_of(LEAF_A, "/cmd", topic, sizeof(topic));
+    topic_of(LEAF_A, "/cmd/ack", ack_topic, sizeof(ack_topic));
+
+    shim_mqtt_event(MQTT_EVENT_DATA, topic, "{\"op\":\"set_sample\",\"ms\":5000,\"ref\":7}");
+    CHECK(find_sent(sent0, LEAF_A, MESH_MSG_CMD, &tx));
+    CHECK(cmd_decode(tx.data, tx.len, &c));
+    CHECK_EQ(c.op, CMD_OP_SET_SAMPLE);
+    CHECK_EQ(c.arg_len, 4);
+    CHECK_EQ(mp_get_u32(c.arg), 5000);
+
+    uint8_t buf[CMD_ACK_LEN];
+    cmd_ack_t a = { .node_id = 1, .cmd_id = c.cmd_id, .status = CMD_OK, .op = c.op, .leaf_us = 120 };
+    shim_mesh_inject(LEAF_A, buf, cmd_ack_encode(&a, buf, sizeof(buf)));
+    CHECK(wait_msgs(ack_topic, NULL, 1));
+    CHECK(last_msg(ack_topic, &m));
+    CHECK(strstr(m.payload, "\"ref\":7") != NULL);
+    CHECK(strstr(m.payload, "\"status\":\"ok\"") != NULL);
+    CHECK(strstr(m.payload, "\"leaf_us\":120") != NULL);
+
+    // sai định dạng: bỏ, không gửi gì xuống mesh
+    size_t sent1 = shim_mesh_sent(0, NULL, 0);
+    shim_mqtt_event(MQTT_EVENT_DATA, topic, "{\"op\":\"nope\"}");
+    shim_mqtt_event(MQTT_EVENT_DATA, topic, "{\"op\":");
+    usleep(50 * 1000);
+    CHECK_EQ(shim_mesh_sent(0, NULL, 0), sent1);
+}
+
+// Luật qua "<base>/rules/set" -> status, telemetry vượt ngưỡng -> "<base>/alert" QoS 1
+static void test_rules(void) {
+    char topic[48];
+    shim_mqtt_msg_t m;
+    topic_of(LEAF_A, "", topic, sizeof(topic));
+
+    shim_mqtt_event(MQTT_EVENT_DATA, "mesh/rules/set",
+                    "{\"rules\":[{\"name\":\"hot\",\"node\":\"*\",\"src\":\"temp\",\"op\":\">\",\"value\":30}]}");
+    CHECK(last_msg("mesh/rules/status", &m));
+    CHECK(strstr(m.payload, "\"status\":\"ok\",\"rules\":1") != NULL);
+
+    inject_tlm(LEAF_A, 14, 25);
+    inject_tlm(LEAF_A, 15, 35);
+    CHECK(wait_msgs("mesh/alert", "\"rule\":\"hot\"", 1));
+    CHECK(last_msg("mesh/alert", &m));
+    CHECK(strstr(m.payload, "\"node\":\"24:0a:c4:11:22:01\"") != NULL);
+    CHECK(strstr(m.payload, "\"value\":35") != NULL);
+    CHECK_EQ(m.qos, 1);
+    CHECK(wait_msgs(topic, "\"seq\":15", 1));
+    CHECK_EQ(count_msgs("mesh/alert", NULL), 1);
+
+    shim_mqtt_event(MQTT_EVENT_DATA, "mesh/rules/set", "{\"rules\":[{\"src\":\"bogus\"}]}");
+    CHECK(last_msg("mesh/rules/status", &m));
+    CHECK(strstr(m.payload, "\"status\":\"invalid\"") != NULL);
+}
+
+// Publish lỗi giữa chừng: frame vào journal, broker ổn lại thì replay
+static void test_publish_fail_replay(void) {
+    char topic[48];
+    topic_of(LEAF_A, "", topic, sizeof(topic));
+
+    shim_mqtt_set_fail(true);
+    inject_tlm(LEAF_A, 16, 20);
+    usleep(100 * 1000);
+    CHECK_EQ(count_msgs(topic, "\"seq\":16"), 0);
+    shim_mqtt_set_fail(false);
+    CHECK(wait_msgs(topic, "\"seq\":16", 1));
+    CHECK_EQ(count_msgs(topic, "\"seq\":16"), 1);
+}
+
+int main(void) {
+    app_main();
+    test_journal_before_connect();
+    test_telemetry_and_dup();
+    test_motion();
+    test_batch();
+    test_fragmented_batch();
+    test_pub_backpressure();
+    test_echo_not_published();
+    test_command();
+    test_rules();
+    test_publish_fail_replay();
+    test_echo_registry_full();
+    return TEST_RESULT();
+}
@@ -0,0 +1,237 @@
+#include <string.h>
+#include "test_util.h"
+#include "rule_engine.h"
+
+// ==== rule_engine: biên dịch, đếm mẫu liên tiếp, holdoff, khung giờ, trạng thái theo slot ====
+static const uint8_t MAC_A[6] = { 0x24, 0x0a, 0xc4, 0x11, 0x22, 0x01 };
+static const uint8_t MAC_B[6] = { 0x24, 0x0a, 0xc4, 0x11, 0x22, 0x02 };
+
+static rule_engine_t s_eng;     // ~6 KB trạng thái, để ngoài stack
+
+static struct {
+    uint32_t n;
+    uint8_t  idx;
+    uint8_t  mac[6];
+    int32_t  value;
+} s_fire;
+
+static void on_fire(const rule_t *r, uint8_t idx, const uint8_t mac[6], int32_t value, void *ctx) {
+    (void)r;
+    CHECK(ctx == &s_fire);
+    s_fire.n++;
+    s_fire.idx = idx;
+    memcpy(s_fire.mac, mac, 6);
+    s_fire.value = value;
+}
+
+static rule_sample_t smp(uint8_t src, int32_t v) {
+    rule_sample_t s = { .valid = (uint8_t)(1u << src) };
+    s.v[src] = v;
+    return s;
+}
+
+static uint32_t eval(const uint8_t mac[6], uint32_t slot, uint8_t src, int32_t v, int hour, uint32_t now_ms) {
+    rule_sample_t s = smp(src, v);
+    return rule_engine_eval(&s_eng, mac, slot, &s, hour, now_ms, on_fire, &s_fire);
+}
+
+static void load(const rule_t *rules, uint8_t n) {
+    rule_set_t set = { .count = n };
+    memcpy(set.rules, rules, n * sizeof(*rules));
+    CHECK(rule_set_compile(&set));
+    rule_engine_init(&s_eng);       // load giữ bộ đếm evals/fired/held, mỗi case bắt đầu từ 0
+    rule_engine_load(&s_eng, &set);
+    memset(&s_fire, 0, sizeof(s_fire));
+}
+
+static void test_compile(void) {
+    rule_set_t s = { .count = 4 };
+    s.rules[0] = (rule_t){ .src = RULE_SRC_TEMP, .count = 1, .actions = RULE_ACT_ALERT };
+    s.rules[1] = (rule_t){ .src = RULE_SRC_LIGHT, .count = 1, .actions = RULE_ACT_CMD };
+    s.rules[2] = (rule_t){ .src = RULE_SRC_TEMP, .count = 2, .actions = RULE_ACT_ALERT };
+    s.rules[3] = (rule_t){ .src = RULE_SRC_MOTION, .count = 1, .actions = RULE_ACT_ALERT };
+    CHECK(rule_set_compile(&s));
+    CHECK_EQ(s.n_src[RULE_SRC_TEMP], 2);
+    CHECK_EQ(s.by_src[RULE_SRC_TEMP][0], 0);
+    CHECK_EQ(s.by_src[RULE_SRC_TEMP][1], 2);
+    CHECK_EQ(s.n_src[RULE_SRC_HUMI], 0);
+    CHECK_EQ(s.by_src[RULE_SRC_LIGHT][0], 1);
+    CHECK_EQ(s.by_src[RULE_SRC_MOTION][0], 3);
+
+    // từng kiểu luật sai: cả bảng bị bỏ, chỉ số rỗng
+    const rule_t ok = { .src = RULE_SRC_HUMI, .count = 1, .actions = RULE_ACT_ALERT };
+    rule_t bad[8];
+    for (int i = 0; i < 8; i++) bad[i] = ok;
+    bad[0].src = RULE_SRC_COUNT;
+    bad[1].op = RULE_OP_LT + 1;
+    bad[2].count = 0;
+    bad[3].hour_from = 24;
+    bad[4].hour_to = -1;
+    bad[5].actions = 0;
+    bad[6].cmd_arg_len = RULE_CMD_ARG_MAX + 1;
+    bad[7].count = RULE_COUNT_MAX + 1;
+    for (int i = 0; i < 8; i++) {
+        rule_set_t b = { .count = 2 };
+        b.rules[0] = ok;
+        b.rules[1] = bad[i];
+        CHECK(!rule_set_compile(&b));
+        CHECK_EQ(b.count, 0);
+        CHECK_EQ(b.n_src[RULE_SRC_HUMI], 0);
+    }
+    rule_set_t big = { .count = RULE_MAX + 1 };
+    CHECK(rule_set_compile(&big));
+    CHECK_EQ(big.count, 0);
+
+    CHECK_EQ(rule_src_from_name("light"), RULE_SRC_LIGHT);
+    CHECK_EQ(rule_src_from_name("lux"), -1);
+    CHECK(strcmp(rule_src_name(RULE_SRC_HUMI), "humi") == 0);
+    CHECK(strcmp(rule_src_name(RULE_SRC_COUNT), "?") == 0);
+}
+
+// Motion gắn MAC: chỉ node đó, mỗi cạnh lên bắn 1 lần
+static void test_motion(void) {
+    rule_t r = { .src = RULE_SRC_MOTION, .count = 1, .actions = RULE_ACT_ALERT };
+    memcpy(r.mac, MAC_A, 6);
+    load(&r, 1);
+
+    CHECK_EQ(eval(MAC_B, 1, RULE_SRC_MOTION, 1, 12, 0), 0);
+    CHECK_EQ(s_eng.evals, 0);                       // MAC khác: không tính là đã xét
+    CHECK_EQ(eval(MAC_A, 0, RULE_SRC_MOTION, 1, 12, 0), 1);
+    CHECK_EQ(s_fire.idx, 0);
+    CHECK_EQ(memcmp(s_fire.mac, MAC_A, 6), 0);
+    CHECK_EQ(s_fire.value, 1);
+    CHECK_EQ(eval(MAC_A, 0, RULE_SRC_MOTION, 1, 12, 100), 0);    // vẫn mức 1: không bắn lại
+    CHECK_EQ(eval(MAC_A, 0, RULE_SRC_MOTION, 0, 12, 200), 0);
+    CHECK_EQ(eval(MAC_A, 0, RULE_SRC_MOTION, 1, 12, 300), 1);
+    CHECK_EQ(s_fire.n, 2);
+    CHECK_EQ(s_eng.fired, 2);
+
+    // mẫu không có nguồn motion: luật không được xét
+    CHECK_EQ(eval(MAC_A, 0, RULE_SRC_TEMP, 1, 12, 400), 0);
+    CHECK_EQ(s_eng.evals, 4);
+}
+
+// Ngưỡng so chặt, đủ count mẫu liên tiếp; mẫu sai điều kiện đếm lại từ đầu
+static void test_count_holdoff(void) {
+    rule_t r = { .any_node = true, .src = RULE_SRC_TEMP, .op = RULE_OP_GT, .threshold = 35,
+                 .count = 3, .holdoff_s = 60, .actions = RULE_ACT_ALERT };
+    load(&r, 1);
+
+    CHECK_EQ(eval(MAC_A, 0, RULE_SRC_TEMP, 35, 12, 0), 0);
+    CHECK_EQ(s_eng.run[0][0], 0);
+    uint32_t f = 0;
+    for (int i = 0; i < 5; i++) f += eval(MAC_A, 0, RULE_SRC_TEMP, 36, 12, 1000u * i);
+    CHECK_EQ(f, 1);
+    CHECK_EQ(s_fire.value, 36);
+    // đếm bão hòa ở 255, chạy dài cũng không bắn lại
+    for (int i = 0; i < 600; i++) f += eval(MAC_A, 0, RULE_SRC_TEMP, 40, 12, 5000);
+    CHECK_EQ(f, 1);
+    CHECK_EQ(s_eng.run[0][0], UINT8_MAX);
+
+    // count lớn nhất vẫn chỉ bắn 1 lần dù run bão hòa ngay sau đó
+    rule_t big = r;
+    big.count = RULE_COUNT_MAX;
+    big.holdoff_s = 0;
+    load(&big, 1);
+    uint32_t fb = 0;
+    for (int i = 0; i < 600; i++) fb += eval(MAC_A, 0, RULE_SRC_TEMP, 40, 12, 1000u * i);
+    CHECK_EQ(fb, 1);
+    load(&r, 1);
+    f = 0;
+    for (int i = 0; i < 3; i++) f += eval(MAC_A, 0, RULE_SRC_TEMP, 36, 12, 2000);
+    CHECK_EQ(f, 1);
+
+    // đủ lại trong holdoff: held, không bắn
+    CHECK_EQ(eval(MAC_A, 0, RULE_SRC_TEMP, 30, 12, 6000), 0);
+    for (int i = 0; i < 3; i++) f += eval(MAC_A, 0, RULE_SRC_TEMP, 36, 12, 7000 + i);
+    CHECK_EQ(f, 1);
+    CHECK_EQ(s_eng.held, 1);
+
+    // hết holdoff (tính từ lần bắn ở giây 2)
+    eval(MAC_A, 0, RULE_SRC_TEMP, 30, 12, 61000);
+    for (int i = 0; i < 3; i++) f += eval(MAC_A, 0, RULE_SRC_TEMP, 36, 12, 61000 + i);
+    CHECK_EQ(f, 1);
+    CHECK_EQ(s_eng.held, 2);
+    eval(MAC_A, 0, RULE_SRC_TEMP, 30, 12, 62000);
+    for (int i = 0; i < 3; i++) f += eval(MAC_A, 0, RULE_SRC_TEMP, 36, 12, 62000 + i);
+    CHECK_EQ(f, 2);
+
+    // any_node: mỗi slot đếm riêng, mẫu của B không cắt chuỗi của A
+    eval(MAC_A, 0, RULE_SRC_TEMP, 30, 12, 0);
+    eval(MAC_A, 0, RULE_SRC_TEMP, 36, 12, 0);
+    eval(MAC_B, 5, RULE_SRC_TEMP, 20, 12, 0);
+    eval(MAC_A, 0, RULE_SRC_TEMP, 36, 12, 0);
+    CHECK_EQ(eval(MAC_B, 5, RULE_SRC_TEMP, 36, 12, 0), 0);
+    CHECK_EQ(s_eng.run[0][5], 1);
+    CHECK_EQ(s_eng.run[0][0], 2);
+    CHECK_EQ(eval(MAC_B, RULE_NODE_SLOTS, RULE_SRC_TEMP, 36, 12, 0), 0);    // slot ngoài bảng: bỏ qua
+
+    // now_s = 0 vẫn ghi nhận là đã bắn (fired_s = 0 nghĩa là chưa bắn)
+    load(&r, 1);
+    for (int i = 0; i < 3; i++) eval(MAC_B, 7, RULE_SRC_TEMP, 36, 12, 10);
+    CHECK_EQ(s_eng.fired_s[0][7], 1);
+    eval(MAC_B, 7, RULE_SRC_TEMP, 0, 12, 20);
+    for (int i = 0; i < 3; i++) eval(MAC_B, 7, RULE_SRC_TEMP, 36, 12, 30000);
+    CHECK_EQ(s_eng.held, 1);
+
+    // mốc giây 16 bit wrap
+    load(&r, 1);
+    for (int i = 0; i < 3; i++) eval(MAC_A, 0, RULE_SRC_TEMP, 36, 12, 65530000u);
+    eval(MAC_A, 0, RULE_SRC_TEMP, 0, 12, 65530000u);
+    for (int i = 0; i < 3; i++) eval(MAC_A, 0, RULE_SRC_TEMP, 36, 12, 65540000u);    // +10 s
+    CHECK_EQ(s_eng.held, 1);
+    eval(MAC_A, 0, RULE_SRC_TEMP, 0, 12, 65540000u);
+    for (int i = 0; i < 3; i++) eval(MAC_A, 0, RULE_SRC_TEMP, 36, 12, 65590000u);    // +60 s
+    CHECK_EQ(s_eng.fired, 2);
+}
+
+static void test_hours(void) {
+    rule_t r[3] = {
+        { .any_node = true, .src = RULE_SRC_LIGHT, .op = RULE_OP_LT, .threshold = 500, .count = 1,
+          .hour_from = 18, .hour_to = 6, .actions = RULE_ACT_CMD },
+        { .any_node = true, .src = RULE_SRC_HUMI, .op = RULE_OP_GT, .threshold = 80, .count = 1,
+          .hour_from = 8, .hour_to = 17, .actions = RULE_ACT_ALERT },
+        { .any_node = true, .src = RULE_SRC_HUMI, .op = RULE_OP_LT, .threshold = 20, .count = 1,
+          .actions = RULE_ACT_ALERT },      // from == to: cả ngày
+    };
+    load(r, 3);
+
+    // khung qua nửa đêm, giờ chưa biết không khớp
+    static const int hours[] = { -1, 5, 6, 12, 17, 18, 23, 0 };
+    static const int want[]  = {  0, 1, 0,  0,  0,  1,  1, 1 };
+    for (int i = 0; i < 8; i++) {
+        eval(MAC_A, 0, RULE_SRC_LIGHT, 900, hours[i], 0);     // sai điều kiện: đặt lại run
+        CHECK_EQ(eval(MAC_A, 0, RULE_SRC_LIGHT, 100, hours[i], 0), want[i]);
+    }
+
+    // khung thường [8, 17)
+    CHECK_EQ(eval(MAC_A, 0, RULE_SRC_HUMI, 90, 7, 0), 0);
+    CHECK_EQ(eval(MAC_A, 0, RULE_SRC_HUMI, 90, 8, 0), 1);
+    eval(MAC_A, 0, RULE_SRC_HUMI, 50, 8, 0);
+    CHECK_EQ(eval(MAC_A, 0, RULE_SRC_HUMI, 90, 17, 0), 0);
+
+    // cả ngày: cả khi chưa biết giờ
+    CHECK_EQ(eval(MAC_A, 0, RULE_SRC_HUMI, 10, -1, 0), 1);
+    CHECK_EQ(s_fire.idx, 2);
+
+    // 1 mẫu nhiều nguồn: xét đủ luật của từng nguồn
+    load(r, 3);
+    rule_sample_t s = { .valid = (1u << RULE_SRC_LIGHT) | (1u << RULE_SRC_HUMI) };
+    s.v[RULE_SRC_LIGHT] = 100;
+    s.v[RULE_SRC_HUMI]  = 90;
+    CHECK_EQ(rule_engine_eval(&s_eng, MAC_B, 3, &s, 2, 0, on_fire, &s_fire), 1);
+    CHECK_EQ(rule_engine_eval(&s_eng, MAC_B, 4, &s, 12, 0, on_fire, &s_fire), 1);
+    CHECK_EQ(s_eng.evals, 6);
+    CHECK_EQ(rule_engine_eval(&s_eng, MAC_B, 9, &s, 12, 0, NULL, NULL), 1);   // không có callback
+    CHECK_EQ(s_fire.n, 2);
+}
+
+int main(void) {
+    rule_engine_init(&s_eng);
+    CHECK_EQ(eval(MAC_A, 0, RULE_SRC_TEMP, 99, 12, 0), 0);   // chưa nạp luật
+    test_compile();
+    test_motion();
+    test_count_holdoff();
+    test_hours();
+    return TEST_RESULT();
+}
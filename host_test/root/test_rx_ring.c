@@ -0,0 +1,163 @@
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include "test_util.h"
+#include "rx_ring.h"
+
+// ==== rx_ring: 1 thread producer + 1 thread consumer như recv -> decode trên 2 core ====
+// Payload mỗi frame suy ra từ seq nên consumer phát hiện được slot bị ghi đè / đọc sớm.
+#define STRESS_FRAMES   500000u
+#define RING_SLOTS      16
+
+typedef struct {
+    rx_ring_t *ring;
+    uint32_t   frames;
+    bool       lossy;           // true: ring đầy thì bỏ frame như mesh_recv_task
+    uint32_t   sent;
+    uint32_t   dropped;
+    atomic_bool done;
+} stress_t;
+
+static uint16_t frame_len(uint32_t seq) {
+    return (uint16_t)(8 + seq % (RX_RING_SLOT_SIZE - 8));
+}
+
+static uint8_t frame_byte(uint32_t seq, uint32_t i) {
+    return (uint8_t)(seq * 131u + i * 7u);
+}
+
+static void *producer(void *arg) {
+    stress_t *s = arg;
+    for (uint32_t seq = 0; seq < s->frames; seq++) {
+        // lossy: frame tới theo từng đợt 64, giữa các đợt consumer mới kịp chạy
+        if (s->lossy && seq && (seq & 63) == 0) sched_yield();
+        rx_slot_t *slot;
+        while ((slot = rx_ring_acquire(s->ring)) == NULL) {
+            if (s->lossy) break;
+            sched_yield();          // máy 1 core: nhường cho consumer
+        }
+        if (!slot) {
+            rx_ring_count_overflow(s->ring);
+            s->dropped++;
+            continue;
+        }
+        uint16_t len = frame_len(seq);
+        memcpy(slot->data, &seq, 4);
+        for (uint32_t i = 4; i < len; i++) slot->data[i] = frame_byte(seq, i);
+        slot->len   = len;
+        slot->rx_us = seq;
+        rx_ring_commit(s->ring);
+        s->sent++;
+    }
+    atomic_store(&s->done, true);
+    return NULL;
+}
+
+typedef struct {
+    uint32_t received;
+    int64_t  last_seq;
+    uint32_t corrupt;
+    uint32_t out_of_order;
+} consumer_t;
+
+static void check_slot(const rx_slot_t *slot, void *ctx) {
+    consumer_t *c = ctx;
+    uint32_t seq;
+    memcpy(&seq, slot->data, 4);
+    if (slot->rx_us != seq || slot->len != frame_len(seq)) c->corrupt++;
+    for (uint32_t i = 4; i < slot->len; i += 61) {
+        if (slot->data[i] != frame_byte(seq, i)) {
+            c->corrupt++;
+            break;
+        }
+    }
+    if ((int64_t)seq <= c->last_seq) c->out_of_order++;
+    c->last_seq = seq;
+    c->received++;
+}
+
+static void run_stress(bool lossy) {
+    static rx_slot_t slots[RING_SLOTS];
+    rx_ring_t ring;
+    CHECK(rx_ring_init(&ring, slots, RING_SLOTS));
+
+    stress_t s = { .ring = &ring, .frames = STRESS_FRAMES, .lossy = lossy };
+    atomic_init(&s.done, false);
+    consumer_t c = { .last_seq = -1 };
+
+    uint64_t t0 = test_now_ns();
+    pthread_t th;
+    pthread_create(&th, NULL, producer, &s);
+    for (;;) {
+        bool fin = atomic_load(&s.done);
+        if (rx_ring_drain(&ring, check_slot, &c, 0) == 0) {
+            if (fin && rx_ring_depth(&ring) == 0) break;
+            sched_yield();
+        }
+    }
+    pthread_join(th, NULL);
+    double sec = (double)(test_now_ns() - t0) / 1e9;
+
+    rx_ring_stats_t st;
+    rx_ring_get_stats(&ring, &st);
+    printf("%s: sent=%u received=%u dropped=%u hwm=%u/%u, %.1f Mframe/s\n",
+           lossy ? "lossy   " : "lossless", s.sent, c.received, s.dropped, st.hwm, st.capacity,
+           c.received / sec / 1e6);
+    CHECK_EQ(c.corrupt, 0);
+    CHECK_EQ(c.out_of_order, 0);
+    CHECK_EQ(c.received, s.sent);
+    CHECK_EQ(s.sent + s.dropped, STRESS_FRAMES);
+    CHECK_EQ(st.overflow, s.dropped);
+    CHECK(st.hwm <= RING_SLOTS);
+    if (!lossy) CHECK_EQ(c.received, STRESS_FRAMES);
+}
+
+static void count_slot(const rx_slot_t *slot, void *ctx) {
+    ((consumer_t *)ctx)->received++;
+}
+
+// 1 thread: biên đầy / rỗng, hwm, drain có giới hạn
+static void test_single_thread(void) {
+    static rx_slot_t slots[4];
+    rx_ring_t ring;
+    CHECK(!rx_ring_init(&ring, slots, 3));
+    CHECK(!rx_ring_init(&ring, slots, 1));
+    CHECK(rx_ring_init(&ring, slots, 4));
+    CHECK(rx_ring_peek(&ring) == NULL);
+
+    for (int i = 0; i < 4; i++) {
+        rx_slot_t *s = rx_ring_acquire(&ring);
+        CHECK(s != NULL);
+        if (s) s->len = (uint16_t)i;
+        rx_ring_commit(&ring);
+    }
+    CHECK(rx_ring_acquire(&ring) == NULL);
+    CHECK_EQ(rx_ring_depth(&ring), 4);
+
+    rx_slot_t *p = rx_ring_peek(&ring);
+    CHECK(p && p->len == 0);
+    rx_ring_release(&ring);
+    CHECK(rx_ring_acquire(&ring) != NULL);
+
+    rx_ring_commit(&ring);
+
+    rx_ring_stats_t st;
+    rx_ring_get_stats(&ring, &st);
+    CHECK_EQ(st.hwm, 4);
+    CHECK_EQ(st.depth, 4);
+    CHECK_EQ(st.capacity, 4);
+
+    consumer_t c = { .last_seq = -1 };
+    CHECK_EQ(rx_ring_drain(&ring, count_slot, &c, 3), 3);
+    CHECK_EQ(rx_ring_depth(&ring), 1);
+    CHECK_EQ(rx_ring_drain(&ring, count_slot, &c, 0), 1);
+    CHECK_EQ(c.received, 4);
+    CHECK(rx_ring_peek(&ring) == NULL);
+}
+
+int main(void) {
+    test_single_thread();
+    run_stress(false);
+    run_stress(true);
+    return TEST_RESULT();
+}
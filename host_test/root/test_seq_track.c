@@ -0,0 +1,171 @@
+#include "test_util.h"
+#include "seq_track.h"
+
+// ==== seq_track: wrap 16 bit, khởi động lại, trùng, đến trễ, summary theo dải ====
+static void feed(seq_track_t *t, uint16_t from, uint16_t n) {
+    for (uint16_t i = 0; i < n; i++) seq_track_update(t, (uint16_t)(from + i));
+}
+
+static void test_basic(void) {
+    seq_track_t t;
+    seq_track_reset(&t);
+    CHECK_EQ(seq_track_update(&t, 1), SEQ_NEW);
+    CHECK_EQ(seq_track_update(&t, 2), SEQ_NEW);
+    CHECK_EQ(seq_track_update(&t, 5), SEQ_NEW);
+    CHECK_EQ(t.lost, 2);
+    CHECK_EQ(seq_track_update(&t, 3), SEQ_LATE);
+    CHECK_EQ(t.lost, 1);
+    CHECK_EQ(t.reorder, 1);
+    CHECK_EQ(seq_track_update(&t, 3), SEQ_DUP);
+    CHECK_EQ(seq_track_update(&t, 5), SEQ_DUP);
+    CHECK_EQ(t.dup, 2);
+    CHECK_EQ(t.received, 4);
+    CHECK_EQ(t.last, 5);
+
+    // mép cửa sổ: lùi 63 còn nhận là trễ, lùi 64 coi như node khởi động lại
+    seq_track_reset(&t);
+    seq_track_update(&t, 100);
+    seq_track_update(&t, 200);
+    CHECK_EQ(t.lost, 99);
+    CHECK_EQ(seq_track_update(&t, 200 - (SEQ_TRACK_WINDOW - 1)), SEQ_LATE);
+    CHECK_EQ(t.lost, 98);
+    CHECK_EQ(seq_track_update(&t, 200 - SEQ_TRACK_WINDOW), SEQ_RESTART);
+    CHECK_EQ(t.restarts, 1);
+    CHECK_EQ(t.last, 200 - SEQ_TRACK_WINDOW);
+
+    // tiến >= cửa sổ: bitmap xóa sạch, seq cũ trong cửa sổ mới là trễ chứ không trùng
+    seq_track_reset(&t);
+    feed(&t, 0, 10);
+    seq_track_update(&t, 9 + SEQ_TRACK_WINDOW);
+    CHECK_EQ(seq_track_update(&t, 10 + 1), SEQ_LATE);
+}
+
+static void test_wrap(void) {
+    seq_track_t t;
+    seq_track_reset(&t);
+    feed(&t, 65530, 12);                // 65530..65535, 0..5
+    CHECK_EQ(t.received, 12);
+    CHECK_EQ(t.lost, 0);
+    CHECK_EQ(t.restarts, 0);
+    CHECK_EQ(t.last, 5);
+
+    // khoảng trống vắt qua 0, rồi đến trễ bên kia
+    seq_track_reset(&t);
+    seq_track_update(&t, 65534);
+    CHECK_EQ(seq_track_update(&t, 2), SEQ_NEW);
+    CHECK_EQ(t.lost, 3);
+    CHECK_EQ(seq_track_update(&t, 65535), SEQ_LATE);
+    CHECK_EQ(seq_track_update(&t, 0), SEQ_LATE);
+    CHECK_EQ(seq_track_update(&t, 65535), SEQ_DUP);
+    CHECK_EQ(t.lost, 1);
+
+    // chạy qua nhiều vòng 16 bit không sinh restart giả
+    seq_track_reset(&t);
+    for (uint32_t i = 0; i < 3u * 65536; i++) seq_track_update(&t, (uint16_t)i);
+    CHECK_EQ(t.restarts, 0);
+    CHECK_EQ(t.lost, 0);
+    CHECK_EQ(t.received, 3u * 65536);
+}
+
+static void test_restart(void) {
+    seq_track_t t;
+    seq_track_reset(&t);
+    feed(&t, 500, 10);
+
+    // nhảy tiến dưới ngưỡng: mất, không restart
+    CHECK_EQ(seq_track_update(&t, 509 + SEQ_TRACK_RESTART_GAP - 1), SEQ_NEW);
+    CHECK_EQ(t.lost, SEQ_TRACK_RESTART_GAP - 2);
+    // nhảy đúng ngưỡng: restart, không cộng mất
+    uint32_t lost = t.lost;
+    uint16_t last = t.last;
+    CHECK_EQ(seq_track_update(&t, (uint16_t)(last + SEQ_TRACK_RESTART_GAP)), SEQ_RESTART);
+    CHECK_EQ(t.lost, lost);
+
+    // reboot về 0: restart, seq tiếp theo bình thường
+    CHECK_EQ(seq_track_update(&t, 0), SEQ_RESTART);
+    CHECK_EQ(seq_track_update(&t, 1), SEQ_NEW);
+    CHECK_EQ(seq_track_update(&t, 0), SEQ_DUP);
+    CHECK_EQ(t.restarts, 2);
+    CHECK_EQ(t.lost, lost);
+
+    // nửa vòng (d = -32768) cũng là restart
+    CHECK_EQ(seq_track_update(&t, (uint16_t)(1 + 32768)), SEQ_RESTART);
+}
+
+static void test_range(void) {
+    seq_track_t t;
+    seq_track_reset(&t);
+
+    // summary đầu tiên: 10..19 gộp đủ 10 frame
+    CHECK_EQ(seq_track_update_range(&t, 10, 19, 10), SEQ_NEW);
+    CHECK_EQ(t.received, 10);
+    CHECK_EQ(t.lost, 0);
+
+    // 20..29 nhưng relay chỉ nhận 7
+    CHECK_EQ(seq_track_update_range(&t, 20, 29, 7), SEQ_NEW);
+    CHECK_EQ(t.received, 17);
+    CHECK_EQ(t.lost, 3);
+
+    // khoảng trống trước dải: 30..39 mất hẳn
+    CHECK_EQ(seq_track_update_range(&t, 40, 49, 10), SEQ_NEW);
+    CHECK_EQ(t.received, 27);
+    CHECK_EQ(t.lost, 13);
+
+    // count lớn hơn dải (relay đếm cả frame trùng): chặn ở số seq trong dải
+    CHECK_EQ(seq_track_update_range(&t, 50, 51, 9), SEQ_NEW);
+    CHECK_EQ(t.received, 29);
+    CHECK_EQ(t.lost, 13);
+
+    // dải đã thấy -> trùng; seq lẻ nằm trong dải cũng là trùng
+    CHECK_EQ(seq_track_update_range(&t, 40, 49, 10), SEQ_DUP);
+    CHECK_EQ(seq_track_update(&t, 45), SEQ_DUP);
+    CHECK_EQ(t.received, 29);
+
+    // frame lẻ trong khoảng trống đến trễ vẫn lấp mất
+    CHECK_EQ(seq_track_update(&t, 35), SEQ_LATE);
+    CHECK_EQ(t.lost, 12);
+
+    // dải vắt qua 0
+    seq_track_reset(&t);
+    seq_track_update(&t, 65530);
+    CHECK_EQ(seq_track_update_range(&t, 65531, 4, 10), SEQ_NEW);
+    CHECK_EQ(t.received, 11);
+    CHECK_EQ(t.lost, 0);
+    CHECK_EQ(t.restarts, 0);
+
+    // reboot giữa chừng: dải mới tính lại từ đầu
+    CHECK_EQ(seq_track_update_range(&t, 0x8000, 0x8000 + 9, 8), SEQ_RESTART);
+    CHECK_EQ(t.restarts, 1);
+    CHECK_EQ(t.received, 19);
+    CHECK_EQ(t.lost, 2);
+
+    // dải quá rộng / count 0: coi như 1 frame seq cuối
+    seq_track_reset(&t);
+    CHECK_EQ(seq_track_update_range(&t, 0, SEQ_TRACK_RESTART_GAP, 5), SEQ_NEW);
+    CHECK_EQ(t.received, 1);
+    CHECK_EQ(seq_track_update_range(&t, 1, 2000, 0), SEQ_NEW);
+    CHECK_EQ(t.received, 2);
+
+    // received + lost = số seq đã qua, với summary và frame lẻ xen kẽ (bắt đầu bằng summary:
+    // frame lẻ đầu tiên không biết được các seq trước nó)
+    seq_track_reset(&t);
+    uint32_t rng = 9, seq = 0, sent = 0;
+    for (int k = 0; k < 5000; k++) {
+        uint16_t n = (uint16_t)(1 + test_rand(&rng) % 12);
+        uint16_t got = (uint16_t)(n - test_rand(&rng) % (n < 3 ? 1 : 3));
+        if (k % 3 != 1) seq_track_update_range(&t, (uint16_t)seq, (uint16_t)(seq + n - 1), got);
+        else       seq_track_update(&t, (uint16_t)(seq + n - 1));
+        seq += n;
+        sent += n;
+    }
+    CHECK_EQ(t.received + t.lost, sent);
+    CHECK_EQ(t.restarts, 0);
+}
+
+int main(void) {
+    test_basic();
+    test_wrap();
+    test_restart();
+    test_range();
+    return TEST_RESULT();
+}
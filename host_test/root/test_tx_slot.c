@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test_util.h"
+#include "node_registry.h"
+#include "time_sync.h"
+
+// ==== Slot gửi: root cấp slot lúc insert (node_registry), leaf chờ tới mốc slot (time_sync) ====
+#define PERIOD_MS   5000
+#define PERIODS     20
+
+static node_entry_t    s_slots[2 * NODE_TX_SLOTS];
+static node_registry_t s_reg;
+
+static void mac_of(uint32_t i, uint8_t mac[6]) {
+    const uint8_t m[6] = { 0x24, 0x0a, 0xc4, 0x00, (uint8_t)(i >> 8), (uint8_t)i };
+    memcpy(mac, m, 6);
+}
+
+static int cmp_int(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+// k node đầu tiên: slot không trùng, khoảng cách vòng nhỏ nhất >= NODE_TX_SLOTS / 2^ceil(log2 k)
+static void test_assign(void) {
+    uint8_t mac[6];
+    int slot[NODE_TX_SLOTS];
+
+    CHECK(node_registry_init(&s_reg, s_slots, 2 * NODE_TX_SLOTS, NODE_TX_SLOTS, "mesh"));
+    for (int k = 1; k <= NODE_TX_SLOTS; k++) {
+        mac_of((uint32_t)k, mac);
+        node_entry_t *e = node_registry_get(&s_reg, mac, 0);
+        CHECK(e != NULL);
+        if (!e) return;
+        CHECK(e->tx_slot < NODE_TX_SLOTS);
+        slot[k - 1] = e->tx_slot;
+
+        int sorted[NODE_TX_SLOTS], pow2 = 1;
+        while (pow2 < k) pow2 <<= 1;
+        memcpy(sorted, slot, sizeof(int) * (size_t)k);
+        qsort(sorted, (size_t)k, sizeof(int), cmp_int);
+        int min_gap = NODE_TX_SLOTS - sorted[k - 1] + sorted[0];
+        for (int i = 1; i < k; i++) {
+            if (sorted[i] - sorted[i - 1] < min_gap) min_gap = sorted[i] - sorted[i - 1];
+        }
+        CHECK(k == 1 || min_gap >= NODE_TX_SLOTS / pow2);
+    }
+    CHECK_EQ(slot[0], 0);
+    CHECK_EQ(slot[1], NODE_TX_SLOTS / 2);
+    CHECK_EQ(slot[2], NODE_TX_SLOTS / 4);
+    CHECK_EQ(slot[3], 3 * NODE_TX_SLOTS / 4);
+
+    // slot cố định: tra lại không đổi, bảng đầy thì không cấp thêm
+    mac_of(3, mac);
+    CHECK_EQ(node_registry_get(&s_reg, mac, 1000)->tx_slot, slot[2]);
+    mac_of(1000, mac);
+    CHECK(node_registry_get(&s_reg, mac, 1000) == NULL);
+}
+
+// Leaf ngủ tới mốc slot rồi gửi (thức sớm 0-5 ms): mỗi chu kỳ mọi leaf gửi đúng 1 lần,
+// các lần gửi cách nhau đúng PERIOD_MS / NODE_TX_SLOTS
+static void test_schedule(void) {
+    const int64_t gap = (int64_t)PERIOD_MS * 1000 / NODE_TX_SLOTS;
+    int64_t next[NODE_TX_SLOTS];
+    uint8_t slot[NODE_TX_SLOTS];
+    uint32_t seed = 9;
+
+    // mọi leaf khởi động cùng lúc (trước khi có slot là gửi cùng pha)
+    int64_t boot = 1760000000000000ll + 1234567;
+    for (int i = 0; i < NODE_TX_SLOTS; i++) {
+        uint8_t mac[6];
+        mac_of((uint32_t)i + 1, mac);
+        slot[i] = node_registry_find(&s_reg, mac)->tx_slot;
+        next[i] = boot + time_sync_slot_wait(boot, PERIOD_MS, slot[i], NODE_TX_SLOTS);
+    }
+
+    int64_t t_min = boot, prev_period_end = 0;
+    for (int p = 0; p < PERIODS; p++) {
+        // gom lần gửi kế tiếp của mọi leaf, sắp theo thời gian
+        int64_t tx[NODE_TX_SLOTS];
+        for (int i = 0; i < NODE_TX_SLOTS; i++) {
+            tx[i] = next[i];
+            CHECK(next[i] > t_min);
+            int64_t wake = next[i] - (int64_t)(test_rand(&seed) % 5000);
+            next[i] = wake + time_sync_slot_wait(wake, PERIOD_MS, slot[i], NODE_TX_SLOTS);
+            CHECK_EQ(next[i] - tx[i], (int64_t)PERIOD_MS * 1000);
+        }
+        for (int i = 1; i < NODE_TX_SLOTS; i++) {
+            for (int j = i; j > 0 && tx[j] < tx[j - 1]; j--) {
+                int64_t t = tx[j];
+                tx[j] = tx[j - 1];
+                tx[j - 1] = t;
+            }
+        }
+        for (int i = 1; i < NODE_TX_SLOTS; i++) CHECK_EQ(tx[i] - tx[i - 1], gap);
+        CHECK(tx[NODE_TX_SLOTS - 1] - tx[0] < (int64_t)PERIOD_MS * 1000);
+        if (p) CHECK_EQ(tx[0] - prev_period_end, gap);
+        prev_period_end = tx[NODE_TX_SLOTS - 1];
+        t_min = tx[NODE_TX_SLOTS - 1];
+    }
+}
+
+int main(void) {
+    test_assign();
+    test_schedule();
+    return TEST_RESULT();
+}
@@ -0,0 +1,44 @@
+#ifndef CJSON_SHIM_H_
+#define CJSON_SHIM_H_
+
+// ==== Tập con API cJSON mà root dùng để parse lệnh / luật (cjson_lite.c) ====
+// Cùng tên, cùng layout trường với cJSON thật; chỉ parse, không in.
+
+#include <stddef.h>
+
+#define cJSON_Invalid   0
+#define cJSON_False     (1 << 0)
+#define cJSON_True      (1 << 1)
+#define cJSON_NULL      (1 << 2)
+#define cJSON_Number    (1 << 3)
+#define cJSON_String    (1 << 4)
+#define cJSON_Array     (1 << 5)
+#define cJSON_Object    (1 << 6)
+
+typedef struct cJSON {
+    struct cJSON *next;
+    struct cJSON *prev;
+    struct cJSON *child;
+    int           type;
+    char         *valuestring;
+    int           valueint;
+    double        valuedouble;
+    char         *string;
+} cJSON;
+
+cJSON *cJSON_ParseWithLength(const char *value, size_t len);
+void   cJSON_Delete(cJSON *item);
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *name);
+int    cJSON_GetArraySize(const cJSON *array);
+
+#define cJSON_IsTrue(j)     ((j) != NULL && (j)->type == cJSON_True)
+#define cJSON_IsBool(j)     ((j) != NULL && ((j)->type == cJSON_True || (j)->type == cJSON_False))
+#define cJSON_IsNumber(j)   ((j) != NULL && (j)->type == cJSON_Number)
+#define cJSON_IsString(j)   ((j) != NULL && (j)->type == cJSON_String)
+#define cJSON_IsArray(j)    ((j) != NULL && (j)->type == cJSON_Array)
+#define cJSON_IsObject(j)   ((j) != NULL && (j)->type == cJSON_Object)
+
+#define cJSON_ArrayForEach(element, array) \
+    for (element = (array) != NULL ? (array)->child : NULL; element != NULL; element = element->next)
+
+#endif /* CJSON_SHIM_H_ */
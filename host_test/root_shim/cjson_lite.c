@@ -0,0 +1,189 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cJSON.h"
+
+// ==== Parser JSON đệ quy nhỏ, đủ cho payload lệnh / luật trong test ====
+// \uXXXX chỉ giữ ASCII (ký tự khác thành '?'), độ sâu giới hạn để input xấu không tràn stack.
+#define JSON_DEPTH_MAX  16
+
+typedef struct {
+    const char *p;
+    const char *end;
+} json_in_t;
+
+static void skip_ws(json_in_t *in) {
+    while (in->p < in->end && (*in->p == ' ' || *in->p == '\t' || *in->p == '\n' || *in->p == '\r')) in->p++;
+}
+
+static bool take(json_in_t *in, const char *lit) {
+    size_t n = strlen(lit);
+    if ((size_t)(in->end - in->p) < n || memcmp(in->p, lit, n) != 0) return false;
+    in->p += n;
+    return true;
+}
+
+static char *parse_str(json_in_t *in) {
+    if (in->p >= in->end || *in->p != '"') return NULL;
+    const char *s = ++in->p;
+    while (in->p < in->end && *in->p != '"') in->p += (*in->p == '\\') ? 2 : 1;
+    if (in->p >= in->end) return NULL;
+
+    char *out = malloc((size_t)(in->p - s) + 1), *o = out;
+    if (!out) return NULL;
+    while (s < in->p) {
+        if (*s != '\\') {
+            *o++ = *s++;
+            continue;
+        }
+        s++;
+        switch (*s) {
+            case 'n': *o++ = '\n'; break;
+            case 't': *o++ = '\t'; break;
+            case 'r': *o++ = '\r'; break;
+            case 'b': *o++ = '\b'; break;
+            case 'f': *o++ = '\f'; break;
+            case 'u': {
+                unsigned v = 0;
+                int i = 0;
+                for (; i < 4 && s + 1 < in->p; i++) {
+                    char c = *++s;
+                    v = v * 16 + (unsigned)(c >= 'a' ? c - 'a' + 10 : c >= 'A' ? c - 'A' + 10 : c - '0');
+                }
+                *o++ = (i == 4 && v < 0x80) ? (char)v : '?';
+                break;
+            }
+            default: *o++ = *s; break;
+        }
+        s++;
+    }
+    *o = '\0';
+    in->p++;
+    return out;
+}
+
+static cJSON *parse_value(json_in_t *in, int depth);
+
+// Object/array: các phần tử nối next/prev dưới child
+static bool parse_items(json_in_t *in, cJSON *parent, char close, int depth) {
+    cJSON *last = NULL;
+    in->p++;
+    skip_ws(in);
+    if (in->p < in->end && *in->p == close) {
+        in->p++;
+        return true;
+    }
+    for (;;) {
+        char *key = NULL;
+        skip_ws(in);
+        if (close == '}') {
+            if (!(key = parse_str(in))) return false;
+            skip_ws(in);
+            if (in->p >= in->end || *in->p++ != ':') {
+                free(key);
+                return false;
+            }
+        }
+        cJSON *item = parse_value(in, depth + 1);
+        if (!item) {
+            free(key);
+            return false;
+        }
+        item->string = key;
+        if (last) {
+            last->next = item;
+            item->prev = last;
+        } else {
+            parent->child = item;
+        }
+        last = item;
+
+        skip_ws(in);
+        if (in->p >= in->end) return false;
+        char c = *in->p++;
+        if (c == close) return true;
+        if (c != ',') return false;
+    }
+}
+
+static cJSON *parse_value(json_in_t *in, int depth) {
+    if (depth > JSON_DEPTH_MAX) return NULL;
+    skip_ws(in);
+    if (in->p >= in->end) return NULL;
+
+    cJSON *j = calloc(1, sizeof(*j));
+    if (!j) return NULL;
+    bool ok = true;
+    char c = *in->p;
+    if (c == '{' || c == '[') {
+        j->type = c == '{' ? cJSON_Object : cJSON_Array;
+        ok = parse_items(in, j, c == '{' ? '}' : ']', depth);
+    } else if (c == '"') {
+        j->type = cJSON_String;
+        ok = (j->valuestring = parse_str(in)) != NULL;
+    } else if (take(in, "true")) {
+        j->type = cJSON_True;
+        j->valueint = 1;
+    } else if (take(in, "false")) {
+        j->type = cJSON_False;
+    } else if (take(in, "null")) {
+        j->type = cJSON_NULL;
+    } else {
+        // strtod cần chuỗi kết thúc 0: chép phần có thể là số
+        char num[32];
+        size_t n = 0;
+        while (in->p + n < in->end && n < sizeof(num) - 1 && in->p[n] && strchr("+-.eE0123456789", in->p[n])) n++;
+        memcpy(num, in->p, n);
+        num[n] = '\0';
+        char *e;
+        j->valuedouble = strtod(num, &e);
+        ok = n > 0 && e == num + n;
+        j->valueint = (int)j->valuedouble;
+        j->type = cJSON_Number;
+        in->p += n;
+    }
+    if (!ok) {
+        cJSON_Delete(j);
+        return NULL;
+    }
+    return j;
+}
+
+cJSON *cJSON_ParseWithLength(const char *value, size_t len) {
+    json_in_t in = { value, value + len };
+    if (!value) return NULL;
+    cJSON *j = parse_value(&in, 0);
+    skip_ws(&in);
+    // cJSON thật bỏ qua '\0' cuối buffer
+    if (j && in.p < in.end && *in.p != '\0') {
+        cJSON_Delete(j);
+        return NULL;
+    }
+    return j;
+}
+
+void cJSON_Delete(cJSON *item) {
+    while (item) {
+        cJSON *next = item->next;
+        cJSON_Delete(item->child);
+        free(item->valuestring);
+        free(item->string);
+        free(item);
+        item = next;
+    }
+}
+
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *name) {
+    if (!object || !name) return NULL;
+    for (cJSON *c = object->child; c; c = c->next) {
+        if (c->string && strcmp(c->string, name) == 0) return c;
+    }
+    return NULL;
+}
+
+int cJSON_GetArraySize(const cJSON *array) {
+    int n = 0;
+    if (!array) return 0;
+    for (const cJSON *c = array->child; c; c = c->next) n++;
+    return n;
+}
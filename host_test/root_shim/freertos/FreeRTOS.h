@@ -0,0 +1 @@
+#include "../idf_shim.h"
@@ -0,0 +1,598 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdarg.h>
+#include <time.h>
+#include "idf_shim.h"
+
+// ==== Thời gian / log ====
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t s_boot_us;
+
+__attribute__((constructor)) static void shim_boot(void) {
+    s_boot_us = now_us();
+}
+
+int64_t esp_timer_get_time(void) {
+    return now_us() - s_boot_us;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec ts = { .tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+size_t esp_get_free_heap_size(void) {
+    return 200 * 1024;
+}
+
+const char *esp_err_to_name(esp_err_t err) {
+    return err == ESP_OK ? "ESP_OK" : "ESP_FAIL";
+}
+
+void shim_log(char level, const char *tag, const char *fmt, ...) {
+    static int max_level = 0;
+    if (!max_level) {
+        const char *env = getenv("SHIM_LOG");
+        max_level = env && *env ? *env : 'W';
+    }
+    // thứ tự mức E < W < I
+    int rank = level == 'E' ? 0 : level == 'W' ? 1 : 2;
+    int max  = max_level == 'E' ? 0 : max_level == 'W' ? 1 : 2;
+    if (rank > max) return;
+
+    va_list ap;
+    va_start(ap, fmt);
+    flockfile(stderr);
+    fprintf(stderr, "%c (%u) %s: ", level, (unsigned)xTaskGetTickCount(), tag);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    funlockfile(stderr);
+    va_end(ap);
+}
+
+size_t shim_strlcpy(char *dst, const char *src, size_t cap) {
+    size_t n = strlen(src);
+    if (cap) {
+        size_t c = n < cap - 1 ? n : cap - 1;
+        memcpy(dst, src, c);
+        dst[c] = '\0';
+    }
+    return n;
+}
+
+// deadline tuyệt đối cho pthread_cond_timedwait (CLOCK_REALTIME mặc định)
+static void deadline(TickType_t ticks, struct timespec *ts) {
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec  += ticks / 1000;
+    ts->tv_nsec += (long)(ticks % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+// Chờ cv tới khi *ready hoặc hết ticks; true nếu ready
+static bool wait_until(pthread_cond_t *cv, pthread_mutex_t *mu, const volatile bool *ready, TickType_t ticks) {
+    struct timespec ts;
+    if (ticks != portMAX_DELAY) deadline(ticks, &ts);
+    while (!*ready) {
+        if (ticks == 0) return false;
+        if (ticks == portMAX_DELAY) pthread_cond_wait(cv, mu);
+        else if (pthread_cond_timedwait(cv, mu, &ts) == ETIMEDOUT) return *ready;
+    }
+    return true;
+}
+
+// ==== Task + notify ====
+struct shim_task {
+    pthread_t       th;
+    pthread_mutex_t mu;
+    pthread_cond_t  cv;
+    uint32_t        notify;
+    volatile bool   pending;
+    void          (*fn)(void *);
+    void           *arg;
+};
+
+static __thread struct shim_task *t_self;
+
+static void *task_main(void *p) {
+    t_self = p;
+    t_self->fn(t_self->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *out, BaseType_t core) {
+    struct shim_task *t = calloc(1, sizeof(*t));
+    if (!t) return pdFALSE;
+    pthread_mutex_init(&t->mu, NULL);
+    pthread_cond_init(&t->cv, NULL);
+    t->fn  = fn;
+    t->arg = arg;
+    // handle phải có trước khi task chạy: task khác notify qua biến global
+    if (out) *out = t;
+    if (pthread_create(&t->th, NULL, task_main, t) != 0) {
+        if (out) *out = NULL;
+        free(t);
+        return pdFALSE;
+    }
+    pthread_setname_np(t->th, name);
+    pthread_detach(t->th);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    struct shim_task *t = t_self;
+    uint32_t v = 0;
+    pthread_mutex_lock(&t->mu);
+    if (wait_until(&t->cv, &t->mu, &t->pending, ticks)) {
+        v = t->notify;
+        t->notify = clear ? 0 : t->notify - 1;
+        t->pending = t->notify != 0;
+    }
+    pthread_mutex_unlock(&t->mu);
+    return v;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t t) {
+    pthread_mutex_lock(&t->mu);
+    t->notify++;
+    t->pending = true;
+    pthread_cond_signal(&t->cv);
+    pthread_mutex_unlock(&t->mu);
+    return pdPASS;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t t) {
+    return 0;
+}
+
+// ==== Queue ====
+struct shim_queue {
+    pthread_mutex_t mu;
+    pthread_cond_t  cv;
+    UBaseType_t     len, item, head, count;
+    volatile bool   has_item, has_space;
+    uint8_t         buf[];
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item) {
+    struct shim_queue *q = calloc(1, sizeof(*q) + (size_t)len * item);
+    if (!q) return NULL;
+    pthread_mutex_init(&q->mu, NULL);
+    pthread_cond_init(&q->cv, NULL);
+    q->len = len;
+    q->item = item;
+    q->has_space = true;
+    return q;
+}
+
+static void queue_flags(struct shim_queue *q) {
+    q->has_item  = q->count > 0;
+    q->has_space = q->count < q->len;
+    pthread_cond_broadcast(&q->cv);
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks) {
+    pthread_mutex_lock(&q->mu);
+    bool ok = wait_until(&q->cv, &q->mu, &q->has_space, ticks);
+    if (ok) {
+        memcpy(&q->buf[((q->head + q->count) % q->len) * q->item], item, q->item);
+        q->count++;
+        queue_flags(q);
+    }
+    pthread_mutex_unlock(&q->mu);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks) {
+    pthread_mutex_lock(&q->mu);
+    bool ok = wait_until(&q->cv, &q->mu, &q->has_item, ticks);
+    if (ok) {
+        memcpy(item, &q->buf[q->head * q->item], q->item);
+        q->head = (q->head + 1) % q->len;
+        q->count--;
+        queue_flags(q);
+    }
+    pthread_mutex_unlock(&q->mu);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+// Chỉ dùng cho queue dài 1 như FreeRTOS yêu cầu
+BaseType_t xQueueOverwrite(QueueHandle_t q, const void *item) {
+    pthread_mutex_lock(&q->mu);
+    memcpy(q->buf, item, q->item);
+    q->head  = 0;
+    q->count = 1;
+    queue_flags(q);
+    pthread_mutex_unlock(&q->mu);
+    return pdPASS;
+}
+
+// ==== esp_event (gọi đồng bộ) ====
+esp_event_base_t IP_EVENT   = "IP_EVENT";
+esp_event_base_t MESH_EVENT = "MESH_EVENT";
+
+#define EVENT_HANDLERS  8
+static struct {
+    esp_event_base_t    base;
+    int32_t             id;
+    esp_event_handler_t fn;
+    void               *arg;
+} s_handlers[EVENT_HANDLERS];
+static int s_n_handlers;
+
+esp_err_t esp_event_loop_create_default(void) {
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t fn, void *arg) {
+    if (s_n_handlers == EVENT_HANDLERS) return ESP_ERR_NO_MEM;
+    s_handlers[s_n_handlers].base = base;
+    s_handlers[s_n_handlers].id   = id;
+    s_handlers[s_n_handlers].fn   = fn;
+    s_handlers[s_n_handlers].arg  = arg;
+    s_n_handlers++;
+    return ESP_OK;
+}
+
+void shim_event_post(esp_event_base_t base, int32_t id, void *data) {
+    for (int i = 0; i < s_n_handlers; i++) {
+        if (s_handlers[i].base == base && (s_handlers[i].id == ESP_EVENT_ANY_ID || s_handlers[i].id == id)) {
+            s_handlers[i].fn(s_handlers[i].arg, base, id, data);
+        }
+    }
+}
+
+// ==== NVS: 1 namespace phẳng, chuỗi ====
+#define NVS_KEYS    8
+static struct {
+    char  key[32];
+    char *val;
+} s_nvs[NVS_KEYS];
+static pthread_mutex_t s_nvs_mu = PTHREAD_MUTEX_INITIALIZER;
+
+esp_err_t nvs_flash_init(void)  { return ESP_OK; }
+esp_err_t nvs_flash_erase(void) { return ESP_OK; }
+
+esp_err_t nvs_open(const char *ns, nvs_open_mode_t mode, nvs_handle_t *out) {
+    *out = 1;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t h) {}
+
+esp_err_t nvs_commit(nvs_handle_t h) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_str(nvs_handle_t h, const char *key, char *out, size_t *len) {
+    esp_err_t err = ESP_ERR_NVS_NOT_FOUND;
+    pthread_mutex_lock(&s_nvs_mu);
+    for (int i = 0; i < NVS_KEYS; i++) {
+        if (!s_nvs[i].val || strcmp(s_nvs[i].key, key) != 0) continue;
+        size_t n = strlen(s_nvs[i].val) + 1;
+        if (out && *len < n) {
+            err = ESP_ERR_INVALID_SIZE;
+        } else {
+            if (out) memcpy(out, s_nvs[i].val, n);
+            *len = n;
+            err = ESP_OK;
+        }
+        break;
+    }
+    pthread_mutex_unlock(&s_nvs_mu);
+    return err;
+}
+
+esp_err_t nvs_set_str(nvs_handle_t h, const char *key, const char *val) {
+    esp_err_t err = ESP_ERR_NO_MEM;
+    pthread_mutex_lock(&s_nvs_mu);
+    for (int i = 0; i < NVS_KEYS; i++) {
+        if (s_nvs[i].val && strcmp(s_nvs[i].key, key) != 0) continue;
+        free(s_nvs[i].val);
+        snprintf(s_nvs[i].key, sizeof(s_nvs[i].key), "%s", key);
+        s_nvs[i].val = strdup(val);
+        err = s_nvs[i].val ? ESP_OK : ESP_ERR_NO_MEM;
+        break;
+    }
+    pthread_mutex_unlock(&s_nvs_mu);
+    return err;
+}
+
+// ==== netif / SNTP / Wi-Fi: không làm gì ====
+static esp_sntp_time_cb_t s_sntp_cb;
+
+esp_err_t esp_netif_init(void) { return ESP_OK; }
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t *n) { return ESP_OK; }
+esp_err_t esp_netif_dhcpc_start(esp_netif_t *n) { return ESP_OK; }
+
+esp_err_t esp_netif_create_default_wifi_mesh_netifs(esp_netif_t **sta, esp_netif_t **ap) {
+    *sta = NULL;
+    *ap  = NULL;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_sntp_init(const esp_sntp_config_t *cfg) {
+    s_sntp_cb = cfg->sync_cb;
+    return ESP_OK;
+}
+
+void shim_sntp_sync(int64_t epoch_us) {
+    struct timeval tv = { .tv_sec = epoch_us / 1000000, .tv_usec = epoch_us % 1000000 };
+    if (s_sntp_cb) s_sntp_cb(&tv);
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *cfg) { return ESP_OK; }
+esp_err_t esp_wifi_set_storage(wifi_storage_t s) { return ESP_OK; }
+esp_err_t esp_wifi_start(void) { return ESP_OK; }
+esp_err_t esp_wifi_set_country(const wifi_country_t *c) { return ESP_OK; }
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t ps) { return ESP_OK; }
+esp_err_t esp_wifi_set_bandwidth(wifi_interface_t ifx, wifi_bandwidth_t bw) { return ESP_OK; }
+
+esp_err_t esp_wifi_get_mode(wifi_mode_t *mode) {
+    *mode = WIFI_MODE_APSTA;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]) {
+    static const uint8_t base[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x00 };
+    memcpy(mac, base, 6);
+    mac[5] = ifx == WIFI_IF_AP ? 1 : 0;
+    return ESP_OK;
+}
+
+// ==== esp_mesh: recv từ hàng đợi test, send ghi log ====
+#define MESH_RX_DEPTH   64
+#define MESH_TX_LOG     512
+
+typedef struct {
+    uint8_t  from[6];
+    uint16_t len;
+    uint8_t  data[SHIM_FRAME_MAX];
+} mesh_rx_t;
+
+static mesh_rx_t        s_rx[MESH_RX_DEPTH];
+static unsigned         s_rx_head, s_rx_count;
+static volatile bool    s_rx_ready, s_rx_space = true;
+static pthread_mutex_t  s_rx_mu = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   s_rx_cv = PTHREAD_COND_INITIALIZER;
+
+static shim_mesh_tx_t   s_tx[MESH_TX_LOG];
+static size_t           s_tx_count;
+static pthread_mutex_t  s_tx_mu = PTHREAD_MUTEX_INITIALIZER;
+
+esp_err_t esp_mesh_init(void) { return ESP_OK; }
+esp_err_t esp_mesh_start(void) { return ESP_OK; }
+esp_err_t esp_mesh_set_config(const mesh_cfg_t *cfg) { return ESP_OK; }
+esp_err_t esp_mesh_set_ap_authmode(wifi_auth_mode_t m) { return ESP_OK; }
+esp_err_t esp_mesh_set_self_organized(bool en, bool sel) { return ESP_OK; }
+esp_err_t esp_mesh_set_max_layer(int layer) { return ESP_OK; }
+esp_err_t esp_mesh_set_type(mesh_type_t type) { return ESP_OK; }
+bool      esp_mesh_is_root(void) { return true; }
+
+void shim_mesh_inject(const uint8_t from[6], const void *data, size_t len) {
+    if (len > SHIM_FRAME_MAX) len = SHIM_FRAME_MAX;
+    pthread_mutex_lock(&s_rx_mu);
+    // test đẩy nhanh hơn recv task: chờ chỗ trống thay vì bỏ
+    wait_until(&s_rx_cv, &s_rx_mu, &s_rx_space, portMAX_DELAY);
+    mesh_rx_t *r = &s_rx[(s_rx_head + s_rx_count) % MESH_RX_DEPTH];
+    memcpy(r->from, from, 6);
+    memcpy(r->data, data, len);
+    r->len = (uint16_t)len;
+    s_rx_count++;
+    s_rx_ready = true;
+    s_rx_space = s_rx_count < MESH_RX_DEPTH;
+    pthread_cond_broadcast(&s_rx_cv);
+    pthread_mutex_unlock(&s_rx_mu);
+}
+
+// Như IDF: frame lớn hơn data->size bị cắt, data->size = số byte chép
+esp_err_t esp_mesh_recv(mesh_addr_t *from, mesh_data_t *data, int timeout_ms, int *flag,
+                        mesh_opt_t opt[], int opt_count) {
+    TickType_t ticks = timeout_ms < 0 ? portMAX_DELAY : (TickType_t)timeout_ms;
+    pthread_mutex_lock(&s_rx_mu);
+    if (!wait_until(&s_rx_cv, &s_rx_mu, &s_rx_ready, ticks)) {
+        pthread_mutex_unlock(&s_rx_mu);
+        return ESP_ERR_TIMEOUT;
+    }
+    const mesh_rx_t *r = &s_rx[s_rx_head];
+    size_t n = r->len < data->size ? r->len : data->size;
+    memcpy(from->addr, r->from, 6);
+    memcpy(data->data, r->data, n);
+    data->size = (uint16_t)n;
+    s_rx_head = (s_rx_head + 1) % MESH_RX_DEPTH;
+    s_rx_count--;
+    s_rx_ready = s_rx_count > 0;
+    s_rx_space = true;
+    pthread_cond_broadcast(&s_rx_cv);
+    pthread_mutex_unlock(&s_rx_mu);
+    if (flag) *flag = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_mesh_send(const mesh_addr_t *to, const mesh_data_t *data, int flag,
+                        const mesh_opt_t opt[], int opt_count) {
+    pthread_mutex_lock(&s_tx_mu);
+    if (s_tx_count < MESH_TX_LOG) {
+        shim_mesh_tx_t *t = &s_tx[s_tx_count];
+        size_t n = data->size < sizeof(t->data) ? data->size : sizeof(t->data);
+        memcpy(t->to, to->addr, 6);
+        memcpy(t->data, data->data, n);
+        t->len = (uint16_t)n;
+    }
+    s_tx_count++;
+    pthread_mutex_unlock(&s_tx_mu);
+    return ESP_OK;
+}
+
+size_t shim_mesh_sent(size_t first, shim_mesh_tx_t *out, size_t max) {
+    pthread_mutex_lock(&s_tx_mu);
+    size_t total = s_tx_count;
+    for (size_t i = 0; out && i < max && first + i < total && first + i < MESH_TX_LOG; i++) {
+        out[i] = s_tx[first + i];
+    }
+    pthread_mutex_unlock(&s_tx_mu);
+    return total;
+}
+
+// ==== esp-mqtt: 1 client, publish/enqueue ghi log ====
+struct esp_mqtt_client {
+    esp_event_handler_t handler;
+    void               *arg;
+    int                 msg_id;
+};
+
+static struct esp_mqtt_client s_mqtt;
+static shim_mqtt_msg_t  s_msgs[SHIM_MQTT_LOG];
+static size_t           s_msg_count;
+static bool             s_mqtt_fail;
+static bool             s_mqtt_hold;
+static pthread_mutex_t  s_mqtt_mu = PTHREAD_MUTEX_INITIALIZER;
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *cfg) {
+    return &s_mqtt;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t c, int32_t id, esp_event_handler_t fn, void *arg) {
+    c->handler = fn;
+    c->arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t c) {
+    return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t c, const char *topic, const char *data, int len, int qos,
+                            int retain) {
+    int id;
+    if (len <= 0) len = (int)strlen(data);
+    pthread_mutex_lock(&s_mqtt_mu);
+    while (s_mqtt_hold) {
+        pthread_mutex_unlock(&s_mqtt_mu);
+        vTaskDelay(1);
+        pthread_mutex_lock(&s_mqtt_mu);
+    }
+    if (s_mqtt_fail) {
+        pthread_mutex_unlock(&s_mqtt_mu);
+        return -1;
+    }
+    if (s_msg_count < SHIM_MQTT_LOG) {
+        shim_mqtt_msg_t *m = &s_msgs[s_msg_count];
+        int n = len < SHIM_PAYLOAD_MAX - 1 ? len : SHIM_PAYLOAD_MAX - 1;
+        snprintf(m->topic, sizeof(m->topic), "%s", topic);
+        memcpy(m->payload, data, n);
+        m->payload[n] = '\0';
+        m->len = len;
+        m->qos = qos;
+    }
+    s_msg_count++;
+    id = ++c->msg_id;
+    pthread_mutex_unlock(&s_mqtt_mu);
+    return id;
+}
+
+int esp_mqtt_client_enqueue(esp_mqtt_client_handle_t c, const char *topic, const char *data, int len, int qos,
+                            int retain, bool store) {
+    return esp_mqtt_client_publish(c, topic, data, len, qos, retain);
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t c, const char *topic, int qos) {
+    pthread_mutex_lock(&s_mqtt_mu);
+    int id = ++c->msg_id;
+    pthread_mutex_unlock(&s_mqtt_mu);
+    return id;
+}
+
+int esp_mqtt_client_get_outbox_size(esp_mqtt_client_handle_t c) {
+    return 0;
+}
+
+size_t shim_mqtt_count(void) {
+    pthread_mutex_lock(&s_mqtt_mu);
+    size_t n = s_msg_count;
+    pthread_mutex_unlock(&s_mqtt_mu);
+    return n;
+}
+
+bool shim_mqtt_get(size_t i, shim_mqtt_msg_t *out) {
+    pthread_mutex_lock(&s_mqtt_mu);
+    bool ok = i < s_msg_count && i < SHIM_MQTT_LOG;
+    if (ok) *out = s_msgs[i];
+    pthread_mutex_unlock(&s_mqtt_mu);
+    return ok;
+}
+
+void shim_mqtt_set_fail(bool fail) {
+    pthread_mutex_lock(&s_mqtt_mu);
+    s_mqtt_fail = fail;
+    pthread_mutex_unlock(&s_mqtt_mu);
+}
+
+void shim_mqtt_set_hold(bool hold) {
+    pthread_mutex_lock(&s_mqtt_mu);
+    s_mqtt_hold = hold;
+    pthread_mutex_unlock(&s_mqtt_mu);
+}
+
+void shim_mqtt_event(int event_id, const char *topic, const char *data) {
+    esp_mqtt_event_t ev = {
+        .event_id = event_id,
+        .client   = &s_mqtt,
+        .topic    = (char *)topic,
+        .topic_len = topic ? (int)strlen(topic) : 0,
+        .data     = (char *)data,
+        .data_len = data ? (int)strlen(data) : 0,
+    };
+    ev.total_data_len = ev.data_len;
+    if (s_mqtt.handler) s_mqtt.handler(s_mqtt.arg, "MQTT_EVENTS", event_id, &ev);
+}
+
+// ==== Partition "journal" trong RAM ====
+#define PART_SIZE   (4 * 4096)
+
+static uint8_t s_part_mem[PART_SIZE];
+static esp_partition_t s_part = {
+    .type = ESP_PARTITION_TYPE_DATA, .subtype = 0x40, .size = PART_SIZE, .erase_size = 4096, .label = "journal",
+};
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label) {
+    static bool erased;
+    if (!label || strcmp(label, s_part.label) != 0) return NULL;
+    if (!erased) {
+        memset(s_part_mem, 0xFF, sizeof(s_part_mem));
+        erased = true;
+    }
+    return &s_part;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *p, size_t off, void *buf, size_t len) {
+    if (off + len > p->size) return ESP_ERR_INVALID_SIZE;
+    memcpy(buf, &s_part_mem[off], len);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *p, size_t off, const void *buf, size_t len) {
+    if (off + len > p->size) return ESP_ERR_INVALID_SIZE;
+    const uint8_t *b = buf;
+    for (size_t i = 0; i < len; i++) s_part_mem[off + i] &= b[i];
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *p, size_t off, size_t len) {
+    if (off % p->erase_size || len % p->erase_size || off + len > p->size) return ESP_ERR_INVALID_ARG;
+    memset(&s_part_mem[off], 0xFF, len);
+    return ESP_OK;
+}
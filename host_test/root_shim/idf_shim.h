@@ -0,0 +1,267 @@
+#ifndef IDF_SHIM_H_
+#define IDF_SHIM_H_
+
+// ==== ESP-IDF / FreeRTOS tối thiểu để build nguyên "Root node/main/main.c" trên Linux ====
+// Task = pthread, notify/queue = mutex + condvar, tick = 1 ms từ CLOCK_MONOTONIC.
+// esp_mesh_recv lấy frame test đẩy vào (shim_mesh_inject), esp_mesh_send và MQTT
+// publish chỉ ghi lại để test đọc. Wi-Fi/netif không làm gì, trả ESP_OK.
+// Chỉ khai báo những gì main.c + loadgen.c dùng; thiếu thì thêm ở đây và idf_shim.c.
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+// ==== esp_err ====
+typedef int esp_err_t;
+#define ESP_OK                          0
+#define ESP_FAIL                        -1
+#define ESP_ERR_NO_MEM                  0x101
+#define ESP_ERR_INVALID_ARG             0x102
+#define ESP_ERR_INVALID_STATE           0x103
+#define ESP_ERR_INVALID_SIZE            0x104
+#define ESP_ERR_NOT_FOUND               0x105
+#define ESP_ERR_TIMEOUT                 0x107
+#define ESP_ERR_NVS_NOT_FOUND           0x1102
+#define ESP_ERR_NVS_NO_FREE_PAGES       0x110d
+#define ESP_ERR_NVS_NEW_VERSION_FOUND   0x1110
+#define ESP_ERR_MESH_QUEUE_FULL         0x400a
+
+const char *esp_err_to_name(esp_err_t err);
+
+#define ESP_ERROR_CHECK(x) do {                                                 \
+        esp_err_t err_ = (x);                                                   \
+        if (err_ != ESP_OK) {                                                   \
+            fprintf(stderr, "%s:%d: ESP_ERROR_CHECK(%s) = 0x%x\n",              \
+                    __FILE__, __LINE__, #x, err_);                              \
+            abort();                                                            \
+        }                                                                       \
+    } while (0)
+
+// ==== esp_log: mặc định chỉ in W/E, SHIM_LOG=I để xem hết ====
+void shim_log(char level, const char *tag, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+#define ESP_LOGE(tag, fmt, ...) shim_log('E', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) shim_log('W', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) shim_log('I', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) ((void)0)
+
+#define MACSTR      "%02x:%02x:%02x:%02x:%02x:%02x"
+#define MAC2STR(a)  (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
+#define IPSTR       "%d.%d.%d.%d"
+#define IP2STR(ip)  (int)((ip)->addr & 0xff), (int)(((ip)->addr >> 8) & 0xff), \
+                    (int)(((ip)->addr >> 16) & 0xff), (int)(((ip)->addr >> 24) & 0xff)
+
+// glibc < 2.38 không có strlcpy
+size_t shim_strlcpy(char *dst, const char *src, size_t cap);
+#define strlcpy shim_strlcpy
+
+// ==== FreeRTOS ====
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+typedef struct shim_task  *TaskHandle_t;
+typedef struct shim_queue *QueueHandle_t;
+
+typedef pthread_mutex_t portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED    PTHREAD_MUTEX_INITIALIZER
+#define portENTER_CRITICAL(m)           pthread_mutex_lock(m)
+#define portEXIT_CRITICAL(m)            pthread_mutex_unlock(m)
+#define portMAX_DELAY                   0xffffffffu
+#define portTICK_PERIOD_MS              1
+#define configTICK_RATE_HZ              1000
+#define pdMS_TO_TICKS(x)                ((TickType_t)(x))
+#define pdTICKS_TO_MS(x)                ((uint32_t)(x))
+#define pdTRUE                          1
+#define pdFALSE                         0
+#define pdPASS                          1
+
+TickType_t  xTaskGetTickCount(void);
+void        vTaskDelay(TickType_t ticks);
+BaseType_t  xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack, void *arg,
+                                    UBaseType_t prio, TaskHandle_t *out, BaseType_t core);
+uint32_t    ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+BaseType_t  xTaskNotifyGive(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size);
+BaseType_t    xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks);
+BaseType_t    xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks);
+BaseType_t    xQueueOverwrite(QueueHandle_t q, const void *item);
+
+// ==== esp_timer / system ====
+int64_t esp_timer_get_time(void);
+size_t  esp_get_free_heap_size(void);
+
+// ==== esp_event ====
+typedef const char *esp_event_base_t;
+typedef void (*esp_event_handler_t)(void *arg, esp_event_base_t base, int32_t id, void *data);
+extern esp_event_base_t IP_EVENT, MESH_EVENT;
+#define ESP_EVENT_ANY_ID    -1
+enum { IP_EVENT_STA_GOT_IP = 0 };
+
+esp_err_t esp_event_loop_create_default(void);
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t fn, void *arg);
+
+// ==== nvs (RAM, mất khi thoát) ====
+typedef uint32_t nvs_handle_t;
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode_t;
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
+esp_err_t nvs_open(const char *ns, nvs_open_mode_t mode, nvs_handle_t *out);
+void      nvs_close(nvs_handle_t h);
+esp_err_t nvs_get_str(nvs_handle_t h, const char *key, char *out, size_t *len);
+esp_err_t nvs_set_str(nvs_handle_t h, const char *key, const char *val);
+esp_err_t nvs_commit(nvs_handle_t h);
+
+// ==== netif / SNTP ====
+typedef struct { uint32_t addr; } esp_ip4_addr_t;
+typedef struct { esp_ip4_addr_t ip, netmask, gw; } esp_netif_ip_info_t;
+typedef struct { esp_netif_ip_info_t ip_info; } ip_event_got_ip_t;
+typedef struct esp_netif_obj esp_netif_t;
+esp_err_t esp_netif_init(void);
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t *netif);
+esp_err_t esp_netif_dhcpc_start(esp_netif_t *netif);
+esp_err_t esp_netif_create_default_wifi_mesh_netifs(esp_netif_t **sta, esp_netif_t **ap);
+
+typedef void (*esp_sntp_time_cb_t)(struct timeval *tv);
+typedef struct { const char *server; esp_sntp_time_cb_t sync_cb; } esp_sntp_config_t;
+#define ESP_NETIF_SNTP_DEFAULT_CONFIG(srv)  { .server = (srv) }
+esp_err_t esp_netif_sntp_init(const esp_sntp_config_t *cfg);
+
+// ==== Wi-Fi ====
+typedef enum { WIFI_MODE_NULL = 0, WIFI_MODE_STA = 1, WIFI_MODE_AP = 2, WIFI_MODE_APSTA = 3 } wifi_mode_t;
+typedef enum { WIFI_IF_STA, WIFI_IF_AP } wifi_interface_t;
+typedef enum { WIFI_BW_HT20 = 1 } wifi_bandwidth_t;
+typedef enum { WIFI_PS_NONE } wifi_ps_type_t;
+typedef enum { WIFI_AUTH_OPEN } wifi_auth_mode_t;
+typedef enum { WIFI_COUNTRY_POLICY_MANUAL } wifi_country_policy_t;
+typedef enum { WIFI_STORAGE_FLASH, WIFI_STORAGE_RAM } wifi_storage_t;
+typedef struct { char cc[3]; uint8_t schan, nchan; int8_t max_tx_power; wifi_country_policy_t policy; } wifi_country_t;
+typedef struct { int unused; } wifi_init_config_t;
+#define WIFI_INIT_CONFIG_DEFAULT()  { 0 }
+esp_err_t esp_wifi_init(const wifi_init_config_t *cfg);
+esp_err_t esp_wifi_set_storage(wifi_storage_t storage);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_set_country(const wifi_country_t *c);
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t ps);
+esp_err_t esp_wifi_get_mode(wifi_mode_t *mode);
+esp_err_t esp_wifi_set_bandwidth(wifi_interface_t ifx, wifi_bandwidth_t bw);
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]);
+
+// ==== esp_mesh ====
+typedef union { uint8_t addr[6]; struct { uint16_t port; uint32_t ip4; } mip; } mesh_addr_t;
+typedef enum { MESH_PROTO_BIN, MESH_PROTO_HTTP, MESH_PROTO_JSON } mesh_proto_t;
+typedef enum { MESH_TOS_P2P, MESH_TOS_E2E, MESH_TOS_DEF } mesh_tos_t;
+typedef struct { uint8_t *data; uint16_t size; mesh_proto_t proto; mesh_tos_t tos; } mesh_data_t;
+typedef struct { uint8_t type; uint16_t len; uint8_t *val; } mesh_opt_t;
+#define MESH_DATA_P2P       0x02
+#define MESH_DATA_NONBLOCK  0x10
+typedef enum { MESH_IDLE, MESH_ROOT, MESH_NODE, MESH_LEAF, MESH_STA } mesh_type_t;
+enum { MESH_EVENT_STARTED, MESH_EVENT_CHILD_CONNECTED, MESH_EVENT_CHILD_DISCONNECTED, MESH_EVENT_PARENT_CONNECTED };
+typedef struct { int self_layer; } mesh_event_connected_t;
+typedef struct { uint8_t mac[6]; uint8_t aid; } mesh_event_child_connected_t;
+typedef mesh_event_child_connected_t mesh_event_child_disconnected_t;
+typedef struct { uint8_t ssid[32]; uint8_t ssid_len; uint8_t password[64]; } mesh_router_t;
+typedef struct { uint8_t password[64]; uint8_t max_connection; uint8_t nonmesh_max_connection; } mesh_ap_cfg_t;
+typedef struct { uint8_t channel; mesh_addr_t mesh_id; mesh_router_t router; mesh_ap_cfg_t mesh_ap; } mesh_cfg_t;
+#define MESH_INIT_CONFIG_DEFAULT()  { 0 }
+esp_err_t esp_mesh_init(void);
+esp_err_t esp_mesh_start(void);
+esp_err_t esp_mesh_set_config(const mesh_cfg_t *cfg);
+esp_err_t esp_mesh_set_ap_authmode(wifi_auth_mode_t mode);
+esp_err_t esp_mesh_set_self_organized(bool enable, bool select_parent);
+esp_err_t esp_mesh_set_max_layer(int layer);
+esp_err_t esp_mesh_set_type(mesh_type_t type);
+bool      esp_mesh_is_root(void);
+esp_err_t esp_mesh_send(const mesh_addr_t *to, const mesh_data_t *data, int flag,
+                        const mesh_opt_t opt[], int opt_count);
+esp_err_t esp_mesh_recv(mesh_addr_t *from, mesh_data_t *data, int timeout_ms, int *flag,
+                        mesh_opt_t opt[], int opt_count);
+
+// ==== esp-mqtt ====
+typedef struct esp_mqtt_client *esp_mqtt_client_handle_t;
+typedef struct {
+    struct { struct { const char *uri; } address; } broker;
+    struct { const char *username; struct { const char *password; } authentication; } credentials;
+} esp_mqtt_client_config_t;
+typedef struct {
+    int event_id;
+    esp_mqtt_client_handle_t client;
+    char *data;
+    int data_len;
+    int total_data_len;
+    int current_data_offset;
+    char *topic;
+    int topic_len;
+    int msg_id;
+} esp_mqtt_event_t;
+typedef esp_mqtt_event_t *esp_mqtt_event_handle_t;
+enum { MQTT_EVENT_ERROR = 0, MQTT_EVENT_CONNECTED, MQTT_EVENT_DISCONNECTED, MQTT_EVENT_DATA = 6 };
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *cfg);
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t c, int32_t id, esp_event_handler_t fn, void *arg);
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t c);
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t c, const char *topic, const char *data, int len, int qos, int retain);
+int esp_mqtt_client_enqueue(esp_mqtt_client_handle_t c, const char *topic, const char *data, int len, int qos,
+                            int retain, bool store);
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t c, const char *topic, int qos);
+int esp_mqtt_client_get_outbox_size(esp_mqtt_client_handle_t c);
+
+// ==== esp_partition (RAM, hành vi NOR: ghi chỉ xóa bit, erase về 0xFF) ====
+typedef enum { ESP_PARTITION_TYPE_APP, ESP_PARTITION_TYPE_DATA } esp_partition_type_t;
+typedef int esp_partition_subtype_t;
+typedef struct {
+    esp_partition_type_t    type;
+    esp_partition_subtype_t subtype;
+    uint32_t                address;
+    uint32_t                size;
+    uint32_t                erase_size;
+    char                    label[17];
+} esp_partition_t;
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *p, size_t off, void *buf, size_t len);
+esp_err_t esp_partition_write(const esp_partition_t *p, size_t off, const void *buf, size_t len);
+esp_err_t esp_partition_erase_range(const esp_partition_t *p, size_t off, size_t len);
+
+// ==== Điều khiển từ test ====
+#define SHIM_FRAME_MAX      1024
+#define SHIM_TOPIC_MAX      64
+#define SHIM_PAYLOAD_MAX    512
+
+typedef struct {
+    uint8_t  to[6];
+    uint16_t len;
+    uint8_t  data[64];      // đủ cho lệnh / ACK / beacon / congest
+} shim_mesh_tx_t;
+
+typedef struct {
+    char topic[SHIM_TOPIC_MAX];
+    char payload[SHIM_PAYLOAD_MAX];
+    int  len;
+    int  qos;
+} shim_mqtt_msg_t;
+
+// Frame tới root như thể esp_mesh_recv nhận từ from
+void   shim_mesh_inject(const uint8_t from[6], const void *data, size_t len);
+// Số frame root đã esp_mesh_send, out[i] = frame thứ first + i
+size_t shim_mesh_sent(size_t first, shim_mesh_tx_t *out, size_t max);
+// Cả publish lẫn enqueue; giữ SHIM_MQTT_LOG message đầu, đếm tất cả
+#define SHIM_MQTT_LOG       512
+size_t shim_mqtt_count(void);
+bool   shim_mqtt_get(size_t i, shim_mqtt_msg_t *out);
+// true: publish trả -1 như khi mất kết nối giữa chừng
+void   shim_mqtt_set_fail(bool fail);
+// true: publish chặn tới khi thả ra, như broker chậm / TCP nghẽn
+void   shim_mqtt_set_hold(bool hold);
+// Gọi handler MQTT đã đăng ký (CONNECTED / DISCONNECTED / DATA) trên thread gọi
+void   shim_mqtt_event(int event_id, const char *topic, const char *data);
+// Gọi handler esp_event khớp base/id trên thread gọi
+void   shim_event_post(esp_event_base_t base, int32_t id, void *data);
+// Giả lập SNTP đồng bộ xong (gọi sync_cb của esp_netif_sntp_init)
+void   shim_sntp_sync(int64_t epoch_us);
+
+#endif /* IDF_SHIM_H_ */
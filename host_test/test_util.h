@@ -0,0 +1,47 @@
+#ifndef TEST_UTIL_H_
+#define TEST_UTIL_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+// ==== Tiện ích nhỏ cho test host: CHECK không dừng, main trả TEST_RESULT() ====
+static int g_test_fail __attribute__((unused)) = 0;
+
+#define CHECK(cond) do {                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: CHECK(%s) fail\n", __FILE__, __LINE__, #cond); \
+            g_test_fail++;                                                      \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_EQ(a, b) do {                                                     \
+        long long a_ = (long long)(a), b_ = (long long)(b);                     \
+        if (a_ != b_) {                                                         \
+            fprintf(stderr, "%s:%d: %s = %lld, cần %lld\n",                     \
+                    __FILE__, __LINE__, #a, a_, b_);                            \
+            g_test_fail++;                                                      \
+        }                                                                       \
+    } while (0)
+
+#define TEST_RESULT() (printf("%s\n", g_test_fail ? "FAIL" : "OK"), g_test_fail ? 1 : 0)
+
+static inline uint64_t test_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// xorshift32, trace/fuzz lặp lại được giữa các lần chạy
+static inline uint32_t test_rand(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+// Chặn compiler bỏ vòng benchmark
+static volatile uint32_t g_bench_sink __attribute__((unused));
+
+#endif /* TEST_UTIL_H_ */